@@ -0,0 +1,179 @@
+/* GraphicsGemsBench.c: times the routines of GraphicsGems.c against their
+ * inline twins and batch forms in GraphicsGemsInline.h, and checks that
+ * each gives the same results.
+ *
+ * Usage: GraphicsGemsBench [vectors [repetitions]]
+ *
+ * The times mean little unless it is compiled with optimization
+ * (cmake -DCMAKE_BUILD_TYPE=Release).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "GraphicsGemsInline.h"
+
+static int n, reps;
+static Vector3 *a, *b, *c, *d;
+static Vector2 *a2, *c2, *d2;
+static double *s, *t;
+static Matrix3 m3;
+static Matrix4 m4, *ma, *mc, *md;
+
+/* seconds of processor time */
+static double seconds(void)
+{
+	return((double)clock()/CLOCKS_PER_SEC);
+}
+
+static double uniform(void)
+{
+	return(2.0*rand()/RAND_MAX - 1.0);
+}
+
+/* largest difference of k doubles */
+static double differ(const double *p, const double *q, int k)
+{
+	double e = 0.0;
+	int i;
+	for (i=0; i<k; i++)
+		if (ABS(p[i]-q[i]) > e) e = ABS(p[i]-q[i]);
+	return(e);
+}
+
+/* times body over reps passes of n items; nanoseconds an item */
+#define TIME(ns, body) { \
+	int r_, i; double t_ = seconds(); \
+	for (r_=0; r_<reps; r_++) { body; } \
+	ns = 1e9*(seconds()-t_)/((double)reps*n); (void)i; }
+
+static void report(const char *name, double lib, double inl, double bat,
+		   double err)
+{
+	printf("%-26s %8.2f %8.2f ", name, lib, inl);
+	if (bat >= 0.0) printf("%8.2f ", bat); else printf("%8s ", "-");
+	printf("%10.3g\n", err);
+}
+
+int main(int argc, char *argv[])
+{
+	double lib, inl, bat, err;
+	int i, j;
+
+	n = argc > 1 ? atoi(argv[1]) : 4096;
+	reps = argc > 2 ? atoi(argv[2]) : 2000;
+	a = (Vector3 *)malloc(n*sizeof(Vector3));
+	b = (Vector3 *)malloc(n*sizeof(Vector3));
+	c = (Vector3 *)malloc(n*sizeof(Vector3));
+	d = (Vector3 *)malloc(n*sizeof(Vector3));
+	a2 = (Vector2 *)malloc(n*sizeof(Vector2));
+	c2 = (Vector2 *)malloc(n*sizeof(Vector2));
+	d2 = (Vector2 *)malloc(n*sizeof(Vector2));
+	s = (double *)malloc(n*sizeof(double));
+	t = (double *)malloc(n*sizeof(double));
+	ma = (Matrix4 *)malloc(n*sizeof(Matrix4));
+	mc = (Matrix4 *)malloc(n*sizeof(Matrix4));
+	md = (Matrix4 *)malloc(n*sizeof(Matrix4));
+	if (!a || !b || !c || !d || !a2 || !c2 || !d2 || !s || !t ||
+	    !ma || !mc || !md) {
+		fprintf(stderr, "?Unable to malloc\n");
+		exit(1);
+	}
+	srand(1);
+	for (i=0; i<n; i++) {
+		a[i].x = uniform();  a[i].y = uniform();  a[i].z = uniform();
+		b[i].x = uniform();  b[i].y = uniform();  b[i].z = uniform();
+		a2[i].x = uniform();  a2[i].y = uniform();
+		for (j=0; j<16; j++) ma[i].element[j/4][j%4] = uniform();
+	}
+	for (j=0; j<9; j++) m3.element[j/3][j%3] = uniform();
+	for (j=0; j<16; j++) m4.element[j/4][j%4] = uniform();
+	m4.element[3][3] += 4.0;		/* keep w away from 0 */
+
+	printf("%d vectors, %d repetitions; nanoseconds a vector\n", n, reps);
+	printf("%-26s %8s %8s %8s %10s\n", "routine", "library", "inline",
+	       "batch", "difference");
+
+	TIME(lib, for (i=0; i<n; i++) V3Add(&a[i], &b[i], &c[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV3Add(&a[i], &b[i], &d[i]));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	TIME(bat, V3AddVectors(n, a, b, d));
+	err += differ(&c[0].x, &d[0].x, 3*n);
+	report("V3Add", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V3Sub(&a[i], &b[i], &c[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV3Sub(&a[i], &b[i], &d[i]));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	TIME(bat, V3SubVectors(n, a, b, d));
+	err += differ(&c[0].x, &d[0].x, 3*n);
+	report("V3Sub", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) s[i] = V3Dot(&a[i], &b[i]));
+	TIME(inl, for (i=0; i<n; i++) t[i] = GGV3Dot(&a[i], &b[i]));
+	err = differ(s, t, n);
+	TIME(bat, V3DotVectors(n, a, b, t));
+	err += differ(s, t, n);
+	report("V3Dot", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V3Cross(&a[i], &b[i], &c[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV3Cross(&a[i], &b[i], &d[i]));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	TIME(bat, V3CrossVectors(n, a, b, d));
+	err += differ(&c[0].x, &d[0].x, 3*n);
+	report("V3Cross", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V3Combine(&a[i], &b[i], &c[i], 0.3, 0.7));
+	TIME(inl, for (i=0; i<n; i++) GGV3Combine(&a[i], &b[i], &d[i], 0.3, 0.7));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	TIME(bat, V3CombineVectors(n, a, b, d, 0.3, 0.7));
+	err += differ(&c[0].x, &d[0].x, 3*n);
+	report("V3Combine", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V3Lerp(&a[i], &b[i], 0.25, &c[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV3Lerp(&a[i], &b[i], 0.25, &d[i]));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	report("V3Lerp", lib, inl, -1.0, err);
+
+	TIME(lib, for (i=0; i<n; i++) { c[i] = a[i]; V3Normalize(&c[i]); });
+	TIME(inl, for (i=0; i<n; i++) { d[i] = a[i]; GGV3Normalize(&d[i]); });
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	TIME(bat, { for (i=0; i<n; i++) d[i] = a[i];
+		    V3NormalizeVectors(n, d); });
+	err += differ(&c[0].x, &d[0].x, 3*n);
+	report("V3Normalize", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V3MulPointByMatrix(&a[i], &m3, &c[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV3MulPointByMatrix(&a[i], &m3, &d[i]));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	TIME(bat, V3MulPointsByMatrix(n, a, &m3, d));
+	err += differ(&c[0].x, &d[0].x, 3*n);
+	report("V3MulPointByMatrix", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V3MulPointByProjMatrix(&a[i], &m4, &c[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV3MulPointByProjMatrix(&a[i], &m4, &d[i]));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	TIME(bat, V3MulPointsByProjMatrix(n, a, &m4, d));
+	err += differ(&c[0].x, &d[0].x, 3*n);
+	report("V3MulPointByProjMatrix", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V2MulPointByProjMatrix(&a2[i], &m3, &c2[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV2MulPointByProjMatrix(&a2[i], &m3, &d2[i]));
+	err = differ(&c2[0].x, &d2[0].x, 2*n);
+	TIME(bat, V2MulPointsByProjMatrix(n, a2, &m3, d2));
+	err += differ(&c2[0].x, &d2[0].x, 2*n);
+	report("V2MulPointByProjMatrix", lib, inl, bat, err);
+
+	TIME(lib, for (i=0; i<n; i++) V3MatMul(&ma[i], &m4, &mc[i]));
+	TIME(inl, for (i=0; i<n; i++) GGV3MatMul(&ma[i], &m4, &md[i]));
+	err = differ(&mc[0].element[0][0], &md[0].element[0][0], 16*n);
+	report("V3MatMul", lib, inl, -1.0, err);
+
+	TIME(lib, for (i=0; i<n; i++) {
+		Vector3 *v = V3New(a[i].x, a[i].y, a[i].z);
+		c[i] = *v;  free(v); });
+	TIME(inl, for (i=0; i<n; i++) d[i] = GGV3Make(a[i].x, a[i].y, a[i].z));
+	err = differ(&c[0].x, &d[0].x, 3*n);
+	report("V3New", lib, inl, -1.0, err);
+
+	return(0);
+}
@@ -0,0 +1,525 @@
+/*
+ * GraphicsGemsInline.h
+ * inline companion to the 2d and 3d vector library of GraphicsGems.c
+ *
+ * Every routine of the library has an inline twin here named with a
+ * leading GG (GGV3Add for V3Add, ...) that takes and returns the same
+ * pointers and computes the same values in the same order, so it may
+ * replace the library call in a hot loop without changing any result.
+ * V2New, V3New, V2Duplicate and V3Duplicate, which malloc, have twins
+ * GGV2Make and GGV3Make that return the vector itself.
+ *
+ * The batch forms at the end apply one routine to n points or vectors
+ * of arrays, with SSE2 where the compiler has it; in and out may be the
+ * same array.
+ */
+
+#ifndef GG_INLINE_H
+
+#define GG_INLINE_H 1
+
+#include <math.h>
+#include "GraphicsGems.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GG_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define GGINLINE static __inline
+#else
+#define GGINLINE static inline
+#endif
+
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define GGCONSTEXPR constexpr
+#else
+#define GGCONSTEXPR
+#endif
+
+
+/******************/
+/*   2d Library   */
+/******************/
+
+/* returns squared length of input vector */
+GGINLINE GGCONSTEXPR double GGV2SquaredLength(const Vector2 *a)
+{
+	return((a->x * a->x)+(a->y * a->y));
+}
+
+/* returns length of input vector */
+GGINLINE double GGV2Length(const Vector2 *a)
+{
+	return(sqrt(GGV2SquaredLength(a)));
+}
+
+/* negates the input vector and returns it */
+GGINLINE Vector2 *GGV2Negate(Vector2 *v)
+{
+	v->x = -v->x;  v->y = -v->y;
+	return(v);
+}
+
+/* normalizes the input vector and returns it */
+GGINLINE Vector2 *GGV2Normalize(Vector2 *v)
+{
+	double len = GGV2Length(v);
+	if (len != 0.0) { v->x /= len;  v->y /= len; }
+	return(v);
+}
+
+/* scales the input vector to the new length and returns it */
+GGINLINE Vector2 *GGV2Scale(Vector2 *v, double newlen)
+{
+	double len = GGV2Length(v);
+	if (len != 0.0) { v->x *= newlen/len;  v->y *= newlen/len; }
+	return(v);
+}
+
+/* return vector sum c = a+b */
+GGINLINE Vector2 *GGV2Add(const Vector2 *a, const Vector2 *b, Vector2 *c)
+{
+	c->x = a->x+b->x;  c->y = a->y+b->y;
+	return(c);
+}
+
+/* return vector difference c = a-b */
+GGINLINE Vector2 *GGV2Sub(const Vector2 *a, const Vector2 *b, Vector2 *c)
+{
+	c->x = a->x-b->x;  c->y = a->y-b->y;
+	return(c);
+}
+
+/* return the dot product of vectors a and b */
+GGINLINE GGCONSTEXPR double GGV2Dot(const Vector2 *a, const Vector2 *b)
+{
+	return((a->x*b->x)+(a->y*b->y));
+}
+
+/* linearly interpolate between vectors by an amount alpha */
+GGINLINE Vector2 *GGV2Lerp(const Vector2 *lo, const Vector2 *hi,
+			   double alpha, Vector2 *result)
+{
+	result->x = LERP(alpha, lo->x, hi->x);
+	result->y = LERP(alpha, lo->y, hi->y);
+	return(result);
+}
+
+/* result = (a * ascl) + (b * bscl) */
+GGINLINE Vector2 *GGV2Combine(const Vector2 *a, const Vector2 *b,
+			      Vector2 *result, double ascl, double bscl)
+{
+	result->x = (ascl * a->x) + (bscl * b->x);
+	result->y = (ascl * a->y) + (bscl * b->y);
+	return(result);
+}
+
+/* multiply two vectors together component-wise */
+GGINLINE Vector2 *GGV2Mul(const Vector2 *a, const Vector2 *b, Vector2 *result)
+{
+	result->x = a->x * b->x;
+	result->y = a->y * b->y;
+	return(result);
+}
+
+/* return the distance between two points */
+GGINLINE double GGV2DistanceBetween2Points(const Point2 *a, const Point2 *b)
+{
+	double dx = a->x - b->x;
+	double dy = a->y - b->y;
+	return(sqrt((dx*dx)+(dy*dy)));
+}
+
+/* return the vector perpendicular to the input vector a */
+GGINLINE Vector2 *GGV2MakePerpendicular(const Vector2 *a, Vector2 *ap)
+{
+	double x = a->x;	/* ap may be a */
+	ap->x = -a->y;
+	ap->y = x;
+	return(ap);
+}
+
+/* return a vector, without allocating it */
+GGINLINE Vector2 GGV2Make(double x, double y)
+{
+	Vector2 v;
+	v.x = x;  v.y = y;
+	return(v);
+}
+
+/* multiply a point by a projective matrix and return the transformed point */
+GGINLINE Point2 *GGV2MulPointByProjMatrix(const Point2 *pin, const Matrix3 *m,
+					  Point2 *pout)
+{
+	double x = pin->x, y = pin->y, w;
+	pout->x = (x * m->element[0][0]) +
+		(y * m->element[1][0]) + m->element[2][0];
+	pout->y = (x * m->element[0][1]) +
+		(y * m->element[1][1]) + m->element[2][1];
+	w    = (x * m->element[0][2]) +
+		(y * m->element[1][2]) + m->element[2][2];
+	if (w != 0.0) { pout->x /= w;  pout->y /= w; }
+	return(pout);
+}
+
+/* multiply together matrices c = ab */
+/* note that c must not point to either of the input matrices */
+GGINLINE Matrix3 *GGV2MatMul(const Matrix3 *a, const Matrix3 *b, Matrix3 *c)
+{
+	int i, j, k;
+	for (i=0; i<3; i++)
+		for (j=0; j<3; j++) {
+			c->element[i][j] = 0;
+			for (k=0; k<3; k++) c->element[i][j] +=
+				a->element[i][k] * b->element[k][j];
+		}
+	return(c);
+}
+
+/* transpose matrix a, return b */
+GGINLINE Matrix3 *GGTransposeMatrix3(const Matrix3 *a, Matrix3 *b)
+{
+	int i, j;
+	for (i=0; i<3; i++)
+		for (j=0; j<3; j++)
+			b->element[i][j] = a->element[j][i];
+	return(b);
+}
+
+
+/******************/
+/*   3d Library   */
+/******************/
+
+/* returns squared length of input vector */
+GGINLINE GGCONSTEXPR double GGV3SquaredLength(const Vector3 *a)
+{
+	return((a->x * a->x)+(a->y * a->y)+(a->z * a->z));
+}
+
+/* returns length of input vector */
+GGINLINE double GGV3Length(const Vector3 *a)
+{
+	return(sqrt(GGV3SquaredLength(a)));
+}
+
+/* negates the input vector and returns it */
+GGINLINE Vector3 *GGV3Negate(Vector3 *v)
+{
+	v->x = -v->x;  v->y = -v->y;  v->z = -v->z;
+	return(v);
+}
+
+/* normalizes the input vector and returns it */
+GGINLINE Vector3 *GGV3Normalize(Vector3 *v)
+{
+	double len = GGV3Length(v);
+	if (len != 0.0) { v->x /= len;  v->y /= len;  v->z /= len; }
+	return(v);
+}
+
+/* scales the input vector to the new length and returns it */
+GGINLINE Vector3 *GGV3Scale(Vector3 *v, double newlen)
+{
+	double len = GGV3Length(v);
+	if (len != 0.0) {
+		v->x *= newlen/len;  v->y *= newlen/len;  v->z *= newlen/len;
+	}
+	return(v);
+}
+
+/* return vector sum c = a+b */
+GGINLINE Vector3 *GGV3Add(const Vector3 *a, const Vector3 *b, Vector3 *c)
+{
+	c->x = a->x+b->x;  c->y = a->y+b->y;  c->z = a->z+b->z;
+	return(c);
+}
+
+/* return vector difference c = a-b */
+GGINLINE Vector3 *GGV3Sub(const Vector3 *a, const Vector3 *b, Vector3 *c)
+{
+	c->x = a->x-b->x;  c->y = a->y-b->y;  c->z = a->z-b->z;
+	return(c);
+}
+
+/* return the dot product of vectors a and b */
+GGINLINE GGCONSTEXPR double GGV3Dot(const Vector3 *a, const Vector3 *b)
+{
+	return((a->x*b->x)+(a->y*b->y)+(a->z*b->z));
+}
+
+/* linearly interpolate between vectors by an amount alpha */
+GGINLINE Vector3 *GGV3Lerp(const Vector3 *lo, const Vector3 *hi,
+			   double alpha, Vector3 *result)
+{
+	result->x = LERP(alpha, lo->x, hi->x);
+	result->y = LERP(alpha, lo->y, hi->y);
+	result->z = LERP(alpha, lo->z, hi->z);
+	return(result);
+}
+
+/* result = (a * ascl) + (b * bscl) */
+GGINLINE Vector3 *GGV3Combine(const Vector3 *a, const Vector3 *b,
+			      Vector3 *result, double ascl, double bscl)
+{
+	result->x = (ascl * a->x) + (bscl * b->x);
+	result->y = (ascl * a->y) + (bscl * b->y);
+	result->z = (ascl * a->z) + (bscl * b->z);
+	return(result);
+}
+
+/* multiply two vectors together component-wise */
+GGINLINE Vector3 *GGV3Mul(const Vector3 *a, const Vector3 *b, Vector3 *result)
+{
+	result->x = a->x * b->x;
+	result->y = a->y * b->y;
+	result->z = a->z * b->z;
+	return(result);
+}
+
+/* return the distance between two points */
+GGINLINE double GGV3DistanceBetween2Points(const Point3 *a, const Point3 *b)
+{
+	double dx = a->x - b->x;
+	double dy = a->y - b->y;
+	double dz = a->z - b->z;
+	return(sqrt((dx*dx)+(dy*dy)+(dz*dz)));
+}
+
+/* return the cross product c = a cross b; c may be a or b */
+GGINLINE Vector3 *GGV3Cross(const Vector3 *a, const Vector3 *b, Vector3 *c)
+{
+	double x = (a->y*b->z) - (a->z*b->y);
+	double y = (a->z*b->x) - (a->x*b->z);
+	double z = (a->x*b->y) - (a->y*b->x);
+	c->x = x;  c->y = y;  c->z = z;
+	return(c);
+}
+
+/* return a vector, without allocating it */
+GGINLINE Vector3 GGV3Make(double x, double y, double z)
+{
+	Vector3 v;
+	v.x = x;  v.y = y;  v.z = z;
+	return(v);
+}
+
+/* multiply a point by a matrix and return the transformed point */
+GGINLINE Point3 *GGV3MulPointByMatrix(const Point3 *pin, const Matrix3 *m,
+				      Point3 *pout)
+{
+	double x = pin->x, y = pin->y, z = pin->z;
+	pout->x = (x * m->element[0][0]) + (y * m->element[1][0]) +
+		(z * m->element[2][0]);
+	pout->y = (x * m->element[0][1]) + (y * m->element[1][1]) +
+		(z * m->element[2][1]);
+	pout->z = (x * m->element[0][2]) + (y * m->element[1][2]) +
+		(z * m->element[2][2]);
+	return(pout);
+}
+
+/* multiply a point by a projective matrix and return the transformed point */
+GGINLINE Point3 *GGV3MulPointByProjMatrix(const Point3 *pin, const Matrix4 *m,
+					  Point3 *pout)
+{
+	double x = pin->x, y = pin->y, z = pin->z, w;
+	pout->x = (x * m->element[0][0]) + (y * m->element[1][0]) +
+		(z * m->element[2][0]) + m->element[3][0];
+	pout->y = (x * m->element[0][1]) + (y * m->element[1][1]) +
+		(z * m->element[2][1]) + m->element[3][1];
+	pout->z = (x * m->element[0][2]) + (y * m->element[1][2]) +
+		(z * m->element[2][2]) + m->element[3][2];
+	w =    (x * m->element[0][3]) + (y * m->element[1][3]) +
+		(z * m->element[2][3]) + m->element[3][3];
+	if (w != 0.0) { pout->x /= w;  pout->y /= w;  pout->z /= w; }
+	return(pout);
+}
+
+/* multiply together matrices c = ab */
+/* note that c must not point to either of the input matrices */
+GGINLINE Matrix4 *GGV3MatMul(const Matrix4 *a, const Matrix4 *b, Matrix4 *c)
+{
+	int i, k;
+#ifdef GG_SSE2
+	for (i=0; i<4; i++) {		/* row i of c, two columns at once */
+		__m128d c01 = _mm_setzero_pd(), c23 = _mm_setzero_pd();
+		for (k=0; k<4; k++) {
+			__m128d aik = _mm_set1_pd(a->element[i][k]);
+			c01 = _mm_add_pd(c01,
+				_mm_mul_pd(aik, _mm_loadu_pd(&b->element[k][0])));
+			c23 = _mm_add_pd(c23,
+				_mm_mul_pd(aik, _mm_loadu_pd(&b->element[k][2])));
+		}
+		_mm_storeu_pd(&c->element[i][0], c01);
+		_mm_storeu_pd(&c->element[i][2], c23);
+	}
+#else
+	int j;
+	for (i=0; i<4; i++)
+		for (j=0; j<4; j++) {
+			c->element[i][j] = 0;
+			for (k=0; k<4; k++) c->element[i][j] +=
+				a->element[i][k] * b->element[k][j];
+		}
+#endif
+	return(c);
+}
+
+
+/*******************/
+/*   batch forms   */
+/*******************/
+
+/* pout[i] = pin[i] transformed by the projective matrix m, i < n */
+GGINLINE Point2 *V2MulPointsByProjMatrix(int n, const Point2 *pin,
+					 const Matrix3 *m, Point2 *pout)
+{
+	int i;
+	for (i=0; i<n; i++) GGV2MulPointByProjMatrix(&pin[i], m, &pout[i]);
+	return(pout);
+}
+
+/* pout[i] = pin[i] transformed by the matrix m, i < n */
+GGINLINE Point3 *V3MulPointsByMatrix(int n, const Point3 *pin,
+				     const Matrix3 *m, Point3 *pout)
+{
+	int i;
+#ifdef GG_SSE2
+	__m128d r0 = _mm_loadu_pd(&m->element[0][0]);	/* x and y columns */
+	__m128d r1 = _mm_loadu_pd(&m->element[1][0]);
+	__m128d r2 = _mm_loadu_pd(&m->element[2][0]);
+	double m02 = m->element[0][2], m12 = m->element[1][2],
+	       m22 = m->element[2][2];
+	for (i=0; i<n; i++) {
+		double x = pin[i].x, y = pin[i].y, z = pin[i].z;
+		__m128d xy = _mm_add_pd(_mm_add_pd(
+			_mm_mul_pd(_mm_set1_pd(x), r0),
+			_mm_mul_pd(_mm_set1_pd(y), r1)),
+			_mm_mul_pd(_mm_set1_pd(z), r2));
+		_mm_storeu_pd(&pout[i].x, xy);
+		pout[i].z = (x * m02) + (y * m12) + (z * m22);
+	}
+#else
+	for (i=0; i<n; i++) GGV3MulPointByMatrix(&pin[i], m, &pout[i]);
+#endif
+	return(pout);
+}
+
+/* pout[i] = pin[i] transformed by the projective matrix m, i < n */
+GGINLINE Point3 *V3MulPointsByProjMatrix(int n, const Point3 *pin,
+					 const Matrix4 *m, Point3 *pout)
+{
+	int i;
+#ifdef GG_SSE2
+	__m128d r0 = _mm_loadu_pd(&m->element[0][0]);	/* x and y columns */
+	__m128d r1 = _mm_loadu_pd(&m->element[1][0]);
+	__m128d r2 = _mm_loadu_pd(&m->element[2][0]);
+	__m128d r3 = _mm_loadu_pd(&m->element[3][0]);
+	__m128d s0 = _mm_loadu_pd(&m->element[0][2]);	/* z and w columns */
+	__m128d s1 = _mm_loadu_pd(&m->element[1][2]);
+	__m128d s2 = _mm_loadu_pd(&m->element[2][2]);
+	__m128d s3 = _mm_loadu_pd(&m->element[3][2]);
+	for (i=0; i<n; i++) {
+		__m128d x = _mm_set1_pd(pin[i].x), y = _mm_set1_pd(pin[i].y),
+			z = _mm_set1_pd(pin[i].z);
+		__m128d xy = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+			_mm_mul_pd(x, r0), _mm_mul_pd(y, r1)),
+			_mm_mul_pd(z, r2)), r3);
+		__m128d zw = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+			_mm_mul_pd(x, s0), _mm_mul_pd(y, s1)),
+			_mm_mul_pd(z, s2)), s3);
+		double w = _mm_cvtsd_f64(_mm_unpackhi_pd(zw, zw));
+		if (w != 0.0) {
+			__m128d ww = _mm_set1_pd(w);
+			xy = _mm_div_pd(xy, ww);
+			zw = _mm_div_pd(zw, ww);
+		}
+		_mm_storeu_pd(&pout[i].x, xy);
+		pout[i].z = _mm_cvtsd_f64(zw);
+	}
+#else
+	for (i=0; i<n; i++) GGV3MulPointByProjMatrix(&pin[i], m, &pout[i]);
+#endif
+	return(pout);
+}
+
+/* c[i] = (a[i] * ascl) + (b[i] * bscl), i < n; the arrays are taken as
+ * 3n doubles, two at a time */
+GGINLINE Vector3 *V3CombineVectors(int n, const Vector3 *a, const Vector3 *b,
+				   Vector3 *c, double ascl, double bscl)
+{
+	const double *pa = &a[0].x, *pb = &b[0].x;
+	double *pc = &c[0].x;
+	int i = 0;
+#ifdef GG_SSE2
+	__m128d sa = _mm_set1_pd(ascl), sb = _mm_set1_pd(bscl);
+	for (; i+2<=3*n; i+=2)
+		_mm_storeu_pd(pc+i, _mm_add_pd(
+			_mm_mul_pd(sa, _mm_loadu_pd(pa+i)),
+			_mm_mul_pd(sb, _mm_loadu_pd(pb+i))));
+#endif
+	for (; i<3*n; i++) pc[i] = (ascl * pa[i]) + (bscl * pb[i]);
+	return(c);
+}
+
+/* c[i] = a[i]+b[i], i < n */
+GGINLINE Vector3 *V3AddVectors(int n, const Vector3 *a, const Vector3 *b,
+			       Vector3 *c)
+{
+	const double *pa = &a[0].x, *pb = &b[0].x;
+	double *pc = &c[0].x;
+	int i = 0;
+#ifdef GG_SSE2
+	for (; i+2<=3*n; i+=2)
+		_mm_storeu_pd(pc+i, _mm_add_pd(_mm_loadu_pd(pa+i),
+					       _mm_loadu_pd(pb+i)));
+#endif
+	for (; i<3*n; i++) pc[i] = pa[i]+pb[i];
+	return(c);
+}
+
+/* c[i] = a[i]-b[i], i < n */
+GGINLINE Vector3 *V3SubVectors(int n, const Vector3 *a, const Vector3 *b,
+			       Vector3 *c)
+{
+	const double *pa = &a[0].x, *pb = &b[0].x;
+	double *pc = &c[0].x;
+	int i = 0;
+#ifdef GG_SSE2
+	for (; i+2<=3*n; i+=2)
+		_mm_storeu_pd(pc+i, _mm_sub_pd(_mm_loadu_pd(pa+i),
+					       _mm_loadu_pd(pb+i)));
+#endif
+	for (; i<3*n; i++) pc[i] = pa[i]-pb[i];
+	return(c);
+}
+
+/* d[i] = a[i] . b[i], i < n */
+GGINLINE double *V3DotVectors(int n, const Vector3 *a, const Vector3 *b,
+			      double *d)
+{
+	int i;
+	for (i=0; i<n; i++) d[i] = GGV3Dot(&a[i], &b[i]);
+	return(d);
+}
+
+/* c[i] = a[i] cross b[i], i < n */
+GGINLINE Vector3 *V3CrossVectors(int n, const Vector3 *a, const Vector3 *b,
+				 Vector3 *c)
+{
+	int i;
+	for (i=0; i<n; i++) GGV3Cross(&a[i], &b[i], &c[i]);
+	return(c);
+}
+
+/* normalizes v[i], i < n */
+GGINLINE Vector3 *V3NormalizeVectors(int n, Vector3 *v)
+{
+	int i;
+	for (i=0; i<n; i++) GGV3Normalize(&v[i]);
+	return(v);
+}
+
+#endif
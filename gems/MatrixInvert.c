@@ -10,6 +10,7 @@ from "Graphics Gems", Academic Press, 1990
 #define SMALL_NUMBER	1.e-8
 
 #include "GraphicsGems.h"
+#include "MatrixInvert.h"
 #include <math.h>
 
 /*
@@ -181,3 +182,117 @@ void inverse(Matrix4* in, Matrix4* out )
 	    out->element[i][j] = out->element[i][j] / det;
 }
 
+
+/* 
+ *   nsingular = inverseBatch( n, in, out, singular, kind )
+ *   nsingular = inverseBatchf( n, in, out, singular, kind )
+ *
+ *    invert the n matrices in[] into out[], which may be in[], several
+ *    at a time with SSE or AVX where the compiler has them.  kind says
+ *    what may be assumed of the matrices (MatrixInvert.h): the inverse of
+ *    an affine matrix needs only the 3x3 part and the translation, that
+ *    of an orthonormal one is the transpose (see MatrixOrtho.c for
+ *    keeping matrices orthonormal).  Instead of stopping at a singular
+ *    matrix, as inverse() does, its adjoint is left in out[i], singular[i]
+ *    (when singular is not NULL) is set to 1, and the number of singular
+ *    matrices is returned.
+ */
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MI_SSE2
+#endif
+
+#define REAL	double
+#define MATRIX	Matrix4
+#define BATCH	inverseBatch
+#define GENERAL	inverseGeneral
+#define AFFINE	inverseAffine
+#define ORTHO	inverseOrtho
+#if defined(__AVX__)
+#define VEC	__m256d
+#define W	4
+#define VLOAD	_mm256_loadu_pd
+#define VSTORE	_mm256_storeu_pd
+#define VSET1	_mm256_set1_pd
+#define VADD	_mm256_add_pd
+#define VSUB	_mm256_sub_pd
+#define VMUL	_mm256_mul_pd
+#define VDIV	_mm256_div_pd
+#elif defined(MI_SSE2)
+#define VEC	__m128d
+#define W	2
+#define VLOAD	_mm_loadu_pd
+#define VSTORE	_mm_storeu_pd
+#define VSET1	_mm_set1_pd
+#define VADD	_mm_add_pd
+#define VSUB	_mm_sub_pd
+#define VMUL	_mm_mul_pd
+#define VDIV	_mm_div_pd
+#else					/* one matrix at a time */
+#define VEC	REAL
+#define W	1
+#define VLOAD(p)	(*(p))
+#define VSTORE(p,v)	(*(p) = (v))
+#define VSET1(x)	((REAL)(x))
+#define VADD(a,b)	((a)+(b))
+#define VSUB(a,b)	((a)-(b))
+#define VMUL(a,b)	((a)*(b))
+#define VDIV(a,b)	((a)/(b))
+#endif
+#include "MatrixInvertSoA.h"
+#undef REAL
+#undef MATRIX
+#undef BATCH
+#undef GENERAL
+#undef AFFINE
+#undef ORTHO
+
+#define REAL	float
+#define MATRIX	Matrix4f
+#define BATCH	inverseBatchf
+#define GENERAL	inverseGeneralf
+#define AFFINE	inverseAffinef
+#define ORTHO	inverseOrthof
+#if defined(__AVX__)
+#undef VEC
+#undef W
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#define VEC	__m256
+#define W	8
+#define VLOAD	_mm256_loadu_ps
+#define VSTORE	_mm256_storeu_ps
+#define VSET1	_mm256_set1_ps
+#define VADD	_mm256_add_ps
+#define VSUB	_mm256_sub_ps
+#define VMUL	_mm256_mul_ps
+#define VDIV	_mm256_div_ps
+#elif defined(MI_SSE2)
+#undef VEC
+#undef W
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#define VEC	__m128
+#define W	4
+#define VLOAD	_mm_loadu_ps
+#define VSTORE	_mm_storeu_ps
+#define VSET1	_mm_set1_ps
+#define VADD	_mm_add_ps
+#define VSUB	_mm_sub_ps
+#define VMUL	_mm_mul_ps
+#define VDIV	_mm_div_ps
+#endif
+#include "MatrixInvertSoA.h"
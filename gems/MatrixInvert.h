@@ -2,3 +2,18 @@
 
 double det4x4(Matrix4* m);
 void inverse(Matrix4* in, Matrix4* out);
+
+/* 4-by-4 matrix of floats, for inverseBatchf() */
+typedef struct Matrix4fStruct {
+	float element[4][4];
+} Matrix4f;
+
+/* what inverseBatch() may assume of its matrices */
+#define MATRIX_GENERAL		0	/* any */
+#define MATRIX_AFFINE		1	/* last column 0, 0, 0, 1 */
+#define MATRIX_ORTHONORMAL	2	/* affine, upper 3x3 orthonormal */
+
+int inverseBatch(int n, const Matrix4 *in, Matrix4 *out,
+		 unsigned char *singular, int kind);
+int inverseBatchf(int n, const Matrix4f *in, Matrix4f *out,
+		  unsigned char *singular, int kind);
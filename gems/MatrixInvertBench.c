@@ -0,0 +1,148 @@
+/*
+ * MatrixInvertBench.c
+ * times inverse() against inverseBatch() and inverseBatchf() on general,
+ * affine and orthonormal matrices, and reports the largest error of
+ * A times its inverse against the identity.
+ *
+ * Usage: MatrixInvertBench [matrices [repetitions]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "GraphicsGems.h"
+#include "MatrixInvert.h"
+
+static double uniform(void)
+{
+    return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+static double seconds(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* random matrix of the given kind */
+static void makeMatrix(Matrix4 *m, int kind)
+{
+    int i, j;
+
+    if (kind == MATRIX_GENERAL) {
+	for (i=0; i<4; i++)
+	    for (j=0; j<4; j++)
+		m->element[i][j] = uniform() + (i == j ? 4.0 : 0.0);
+	return;
+    }
+    if (kind == MATRIX_ORTHONORMAL) {	/* rotation about a random axis */
+	double x = uniform(), y = uniform(), z = uniform(), a = 3.0*uniform();
+	double l = sqrt(x*x + y*y + z*z), c = cos(a), s = sin(a), t = 1-c;
+	if (l == 0.0) x = l = 1.0;
+	x /= l;  y /= l;  z /= l;
+	m->element[0][0] = t*x*x + c;   m->element[0][1] = t*x*y + s*z;
+	m->element[0][2] = t*x*z - s*y;
+	m->element[1][0] = t*x*y - s*z; m->element[1][1] = t*y*y + c;
+	m->element[1][2] = t*y*z + s*x;
+	m->element[2][0] = t*x*z + s*y; m->element[2][1] = t*y*z - s*x;
+	m->element[2][2] = t*z*z + c;
+    } else
+	for (i=0; i<3; i++)
+	    for (j=0; j<3; j++)
+		m->element[i][j] = uniform() + (i == j ? 3.0 : 0.0);
+    for (j=0; j<3; j++) {
+	m->element[3][j] = 10.0 * uniform();
+	m->element[j][3] = 0.0;
+    }
+    m->element[3][3] = 1.0;
+}
+
+/* largest |a b - I| */
+static double error(const Matrix4 *a, const Matrix4 *b)
+{
+    double e = 0.0, s;
+    int i, j, k;
+
+    for (i=0; i<4; i++)
+	for (j=0; j<4; j++) {
+	    for (s = (i == j ? -1.0 : 0.0), k=0; k<4; k++)
+		s += a->element[i][k] * b->element[k][j];
+	    if (fabs(s) > e) e = fabs(s);
+	}
+    return e;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *names[3] = { "general", "affine", "orthonormal" };
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    int reps = argc > 2 ? atoi(argv[2]) : 10;
+    Matrix4 *in = (Matrix4 *)malloc(n * sizeof(Matrix4));
+    Matrix4 *out = (Matrix4 *)malloc(n * sizeof(Matrix4));
+    Matrix4f *inf = (Matrix4f *)malloc(n * sizeof(Matrix4f));
+    Matrix4f *outf = (Matrix4f *)malloc(n * sizeof(Matrix4f));
+    unsigned char *singular = (unsigned char *)malloc(n);
+    int kind, i, j, r;
+
+    if (!in || !out || !inf || !outf || !singular) {
+	fprintf(stderr, "?Unable to malloc\n");
+	exit(1);
+    }
+    printf("%d matrices, %d repetitions\n", n, reps);
+    printf("%-12s %-24s %14s %10s\n", "matrices", "routine",
+	   "matrices/s", "error");
+    srand(1);
+    for (kind = MATRIX_GENERAL; kind <= MATRIX_ORTHONORMAL; kind++) {
+	double t, e;
+	for (i=0; i<n; i++) {
+	    makeMatrix(&in[i], kind);
+	    for (j=0; j<16; j++)
+		inf[i].element[j/4][j%4] = (float)in[i].element[j/4][j%4];
+	}
+
+	t = seconds();
+	for (r=0; r<reps; r++)
+	    for (i=0; i<n; i++)
+		inverse(&in[i], &out[i]);
+	t = seconds() - t;
+	for (e = 0.0, i=0; i<n; i++)
+	    if (error(&in[i], &out[i]) > e) e = error(&in[i], &out[i]);
+	printf("%-12s %-24s %14.0f %10.3g\n", names[kind], "inverse()",
+	       (double)n * reps / t, e);
+
+	for (j = MATRIX_GENERAL; j <= kind; j++) {
+	    char label[32];
+	    t = seconds();
+	    for (r=0; r<reps; r++)
+		inverseBatch(n, in, out, singular, j);
+	    t = seconds() - t;
+	    for (e = 0.0, i=0; i<n; i++)
+		if (error(&in[i], &out[i]) > e) e = error(&in[i], &out[i]);
+	    sprintf(label, "inverseBatch(%s)", names[j]);
+	    printf("%-12s %-24s %14.0f %10.3g\n", names[kind], label,
+		   (double)n * reps / t, e);
+
+	    t = seconds();
+	    for (r=0; r<reps; r++)
+		inverseBatchf(n, inf, outf, singular, j);
+	    t = seconds() - t;
+	    for (e = 0.0, i=0; i<n; i++) {
+		Matrix4 b;
+		int k;
+		for (k=0; k<16; k++)
+		    b.element[k/4][k%4] = outf[i].element[k/4][k%4];
+		if (error(&in[i], &b) > e) e = error(&in[i], &b);
+	    }
+	    sprintf(label, "inverseBatchf(%s)", names[j]);
+	    printf("%-12s %-24s %14.0f %10.3g\n", names[kind], label,
+		   (double)n * reps / t, e);
+	}
+    }
+
+    /* a singular matrix is flagged, not fatal */
+    for (i=0; i<16; i++)
+	in[0].element[i/4][i%4] = (double)(i % 4);
+    printf("singular matrices flagged: %d of 1\n",
+	   inverseBatch(1, in, out, singular, MATRIX_GENERAL));
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * MatrixInvertSoA.h
+ *
+ * Body of inverseBatch() and inverseBatchf(), included by MatrixInvert.c
+ * once for doubles and once for floats.  Before each inclusion REAL,
+ * MATRIX and BATCH name the scalar, the matrix type and the function,
+ * and VEC, W, VLOAD, VSTORE, VSET1, VADD, VSUB, VMUL and VDIV a vector
+ * of W scalars and its operations.
+ *
+ * W matrices at a time are taken apart into 16 vectors, one for each
+ * element (structure of arrays), so the cofactor expansion below works on
+ * W matrices with each operation.
+ */
+
+/*
+ * The twelve 2x2 determinants of rows 0,1 and rows 2,3 give both the
+ * determinant and the adjoint of a 4x4 matrix (Laplace expansion).
+ */
+static void GENERAL( REAL m[16][W], REAL r[16][W], REAL det[W] )
+{
+#define M(i,j)	VLOAD(m[4*(i)+(j)])
+#define D2(a,b,c,d)	VSUB(VMUL(a,d), VMUL(b,c))
+    VEC s0 = D2(M(0,0), M(1,0), M(0,1), M(1,1));
+    VEC s1 = D2(M(0,0), M(1,0), M(0,2), M(1,2));
+    VEC s2 = D2(M(0,0), M(1,0), M(0,3), M(1,3));
+    VEC s3 = D2(M(0,1), M(1,1), M(0,2), M(1,2));
+    VEC s4 = D2(M(0,1), M(1,1), M(0,3), M(1,3));
+    VEC s5 = D2(M(0,2), M(1,2), M(0,3), M(1,3));
+    VEC c5 = D2(M(2,2), M(3,2), M(2,3), M(3,3));
+    VEC c4 = D2(M(2,1), M(3,1), M(2,3), M(3,3));
+    VEC c3 = D2(M(2,1), M(3,1), M(2,2), M(3,2));
+    VEC c2 = D2(M(2,0), M(3,0), M(2,3), M(3,3));
+    VEC c1 = D2(M(2,0), M(3,0), M(2,2), M(3,2));
+    VEC c0 = D2(M(2,0), M(3,0), M(2,1), M(3,1));
+    VEC d = VSUB(VSUB(VADD(VADD(VADD(VMUL(s0,c5), VMUL(s2,c3)),
+	VMUL(s3,c2)), VMUL(s5,c0)), VMUL(s1,c4)), VMUL(s4,c1));
+#define T3(k, x,a, y,b, z,c)	VSTORE(r[k], \
+	VADD(VSUB(VMUL(M x,a), VMUL(M y,b)), VMUL(M z,c)))
+#define N3(k, x,a, y,b, z,c)	VSTORE(r[k], \
+	VSUB(VSUB(VMUL(M y,b), VMUL(M x,a)), VMUL(M z,c)))
+    T3( 0, (1,1),c5, (1,2),c4, (1,3),c3);
+    N3( 1, (0,1),c5, (0,2),c4, (0,3),c3);
+    T3( 2, (3,1),s5, (3,2),s4, (3,3),s3);
+    N3( 3, (2,1),s5, (2,2),s4, (2,3),s3);
+    N3( 4, (1,0),c5, (1,2),c2, (1,3),c1);
+    T3( 5, (0,0),c5, (0,2),c2, (0,3),c1);
+    N3( 6, (3,0),s5, (3,2),s2, (3,3),s1);
+    T3( 7, (2,0),s5, (2,2),s2, (2,3),s1);
+    T3( 8, (1,0),c4, (1,1),c2, (1,3),c0);
+    N3( 9, (0,0),c4, (0,1),c2, (0,3),c0);
+    T3(10, (3,0),s4, (3,1),s2, (3,3),s0);
+    N3(11, (2,0),s4, (2,1),s2, (2,3),s0);
+    N3(12, (1,0),c3, (1,1),c1, (1,2),c0);
+    T3(13, (0,0),c3, (0,1),c1, (0,2),c0);
+    N3(14, (3,0),s3, (3,1),s1, (3,2),s0);
+    T3(15, (2,0),s3, (2,1),s1, (2,2),s0);
+    VSTORE(det, d);
+#undef T3
+#undef N3
+}
+
+/*
+ * An affine matrix has 0, 0, 0, 1 in its last column; its inverse is
+ * the inverse A' of the upper 3x3 part A, and the translation -tA'.
+ */
+static void AFFINE( REAL m[16][W], REAL r[16][W], REAL det[W] )
+{
+    VEC c00 = D2(M(1,1), M(2,1), M(1,2), M(2,2));
+    VEC c01 = D2(M(1,2), M(2,2), M(1,0), M(2,0));
+    VEC c02 = D2(M(1,0), M(2,0), M(1,1), M(2,1));
+    VEC d = VADD(VADD(VMUL(M(0,0),c00), VMUL(M(0,1),c01)), VMUL(M(0,2),c02));
+    VEC zero = VSET1(0);
+    VEC a[9];
+    int i, j;
+
+    a[0] = c00;
+    a[1] = D2(M(2,1), M(0,1), M(2,2), M(0,2));
+    a[2] = D2(M(0,1), M(1,1), M(0,2), M(1,2));
+    a[3] = c01;
+    a[4] = D2(M(0,0), M(2,0), M(0,2), M(2,2));
+    a[5] = D2(M(1,0), M(0,0), M(1,2), M(0,2));
+    a[6] = c02;
+    a[7] = D2(M(2,0), M(0,0), M(2,1), M(0,1));
+    a[8] = D2(M(0,0), M(1,0), M(0,1), M(1,1));
+    for (i=0; i<3; i++) {
+	for (j=0; j<3; j++)
+	    VSTORE(r[4*i+j], a[3*i+j]);
+	VSTORE(r[4*i+3], zero);
+    }
+    for (j=0; j<3; j++)		/* translation, times det */
+	VSTORE(r[12+j], VSUB(zero, VADD(VADD(VMUL(M(3,0),a[j]),
+	    VMUL(M(3,1),a[3+j])), VMUL(M(3,2),a[6+j]))));
+    VSTORE(r[15], d);		/* divided by det below */
+    VSTORE(det, d);
+}
+
+/*
+ * An orthonormal matrix has the transpose A' of its upper 3x3 part A
+ * as the inverse of that part; the translation is -tA' again.
+ */
+static void ORTHO( REAL m[16][W], REAL r[16][W] )
+{
+    VEC zero = VSET1(0);
+    int i, j;
+
+    for (i=0; i<3; i++) {
+	for (j=0; j<3; j++)
+	    VSTORE(r[4*i+j], M(j,i));
+	VSTORE(r[4*i+3], zero);
+	VSTORE(r[12+i], VSUB(zero, VADD(VADD(VMUL(M(3,0),M(i,0)),
+	    VMUL(M(3,1),M(i,1))), VMUL(M(3,2),M(i,2)))));
+    }
+    VSTORE(r[15], VSET1(1));
+#undef M
+#undef D2
+}
+
+int BATCH( int n, const MATRIX *in, MATRIX *out, unsigned char *singular,
+	   int kind )
+{
+    REAL m[16][W], r[16][W], det[W], div[W];
+    int i, k, l, w, nsingular = 0;
+
+    for (i=0; i<n; i+=W) {
+	w = n-i < W ? n-i : W;
+	for (l=0; l<W; l++) {	/* short last block: repeat its first */
+	    const REAL *a = &in[i + (l < w ? l : 0)].element[0][0];
+	    for (k=0; k<16; k++)
+		m[k][l] = a[k];
+	}
+	if (kind == MATRIX_ORTHONORMAL) {	/* nothing to divide */
+	    ORTHO(m, r);
+	    for (l=0; l<W; l++)
+		det[l] = 1;
+	} else {
+	    if (kind == MATRIX_AFFINE)
+		AFFINE(m, r, det);
+	    else
+		GENERAL(m, r, det);
+	    for (l=0; l<W; l++)	/* singular ones keep the adjoint */
+		div[l] = fabs(det[l]) < SMALL_NUMBER ? 1 : det[l];
+	    {
+		VEC dv = VLOAD(div);
+		for (k=0; k<16; k++)
+		    VSTORE(r[k], VDIV(VLOAD(r[k]), dv));
+	    }
+	}
+	for (l=0; l<w; l++) {
+	    REAL *b = &out[i+l].element[0][0];
+	    int s = fabs(det[l]) < SMALL_NUMBER;
+	    for (k=0; k<16; k++)
+		b[k] = r[k][l];
+	    if (singular) singular[i+l] = (unsigned char)s;
+	    nsingular += s;
+	}
+    }
+    return nsingular;
+}
@@ -25,6 +25,8 @@
  */
 
 #include    <math.h>
+#include    <float.h>
+#include    "Roots3And4.h"
 #ifndef M_PI
 #define M_PI          3.14159265358979323846
 #endif
@@ -241,3 +243,304 @@ int SolveQuartic(c, s)
     return num;
 }
 
+
+
+/*
+ *   hits = SolveCubicBatch( n, c, s, num )
+ *   hits = SolveQuarticBatch( n, c, s, num )
+ *
+ *    the roots of the n cubics or quartics c[], as SolveCubic() and
+ *    SolveQuartic() give them: num[i] roots of c[i] in s[i], in the same
+ *    order.  With SSE2 or AVX, 2 or 4 polynomials are solved at a time
+ *    (without, they are passed to SolveCubic() and SolveQuartic());
+ *    every case of Cardano's and Ferrari's formulas is worked out for
+ *    all of them and the roots picked with masks.  cbrt(), acos() and
+ *    cos() are replaced by Newton's iterations, so no library call is
+ *    made, and the roots may differ from those of SolveCubic() in the
+ *    last bits.  The number of polynomials with a real root is returned.
+ */
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#if defined(__AVX__)
+#include    <immintrin.h>
+#else
+#include    <emmintrin.h>
+#endif
+
+/*  a >= 0 to within 3.5% of 1/cbrt(a), from the high words of a: the
+    exponent divided by 3 and negated, plus a bias */
+
+#define CBRT_BIAS	0x553ef0fe
+
+static __m128d cbrtStart( __m128d a )
+{
+    __m128i h = _mm_srli_epi64(_mm_castpd_si128(a), 32);
+
+    h = _mm_srli_epi64(_mm_mul_epu32(h, _mm_set1_epi32((int)0xaaaaaaab)), 33);
+    h = _mm_sub_epi32(_mm_set_epi32(0, CBRT_BIAS, 0, CBRT_BIAS), h);
+    return _mm_castsi128_pd(_mm_slli_epi64(h, 32));
+}
+
+#if defined(__AVX__)
+#define VEC	__m256d
+#define VMASK	__m256d
+#define W	4
+#define VLOAD	_mm256_loadu_pd
+#define VSTORE	_mm256_storeu_pd
+#define VSET1	_mm256_set1_pd
+#define VADD	_mm256_add_pd
+#define VSUB	_mm256_sub_pd
+#define VMUL	_mm256_mul_pd
+#define VDIV	_mm256_div_pd
+#define VSQRT	_mm256_sqrt_pd
+#define VMIN	_mm256_min_pd
+#define VMAX	_mm256_max_pd
+#define VLT(a,b)	_mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define VAND	_mm256_and_pd
+#define VSEL(m,a,b)	_mm256_blendv_pd(b, a, m)
+#define VCBRT0(a)	_mm256_insertf128_pd(_mm256_castpd128_pd256( \
+	cbrtStart(_mm256_castpd256_pd128(a))), \
+	cbrtStart(_mm256_extractf128_pd(a, 1)), 1)
+#else
+#define VEC	__m128d
+#define VMASK	__m128d
+#define W	2
+#define VLOAD	_mm_loadu_pd
+#define VSTORE	_mm_storeu_pd
+#define VSET1	_mm_set1_pd
+#define VADD	_mm_add_pd
+#define VSUB	_mm_sub_pd
+#define VMUL	_mm_mul_pd
+#define VDIV	_mm_div_pd
+#define VSQRT	_mm_sqrt_pd
+#define VMIN	_mm_min_pd
+#define VMAX	_mm_max_pd
+#define VLT	_mm_cmplt_pd
+#define VAND	_mm_and_pd
+#define VSEL(m,a,b)	_mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b))
+#define VCBRT0		cbrtStart
+#endif
+#define VNEG(a)		VSUB(VSET1(0), a)
+#define VZERO(a)	VAND(VLT(VSET1(-EQN_EPS), a), VLT(a, VSET1(EQN_EPS)))
+
+/* cube roots: x |x|^(-2/3), by Newton's iteration for |x|^(-1/3) */
+static VEC cbrtBatch( VEC x )
+{
+    VEC ax = VMAX(x, VNEG(x)), z = VCBRT0(ax);
+    int k;
+
+    for (k=0; k<4; k++)		/* z (4 - |x| z^3) / 3 */
+	z = VMUL(VMUL(z, VSUB(VSET1(4), VMUL(ax, VMUL(VMUL(z, z), z)))),
+		 VSET1(1.0/3));
+    return VMUL(x, VMUL(z, z));
+}
+
+/* W cubics in the columns of c[], as SolveCubic() */
+static void cubicBatch( double c[4][W], double s[3][W], int num[W] )
+{
+    VEC A = VDIV(VLOAD(c[2]), VLOAD(c[3]));
+    VEC B = VDIV(VLOAD(c[1]), VLOAD(c[3]));
+    VEC C = VDIV(VLOAD(c[0]), VLOAD(c[3]));
+    VEC sq_A = VMUL(A, A);
+    VEC p = VMUL(VSET1(1.0/3), VADD(VMUL(VSET1(- 1.0/3), sq_A), B));
+    VEC q = VMUL(VSET1(1.0/2), VADD(VSUB(VMUL(VMUL(VSET1(2.0/27), A), sq_A),
+	VMUL(VMUL(VSET1(1.0/3), A), B)), C));
+    VEC cb_p = VMUL(VMUL(p, p), p);
+    VEC D = VADD(VMUL(q, q), cb_p);
+    VEC zero = VSET1(0), sub = VMUL(VSET1(1.0/3), A);
+    VEC sqrt_D, u, v, x, t, e, cos_phi, sin_phi, s0, s1, s2;
+    VMASK zero_D = VZERO(D), zero_q = VZERO(q), three = VLT(D, zero);
+    double Ds[W], qs[W];
+    int k, l;
+
+    /* one real solution, or (D = 0) one single and one double */
+
+    sqrt_D = VSQRT(VMAX(D, zero));
+    u = cbrtBatch(VSEL(zero_D, VNEG(q), VSUB(sqrt_D, q)));
+    v = VNEG(cbrtBatch(VADD(sqrt_D, q)));
+
+    /*  casus irreducibilis: with x = cos(3 phi) = -q / sqrt(-cb_p),
+	cos(phi) = 1/2 + e where e^2 (6 + 4e) = 1 + x.  e is near
+	t (0.57735 - 0.11076t + ...), t = sqrt((1 + x)/2) */
+
+    x = VDIV(VNEG(q), VSQRT(VMAX(VNEG(cb_p), zero)));
+    x = VADD(VSET1(1), VMAX(VMIN(x, VSET1(1)), VSET1(-1)));
+    t = VSQRT(VMUL(VSET1(0.5), x));
+    e = VMUL(t, VADD(VSET1(0.5773437858709167), VMUL(t,
+	VADD(VSET1(-0.11076369213317902), VMUL(t,
+	VADD(VSET1(0.050361007826571894), VMUL(t,
+	VADD(VSET1(-0.022464815108049173),
+	     VMUL(t, VSET1(0.005528644517148882))))))))));
+    for (k=0; k<2; k++)
+	e = VSUB(e, VDIV(
+	    VSUB(VMUL(VMUL(e, e), VADD(VSET1(6), VMUL(VSET1(4), e))), x),
+	    VMAX(VMUL(VMUL(VSET1(12), e), VADD(VSET1(1), e)), VSET1(DBL_MIN))));
+    cos_phi = VADD(VSET1(0.5), e);
+    sin_phi = VSQRT(VMAX(VMUL(VSUB(VSET1(0.5), e), VADD(VSET1(1.5), e)), zero));
+    t = VMUL(VSET1(2), VSQRT(VMAX(VNEG(p), zero)));
+
+    /* cos(phi -+ pi/3) = cos(phi)/2 +- sin(phi) sqrt(3)/2 */
+
+    s0 = VMUL(t, cos_phi);
+    cos_phi = VMUL(VSET1(0.5), cos_phi);
+    sin_phi = VMUL(VSET1(0.86602540378443864676), sin_phi);
+    s1 = VNEG(VMUL(t, VSUB(cos_phi, sin_phi)));
+    s2 = VNEG(VMUL(t, VADD(cos_phi, sin_phi)));
+
+    s0 = VSEL(zero_D, VSEL(zero_q, zero, VADD(u, u)),
+	      VSEL(three, s0, VADD(u, v)));
+    s1 = VSEL(zero_D, VNEG(u), s1);
+
+    /* resubstitute */
+
+    VSTORE(s[0], VSUB(s0, sub));
+    VSTORE(s[1], VSUB(s1, sub));
+    VSTORE(s[2], VSUB(s2, sub));
+
+    VSTORE(Ds, D);
+    VSTORE(qs, q);
+    for (l=0; l<W; l++)
+	num[l] = IsZero(Ds[l]) ? (IsZero(qs[l]) ? 1 : 2) : Ds[l] < 0 ? 3 : 1;
+}
+
+/* W quartics in the columns of c[], as SolveQuartic() */
+static void quarticBatch( double c[5][W], double s[4][W], int num[W] )
+{
+    VEC A = VDIV(VLOAD(c[3]), VLOAD(c[4]));
+    VEC B = VDIV(VLOAD(c[2]), VLOAD(c[4]));
+    VEC C = VDIV(VLOAD(c[1]), VLOAD(c[4]));
+    VEC D = VDIV(VLOAD(c[0]), VLOAD(c[4]));
+    VEC sq_A = VMUL(A, A);
+    VEC p = VADD(VMUL(VSET1(- 3.0/8), sq_A), B);
+    VEC q = VADD(VSUB(VMUL(VMUL(VSET1(1.0/8), sq_A), A),
+	VMUL(VMUL(VSET1(1.0/2), A), B)), C);
+    VEC r = VADD(VSUB(VADD(VMUL(VMUL(VSET1(- 3.0/256), sq_A), sq_A),
+	VMUL(VMUL(VSET1(1.0/16), sq_A), B)), VMUL(VMUL(VSET1(1.0/4), A), C)), D);
+    VEC zero = VSET1(0), sub = VMUL(VSET1(1.0/4), A);
+    VEC z, u, v, p1, d1, d2, sq1, sq2;
+    VMASK zero_r = VZERO(r);
+    double coeffs[4][W], y[3][W], x[5][W], rs[W], us[W], vs[W], D1[W], D2[W];
+    int cnum[W], j, k, l;
+
+    /*  y(y^3 + py + q) = 0 where r = 0, else the resolvent cubic; its
+	first root builds two quadrics */
+
+    VSTORE(coeffs[0], VSEL(zero_r, q, VSUB(VMUL(VMUL(VSET1(1.0/2), r), p),
+	VMUL(VMUL(VSET1(1.0/8), q), q))));
+    VSTORE(coeffs[1], VSEL(zero_r, p, VNEG(r)));
+    VSTORE(coeffs[2], VSEL(zero_r, zero, VMUL(VSET1(- 1.0/2), p)));
+    VSTORE(coeffs[3], VSET1(1));
+    cubicBatch(coeffs, y, cnum);
+
+    z = VLOAD(y[0]);
+    u = VSUB(VMUL(z, z), r);
+    v = VSUB(VMUL(VSET1(2), z), p);
+    VSTORE(us, u);
+    VSTORE(vs, v);
+    u = VSEL(VZERO(u), zero, VSQRT(VMAX(u, zero)));
+    v = VSEL(VZERO(v), zero, VSQRT(VMAX(v, zero)));
+
+    /* x^2 + 2 p1 x + z - u = 0 and x^2 - 2 p1 x + z + u = 0, p1 = -+v/2 */
+
+    p1 = VMUL(VSEL(VLT(q, zero), VNEG(v), v), VSET1(1.0/2));
+    d1 = VSUB(VMUL(p1, p1), VSUB(z, u));
+    d2 = VSUB(VMUL(p1, p1), VADD(z, u));
+    VSTORE(D1, d1);
+    VSTORE(D2, d2);
+    sq1 = VSEL(VZERO(d1), zero, VSQRT(VMAX(d1, zero)));
+    sq2 = VSEL(VZERO(d2), zero, VSQRT(VMAX(d2, zero)));
+
+    /* resubstitute */
+
+    for (k=0; k<3; k++)
+	VSTORE(y[k], VSUB(VLOAD(y[k]), sub));
+    VSTORE(x[0], VSUB(VSUB(sq1, p1), sub));
+    VSTORE(x[1], VSUB(VSUB(VNEG(sq1), p1), sub));
+    VSTORE(x[2], VSUB(VADD(sq2, p1), sub));
+    VSTORE(x[3], VSUB(VSUB(p1, sq2), sub));
+    VSTORE(x[4], VNEG(sub));
+    VSTORE(rs, r);
+
+    for (l=0; l<W; l++) {
+	k = 0;
+	if (IsZero(rs[l])) {
+	    for (j=0; j<cnum[l]; j++)
+		s[k++][l] = y[j][l];
+	    s[k++][l] = x[4][l];
+	} else if ((IsZero(us[l]) || us[l] > 0) &&
+		   (IsZero(vs[l]) || vs[l] > 0)) {
+	    if (IsZero(D1[l]))
+		s[k++][l] = x[0][l];
+	    else if (D1[l] > 0) {
+		s[k++][l] = x[0][l];
+		s[k++][l] = x[1][l];
+	    }
+	    if (IsZero(D2[l]))
+		s[k++][l] = x[2][l];
+	    else if (D2[l] > 0) {
+		s[k++][l] = x[2][l];
+		s[k++][l] = x[3][l];
+	    }
+	}
+	num[l] = k;
+    }
+}
+
+#endif /* SSE2 or AVX */
+
+int SolveCubicBatch( int n, double c[][4], double s[][3], int num[] )
+{
+#ifdef VEC
+    double cc[4][W], ss[3][W];
+    int nn[W], i, k, l, w, hits = 0;
+
+    for (i=0; i<n; i+=W) {
+	w = n-i < W ? n-i : W;
+	for (l=0; l<W; l++)	/* short last block: repeat its first */
+	    for (k=0; k<4; k++)
+		cc[k][l] = c[i + (l < w ? l : 0)][k];
+	cubicBatch(cc, ss, nn);
+	for (l=0; l<w; l++) {
+	    for (k=0; k<nn[l]; k++)
+		s[i+l][k] = ss[k][l];
+	    num[i+l] = nn[l];
+	    hits += nn[l] > 0;
+	}
+    }
+#else					/* one at a time is quicker */
+    int i, hits = 0;
+
+    for (i=0; i<n; i++)
+	hits += (num[i] = SolveCubic(c[i], s[i])) > 0;
+#endif
+    return hits;
+}
+
+int SolveQuarticBatch( int n, double c[][5], double s[][4], int num[] )
+{
+#ifdef VEC
+    double cc[5][W], ss[4][W];
+    int nn[W], i, k, l, w, hits = 0;
+
+    for (i=0; i<n; i+=W) {
+	w = n-i < W ? n-i : W;
+	for (l=0; l<W; l++)
+	    for (k=0; k<5; k++)
+		cc[k][l] = c[i + (l < w ? l : 0)][k];
+	quarticBatch(cc, ss, nn);
+	for (l=0; l<w; l++) {
+	    for (k=0; k<nn[l]; k++)
+		s[i+l][k] = ss[k][l];
+	    num[i+l] = nn[l];
+	    hits += nn[l] > 0;
+	}
+    }
+#else
+    int i, hits = 0;
+
+    for (i=0; i<n; i++)
+	hits += (num[i] = SolveQuartic(c[i], s[i])) > 0;
+#endif
+    return hits;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+ * Roots3And4.h
+ * cubic and quartic roots (Roots3And4.c); the coefficients of each
+ * polynomial are c[0] + c[1]*x + c[2]*x^2 + ...
+ */
+
+int SolveQuadric(double c[3], double s[2]);
+int SolveCubic(double c[4], double s[3]);
+int SolveQuartic(double c[5], double s[4]);
+
+/* n polynomials at a time: the roots of c[i] are s[i][0 .. num[i]-1] */
+int SolveCubicBatch(int n, double c[][4], double s[][3], int num[]);
+int SolveQuarticBatch(int n, double c[][5], double s[][4], int num[]);
@@ -0,0 +1,149 @@
+/*
+ * Roots3And4Bench.c
+ * checks SolveCubicBatch() and SolveQuarticBatch() against SolveCubic()
+ * and SolveQuartic() on random polynomials and on the quartic of
+ * quarcube.c (Graphics Gems V), and times them.  The error of a root x is
+ * |f(x)| over the sum of the |terms| of f(x), which unlike the |f(x)/f'(x)|
+ * of quarcube.c's errors() does not blow up at double roots.
+ *
+ * Usage: Roots3And4Bench [polynomials [repetitions]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "Roots3And4.h"
+
+static double uniform(void)
+{
+    return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+static double seconds(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* |f(x)| / (|c[0]| + |c[1] x| + ...) for the polynomial c */
+static double rootError(const double *c, int degree, double x)
+{
+    double f = c[degree], a = fabs(c[degree]);
+    int i;
+
+    for (i = degree-1; i >= 0; i--) {
+	f = f*x + c[i];
+	a = a*fabs(x) + fabs(c[i]);
+    }
+    return a == 0.0 ? 0.0 : fabs(f) / a;
+}
+
+/* compare the roots of the two solvers, polynomial by polynomial */
+static void compare(const char *name, int n, int degree, const double *c,
+		    const double *s, const int *num,
+		    const double *sb, const int *numb)
+{
+    double e = 0.0, eb = 0.0, diff = 0.0;
+    int i, k, differ = 0, m = degree == 3 ? 3 : 4;
+
+    for (i=0; i<n; i++) {
+	const double *ci = c + (degree+1)*i;
+	for (k=0; k<num[i]; k++) {
+	    double x = s[m*i+k], r = rootError(ci, degree, x);
+	    if (r > e) e = r;
+	}
+	for (k=0; k<numb[i]; k++) {
+	    double x = sb[m*i+k], r = rootError(ci, degree, x);
+	    if (r > eb) eb = r;
+	    if (k < num[i] && fabs(x - s[m*i+k]) / (1.0 + fabs(x)) > diff)
+		diff = fabs(x - s[m*i+k]) / (1.0 + fabs(x));
+	}
+	differ += num[i] != numb[i];
+    }
+    printf("%-10s %12.3g %12.3g %14.3g %10d\n", name, e, eb, diff, differ);
+}
+
+int main(int argc, char *argv[])
+{
+    static double ref[5] = { 24.0, -50.0, 35.0, -10.0, 1.0 };
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    int reps = argc > 2 ? atoi(argv[2]) : 10;
+    double (*c3)[4] = (double (*)[4])malloc(n * sizeof *c3);
+    double (*s3)[3] = (double (*)[3])malloc(n * sizeof *s3);
+    double (*b3)[3] = (double (*)[3])malloc(n * sizeof *b3);
+    double (*c4)[5] = (double (*)[5])malloc(n * sizeof *c4);
+    double (*s4)[4] = (double (*)[4])malloc(n * sizeof *s4);
+    double (*b4)[4] = (double (*)[4])malloc(n * sizeof *b4);
+    int *num3 = (int *)malloc(n * sizeof(int));
+    int *num4 = (int *)malloc(n * sizeof(int));
+    int *numb = (int *)malloc(n * sizeof(int));
+    double s[4], t;
+    int i, k, r;
+
+    if (!c3 || !s3 || !b3 || !c4 || !s4 || !b4 || !num3 || !num4 || !numb) {
+	fprintf(stderr, "?Unable to malloc\n");
+	exit(1);
+    }
+
+    /* quarcube.c: x^4 - 10x^3 + 35x^2 - 50x + 24, roots 1, 2, 3, 4 */
+    k = SolveQuartic(ref, s);
+    printf("SolveQuartic:      ");
+    for (i=0; i<k; i++)
+	printf(" %.17g (%.3g)", s[i], rootError(ref, 4, s[i]));
+    SolveQuarticBatch(1, (double (*)[5])ref, (double (*)[4])s, &k);
+    printf("\nSolveQuarticBatch: ");
+    for (i=0; i<k; i++)
+	printf(" %.17g (%.3g)", s[i], rootError(ref, 4, s[i]));
+    printf("\n\n");
+
+    /*  (x - a)(x^2 + bx + c) and (x^2 + ax + b)(x^2 + cx + d): one or three
+	real roots, or none, two or four, about a tenth of them double */
+    srand(1);
+    for (i=0; i<n; i++) {
+	double a = 4*uniform(), b = 4*uniform(), c = 4*uniform(),
+	       d = 4*uniform(), e = 1 + uniform();
+	if (i % 10 == 0)
+	    b = a*a/4;
+	c3[i][0] = -a*c*e;  c3[i][1] = (c - a*b)*e;
+	c3[i][2] = (b - a)*e;  c3[i][3] = e;
+	if (i % 10 == 0)
+	    d = c*c/4;
+	c4[i][0] = b*d*e;  c4[i][1] = (a*d + b*c)*e;  c4[i][2] = (b + d + a*c)*e;
+	c4[i][3] = (a + c)*e;  c4[i][4] = e;
+    }
+    for (i=0; i<n; i++) {
+	num3[i] = SolveCubic(c3[i], s3[i]);
+	num4[i] = SolveQuartic(c4[i], s4[i]);
+    }
+    printf("%-10s %12s %12s %14s %10s\n", "roots", "error", "batch error",
+	   "batch - roots", "counts");
+    SolveCubicBatch(n, c3, b3, numb);
+    compare("cubic", n, 3, &c3[0][0], &s3[0][0], num3, &b3[0][0], numb);
+    SolveQuarticBatch(n, c4, b4, numb);
+    compare("quartic", n, 4, &c4[0][0], &s4[0][0], num4, &b4[0][0], numb);
+
+    printf("\n%d polynomials, %d repetitions\n", n, reps);
+    printf("%-24s %14s\n", "routine", "polynomials/s");
+    t = seconds();
+    for (r=0; r<reps; r++)
+	for (i=0; i<n; i++)
+	    num3[i] = SolveCubic(c3[i], s3[i]);
+    printf("%-24s %14.0f\n", "SolveCubic()", (double)n * reps / (seconds() - t));
+    t = seconds();
+    for (r=0; r<reps; r++)
+	SolveCubicBatch(n, c3, b3, numb);
+    printf("%-24s %14.0f\n", "SolveCubicBatch()",
+	   (double)n * reps / (seconds() - t));
+    t = seconds();
+    for (r=0; r<reps; r++)
+	for (i=0; i<n; i++)
+	    num4[i] = SolveQuartic(c4[i], s4[i]);
+    printf("%-24s %14.0f\n", "SolveQuartic()",
+	   (double)n * reps / (seconds() - t));
+    t = seconds();
+    for (r=0; r<reps; r++)
+	SolveQuarticBatch(n, c4, b4, numb);
+    printf("%-24s %14.0f\n", "SolveQuarticBatch()",
+	   (double)n * reps / (seconds() - t));
+    return 0;
+}
@@ -214,9 +214,9 @@ void colr_color(COLOR col, COLR clr)		/* convert short to float color */
 		col[RED] = col[GRN] = col[BLU] = 0.0;
 	else {
 		f = ldexp(1.0, (int)clr[EXP]-(COLXS+8));
-		col[RED] = (BYTE)((clr[RED] + 0.5)*f);
-		col[GRN] = (BYTE)((clr[GRN] + 0.5)*f);
-		col[BLU] = (BYTE)((clr[BLU] + 0.5)*f);
+		col[RED] = (clr[RED] + 0.5)*f;
+		col[GRN] = (clr[GRN] + 0.5)*f;
+		col[BLU] = (clr[BLU] + 0.5)*f;
 	}
 }
 
@@ -100,3 +100,11 @@ typedef float  COLOR[3];	/* red, green, blue */
 
 int freadcolrs(COLR* scanline, int len, FILE* fp);
 int fwritecolrs(COLR* scanline, int len, FILE* fp);
+
+long decodecolrs(COLR* scanline, int len, BYTE* buf, long n);
+long encodecolrs(COLR* scanline, int len, BYTE* buf);
+int freadpic(COLR* pic, int xres, int nscans, FILE* fp);
+int mreadpic(COLR* pic, int xres, int nscans, FILE* fp);
+int fwritepic(COLR* pic, int xres, int nscans, FILE* fp);
+void colrs_colors(COLOR* col, COLR* clr, int len);
+void colors_colrs(COLR* clr, COLOR* col, int len);
@@ -0,0 +1,208 @@
+/*
+ *  picbench.c - check and time picio.c against color.c.
+ *
+ *  Makes a picture of sky, gradients and noise, writes it with
+ *  fwritecolrs() and fwritepic(), reads it back with freadcolrs(),
+ *  freadpic() and mreadpic(), and converts it with colr_color() and
+ *  setcolr() and their scanline versions, checking that each gives
+ *  the same bytes as the other.  Speeds are in megabytes of colrs a
+ *  second.  Old-format scanlines are checked too, from a file and
+ *  from a pipe.
+ *
+ *  usage: picbench [xres yres [repetitions]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define  HAVE_PIPE
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include  "color.h"
+
+extern void  setcolr(COLR clr, double r, double g, double b);
+extern void  colr_color(COLOR col, COLR clr);
+
+static double
+seconds(void)
+{
+#ifdef _OPENMP
+	return(omp_get_wtime());
+#else
+	return((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
+
+static void
+report(char *what, double mb, double t, int same)
+{
+	printf("%-28s %10.1f MB/s  %s\n", what, mb / t, same ? "same" : "DIFFERENT");
+}
+
+int
+main(int argc, char *argv[])
+{
+	int  xres = argc > 2 ? atoi(argv[1]) : 4096;
+	int  yres = argc > 2 ? atoi(argv[2]) : 2048;
+	int  reps = argc > 3 ? atoi(argv[3]) : 3;
+	long  npix = (long)xres*yres, i;
+	double  mb = npix*sizeof(COLR) / 1e6, t;
+	COLOR  *col = (COLOR *)malloc(npix*sizeof(COLOR));
+	COLOR  *col2 = (COLOR *)malloc(npix*sizeof(COLOR));
+	COLR  *clr = (COLR *)malloc(npix*sizeof(COLR));
+	COLR  *clr2 = (COLR *)malloc(npix*sizeof(COLR));
+	FILE  *fa = tmpfile(), *fb = tmpfile();
+	long  na, nb;
+	int  x, y, r, same;
+	static BYTE  old[] = {		/* old runs, and a short scanline */
+		10,20,30,130, 1,1,1,3, 40,50,60,131, 1,1,1,2, 1,1,1,0,
+		7,7,7,129, 2,5,6,128, 2,5,6,128,
+		9,9,9,130, 1,1,1,5 };
+
+	if (col == NULL || col2 == NULL || clr == NULL || clr2 == NULL ||
+			fa == NULL || fb == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	srand(1);
+	for (y = 0; y < yres; y++)
+		for (x = 0; x < xres; x++) {
+			float  *c = col[(long)y*xres+x];
+			if (y < yres/3)			/* sky */
+				setcolor(c, .4f, .6f, 1.2f);
+			else if (x < xres/2)		/* gradient */
+				setcolor(c, x*.01f, y*1e-3f, 1e-4f*(x+y));
+			else				/* noise */
+				setcolor(c, 100.f*rand()/RAND_MAX,
+					(float)rand()/RAND_MAX,
+					1e-3f*rand()/RAND_MAX);
+		}
+	printf("%d x %d picture, %.1f MB of colrs, %d repetitions\n",
+			xres, yres, mb, reps);
+
+	t = seconds();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < npix; i++)
+			setcolr(clr[i], col[i][RED], col[i][GRN], col[i][BLU]);
+	report("setcolr()", mb*reps, seconds()-t, 1);
+	t = seconds();
+	for (r = 0; r < reps; r++)
+		for (y = 0; y < yres; y++)
+			colors_colrs(clr2+(long)y*xres, col+(long)y*xres, xres);
+	report("colors_colrs()", mb*reps, seconds()-t,
+			!memcmp(clr, clr2, npix*sizeof(COLR)));
+
+	t = seconds();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < npix; i++)
+			colr_color(col[i], clr[i]);
+	report("colr_color()", mb*reps, seconds()-t, 1);
+	t = seconds();
+	for (r = 0; r < reps; r++)
+		for (y = 0; y < yres; y++)
+			colrs_colors(col2+(long)y*xres, clr+(long)y*xres, xres);
+	report("colrs_colors()", mb*reps, seconds()-t,
+			!memcmp(col, col2, npix*sizeof(COLOR)));
+
+	t = seconds();
+	for (r = 0; r < reps; r++) {
+		rewind(fa);
+		for (y = 0; y < yres; y++)
+			fwritecolrs(clr+(long)y*xres, xres, fa);
+		fflush(fa);
+	}
+	report("fwritecolrs()", mb*reps, seconds()-t, 1);
+	na = ftell(fa);
+	t = seconds();
+	for (r = 0; r < reps; r++) {
+		rewind(fb);
+		fwritepic(clr, xres, yres, fb);
+		fflush(fb);
+	}
+	nb = ftell(fb);
+	same = na == nb;
+	rewind(fa);
+	rewind(fb);
+	for (i = 0; same && i < na; i++)
+		same = getc(fa) == getc(fb);
+	report("fwritepic()", mb*reps, seconds()-t, same);
+	printf("%28s %10.1f MB\n", "encoded", na / 1e6);
+
+	t = seconds();
+	for (r = 0; r < reps; r++) {
+		rewind(fa);
+		for (y = 0; y < yres; y++)
+			freadcolrs(clr2+(long)y*xres, xres, fa);
+	}
+	report("freadcolrs()", mb*reps, seconds()-t,
+			!memcmp(clr, clr2, npix*sizeof(COLR)));
+	memset(clr2, 0, npix*sizeof(COLR));
+	t = seconds();
+	for (r = 0; r < reps; r++) {
+		rewind(fa);
+		same = freadpic(clr2, xres, yres, fa) == 0 && ftell(fa) == na;
+	}
+	report("freadpic()", mb*reps, seconds()-t,
+			same && !memcmp(clr, clr2, npix*sizeof(COLR)));
+	memset(clr2, 0, npix*sizeof(COLR));
+	t = seconds();
+	for (r = 0; r < reps; r++) {
+		rewind(fa);
+		same = mreadpic(clr2, xres, yres, fa) == 0 && ftell(fa) == na;
+	}
+	report("mreadpic()", mb*reps, seconds()-t,
+			same && !memcmp(clr, clr2, npix*sizeof(COLR)));
+
+	/* old format: two scanlines of 8, then one of 5, whole or split */
+	rewind(fa);
+	fwrite(old, 1, sizeof(old), fa);
+	fwritecolrs(clr, 5, fa);
+	fflush(fa);
+	na = ftell(fa);
+	rewind(fa);
+	memset(clr2, 0, 21*sizeof(COLR));
+	freadcolrs(clr2+1, 8, fa);
+	freadcolrs(clr2+9, 8, fa);
+	freadcolrs(clr2+17, 5, fa);
+	memset(clr2+32, 0, 21*sizeof(COLR));
+	rewind(fa);
+	same = freadpic(clr2+33, 8, 2, fa) == 0 &&
+		freadpic(clr2+49, 5, 1, fa) == 0;
+	printf("%-28s %s\n", "old format", same &&
+			!memcmp(clr2, clr2+32, 21*sizeof(COLR)) ? "same" : "DIFFERENT");
+#ifdef HAVE_PIPE
+	{					/* the same, and a byte after */
+		int  fd[2];
+		FILE  *fp;
+
+		rewind(fa);
+		if (pipe(fd) < 0 || (fp = fdopen(fd[0], "rb")) == NULL) {
+			perror("pipe");
+			exit(1);
+		}
+		/* a few bytes, so the pipe takes them all at once */
+		if (fread(clr2+64, 1, na, fa) != (size_t)na ||
+				write(fd[1], clr2+64, na) != na ||
+				write(fd[1], "!", 1) != 1) {
+			perror("pipe");
+			exit(1);
+		}
+		close(fd[1]);
+		memset(clr2+32, 0, 21*sizeof(COLR));
+		same = freadpic(clr2+33, 8, 2, fp) == 0 &&
+			freadpic(clr2+49, 5, 1, fp) == 0 && getc(fp) == '!';
+		fclose(fp);
+		printf("%-28s %s\n", "old format, pipe", same &&
+				!memcmp(clr2, clr2+32, 21*sizeof(COLR)) ?
+				"same" : "DIFFERENT");
+	}
+#endif
+	return(0);
+}
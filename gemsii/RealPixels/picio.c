@@ -0,0 +1,463 @@
+/* Copyright (c) 1991 Regents of the University of California */
+
+/*
+ *  picio.c - routines for whole pictures of colr scanlines.
+ *
+ *  The run-length encoded scanlines of a picture are independent of
+ *  each other, so once the start of each is known they are decoded in
+ *  parallel (with OpenMP).  A serial pass finds the starts by skipping
+ *  over the runs; scanlines in the old format are decoded by that pass,
+ *  since their runs may continue from the previous scanline.
+ *
+ *  freadpic() reads the scanlines from a stream a block at a time and
+ *  seeks back over what it read past them; from a stream it cannot
+ *  seek (a pipe) it reads them one at a time with freadcolrs().
+ *  mreadpic() maps the rest of the file into memory instead, and
+ *  fwritepic() encodes blocks of scanlines in parallel and writes them
+ *  in order.  All three produce or accept exactly what freadcolrs() and
+ *  fwritecolrs() do, and return 0 or -1 as they do.
+ *
+ *  colrs_colors() and colors_colrs() convert whole scanlines between
+ *  colr and color, as colr_color() and setcolr() do, with SSE2 where
+ *  it is available.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#define  HAVE_MMAP
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#define  COLR_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define  COLR_SSE2
+#endif
+
+#include  "color.h"
+
+#define  MINELEN	8	/* minimum scanline length for encoding */
+#define  MINRUN		4	/* minimum run length */
+
+#define  PICBLOCK	(1L<<20)	/* bytes read at a time */
+#define  PICSCANS	64		/* scanlines encoded at a time */
+
+extern void  setcolr(COLR clr, double r, double g, double b);
+extern void  colr_color(COLOR col, COLR clr);
+
+
+static long
+oldcolrs(scanline, len, buf, n)		/* decode an old colr scanline */
+COLR  *scanline;
+int  len;
+BYTE  *buf;
+long  n;
+{
+	int  rshift = 0;
+	long  pos = 0;
+	register int  i;
+
+	while (len > 0) {
+		if (pos + 4 > n)
+			return(0);
+		copycolr(scanline[0], (buf+pos));
+		pos += 4;
+		if (scanline[0][RED] == 1 &&
+			scanline[0][GRN] == 1 &&
+			scanline[0][BLU] == 1) {
+				for (i = scanline[0][EXP] << rshift; i > 0; i--) {
+					copycolr(scanline[0], scanline[-1]);
+					scanline++;
+					len--;
+				}
+				rshift += 8;
+		} else {
+			scanline++;
+			len--;
+			rshift = 0;
+		}
+	}
+	return(pos);
+}
+
+
+static int
+newformat(buf, n, len)		/* is this an encoded scanline? */
+BYTE  *buf;
+long  n;
+int  len;
+{
+	if (len < MINELEN || n < 1 || buf[0] != 2)
+		return(0);
+	if (n < 4)
+		return(-1);
+	return(buf[1] == 2 && !(buf[2] & 128));
+}
+
+
+static long
+skipcolrs(buf, n, len)		/* find the end of an encoded scanline */
+BYTE  *buf;
+long  n;
+int  len;
+{
+	register long  pos;
+	register int  i, j, code;
+
+	if ((buf[2]<<8 | buf[3]) != len)
+		return(-1);		/* length mismatch! */
+	pos = 4;
+	for (i = 0; i < 4; i++)
+	    for (j = 0; j < len; ) {
+		if (pos >= n)
+		    return(0);
+		code = buf[pos++];
+		if (code > 128) {	/* run */
+		    pos++;
+		    j += code & 127;
+		} else {		/* non-run */
+		    pos += code;
+		    j += code;
+		}
+		if (j > len)
+		    return(-1);
+	    }
+	return(pos > n ? 0 : pos);
+}
+
+
+long
+decodecolrs(scanline, len, buf, n)	/* decode a colr scanline in memory */
+COLR  *scanline;
+int  len;
+BYTE  *buf;
+long  n;
+{
+	register int  i, j;
+	int  code;
+	long  pos;
+					/* returns bytes used, 0 if short */
+	if ((i = newformat(buf, n, len)) <= 0)
+		return(i < 0 ? 0 : oldcolrs(scanline, len, buf, n));
+	if ((pos = skipcolrs(buf, n, len)) <= 0)
+		return(pos);
+	buf += 4;
+	for (i = 0; i < 4; i++)
+	    for (j = 0; j < len; ) {
+		code = *buf++;
+		if (code > 128) {	/* run */
+		    for (code &= 127; code--; j++)
+			scanline[j][i] = *buf;
+		    buf++;
+		} else			/* non-run */
+		    while (code--)
+			scanline[j++][i] = *buf++;
+	    }
+	return(pos);
+}
+
+
+long
+encodecolrs(scanline, len, buf)		/* encode a colr scanline in memory */
+COLR  *scanline;
+int  len;
+BYTE  *buf;
+{
+	register int  i, j, beg, cnt = 0;
+	int  c2;
+	BYTE  *bp = buf;
+					/* as fwritecolrs(), bytes put */
+	if (len < MINELEN) {
+		memcpy(buf, scanline, len*sizeof(COLR));
+		return(len*sizeof(COLR));
+	}
+	if (len > 32767)
+		return(-1);
+	*bp++ = 2;
+	*bp++ = 2;
+	*bp++ = len>>8;
+	*bp++ = len&255;
+	for (i = 0; i < 4; i++) {
+	    for (j = 0; j < len; j += cnt) {
+		for (beg = j; beg < len; beg += cnt) {
+		    for (cnt = 1; cnt < 127 && beg+cnt < len &&
+			    scanline[beg+cnt][i] == scanline[beg][i]; cnt++)
+			;
+		    if (cnt >= MINRUN)
+			break;
+		}
+		if (beg-j > 1 && beg-j < MINRUN) {
+		    c2 = j+1;
+		    while (scanline[c2++][i] == scanline[j][i])
+			if (c2 == beg) {
+			    *bp++ = 128+beg-j;
+			    *bp++ = scanline[j][i];
+			    j = beg;
+			    break;
+			}
+		}
+		while (j < beg) {
+		    if ((c2 = beg-j) > 128) c2 = 128;
+		    *bp++ = c2;
+		    while (c2--)
+			*bp++ = scanline[j++][i];
+		}
+		if (cnt >= MINRUN) {
+		    *bp++ = 128+cnt;
+		    *bp++ = scanline[beg][i];
+		} else
+		    cnt = 0;
+	    }
+	}
+	return(bp - buf);
+}
+
+
+static long
+decodepic(pic, xres, nscans, buf, n, done)	/* decode whole scanlines */
+COLR  *pic;
+int  xres, nscans;
+BYTE  *buf;
+long  n;
+int  *done;
+{
+	long  *start, pos = 0, k;
+	int  y, ny, f, bad = 0;
+				/* returns bytes used, -1 on error */
+	if ((start = (long *)malloc((nscans+1)*sizeof(long))) == NULL)
+		return(-1);
+	for (ny = 0; ny < nscans; ny++) {	/* find the scanlines */
+		start[ny] = pos;
+		if ((f = newformat(buf+pos, n-pos, xres)) < 0)
+			k = 0;			/* too short to tell */
+		else if (f)
+			k = skipcolrs(buf+pos, n-pos, xres);
+		else
+			k = oldcolrs(pic+(long)ny*xres, xres, buf+pos, n-pos);
+		if (k <= 0) {
+			if (k < 0) bad = 1;
+			break;
+		}
+		pos += k;
+	}
+#pragma omp parallel for schedule(dynamic, 4)
+	for (y = 0; y < ny; y++)
+		if (newformat(buf+start[y], n-start[y], xres) > 0)
+			decodecolrs(pic+(long)y*xres, xres, buf+start[y],
+					n-start[y]);
+	free(start);
+	*done = ny;
+	return(bad ? -1 : pos);
+}
+
+
+int
+freadpic(pic, xres, nscans, fp)		/* read in colr scanlines */
+COLR  *pic;
+int  xres, nscans;
+FILE  *fp;
+{
+	BYTE  *buf;
+	long  size = PICBLOCK, have = 0, used;
+	size_t  got;
+	int  done;
+
+	if (ftell(fp) < 0) {			/* can't give back, so */
+		for ( ; nscans > 0; nscans--, pic += xres)	/* don't take */
+			if (freadcolrs(pic, xres, fp) < 0)
+				return(-1);
+		return(0);
+	}
+	if ((buf = (BYTE *)malloc(size)) == NULL)
+		return(-1);
+	while (nscans > 0) {
+		if (have == size) {		/* a scanline longer than this */
+			BYTE  *nb = (BYTE *)realloc(buf, size *= 2);
+			if (nb == NULL)
+				break;
+			buf = nb;
+		}
+		got = fread(buf+have, 1, size-have, fp);
+		have += got;
+		if ((used = decodepic(pic, xres, nscans, buf, have, &done)) < 0)
+			break;
+		if (done == 0 && got == 0)
+			break;			/* ran out */
+		pic += (long)done*xres;
+		nscans -= done;
+		memmove(buf, buf+used, have -= used);
+	}
+	free(buf);
+	if (have > 0 && fseek(fp, -have, SEEK_CUR) < 0)
+		return(-1);			/* the rest is lost */
+	return(nscans > 0 ? -1 : 0);
+}
+
+
+int
+mreadpic(pic, xres, nscans, fp)		/* read mapping the file */
+COLR  *pic;
+int  xres, nscans;
+FILE  *fp;
+{
+#ifdef HAVE_MMAP
+	struct stat  st;
+	BYTE  *map;
+	long  off, used;
+	int  done;
+
+	if ((off = ftell(fp)) < 0 || fstat(fileno(fp), &st) < 0 ||
+			!S_ISREG(st.st_mode) || st.st_size <= off)
+		return(freadpic(pic, xres, nscans, fp));
+	map = (BYTE *)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED,
+				fileno(fp), 0);
+	if (map == (BYTE *)MAP_FAILED)
+		return(freadpic(pic, xres, nscans, fp));
+	used = decodepic(pic, xres, nscans, map+off, st.st_size-off, &done);
+	munmap(map, st.st_size);
+	if (used < 0 || done < nscans)
+		return(-1);
+	return(fseek(fp, off+used, SEEK_SET));
+#else
+	return(freadpic(pic, xres, nscans, fp));
+#endif
+}
+
+
+int
+fwritepic(pic, xres, nscans, fp)	/* write out colr scanlines */
+COLR  *pic;
+int  xres, nscans;
+FILE  *fp;
+{
+	long  most = 4 + 4*(xres + xres/128 + 1) + xres*sizeof(COLR);
+	long  n[PICSCANS];
+	BYTE  *buf;
+	int  y, k, ny, bad = 0;
+
+	if ((buf = (BYTE *)malloc(PICSCANS*most)) == NULL)
+		return(-1);
+	for (y = 0; y < nscans && !bad; y += ny) {
+		ny = nscans-y < PICSCANS ? nscans-y : PICSCANS;
+#pragma omp parallel for schedule(dynamic, 1)
+		for (k = 0; k < ny; k++)
+			n[k] = encodecolrs(pic+(long)(y+k)*xres, xres,
+					buf+k*most);
+		for (k = 0; k < ny; k++)
+			if (n[k] < 0 || fwrite(buf+k*most, 1, n[k], fp) != n[k])
+				bad = 1;
+	}
+	free(buf);
+	return(bad || ferror(fp) ? -1 : 0);
+}
+
+
+void
+colrs_colors(col, clr, len)		/* convert a scanline to colors */
+COLOR  *col;
+COLR  *clr;
+int  len;
+{
+	int  i = 0;
+#ifdef COLR_SSE2
+	/* (m + .5) * 2^(e-136), the power in two halves to keep it normal */
+	const __m128i  zero = _mm_setzero_si128();
+	const __m128  half = _mm_set1_ps(.5f);
+
+	for ( ; i+4 < len; i += 4) {
+		__m128i  c = _mm_loadu_si128((__m128i *)clr[i]);
+		__m128i  e = _mm_srli_epi32(c, 24);
+		__m128i  p = _mm_sub_epi32(e, _mm_set1_epi32(COLXS+8));
+		__m128i  a = _mm_srai_epi32(p, 1);
+		__m128  f = _mm_mul_ps(
+			_mm_castsi128_ps(_mm_slli_epi32(
+				_mm_add_epi32(a, _mm_set1_epi32(127)), 23)),
+			_mm_castsi128_ps(_mm_slli_epi32(
+				_mm_add_epi32(_mm_sub_epi32(p, a),
+					_mm_set1_epi32(127)), 23)));
+		__m128i  lo = _mm_unpacklo_epi8(c, zero);
+		__m128i  hi = _mm_unpackhi_epi8(c, zero);
+		__m128  m;
+
+		f = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(e, zero)), f);
+		m = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_ps(col[i], _mm_mul_ps(_mm_add_ps(m, half),
+				_mm_shuffle_ps(f, f, _MM_SHUFFLE(0,0,0,0))));
+		m = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_ps(col[i+1], _mm_mul_ps(_mm_add_ps(m, half),
+				_mm_shuffle_ps(f, f, _MM_SHUFFLE(1,1,1,1))));
+		m = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_ps(col[i+2], _mm_mul_ps(_mm_add_ps(m, half),
+				_mm_shuffle_ps(f, f, _MM_SHUFFLE(2,2,2,2))));
+		m = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+		_mm_storeu_ps(col[i+3], _mm_mul_ps(_mm_add_ps(m, half),
+				_mm_shuffle_ps(f, f, _MM_SHUFFLE(3,3,3,3))));
+	}
+#endif
+	for ( ; i < len; i++)
+		colr_color(col[i], clr[i]);
+}
+
+
+void
+colors_colrs(clr, col, len)		/* convert a scanline to colrs */
+COLR  *clr;
+COLOR  *col;
+int  len;
+{
+	int  i = 0;
+#ifdef COLR_SSE2
+	/* the mantissas are the colors times 2^(8-e), e of frexp(max) */
+	float  tiny = (float)1e-32;
+	__m128  small;
+
+	if (tiny > 1e-32)
+		tiny = nextafterf(tiny, 0.f);
+	small = _mm_set1_ps(tiny);
+	for ( ; i+4 <= len; i += 4) {
+		__m128  a = _mm_loadu_ps(col[i]);
+		__m128  b = _mm_loadu_ps(col[i]+4);
+		__m128  c = _mm_loadu_ps(col[i]+8);
+		__m128  t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2));
+		__m128  r = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2,0,3,0));
+		__m128  g = _mm_shuffle_ps(
+				_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)),
+				_mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)),
+				_MM_SHUFFLE(2,0,2,0));
+		__m128  bl = _mm_shuffle_ps(
+				_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)),
+				_mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,0,0)),
+				_MM_SHUFFLE(2,0,2,0));
+		__m128  d = _mm_max_ps(_mm_max_ps(r, g), bl);
+		__m128i  be = _mm_srli_epi32(_mm_castps_si128(d), 23);
+		__m128  s = _mm_castsi128_ps(_mm_slli_epi32(
+				_mm_sub_epi32(_mm_set1_epi32(261), be), 23));
+		__m128i  ri = _mm_cvttps_epi32(_mm_mul_ps(r, s));
+		__m128i  gi = _mm_cvttps_epi32(_mm_mul_ps(g, s));
+		__m128i  bi = _mm_cvttps_epi32(_mm_mul_ps(bl, s));
+		__m128i  out;
+
+		ri = _mm_andnot_si128(_mm_srai_epi32(ri, 31), ri);
+		gi = _mm_andnot_si128(_mm_srai_epi32(gi, 31), gi);
+		bi = _mm_andnot_si128(_mm_srai_epi32(bi, 31), bi);
+		out = _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)),
+			_mm_or_si128(_mm_slli_epi32(bi, 16), _mm_slli_epi32(
+				_mm_add_epi32(be, _mm_set1_epi32(2)), 24)));
+		out = _mm_andnot_si128(_mm_castps_si128(_mm_cmple_ps(d, small)),
+				out);
+		_mm_storeu_si128((__m128i *)clr[i], out);
+	}
+#endif
+	for ( ; i < len; i++)
+		setcolr(clr[i], col[i][RED], col[i][GRN], col[i][BLU]);
+}
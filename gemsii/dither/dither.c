@@ -29,6 +29,18 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define DITHER_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DITHER_SSE2
+#endif
 
 #ifdef USE_PROTOTYPES
 void	make_square( double, int [256], int [256], int [16][16] );
@@ -264,3 +276,398 @@ int ditherbw(int x, int y, int val, int divN[256], int modN[256], int magic[16][
 
     return DMAP(val, col, row);
 }
+
+
+/*****************************************************************
+ * TAG( make_thresholds )
+ * 
+ * Turn divN, modN and magic into per-level thresholds.
+ * Inputs:
+ *	divN, modN:	From dithermap or bwdithermap.
+ *	magic:		Magic square from dithermap or bwdithermap.
+ * Outputs:
+ *	thresh:		thresh[row][j][col] is the smallest pixel value
+ *			that DMAP takes to level j+1 or above at
+ *			(col, row).
+ *	Returns the number of thresholds at each location (levels - 1
+ *	for tables from make_square), or 0 if the tables can't be
+ *	written that way.
+ * Assumptions:
+ *	There are at most 16 levels.
+ * Algorithm:
+ *	DMAP(v,col,row) grows with v, so it is the number of thresholds
+ *	of (col, row) that v reaches.  That makes a row of pixels a
+ *	few compares per level, 16 at a time (see dithergb_row).
+ *	Each location is scanned through the 256 values; tables where
+ *	DMAP ever goes down, doesn't start at 0, or doesn't end at the
+ *	same level everywhere, are refused.
+ */
+int
+make_thresholds( int divN[256], int modN[256], int magic[16][16],
+		 unsigned char thresh[16][16][16] )
+{
+    int row, col, v, j, d, top = -1;
+
+    for ( row = 0; row < 16; row++ )
+	for ( col = 0; col < 16; col++ )
+	{
+	    for ( j = 0, v = 0; v < 256; v++ )
+	    {
+		d = DMAP(v, col, row);
+		if ( d < j || d > 16 || (v == 0 && d != 0) )
+		    return 0;
+		for ( ; j < d; j++ )
+		    thresh[row][j][col] = v;
+	    }
+	    if ( top >= 0 && j != top )
+		return 0;
+	    top = j;
+	}
+    return top;
+}
+
+
+/*****************************************************************
+ * TAG( dithergb_row )
+ * 
+ * Dither a row of full color pixels.
+ * Inputs:
+ *	x, y:		Screen location of the first pixel.
+ *	n:		Pixels in the row.
+ *	r, g, b:	The row, one byte per pixel and primary.
+ *	levels:		Number of levels in this map.
+ *	divN, modN:	From dithermap.
+ *	magic:		Magic square from dithermap.
+ *	nthresh, thresh: From make_thresholds, or 0 and NULL.
+ * Outputs:
+ *	out:		Color map indexes, as dithergb gives them.
+ * Assumptions:
+ *	levels^3 <= 256, x >= 0 and y >= 0.
+ * Algorithm:
+ *	With SSE2 and thresholds, 16 pixels at a time: each threshold
+ *	the pixel reaches adds 1, levels or levels^2 to its index.  The
+ *	rest is DMAP, without the function call or the %.
+ */
+void
+dithergb_row( int x, int y, int n, unsigned char *r, unsigned char *g,
+	      unsigned char *b, int levels, int divN[256], int modN[256],
+	      int magic[16][16], int nthresh, unsigned char thresh[16][16][16],
+	      unsigned char *out )
+{
+    register int i = 0, col;
+    int row = y % 16;
+    int levelsq = levels*levels;
+
+#ifdef DITHER_SSE2
+    if ( nthresh > 0 && n >= 16 )
+    {
+	__m128i t[16], one, gw, bw, vr, vg, vb, acc;
+	unsigned char lane[16];
+	int j;
+
+	/* the thresholds, turned so that lane 0 is column x % 16 */
+	for ( j = 0; j < nthresh; j++ )
+	{
+	    for ( col = 0; col < 16; col++ )
+		lane[col] = thresh[row][j][(x + col) % 16];
+	    t[j] = _mm_loadu_si128( (__m128i *)lane );
+	}
+	one = _mm_set1_epi8( 1 );
+	gw = _mm_set1_epi8( (char)levels );
+	bw = _mm_set1_epi8( (char)levelsq );
+	for ( ; i + 16 <= n; i += 16 )
+	{
+	    vr = _mm_loadu_si128( (__m128i *)(r + i) );
+	    vg = _mm_loadu_si128( (__m128i *)(g + i) );
+	    vb = _mm_loadu_si128( (__m128i *)(b + i) );
+	    acc = _mm_setzero_si128();
+	    for ( j = 0; j < nthresh; j++ )
+	    {
+		acc = _mm_add_epi8( acc, _mm_and_si128( one,
+			_mm_cmpeq_epi8( _mm_max_epu8( vr, t[j] ), vr ) ) );
+		acc = _mm_add_epi8( acc, _mm_and_si128( gw,
+			_mm_cmpeq_epi8( _mm_max_epu8( vg, t[j] ), vg ) ) );
+		acc = _mm_add_epi8( acc, _mm_and_si128( bw,
+			_mm_cmpeq_epi8( _mm_max_epu8( vb, t[j] ), vb ) ) );
+	    }
+	    _mm_storeu_si128( (__m128i *)(out + i), acc );
+	}
+    }
+#endif
+    for ( ; i < n; i++ )
+    {
+	col = (x + i) % 16;
+	out[i] = DMAP(r[i], col, row) + DMAP(g[i], col, row) * levels +
+	    DMAP(b[i], col, row) * levelsq;
+    }
+}
+
+
+/*****************************************************************
+ * TAG( ditherbw_row )
+ * 
+ * Dither a row of gray scale pixels.
+ * Inputs:
+ *	x, y:		Screen location of the first pixel.
+ *	n:		Pixels in the row.
+ *	val:		The row, one byte per pixel.
+ *	divN, modN:	From bwdithermap.
+ *	magic:		Magic square from bwdithermap.
+ *	nthresh, thresh: From make_thresholds, or 0 and NULL.
+ * Outputs:
+ *	out:		Color map indexes, as ditherbw gives them.
+ * Assumptions:
+ *	levels <= 256, x >= 0 and y >= 0.
+ * Algorithm:
+ *	As dithergb_row, with a single primary.
+ */
+void
+ditherbw_row( int x, int y, int n, unsigned char *val, int divN[256],
+	      int modN[256], int magic[16][16], int nthresh,
+	      unsigned char thresh[16][16][16], unsigned char *out )
+{
+    register int i = 0, col;
+    int row = y % 16;
+
+#ifdef DITHER_SSE2
+    if ( nthresh > 0 && n >= 16 )
+    {
+	__m128i t[16], one, v, acc;
+	unsigned char lane[16];
+	int j;
+
+	for ( j = 0; j < nthresh; j++ )
+	{
+	    for ( col = 0; col < 16; col++ )
+		lane[col] = thresh[row][j][(x + col) % 16];
+	    t[j] = _mm_loadu_si128( (__m128i *)lane );
+	}
+	one = _mm_set1_epi8( 1 );
+	for ( ; i + 16 <= n; i += 16 )
+	{
+	    v = _mm_loadu_si128( (__m128i *)(val + i) );
+	    acc = _mm_setzero_si128();
+	    for ( j = 0; j < nthresh; j++ )
+		acc = _mm_add_epi8( acc, _mm_and_si128( one,
+			_mm_cmpeq_epi8( _mm_max_epu8( v, t[j] ), v ) ) );
+	    _mm_storeu_si128( (__m128i *)(out + i), acc );
+	}
+    }
+#endif
+    for ( ; i < n; i++ )
+    {
+	col = (x + i) % 16;
+	out[i] = DMAP(val[i], col, row);
+    }
+}
+
+
+/*****************************************************************
+ * TAG( dithergb_frame )
+ * 
+ * Dither a full color frame.
+ * Inputs:
+ *	width, height:	Size of the frame, at screen location (0, 0).
+ *	r, g, b:	The frame, row after row, one byte per pixel
+ *			and primary.
+ *	levels, divN, modN, magic, nthresh, thresh: As dithergb_row.
+ * Outputs:
+ *	out:		width*height color map indexes.
+ * Algorithm:
+ *	dithergb_row on each row, the rows spread over the threads.
+ */
+void
+dithergb_frame( int width, int height, unsigned char *r, unsigned char *g,
+		unsigned char *b, int levels, int divN[256], int modN[256],
+		int magic[16][16], int nthresh,
+		unsigned char thresh[16][16][16], unsigned char *out )
+{
+    int y;
+
+#pragma omp parallel for schedule(static)
+    for ( y = 0; y < height; y++ )
+    {
+	long k = (long)y * width;
+
+	dithergb_row( 0, y, width, r + k, g + k, b + k, levels,
+		      divN, modN, magic, nthresh, thresh, out + k );
+    }
+}
+
+
+/*****************************************************************
+ * TAG( ditherbw_frame )
+ * 
+ * Dither a gray scale frame.
+ * Inputs:
+ *	width, height:	Size of the frame, at screen location (0, 0).
+ *	val:		The frame, row after row, one byte per pixel.
+ *	divN, modN, magic, nthresh, thresh: As ditherbw_row.
+ * Outputs:
+ *	out:		width*height color map indexes.
+ */
+void
+ditherbw_frame( int width, int height, unsigned char *val, int divN[256],
+		int modN[256], int magic[16][16], int nthresh,
+		unsigned char thresh[16][16][16], unsigned char *out )
+{
+    int y;
+
+#pragma omp parallel for schedule(static)
+    for ( y = 0; y < height; y++ )
+    {
+	long k = (long)y * width;
+
+	ditherbw_row( 0, y, width, val + k, divN, modN, magic,
+		      nthresh, thresh, out + k );
+    }
+}
+
+
+/*
+ * Error diffusion: the rows go through the threads one each, and a
+ * row only works on the pixels whose errors from the row above are
+ * all in, so the rows run as a wavefront, DIFFUSE_STEP pixels apart.
+ * Errors are in sixteenths.  Two error rows are enough: the row y+1
+ * adds errors for y+2 at x+1 and before only when the row y has read
+ * (and cleared) them.
+ */
+#define DIFFUSE_STEP	64
+
+static void
+diffuse_frame( int width, int height, int nchan, unsigned char **chan,
+	       int levels, unsigned char *out )
+{
+    double N = 255.0 / (levels - 1);
+    unsigned char nearest[256];
+    int value[256], weight[3];
+    int *err, *done;
+    int i, c, nthreads = 1;
+
+    for ( i = 0; i < 256; i++ )
+	nearest[i] = (int)(0.5 + i / N);
+    for ( i = 0; i < levels; i++ )
+	value[i] = (int)(0.5 + i * N);
+    weight[0] = 1;
+    weight[1] = levels;
+    weight[2] = levels*levels;
+
+    err = (int *)calloc( 2 * nchan * (width + 2), sizeof(int) );
+    done = (int *)calloc( height, sizeof(int) );
+#ifdef _OPENMP
+    /* a waiting row only spins, so never more threads than processors */
+    nthreads = omp_get_max_threads();
+    if ( nthreads > omp_get_num_procs() )
+	nthreads = omp_get_num_procs();
+#endif
+
+#pragma omp parallel for schedule(static,1) num_threads(nthreads) private(c)
+    for ( i = 0; i < height; i++ )
+    {
+	int *cur = err + (i & 1) * nchan * (width + 2);
+	int *next = err + ((i + 1) & 1) * nchan * (width + 2);
+	unsigned char *o = out + (long)i * width;
+	int right[3], x, x0, x1, need, seen, v, q, e;
+
+	for ( c = 0; c < nchan; c++ )
+	    right[c] = 0;
+	for ( x0 = 0; x0 < width; x0 = x1 )
+	{
+	    x1 = x0 + DIFFUSE_STEP < width ? x0 + DIFFUSE_STEP : width;
+	    need = x1 + 1 < width ? x1 + 1 : width;
+	    if ( i > 0 )
+		do {
+#pragma omp flush
+		    seen = ((volatile int *)done)[i - 1];
+		} while ( seen < need );
+#pragma omp flush
+
+	    for ( x = x0; x < x1; x++ )
+	    {
+		long k = (long)i * width + x;
+		int pix = 0;
+
+		for ( c = 0; c < nchan; c++ )
+		{
+		    int *ce = cur + c * (width + 2) + 1;
+		    int *ne = next + c * (width + 2) + 1;
+
+		    v = chan[c][k] + ((ce[x] + 7 * right[c] + 8) >> 4);
+		    ce[x] = 0;
+		    v = v < 0 ? 0 : v > 255 ? 255 : v;
+		    q = nearest[v];
+		    e = v - value[q];
+		    right[c] = e;
+		    ne[x - 1] += 3 * e;
+		    ne[x] += 5 * e;
+		    ne[x + 1] += e;
+		    pix += q * weight[c];
+		}
+		o[x] = pix;
+	    }
+
+#pragma omp flush
+	    ((volatile int *)done)[i] = x1;
+#pragma omp flush
+	}
+    }
+
+    free( err );
+    free( done );
+}
+
+
+/*****************************************************************
+ * TAG( diffusergb_frame )
+ * 
+ * Dither a full color frame by error diffusion.
+ * Inputs:
+ *	width, height:	Size of the frame.
+ *	r, g, b:	The frame, row after row, one byte per pixel
+ *			and primary.
+ *	levels:		Number of levels in the map from dithermap.
+ * Outputs:
+ *	out:		width*height color map indexes, as dithergb
+ *			gives them.
+ * Assumptions:
+ *	levels^3 <= 256.
+ * Algorithm:
+ *	Floyd and Steinberg: each primary goes to its nearest level,
+ *	and the error goes 7/16 to the right, and 3/16, 5/16 and 1/16
+ *	to the pixels below.  The rows run in parallel as a wavefront,
+ *	and give the same pixels as one row after another.
+ */
+void
+diffusergb_frame( int width, int height, unsigned char *r, unsigned char *g,
+		  unsigned char *b, int levels, unsigned char *out )
+{
+    unsigned char *chan[3];
+
+    chan[0] = r;
+    chan[1] = g;
+    chan[2] = b;
+    diffuse_frame( width, height, 3, chan, levels, out );
+}
+
+
+/*****************************************************************
+ * TAG( diffusebw_frame )
+ * 
+ * Dither a gray scale frame by error diffusion.
+ * Inputs:
+ *	width, height:	Size of the frame.
+ *	val:		The frame, row after row, one byte per pixel.
+ *	levels:		Number of levels in the map from bwdithermap.
+ * Outputs:
+ *	out:		width*height color map indexes.
+ * Assumptions:
+ *	levels <= 256.
+ * Algorithm:
+ *	As diffusergb_frame, with a single primary.
+ */
+void
+diffusebw_frame( int width, int height, unsigned char *val, int levels,
+		 unsigned char *out )
+{
+    diffuse_frame( width, height, 1, &val, levels, out );
+}
@@ -0,0 +1,226 @@
+/*
+ * ditherbench.c - check and time the row and frame dithering in dither.c
+ * against dithergb() and ditherbw().
+ *
+ * Makes a frame of gradients and noise, dithers it pixel by pixel with
+ * dithergb() and ditherbw(), and a frame at a time with dithergb_frame()
+ * and ditherbw_frame() ( with and without thresholds ), checking that
+ * each gives the same indexes.  Then dithers it by error diffusion with
+ * diffusergb_frame() and diffusebw_frame(), checked against a plain
+ * Floyd-Steinberg loop.  Speeds are in frames a second.
+ *
+ * usage: ditherbench [width height [repetitions [levels bwlevels]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+void	dithermap( int, double, int [][3], int [256], int [256], int [16][16] );
+void	bwdithermap( int, double, int [], int [256], int [256], int [16][16] );
+int	dithergb( int, int, int, int, int, int, int [256], int [256], int [16][16] );
+int	ditherbw( int, int, int, int [256], int [256], int [16][16] );
+int	make_thresholds( int [256], int [256], int [16][16],
+			 unsigned char [16][16][16] );
+void	dithergb_frame( int, int, unsigned char *, unsigned char *,
+			unsigned char *, int, int [256], int [256], int [16][16],
+			int, unsigned char [16][16][16], unsigned char * );
+void	ditherbw_frame( int, int, unsigned char *, int [256], int [256],
+			int [16][16], int, unsigned char [16][16][16],
+			unsigned char * );
+void	diffusergb_frame( int, int, unsigned char *, unsigned char *,
+			  unsigned char *, int, unsigned char * );
+void	diffusebw_frame( int, int, unsigned char *, int, unsigned char * );
+
+static double
+seconds( void )
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static void
+report( char *what, int reps, double t, int same )
+{
+    printf( "%-32s %10.1f frames/s", what, reps / t );
+    if ( same >= 0 )
+	printf( "  %s", same ? "same" : "DIFFERENT" );
+    printf( "\n" );
+}
+
+/*
+ * Floyd-Steinberg, one row after another, the way diffuse_frame
+ * should give it.
+ */
+static void
+floyd( int width, int height, int nchan, unsigned char **chan, int levels,
+       unsigned char *out )
+{
+    double N = 255.0 / (levels - 1);
+    int *err = (int *)calloc( nchan * 2 * (width + 2), sizeof(int) );
+    int x, y, c, v, q, e, w;
+
+    memset( out, 0, (long)width * height );
+    for ( c = 0, w = 1; c < nchan; c++, w *= levels )
+	for ( y = 0; y < height; y++ )
+	{
+	    int *cur = err + (2 * c + (y & 1)) * (width + 2) + 1;
+	    int *next = err + (2 * c + !(y & 1)) * (width + 2) + 1;
+
+	    e = 0;
+	    for ( x = 0; x < width; x++ )
+	    {
+		v = chan[c][(long)y * width + x] + ((cur[x] + 7 * e + 8) >> 4);
+		cur[x] = 0;
+		v = v < 0 ? 0 : v > 255 ? 255 : v;
+		q = (int)(0.5 + v / N);
+		e = v - (int)(0.5 + q * N);
+		next[x - 1] += 3 * e;
+		next[x] += 5 * e;
+		next[x + 1] += e;
+		out[(long)y * width + x] += q * w;
+	    }
+	}
+    free( err );
+}
+
+int
+main( int argc, char *argv[] )
+{
+    int width = argc > 2 ? atoi( argv[1] ) : 1920;
+    int height = argc > 2 ? atoi( argv[2] ) : 1080;
+    int reps = argc > 3 ? atoi( argv[3] ) : 5;
+    int levels = argc > 5 ? atoi( argv[4] ) : 6;
+    int bwlevels = argc > 5 ? atoi( argv[5] ) : 4;
+    long npix = (long)width * height, k;
+    unsigned char *r = (unsigned char *)malloc( npix );
+    unsigned char *g = (unsigned char *)malloc( npix );
+    unsigned char *b = (unsigned char *)malloc( npix );
+    unsigned char *out = (unsigned char *)malloc( npix );
+    unsigned char *ref = (unsigned char *)malloc( npix );
+    unsigned char *chan[3];
+    static int rgbmap[256][3], bwmap[256];
+    static int divN[256], modN[256], magic[16][16];
+    static int bdivN[256], bmodN[256], bmagic[16][16];
+    static unsigned char thresh[16][16][16], bthresh[16][16][16];
+    int nthresh, bnthresh, x, y, i;
+    double t;
+
+    if ( !r || !g || !b || !out || !ref )
+    {
+	fprintf( stderr, "out of memory\n" );
+	exit( 1 );
+    }
+    if ( levels < 2 || levels * levels * levels > 256 ||
+	 bwlevels < 2 || bwlevels > 256 )
+    {
+	fprintf( stderr, "levels must be 2 to 6, bwlevels 2 to 256\n" );
+	exit( 1 );
+    }
+    srand( 1 );
+    for ( y = 0; y < height; y++ )
+	for ( x = 0; x < width; x++ )
+	{
+	    k = (long)y * width + x;
+	    if ( x < width / 2 )		/* gradients */
+	    {
+		r[k] = 255L * x / width;
+		g[k] = 255L * y / height;
+		b[k] = (r[k] + g[k]) / 2;
+	    }
+	    else				/* noise */
+	    {
+		r[k] = rand();
+		g[k] = rand();
+		b[k] = rand();
+	    }
+	}
+    dithermap( levels, 2.2, rgbmap, divN, modN, magic );
+    bwdithermap( bwlevels, 2.2, bwmap, bdivN, bmodN, bmagic );
+    nthresh = make_thresholds( divN, modN, magic, thresh );
+    bnthresh = make_thresholds( bdivN, bmodN, bmagic, bthresh );
+    printf( "%d x %d frame, %d and %d levels, %d and %d thresholds, "
+	    "%d repetitions\n", width, height, levels, bwlevels,
+	    nthresh, bnthresh, reps );
+
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	for ( y = 0; y < height; y++ )
+	    for ( x = 0; x < width; x++ )
+	    {
+		k = (long)y * width + x;
+		ref[k] = dithergb( x, y, r[k], g[k], b[k], levels,
+				   divN, modN, magic );
+	    }
+    report( "dithergb()", reps, seconds() - t, -1 );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	dithergb_frame( width, height, r, g, b, levels, divN, modN, magic,
+			0, NULL, out );
+    report( "dithergb_frame(), tables", reps, seconds() - t,
+	    !memcmp( out, ref, npix ) );
+    memset( out, 0, npix );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	dithergb_frame( width, height, r, g, b, levels, divN, modN, magic,
+			nthresh, thresh, out );
+    report( "dithergb_frame(), thresholds", reps, seconds() - t,
+	    !memcmp( out, ref, npix ) );
+
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	for ( y = 0; y < height; y++ )
+	    for ( x = 0; x < width; x++ )
+	    {
+		k = (long)y * width + x;
+		ref[k] = ditherbw( x, y, g[k], bdivN, bmodN, bmagic );
+	    }
+    report( "ditherbw()", reps, seconds() - t, -1 );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	ditherbw_frame( width, height, g, bdivN, bmodN, bmagic,
+			0, NULL, out );
+    report( "ditherbw_frame(), tables", reps, seconds() - t,
+	    !memcmp( out, ref, npix ) );
+    memset( out, 0, npix );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	ditherbw_frame( width, height, g, bdivN, bmodN, bmagic,
+			bnthresh, bthresh, out );
+    report( "ditherbw_frame(), thresholds", reps, seconds() - t,
+	    !memcmp( out, ref, npix ) );
+
+    chan[0] = r;
+    chan[1] = g;
+    chan[2] = b;
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	floyd( width, height, 3, chan, levels, ref );
+    report( "Floyd-Steinberg loop, rgb", reps, seconds() - t, -1 );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	diffusergb_frame( width, height, r, g, b, levels, out );
+    report( "diffusergb_frame()", reps, seconds() - t,
+	    !memcmp( out, ref, npix ) );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	floyd( width, height, 1, chan + 1, bwlevels, ref );
+    report( "Floyd-Steinberg loop, bw", reps, seconds() - t, -1 );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+	diffusebw_frame( width, height, g, bwlevels, out );
+    report( "diffusebw_frame()", reps, seconds() - t,
+	    !memcmp( out, ref, npix ) );
+#ifdef _OPENMP
+    printf( "%32s %10d\n", "threads", omp_get_max_threads() );
+#endif
+
+    return 0;
+}
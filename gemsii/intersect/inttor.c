@@ -2,6 +2,53 @@
 #include	<math.h>
 #include	"GraphicsGems.h"
 
+/* ----	torquartic - The quartic of a ray and a torus. ---------------	*/
+/*									*/
+/*	The coefficients C of the quartic in the distance along the	*/
+/*	ray Base + t Dcos, both transformed as for inttor.		*/
+/*									*/
+/* --------------------------------------------------------------------	*/
+
+
+static	void	torquartic	(Base,Dcos,radius,rplane,rnorm,C)
+
+	Point3	*Base;			/* Transformed ray base		*/
+	Vector3	*Dcos;			/* Transformed ray direction	*/
+	double	radius;			/* Major radius of the torus	*/
+	double	rplane;			/* Minor planer radius		*/
+	double	rnorm;			/* Minor normal radius		*/
+	double	C[5];			/* Quartic coefficients		*/
+
+{
+	double	rho, a0, b0;		/* Related constants		*/
+	double	f, l, t, g, q, m, u;	/* Ray dependent terms		*/
+
+/*	Compute constants related to the torus.				*/
+
+	rho = rplane*rplane / (rnorm*rnorm);
+	a0  = 4. * radius*radius;
+	b0  = radius*radius - rplane*rplane;
+
+/*	Compute ray dependent terms.					*/
+
+	f = 1. - Dcos->y*Dcos->y;
+	l = 2. * (Base->x*Dcos->x + Base->z*Dcos->z);
+	t = Base->x*Base->x + Base->z*Base->z;
+	g = f + rho * Dcos->y*Dcos->y;
+	q = a0 / (g*g);
+	m = (l + 2.*rho*Dcos->y*Base->y) / g;
+	u = (t +    rho*Base->y*Base->y + b0) / g;
+
+/*	Compute the coefficients of the quartic.			*/
+
+	C[4] = 1.0;
+	C[3] = 2. * m;
+	C[2] = m*m + 2.*u - q*f;
+	C[1] = 2.*m*u - q*l;
+	C[0] = u*u - q*t;
+}
+
+
 /* ----	inttor - Intersect a ray with a torus. ------------------------	*/
 /*									*/
 /*									*/
@@ -49,8 +96,7 @@ int	inttor	(raybase,raycos,center,radius,rplane,rnorm,tran,nhits,rhits)
 	Vector3	Base, Dcos;		/* Transformed intersection ray	*/
 	double	rmin, rmax;		/* Root bounds			*/
 	double	yin, yout;
-	double	rho, a0, b0;		/* Related constants		*/
-	double	f, l, t, g, q, m, u;	/* Ray dependent terms		*/
+	double	m, u;			/* For swapping roots		*/
 	double	C[5];			/* Quartic coefficients		*/
 
 extern	int	intsph ();		/* Intersect ray with sphere	*/
@@ -82,30 +128,10 @@ extern	int	SolveQuartic ();	/* Solve quartic equation	*/
 
 	if  (!hit) return (hit);	/* If ray is above/below torus.	*/
 
-/*	Compute constants related to the torus.				*/
-
-	rho = rplane*rplane / (rnorm*rnorm);
-	a0  = 4. * radius*radius;
-	b0  = radius*radius - rplane*rplane;
-
-/*	Compute ray dependent terms.					*/
-
-	f = 1. - Dcos.y*Dcos.y;
-	l = 2. * (Base.x*Dcos.x + Base.z*Dcos.z);
-	t = Base.x*Base.x + Base.z*Base.z;
-	g = f + rho * Dcos.y*Dcos.y;
-	q = a0 / (g*g);
-	m = (l + 2.*rho*Dcos.y*Base.y) / g;
-	u = (t +    rho*Base.y*Base.y + b0) / g;
-
 /*	Compute the coefficients of the quartic.			*/
 
-	C[4] = 1.0;
-	C[3] = 2. * m;
-	C[2] = m*m + 2.*u - q*f;
-	C[1] = 2.*m*u - q*l;
-	C[0] = u*u - q*t;
-	
+	torquartic (&Base,&Dcos,radius,rplane,rnorm,C);
+
 /*	Use quartic root solver found in "Graphics Gems" by Jochen	*/
 /*	Schwarze.							*/
 
@@ -118,3 +144,191 @@ extern	int	SolveQuartic ();	/* Solve quartic equation	*/
 	return (*nhits != 0);
 }
 
+
+
+/* ----	inttorn - Intersect a packet of rays with a torus. -----------	*/
+/*									*/
+/*									*/
+/*	Description:							*/
+/*	    Inttorn intersects n rays with one torus, giving each the	*/
+/*	    numbers and distances inttor would.  Rays are culled	*/
+/*	    first: beyond the bounding sphere and the two planes of	*/
+/*	    inttor, the part of a ray between the planes must enter	*/
+/*	    the cylinder of radius radius+rplane about the axis, and	*/
+/*	    must leave the one of radius radius-rplane (the hole).	*/
+/*	    The quartics of the rays left are solved PACKET at a time	*/
+/*	    by SolveQuarticBatch.					*/
+/*									*/
+/*	On entry:							*/
+/*	    n       = The number of rays.				*/
+/*	    raybase = The bases of the rays.				*/
+/*	    raycos  = The direction cosines of the rays.		*/
+/*	    center, radius, rplane, rnorm, tran = As for inttor.	*/
+/*									*/
+/*	On return:							*/
+/*	    nhits   = The number of intersections of each ray.		*/
+/*	    rhits   = The entering/leaving distances of each ray.	*/
+/*									*/
+/*	Returns:  The number of rays that intersect the torus.		*/
+/*									*/
+/* --------------------------------------------------------------------	*/
+
+#define	PACKET	64			/* Quartics solved together	*/
+#define	SLACK	1e-9			/* Relative widening of culls	*/
+
+
+/*	Clip [lo,hi] to where |b + t d| <= h; false if nothing is left.	*/
+
+static	int	inslab	(lo,hi,b,d,h)
+
+	double	*lo, *hi;
+	double	b, d, h;
+
+{
+	double	t0, t1;
+
+	if  (d == 0.) return (fabs (b) <= h);
+
+	t0  = (-h - b) / d;
+	t1  = ( h - b) / d;
+	*lo = MAX (*lo, MIN (t0,t1));
+	*hi = MIN (*hi, MAX (t0,t1));
+	return (*lo <= *hi);
+}
+
+
+/*	[t0,t1] where the ray is within r of the y axis; false if never.*/
+
+static	int	incyl	(t0,t1,Base,Dcos,r)
+
+	double	*t0, *t1;
+	Point3	*Base;
+	Vector3	*Dcos;
+	double	r;
+
+{
+	double	a, b, c, disc;
+
+	a = Dcos->x*Dcos->x + Dcos->z*Dcos->z;
+	b = Base->x*Dcos->x + Base->z*Dcos->z;
+	c = Base->x*Base->x + Base->z*Base->z - r*r;
+
+	if  (a == 0.) {				/* Parallel to the axis	*/
+	    *t0 = -HUGE_VAL;
+	    *t1 =  HUGE_VAL;
+	    return (c <= 0.);
+	}
+	disc = b*b - a*c;
+	if  (disc < 0.) return (FALSE);
+	disc = sqrt (disc);
+	*t0  = (-b - disc) / a;
+	*t1  = (-b + disc) / a;
+	return (TRUE);
+}
+
+
+/*	Solve the k packed quartics C of the rays ray[], and store their	*/
+/*	roots as inttor does; returns the number of rays with roots.	*/
+
+static	int	torsolve	(k,ray,C,nhits,rhits)
+
+	int	k;
+	int	*ray;
+	double	C[][5];
+	int	*nhits;
+	double	(*rhits)[4];
+
+{
+	int	j, i, nray;
+	int	num[PACKET];		/* Roots of each quartic	*/
+	double	S[PACKET][4];		/* Roots			*/
+	double	m, u, *r;
+
+extern	int	SolveQuarticBatch ();	/* Solve quartic equations	*/
+
+
+	SolveQuarticBatch (k,C,S,num);
+	for  (j = 0, nray = 0; j < k; j++) {
+	    r = rhits[ray[j]];
+	    nhits[ray[j]] = num[j];
+	    nray += (num[j] != 0);
+	    for  (i = 0; i < num[j]; i++) r[i] = S[j][i];
+
+/*	SolveQuartic returns root pairs in reversed order.		*/
+	    m = r[0]; u = r[1]; r[0] = u; r[1] = m;
+	    m = r[2]; u = r[3]; r[2] = u; r[3] = m;
+	}
+	return (nray);
+}
+
+
+int	inttorn	(n,raybase,raycos,center,radius,rplane,rnorm,tran,nhits,rhits)
+
+	int	n;			/* Number of rays		*/
+	Point3	*raybase;		/* Bases of the rays		*/
+	Vector3	*raycos;		/* Direction cosines of the rays*/
+	Point3	center;			/* Center of the torus		*/
+	double	radius;			/* Major radius of the torus	*/
+	double	rplane;			/* Minor planer radius		*/
+	double	rnorm;			/* Minor normal radius		*/
+	Matrix4	tran;			/* Transformation matrix	*/
+	int	*nhits;			/* Numbers of intersections	*/
+	double	(*rhits)[4];		/* Intersection distances	*/
+
+{
+	int	i, k, nray;		/* Rays, packed rays, hit rays	*/
+	int	ray[PACKET];		/* Ray of each packed quartic	*/
+	double	C[PACKET][5];		/* Quartic coefficients		*/
+	double	rsphere;		/* Bounding sphere radius	*/
+	Vector3	Base, Dcos;		/* Transformed intersection ray	*/
+	double	rmin, rmax;		/* Root bounds			*/
+	double	t0, t1;			/* Cylinder bounds		*/
+
+extern	int	intsph ();		/* Intersect ray with sphere	*/
+
+
+	rsphere = radius + MAX (rplane,rnorm);
+	nray    = 0;
+
+	for  (i = 0, k = 0; i < n; i++) {
+	    nhits[i] = 0;
+
+/*	Bounding sphere, and the two planes, as in inttor.		*/
+
+	    if  (!intsph (raybase[i],raycos[i],center,rsphere,&rmin,&rmax))
+		continue;
+
+	    Base = raybase[i];
+	    Dcos = raycos[i];
+	    V3MulPointByMatrix4  (&Base,&tran);
+	    V3MulVectorByMatrix4 (&Dcos,&tran);
+
+	    if  (!inslab (&rmin,&rmax,Base.y,Dcos.y,rnorm*(1.+SLACK)))
+		continue;
+
+/*	Between the planes, the ray must get within radius+rplane of	*/
+/*	the axis, and must not stay within radius-rplane.		*/
+
+	    if  (!incyl (&t0,&t1,&Base,&Dcos,(radius+rplane)*(1.+SLACK)))
+		continue;
+	    rmin = MAX (rmin,t0);
+	    rmax = MIN (rmax,t1);
+	    if  (rmin > rmax) continue;
+
+	    if  (radius > rplane &&
+		 incyl (&t0,&t1,&Base,&Dcos,(radius-rplane)*(1.-SLACK)) &&
+		 t0 < rmin && rmax < t1)
+		continue;
+
+	    torquartic (&Base,&Dcos,radius,rplane,rnorm,C[k]);
+	    ray[k++] = i;
+
+	    if  (k == PACKET) {
+		nray += torsolve (k,ray,C,nhits,rhits);
+		k     = 0;
+	    }
+	}
+	if  (k > 0) nray += torsolve (k,ray,C,nhits,rhits);
+
+	return (nray);
+}
@@ -0,0 +1,136 @@
+
+/* ----	inttorbench - Time inttor against inttorn. -------------------	*/
+/*									*/
+/*	Shoots a grid of rays from an eye at a tilted torus, once	*/
+/*	ray by ray with inttor and once as one packet with inttorn,	*/
+/*	and prints rays a second, the rays that hit, the rays whose	*/
+/*	numbers of hits differ, and the largest difference between	*/
+/*	the distances.							*/
+/*									*/
+/*	Usage: inttorbench [size [repetitions]]				*/
+/*									*/
+/* --------------------------------------------------------------------	*/
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<math.h>
+#include	<time.h>
+#include	"GraphicsGems.h"
+
+extern	int	inttor (), inttorn ();
+
+
+/*	inttor transforms its ray with these, which GraphicsGems.c	*/
+/*	does not have: p or v times the affine matrix m, in place.	*/
+
+Point3	*V3MulPointByMatrix4 (Point3 *p, Matrix4 *m)
+{
+	Point3	q;
+
+	q.x = p->x*m->element[0][0] + p->y*m->element[1][0] +
+	      p->z*m->element[2][0] + m->element[3][0];
+	q.y = p->x*m->element[0][1] + p->y*m->element[1][1] +
+	      p->z*m->element[2][1] + m->element[3][1];
+	q.z = p->x*m->element[0][2] + p->y*m->element[1][2] +
+	      p->z*m->element[2][2] + m->element[3][2];
+	*p  = q;
+	return (p);
+}
+
+Point3	*V3MulVectorByMatrix4 (Vector3 *v, Matrix4 *m)
+{
+	Vector3	w;
+
+	w.x = v->x*m->element[0][0] + v->y*m->element[1][0] +
+	      v->z*m->element[2][0];
+	w.y = v->x*m->element[0][1] + v->y*m->element[1][1] +
+	      v->z*m->element[2][1];
+	w.z = v->x*m->element[0][2] + v->y*m->element[1][2] +
+	      v->z*m->element[2][2];
+	*v  = w;
+	return (v);
+}
+
+static	double	seconds (void)
+{
+	return ((double) clock () / CLOCKS_PER_SEC);
+}
+
+int	main (int argc, char *argv[])
+{
+	int	size = argc > 1 ? atoi (argv[1]) : 256;
+	int	reps = argc > 2 ? atoi (argv[2]) : 20;
+	int	n = size*size;
+	Point3	*base = (Point3 *) malloc (n * sizeof (Point3));
+	Vector3	*dir  = (Vector3 *) malloc (n * sizeof (Vector3));
+	int	*nhit = (int *) calloc (n, sizeof (int));
+	int	*nhitn = (int *) calloc (n, sizeof (int));
+	double	(*rhit)[4] = (double (*)[4]) calloc (n, sizeof *rhit);
+	double	(*rhitn)[4] = (double (*)[4]) calloc (n, sizeof *rhitn);
+	Point3	eye, center;
+	Matrix4	tran;
+	double	radius = 2., rplane = .7, rnorm = .5, a = 20. * PI/180.;
+	double	t, diff;
+	int	i, j, k, r, hits, differ;
+
+	if  (!base || !dir || !nhit || !nhitn || !rhit || !rhitn) {
+	    fprintf (stderr, "?Unable to malloc\n");
+	    exit (1);
+	}
+
+/*	The torus at the origin, its plane tilted 20 degrees about x;	*/
+/*	the eye looks at it from above the plane.			*/
+
+	for  (i = 0; i < 16; i++)
+	    tran.element[i/4][i%4] = (i/4 == i%4);
+	tran.element[1][1] = tran.element[2][2] = cos (a);
+	tran.element[1][2] = -sin (a);
+	tran.element[2][1] =  sin (a);
+	center.x = center.y = center.z = 0.;
+	eye.x = 0.;  eye.y = 2.5;  eye.z = -7.;
+
+	for  (i = 0; i < size; i++)
+	    for  (j = 0; j < size; j++) {
+		Vector3	*d = &dir[i*size + j];
+		base[i*size + j] = eye;
+		d->x = 6. * (j + .5) / size - 3. - eye.x;
+		d->y = 4. * (i + .5) / size - 2. - eye.y;
+		d->z = -eye.z;
+		V3Normalize (d);
+	    }
+
+	for  (i = 0; i < n; i++)
+	    inttor (base[i],dir[i],center,radius,rplane,rnorm,tran,
+		    &nhit[i],rhit[i]);
+	hits = inttorn (n,base,dir,center,radius,rplane,rnorm,tran,nhitn,rhitn);
+	for  (i = 0, differ = 0, diff = 0.; i < n; i++) {
+	    differ += (nhit[i] != nhitn[i]);
+	    for  (k = 0; k < nhit[i] && k < nhitn[i]; k++) {
+		j = k ^ 1;		/* root k, after the pair swap	*/
+		if  (fabs (rhit[i][j] - rhitn[i][j]) > diff)
+		    diff = fabs (rhit[i][j] - rhitn[i][j]);
+	    }
+	}
+
+	printf ("%d rays, %d repetitions\n", n, reps);
+	printf ("%-10s %14s %10s %10s %12s\n",
+		"routine", "rays/s", "hits", "differ", "distances");
+
+	t = seconds ();
+	for  (r = 0; r < reps; r++)
+	    for  (i = 0; i < n; i++)
+		inttor (base[i],dir[i],center,radius,rplane,rnorm,tran,
+			&nhit[i],rhit[i]);
+	t = seconds () - t;
+	for  (i = 0, k = 0; i < n; i++)
+	    k += (nhit[i] != 0);
+	printf ("%-10s %14.0f %10d\n", "inttor", (double) n * reps / t, k);
+
+	t = seconds ();
+	for  (r = 0; r < reps; r++)
+	    inttorn (n,base,dir,center,radius,rplane,rnorm,tran,nhitn,rhitn);
+	t = seconds () - t;
+	printf ("%-10s %14.0f %10d %10d %12.3g\n", "inttorn",
+		(double) n * reps / t, hits, differ, diff);
+	return (0);
+}
@@ -2,12 +2,21 @@
  *
  * A simple fast memory allocation package.
  *
- * AllocInit()    - create an alloc pool, returns the old pool handle.
- * Alloc()        - allocate memory.
- * AllocReset()   - reset the current pool.
- * AllocSetPool() - set the current pool.
- * AllocFree()    - free the memory used by the current pool.
+ * AllocInit()     - create an alloc pool, returns the old pool handle.
+ * AllocInitPool() - create a pool with a given block size, alignment
+ *                   and flags, returns the old pool handle.
+ * Alloc()         - allocate memory.
+ * AllocSetAlign() - change the alignment of the current pool.
+ * AllocMark()     - remember the current position in the pool.
+ * AllocRelease()  - free everything allocated since a mark.
+ * AllocReset()    - reset the current pool.
+ * AllocSetPool()  - set the current pool.
+ * AllocStats()    - report how the current pool is being used.
+ * AllocFree()     - free the memory used by the current pool.
  *
+ * The current pool is private to each thread, so several threads
+ * may allocate from their own pools without locking.  A pool must
+ * only be used by one thread at a time.
  */
 
 #include <stdlib.h>
@@ -15,12 +24,33 @@
 
 #include "alloc.h"
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 /* ALLOC_BLOCK_SIZE - adjust this size to suit your installation - it should
  * be reasonably * large otherwise you will be mallocing a lot.
  */
 
 #define ALLOC_BLOCK_SIZE        (100*1024)
 
+/* ALLOC_HUGE_PAGE_SIZE - blocks backed by huge pages are rounded up to
+ * a multiple of this size.
+ */
+
+#define ALLOC_HUGE_PAGE_SIZE    (2*1024*1024)
+
+/* ALLOC_THREAD - storage class for the per thread current pool
+ */
+
+#if defined(_MSC_VER)
+#define ALLOC_THREAD            __declspec(thread)
+#elif defined(__GNUC__)
+#define ALLOC_THREAD            __thread
+#else
+#define ALLOC_THREAD
+#endif
+
 /* alloc_hdr_t - Header for each block of memory
  */
 
@@ -30,7 +60,9 @@ struct alloc_hdr_s
         struct alloc_hdr_s *next;   /* Next Block          */
         char               *block,  /* Start of block      */
                            *free,   /* Next free in block  */
-                           *end;    /* block + block size  */
+                           *end,    /* block + block size  */
+                           *base;   /* What to give back   */
+        long                mapped; /* Length if mmap()ed  */
 }
 alloc_hdr_t;
 
@@ -40,29 +72,106 @@ alloc_hdr_t;
 typedef
 struct alloc_root_s
 {
-        alloc_hdr_t *first,   /* First header in pool */
-                    *current; /* Current header       */
+        alloc_hdr_t *first,     /* First header in pool   */
+                    *current;   /* Current header         */
+        long         block_size;/* Size of a normal block */
+        int          align,     /* Alignment of Alloc()   */
+                     flags;     /* ALLOC_HUGE_PAGES, ...  */
+        alloc_stats_t stats;    /* Instrumentation        */
 }
 alloc_root_t;
 
-/* root - Pointer to the the current pool
+/* root - Pointer to the the current pool of this thread
  */
 
-static alloc_root_t *root;
+static ALLOC_THREAD alloc_root_t *root;
+
+/* AllocAlignPtr()
+ *
+ * Private routine to round ptr up to a multiple of align, which
+ * must be a power of two.
+ */
+
+static
+char *
+AllocAlignPtr(ptr, align)
+char        *ptr;
+int         align;
+{
+        size_t        mask = (size_t) align - 1;
+
+        return(ptr + ((0 - (size_t) ptr) & mask));
+}
+
+/* AllocBlock()
+ *
+ * Private routine to get memory for a block of *size bytes.  Huge
+ * page blocks may round *size up; *mapped is set to the mapping
+ * length, or 0 if the block came from malloc().
+ */
+
+static
+char *
+AllocBlock(size, mapped)
+long        *size;
+long        *mapped;
+{
+        *mapped = 0;
+
+#if defined(__linux__)
+        if (root->flags & ALLOC_HUGE_PAGES)
+        {
+                long        len;
+                void        *mem;
+
+                len = (*size + ALLOC_HUGE_PAGE_SIZE - 1) &
+                      ~(long) (ALLOC_HUGE_PAGE_SIZE - 1);
+                mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+                mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+                /* No reserved huge pages - ask for transparent ones */
+                if (mem == MAP_FAILED)
+                {
+                        mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+                        if (mem != MAP_FAILED)
+                                madvise(mem, len, MADV_HUGEPAGE);
+#endif
+                }
+                if (mem != MAP_FAILED)
+                {
+                        *size   = len;
+                        *mapped = len;
+                        return((char *) mem);
+                }
+        }
+#endif
+        return((char *) malloc(*size));
+}
 
 /* AllocHdr()
  *
- * Private routine to allocate a header and memory block.
+ * Private routine to allocate a header and a memory block with room
+ * for at least size bytes at the pool alignment.
  */
 
 static
 alloc_hdr_t *
-AllocHdr()
+AllocHdr(size)
+long        size;
 {
         alloc_hdr_t        *hdr;
         char               *block;
+        long                mapped;
 
-        block = (char *) malloc(ALLOC_BLOCK_SIZE);
+        if (size < root->block_size)
+                size = root->block_size;
+        size += root->align;
+
+        block = AllocBlock(&size, &mapped);
         hdr   = (alloc_hdr_t *) malloc(sizeof(alloc_hdr_t));
 
         if (hdr == NULL || block == NULL)
@@ -70,14 +179,68 @@ AllocHdr()
                 fprintf(stderr, "Out of memory\n");
                 exit(1);
         }
-        hdr->block = block;
-        hdr->free  = block;
-        hdr->next  = NULL;
-        hdr->end   = block + ALLOC_BLOCK_SIZE;
+        hdr->base   = block;
+        hdr->mapped = mapped;
+        hdr->block  = AllocAlignPtr(block, root->align);
+        hdr->free   = hdr->block;
+        hdr->next   = NULL;
+        hdr->end    = block + size;
+
+        root->stats.blocks++;
+        root->stats.reserved += size;
 
         return(hdr);
 }
 
+/* AllocFreeHdr()
+ *
+ * Private routine to give back a header and its block.
+ */
+
+static
+void
+AllocFreeHdr(hdr)
+alloc_hdr_t        *hdr;
+{
+#if defined(__linux__)
+        if (hdr->mapped)
+                munmap(hdr->base, hdr->mapped);
+        else
+#endif
+                free((char *) hdr->base);
+        free((char *) hdr);
+}
+
+/* AllocInitPool()
+ *
+ * Create a new memory pool with one block of block_size bytes,
+ * returning memory aligned to align bytes (a power of two, eg 32 or
+ * 64 for SIMD types).  flags may be ALLOC_HUGE_PAGES.
+ * Returns pointer to the previous pool.
+ */
+
+alloc_handle_t *
+AllocInitPool(block_size, align, flags)
+int        block_size;
+int        align;
+int        flags;
+{
+        alloc_handle_t        *old = (alloc_handle_t *) root;
+
+        root = (alloc_root_t *) calloc(1, sizeof(alloc_root_t));
+        if (root == NULL)
+        {
+                fprintf(stderr, "Out of memory\n");
+                exit(1);
+        }
+        root->block_size = block_size > 0 ? block_size : ALLOC_BLOCK_SIZE;
+        root->align      = align > 0 ? align : ALLOC_ALIGN;
+        root->flags      = flags;
+        root->first      = AllocHdr(0L);
+        root->current    = root->first;
+        return(old);
+}
+
 /* AllocInit()
  *
  * Create a new memory pool with one block.
@@ -87,12 +250,41 @@ AllocHdr()
 alloc_handle_t *
 AllocInit()
 {
-        alloc_handle_t        *old = (alloc_handle_t *) root;
+        return(AllocInitPool(ALLOC_BLOCK_SIZE, ALLOC_ALIGN, 0));
+}
 
-        root = (alloc_root_t *) malloc(sizeof(alloc_root_t));
-        root->first = AllocHdr();
-        root->current  = root->first;
-        return(old);
+/* AllocNextHdr()
+ *
+ * Private routine to move the pool on to a block with room for size
+ * bytes.  Blocks left over from an AllocReset() are re-used when
+ * they are big enough, otherwise a new block is linked in after hdr.
+ */
+
+static
+alloc_hdr_t *
+AllocNextHdr(hdr, size)
+alloc_hdr_t        *hdr;
+long                size;
+{
+        alloc_hdr_t        *next = hdr->next;
+
+        root->stats.wasted += hdr->end - hdr->free;
+
+        if (next != NULL &&
+            AllocAlignPtr(next->block, root->align) + size <= next->end)
+        {
+                /* re-use block */
+                next->free = next->block;
+        }
+        else
+        {
+                /* extend the pool with a new block */
+                next = AllocHdr(size);
+                next->next = hdr->next;
+                hdr->next = next;
+        }
+        root->current = next;
+        return(next);
 }
 
 /* Alloc()
@@ -108,41 +300,44 @@ int        size;
         alloc_hdr_t        *hdr = root->current;
         char               *ptr;
 
-        /* Align to 4 byte boundary - should be OK for most machines.
-         * Change this if your machine has wierd alignment requirements
-         */
-        size = (size + 3) & 0xfffffffc;
-
-        ptr = hdr->free;
-        hdr->free += size;
+        ptr = AllocAlignPtr(hdr->free, root->align);
 
         /* Check if the current block is exhausted */
 
-        if (hdr->free >= hdr->end)
+        if (ptr + size > hdr->end)
         {
-                /* Is the next block already allocated? */
+                hdr = AllocNextHdr(hdr, (long) size);
+                ptr = AllocAlignPtr(hdr->free, root->align);
+        }
+        hdr->free = ptr + size;
 
-                if (hdr->next != NULL)
-                {
-                        /* re-use block */
-                        hdr->next->free = hdr->next->block;
-                        root->current = hdr->next;
-                }
-                else
-                {
-                        /* extend the pool with a new block */
-                        hdr->next = AllocHdr();
-                        root->current = hdr->next;
-                }
+        root->stats.allocated += size;
+        if (root->stats.allocated > root->stats.peak)
+                root->stats.peak = root->stats.allocated;
 
-                /* set ptr to the first location in the next block */
-                ptr = root->current->free;
-                root->current->free += size;
-        }
         /* Return pointer to allocated memory */
         return(ptr);
 }
 
+/* AllocSetAlign()
+ *
+ * Change the alignment of memory returned from the current pool.
+ * align must be a power of two.  It can be changed at any time: each
+ * Alloc() aligns its pointer to the value then in force, padding within
+ * the block, and a block is only reused if it still fits at that
+ * alignment.  Returns the old alignment.
+ */
+
+int
+AllocSetAlign(align)
+int        align;
+{
+        int        old = root->align;
+
+        root->align = align > 0 ? align : ALLOC_ALIGN;
+        return(old);
+}
+
 /* AllocSetPool()
  *
  * Change the current pool.  Return the old pool.
@@ -158,6 +353,38 @@ alloc_handle_t        *new;
         return(old);
 }
 
+/* AllocMark()
+ *
+ * Remember the current position in the current pool.
+ */
+
+void
+AllocMark(mark)
+alloc_mark_t        *mark;
+{
+        mark->hdr       = (void *) root->current;
+        mark->free      = root->current->free;
+        mark->allocated = root->stats.allocated;
+        mark->wasted    = root->stats.wasted;
+}
+
+/* AllocRelease()
+ *
+ * Give back everything allocated from the current pool since mark
+ * was taken.  Like AllocReset() no memory is freed, later blocks
+ * are kept for re-use.
+ */
+
+void
+AllocRelease(mark)
+alloc_mark_t        *mark;
+{
+        root->current       = (alloc_hdr_t *) mark->hdr;
+        root->current->free = mark->free;
+        root->stats.allocated = mark->allocated;
+        root->stats.wasted    = mark->wasted;
+}
+
 /* AllocReset()
  *
  * Reset the current pool for re-use.  No memory is freed, so
@@ -169,6 +396,20 @@ AllocReset()
 {
         root->current = root->first;
         root->current->free = root->current->block;
+        root->stats.allocated = 0;
+        root->stats.wasted    = 0;
+}
+
+/* AllocStats()
+ *
+ * Copy the instrumentation for the current pool to stats.
+ */
+
+void
+AllocStats(stats)
+alloc_stats_t        *stats;
+{
+        *stats = root->stats;
 }
 
 /* AllocFreePool()
@@ -181,12 +422,13 @@ void
 AllocFreePool()
 {
         alloc_hdr_t        *hdr = root->first;
+        alloc_hdr_t        *next;
 
         while (hdr != NULL)
         {
-                free((char *) hdr->block);
-                free((char *) hdr);
-                hdr = hdr->next;
+                next = hdr->next;
+                AllocFreeHdr(hdr);
+                hdr = next;
         }
         free((char *) root);
         root = NULL;
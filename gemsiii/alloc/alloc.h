@@ -10,3 +10,45 @@ typedef
 struct { int dummy; }
 alloc_handle_t;
 
+/* alloc_mark_t - a position in the current pool saved by AllocMark()
+ * and restored by AllocRelease().  The fields are private.
+ */
+
+typedef
+struct { void *hdr; char *free; long allocated, wasted; }
+alloc_mark_t;
+
+/* alloc_stats_t - instrumentation returned by AllocStats()
+ */
+
+typedef
+struct
+{
+        long allocated;   /* bytes handed out since the last reset   */
+        long peak;        /* largest value allocated has reached     */
+        long wasted;      /* tail bytes skipped when changing blocks */
+        long blocks;      /* blocks owned by the pool                */
+        long reserved;    /* total bytes in those blocks             */
+}
+alloc_stats_t;
+
+/* Flags for AllocInitPool()
+ */
+
+#define ALLOC_HUGE_PAGES        1   /* back blocks with huge pages if possible */
+
+/* Default alignment of memory returned by Alloc()
+ */
+
+#define ALLOC_ALIGN             8
+
+extern alloc_handle_t  *AllocInit(void);
+extern alloc_handle_t  *AllocInitPool(int block_size, int align, int flags);
+extern char            *Alloc(int size);
+extern int              AllocSetAlign(int align);
+extern alloc_handle_t  *AllocSetPool(alloc_handle_t *new_pool);
+extern void             AllocMark(alloc_mark_t *mark);
+extern void             AllocRelease(alloc_mark_t *mark);
+extern void             AllocReset(void);
+extern void             AllocStats(alloc_stats_t *stats);
+extern void             AllocFreePool(void);
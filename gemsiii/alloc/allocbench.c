@@ -0,0 +1,145 @@
+/* allocbench.c
+ *
+ * Times Alloc() against malloc() on the allocation patterns of two
+ * other gems: the implicit surface polygonizer (gemsiv/implicit.c),
+ * which allocates many small list nodes of mixed size per cube, and
+ * the trapezoidation (gemsv/ch7-5/construct.c), which allocates fixed
+ * size trapezoid and query tree records per segment.  Everything is
+ * thrown away at the end of each run, one AllocReset() for the pool
+ * against one free() per node for malloc.
+ *
+ * usage: allocbench [runs [items]]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "alloc.h"
+
+/* Record sizes taken from the two gems */
+
+typedef struct { int i, j, k; double x, y, z, value; } corner_t;
+typedef struct { int i, j, k; double value; void *next; } cornerlist_t;
+typedef struct { int i, j, k; void *next; } centerlist_t;
+typedef struct { int i1, j1, k1, i2, j2, k2, vid; void *next; } edgelist_t;
+typedef struct { int i, j, k; corner_t *corners[8]; void *next; } cubes_t;
+typedef struct { int lseg, rseg; double hi[2], lo[2];
+                 int u0, u1, d0, d1, sink, usave, uside, state; } trap_t;
+typedef struct { int nodetype, segnum; double yval[2];
+                 int trnum, parent, left, right; } node_t;
+
+static int implicit_sizes[] = {
+        sizeof(cubes_t), sizeof(centerlist_t), sizeof(corner_t),
+        sizeof(cornerlist_t), sizeof(edgelist_t), sizeof(edgelist_t),
+        sizeof(edgelist_t), sizeof(corner_t), sizeof(cornerlist_t)
+};
+
+static int construct_sizes[] = {
+        sizeof(trap_t), sizeof(trap_t), sizeof(node_t),
+        sizeof(node_t), sizeof(node_t)
+};
+
+#define NSIZES(a)       ((int) (sizeof(a) / sizeof((a)[0])))
+
+static char **ptrs;
+
+static double
+seconds(start)
+clock_t start;
+{
+        return((double) (clock() - start) / CLOCKS_PER_SEC);
+}
+
+static double
+time_malloc(sizes, nsizes, runs, items)
+int *sizes, nsizes, runs, items;
+{
+        clock_t start = clock();
+        int     r, i;
+
+        for (r = 0; r < runs; r++)
+        {
+                for (i = 0; i < items; i++)
+                {
+                        ptrs[i] = (char *) malloc(sizes[i % nsizes]);
+                        ptrs[i][0] = (char) i;
+                }
+                for (i = 0; i < items; i++)
+                        free(ptrs[i]);
+        }
+        return(seconds(start));
+}
+
+static double
+time_alloc(sizes, nsizes, runs, items)
+int *sizes, nsizes, runs, items;
+{
+        clock_t start = clock();
+        int     r, i;
+
+        for (r = 0; r < runs; r++)
+        {
+                for (i = 0; i < items; i++)
+                {
+                        ptrs[i] = Alloc(sizes[i % nsizes]);
+                        ptrs[i][0] = (char) i;
+                }
+                /* keep the last run so AllocStats() can see it */
+                if (r + 1 < runs)
+                        AllocReset();
+        }
+        return(seconds(start));
+}
+
+static void
+bench(name, sizes, nsizes, runs, items)
+char *name;
+int *sizes, nsizes, runs, items;
+{
+        static int     aligns[] = { 8, 32, 64 };
+        alloc_stats_t  stats;
+        double         t, n = (double) runs * items;
+        int            a;
+
+        t = time_malloc(sizes, nsizes, runs, items);
+        printf("%-10s malloc        %8.2f ns/alloc\n", name, 1e9 * t / n);
+
+        for (a = 0; a < NSIZES(aligns); a++)
+        {
+                AllocInitPool(0, aligns[a], 0);
+                t = time_alloc(sizes, nsizes, runs, items);
+                AllocStats(&stats);
+                printf("%-10s Alloc align %2d %8.2f ns/alloc  "
+                       "peak %ld wasted %ld blocks %ld\n", name, aligns[a],
+                       1e9 * t / n, stats.peak, stats.wasted, stats.blocks);
+                AllocFreePool();
+        }
+
+        AllocInitPool(0, 64, ALLOC_HUGE_PAGES);
+        t = time_alloc(sizes, nsizes, runs, items);
+        AllocStats(&stats);
+        printf("%-10s Alloc huge 64  %8.2f ns/alloc  reserved %ld\n",
+               name, 1e9 * t / n, stats.reserved);
+        AllocFreePool();
+}
+
+int
+main(argc, argv)
+int argc;
+char **argv;
+{
+        int runs  = argc > 1 ? atoi(argv[1]) : 20;
+        int items = argc > 2 ? atoi(argv[2]) : 200000;
+
+        ptrs = (char **) malloc(items * sizeof(char *));
+        if (ptrs == NULL)
+        {
+                fprintf(stderr, "Out of memory\n");
+                return(1);
+        }
+        bench("implicit", implicit_sizes, NSIZES(implicit_sizes), runs, items);
+        bench("construct", construct_sizes, NSIZES(construct_sizes), runs, items);
+        free((char *) ptrs);
+        return(0);
+}
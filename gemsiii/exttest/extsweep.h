@@ -0,0 +1,111 @@
+/******************************************************************
+extsweep.h
+
+This is the header file for a C++ class for incremental n-dimensional
+extent overlap checking (sweep and prune). It is meant for objects
+that move a little from one frame to the next: rather than sorting
+and testing every extent again as ExtHit::test does, the sorted lists
+of extent end points are kept from frame to frame and repaired with
+an insertion sort, and only the pairs that start or stop overlapping
+are reported. The Extent type and number of dimensions are the ones
+from exthit.h.
+
+  ExtSweep(size) - where size is the number of extents to make room
+	for. Unlike ExtHit the tables grow as extents are added.
+
+  ~ExtSweep () - frees the memory allocated for the internal tables.
+
+  int add( Extent &extent, Ptr obj ) - This method adds an extent for
+    the object obj and returns a handle for it, used with move. New
+	extents are taken into account by the next update.
+
+  void move( int handle, Extent &extent ) - This method changes the
+    extent of the object with the given handle.
+
+  void update( PairFunc added, PairFunc removed, Ptr data ) - This
+    method brings the overlapping pairs up to date with the current
+	extents. added is called for each pair of objects whose extents
+	have begun to overlap since the last update, and removed for each
+	pair that has stopped overlapping; either may be NULL. They are
+	called in the same way as the func argument of ExtHit::test. This
+	is how a narrow phase test (such as the couples of collide.c) can
+	be kept up to date: create a couple when a pair is added and throw
+	it away when it is removed.
+
+  void sweep( PairFunc added, PairFunc removed, Ptr data ) - Same as
+    update, but sorts the lists from scratch and sweeps them. update
+	does this itself when many extents have been added.
+
+  int numPairs() - returns the number of pairs currently overlapping.
+
+  void pairs( PairFunc func, Ptr data ) - calls func for each pair
+    currently overlapping.
+******************************************************************/
+
+#ifndef _EXTSWEEP_H
+#define _EXTSWEEP_H
+
+#ifndef _EXTHIT_H
+#include "exthit.h"
+#endif
+
+typedef void (*PairFunc)(Ptr d, Ptr obj1, Ptr obj2);
+
+typedef struct tagEndPoint
+{
+  int value;				// The extent dimension value
+  int id;					// Handle * 2, plus 1 for a maximum value
+} EndPoint;
+
+typedef struct tagPairRecord
+{
+  unsigned int a, b;		// Handles of the pair, a < b, a == ~0 if empty
+  unsigned int stamp;		// Last sweep that saw this pair
+} PairRecord;
+
+/******************************************************************
+ Definition for the ExtSweep class
+ ******************************************************************/
+class ExtSweep
+{
+  public:
+	ExtSweep (int size);					// Class constructor
+	~ExtSweep ();							// Class destructor
+	int add( Extent &extent, Ptr obj );		// Adds an extent
+	void move( int handle, Extent &extent );// Changes an extent
+	void update (PairFunc added, PairFunc removed, Ptr data);
+											// Incremental overlap testing
+	void sweep (PairFunc added, PairFunc removed, Ptr data);
+											// Full overlap testing
+	int numPairs () { return numPairRecs; }
+	void pairs (PairFunc func, Ptr data);	// Calls func for each pair
+
+  private:
+	int maxSize;				// Room in the object tables
+	int numObjs;				// Number of extents added
+	int numSorted;				// Number of extents in the end point lists
+	Extent *extents;			// Current extent of each object
+	Extent *previous;			// Extent of each object at the last update
+	Ptr *objs;					// Parent object of each extent
+	EndPoint *endPoints[num_dimensions];	// Sorted end points per dimension
+	int *position[num_dimensions];	// Index in endPoints of each end point
+	int *open;					// Scratch list for sweep
+
+	PairRecord *pairTable;		// Open addressed hash of overlapping pairs
+	int pairTableSize;			// Size of pairTable, a power of two
+	int numPairRecs;			// Number of pairs in pairTable
+	unsigned int sweepStamp;	// Incremented by each sweep
+
+	BOOL overlap ( Extent &e1, Extent &e2 );
+	void sortDimension ( int dim, PairFunc added, PairFunc removed, Ptr data );
+	PairRecord *findPair ( int h1, int h2 );
+	BOOL addPair ( int h1, int h2, PairFunc added, Ptr data );
+	void removePair ( int h1, int h2, PairFunc removed, Ptr data );
+	void growPairs ();
+};
+
+#endif
+
+/******************************************************************
+ End of extsweep.h
+ ******************************************************************/
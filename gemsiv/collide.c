@@ -8,6 +8,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 typedef long	       Boolean;
 
@@ -44,6 +48,7 @@ typedef long	       Boolean;
 
 typedef struct polyhedron {
    double   verts[MAX_VERTS][3]; /* 3-D vertices of polyhedron. */
+   double   soa[3][MAX_VERTS];	 /* the same vertices as x, y and z arrays. */
    int	    m;			 /* number of 3-D vertices.  */
    double   trn[3];		 /* translational position in world coords. */
    double   itrn[3];		 /* inverse of translational position. */
@@ -68,6 +73,9 @@ typedef struct couple {
    double      pln_pnt2[3];	/* 2nd point used to form separating plane. */
    int	       vert_indx[4][2]; /* cached points for distance algorithm. */
    int	       n;		/* number of cached points, if any. */
+   Boolean     warm;		/* start dist3d_poly from the cached points. */
+   long	       calls;		/* number of calls to dist3d_poly. */
+   long	       iters;		/* total iterations in dist3d_poly. */
 } *Couple;
 
 
@@ -185,90 +193,6 @@ double	    sph_verts[];
 }
 
 
-/*** RJR 05/26/93 ***********************************************************
- *
- *   Function to evaluate the support and contact functions at A for a given
- *   polytope. See equations (6) & (7).
- *
- *   On Entry:
- *	P   - table of 3-element points containing polytope vertices.
- *	r   - number of points in table.
- *	A   - vector at which support and contact functions will be evaluated.
- *	Cp  - empty 3-element array.
- *	P_i - pointer to an int.
- *
- *   On Exit:
- *	Cp  - contact point of P w.r.t. A.
- *	P_i - index into P of contact point.
- *
- *   Function Return :
- *	the result of the evaluation of eq. (6) for P and A.
- *
- ****************************************************************************/
-
-double Hp(P, r, A, Cp, P_i)
-double		 P[][3], A[], Cp[];
-int		 r, *P_i;
-{
-   int		 i;
-   double	 max_val, val;
-
-   max_val = DOT3(P[0], A);	 *P_i = 0;
-
-   for (i = 1; i < r; i++) {
-      val = DOT3(P[i], A);
-      if (val > max_val) {
-	 *P_i = i;
-	 max_val = val;
-      }
-   }
-   CPVECTOR3(Cp, P[*P_i]);
-
-   return max_val;
-}
-
-
-/*** RJR 05/26/93 ***********************************************************
- *
- *   Function to evaluate the support and contact functions at A for the
- *   set difference of two polytopes. See equations (8) & (9).
- *
- *   On Entry:
- *	P1   - table of 3-element points containing first polytope's vertices.
- *	m1   - number of points in P1.
- *	P2   - table of 3-element points containing second polytope's vertices.
- *	m2   - number of points in P2.
- *	A    - vector at which to evaluate support and contact functions.
- *	Cs   - an empty array of size 3.
- *	P1_i - a pointer to an int.
- *	P2_i - a pointer to an int.
- *
- *   On Exit:
- *	Cs   - solution to equation 9.
- *	P1_i - index into P1 for solution to equation 9.
- *	P2_i - index into P2 for solution to equation 9.
- *
- *   Function Return :
- *	the result of the evaluation of eq. (8) for P1 and P2 at A.
- *
- ****************************************************************************/
-
-double Hs(P1, m1, P2, m2, A, Cs, P1_i, P2_i)
-double	     P1[][3], P2[][3], A[], Cs[];
-int	     m1, m2, *P1_i, *P2_i;
-{
-   double    Cp_1[3], Cp_2[3], neg_A[3], Hp_1, Hp_2;
-
-   Hp_1 = Hp(P1, m1, A, Cp_1, P1_i);
-
-   CPVECTOR3(neg_A, A);
-   VECNEGATE3(neg_A);
-   Hp_2 = Hp(P2, m2, neg_A, Cp_2, P2_i);
-
-   VECSUB3(Cs ,Cp_1, Cp_2);
-
-   return (Hp_1 + Hp_2);
-}
 
 /*** RJR 05/26/93 ***********************************************************
  *
@@ -549,65 +473,144 @@ int	      near_indx[], m;
 }
 
 
-/*** RJR 05/26/93 ***********************************************************
+/****************************************************************************
+ *
+ *   Function to evaluate the support and contact functions at A for a
+ *   translated polyhedron, using its x, y, z vertex arrays.  Four running
+ *   maxima are kept so the loop has no dependency from one vertex to the
+ *   next and can be vectorized.  See equations (6) & (7).
+ *
+ *   On Entry:
+ *	polyhedron - polyhedron to evaluate.
+ *	A	   - vector at which support and contact functions will be
+ *		     evaluated.
+ *	Cp	   - empty 3-element array.
+ *	P_i	   - pointer to an int.
+ *
+ *   On Exit:
+ *	Cp  - contact point of the polyhedron w.r.t. A in world coords.
+ *	P_i - index into the vertices of the contact point.
+ *
+ *   Function Return :
+ *	the result of the evaluation of eq. (6) for the polyhedron and A.
+ *
+ ****************************************************************************/
+
+double Hp_poly(polyhedron, A, Cp, P_i)
+Polyhedron	 polyhedron;
+double		 A[], Cp[];
+int		 *P_i;
+{
+   int		 i, l, m, best_i[4];
+   double	 best[4], val;
+   double	 *x = polyhedron->soa[0], *y = polyhedron->soa[1],
+		 *z = polyhedron->soa[2];
+
+   m = polyhedron->m;
+   for (l = 0; l < 4; l++) {
+      best[l] = x[0] * A[0] + y[0] * A[1] + z[0] * A[2];
+      best_i[l] = 0;
+   }
+
+   for (i = 0; i + 4 <= m; i += 4)
+      for (l = 0; l < 4; l++) {
+	 val = x[i+l] * A[0] + y[i+l] * A[1] + z[i+l] * A[2];
+	 if (val > best[l]) {
+	    best[l] = val;
+	    best_i[l] = i + l;
+	 }
+      }
+   for (; i < m; i++) {
+      val = x[i] * A[0] + y[i] * A[1] + z[i] * A[2];
+      if (val > best[0]) {
+	 best[0] = val;
+	 best_i[0] = i;
+      }
+   }
+
+   /** the lowest index wins ties **/
+
+   for (l = 1; l < 4; l++)
+      if (best[l] > best[0] || (best[l] == best[0] && best_i[l] < best_i[0])) {
+	 best[0] = best[l];
+	 best_i[0] = best_i[l];
+      }
+
+   *P_i = best_i[0];
+   VECADD3(Cp, polyhedron->verts[*P_i], polyhedron->trn);
+
+   return best[0] + DOT3(polyhedron->trn, A);
+}
+
+
+/****************************************************************************
  *
- *   Function to compute the minimum distance between two convex polytopes in
- *   3-space.
+ *   Function to compute the minimum distance between two translated
+ *   polyhedra, which are convex polytopes in 3-space.  It works directly
+ *   on the polyhedra, so the vertices never have to be copied into world
+ *   coordinates; only the support points that are used are translated.
  *
  *   On Entry:
- *	   P1 - table of 3-element points containing first polytope's vertices.
- *	   m1 - number of points in P1.
- *	   P2 - table of 3-element points containing second polytope's vertices.
- *	   m2 - number of points in P2.
+ *	   p1 - first polyhedron.
+ *	   p2 - second polyhedron.
  *	   VP - an empty array of size 3.
  *  near_indx - a 4x2 matrix possibly containing indices of initialization
- *		points. The first column are indices into P1, and the second
- *		column are indices into P2.
+ *		points. The first column are indices into p1's vertices, and
+ *		the second column are indices into p2's.
  *     lambda - an empty array of size 4.
  *	   m3 - a pointer to an int, which indicates how many initial points
  *		to extract from near_indx. If 0, near_indx is ignored.
+ *	iters - a pointer to a long.
  *
  *   On Exit:
- *	 Vp   - vector difference of the two near points in P1 and P2.
- *		The length of this vector is the minimum distance between P1
- *		and P2.
- *  near_indx - updated indices into P1 and P2 which indicate the affinely
+ *	 Vp   - vector difference of the two near points in p1 and p2.
+ *		The length of this vector is the minimum distance between p1
+ *		and p2.
+ *  near_indx - updated indices into p1 and p2 which indicate the affinely
  *		independent point sets from each polytope which can be used
- *		to compute along with lambda the near points in P1 and P2
+ *		to compute along with lambda the near points in p1 and p2
  *		as in eq. (12). These indices can be used to re-initialize
- *		dist3d in the next iteration.
+ *		dist3d_poly in the next iteration.
  *     lambda - the lambda as in eqs. (11) & (12).
- *	   m3 - the updated number of indices for P1 and P2 in near_indx.
+ *	   m3 - the updated number of indices for p1 and p2 in near_indx.
+ *	iters - incremented by the number of iterations taken.
  *
  *   Function Return : none.
  *
  ****************************************************************************/
 
-void dist3d(P1, m1, P2, m2, VP, near_indx, lambda, m3)
-double		    P1[][3], P2[][3], VP[], lambda[];
-int		    m1, m2, near_indx[][2], *m3;
+void dist3d_poly(p1, p2, VP, near_indx, lambda, m3, iters)
+Polyhedron	    p1, p2;
+double		    VP[], lambda[];
+int		    near_indx[][2], *m3;
+long		    *iters;
 {
    Boolean	    pass;
    int		    set_size, I[4], i, j, i_tab[4], j_tab[4], P1_i, P2_i, k;
-   double	    Hs(), Pk[4][3], Pk_subset[4][3], Vk[3], neg_Vk[3], Cp[3],
+   double	    Pk[4][3], Pk_subset[4][3], Vk[3], neg_Vk[3], Cp[3], Cp_2[3],
 		    Gp;
 
    if ((*m3) == 0) {	     /** if *m3 == 0 use single point initialization **/
       set_size = 1;
-      VECSUB3(Pk[0], P1[0], P2[0]);	 /** first elementary polytope **/
+      VECSUB3(Pk[0], p1->verts[0], p2->verts[0]);
+      VECADD3(Pk[0], Pk[0], p1->trn);
+      VECSUB3(Pk[0], Pk[0], p2->trn);
       i_tab[0] = j_tab[0] = 0;
    }
    else {				 /** else use indices from near_indx **/
       for (k = 0; k < (*m3); k++) {
 	 i = i_tab[k] = near_indx[k][0];
 	 j = j_tab[k] = near_indx[k][1];
-	 VECSUB3(Pk[k], P1[i], P2[j]);	 /** first elementary polytope **/
+	 VECSUB3(Pk[k], p1->verts[i], p2->verts[j]);
+	 VECADD3(Pk[k], Pk[k], p1->trn);
+	 VECSUB3(Pk[k], Pk[k], p2->trn);
       }
       set_size = *m3;
    }
 
    pass = FALSE;
    while (!pass) {
+      (*iters)++;
 
       /** compute Vk **/
 
@@ -618,17 +621,19 @@ int		    m1, m2, near_indx[][2], *m3;
       else
 	 set_size = sub_dist(Pk, set_size, Vk, I, lambda);
 
-      /** eq. (13) **/
+      /** eq. (13), the support function of the set difference (8) **/
 
       CPVECTOR3(neg_Vk, Vk);	  VECNEGATE3(neg_Vk);
-      Gp = DOT3(Vk, Vk) + Hs(P1, m1, P2, m2, neg_Vk, Cp, &P1_i, &P2_i);
+      Gp = DOT3(Vk, Vk) + Hp_poly(p1, neg_Vk, Cp, &P1_i)
+			+ Hp_poly(p2, Vk, Cp_2, &P2_i);
+      VECSUB3(Cp, Cp, Cp_2);
 
       /** keep track of indices for P1 and P2 **/
 
       for (i = 0; i < set_size; i++) {
 	 j = I[i];
-	 i_tab[i] = i_tab[j];	  /** j is value from member of some Is **/
-	 j_tab[i] = j_tab[j];	  /** j is value from member of some Is **/
+	 i_tab[i] = i_tab[j];
+	 j_tab[i] = j_tab[j];
       }
 
       if (EQZ(Gp))		  /** Do we have a solution **/
@@ -647,6 +652,9 @@ int		    m1, m2, near_indx[][2], *m3;
       }
    }
 
+   if (set_size == 1)
+      lambda[0] = 1.0;
+
    CPVECTOR3(VP, Vk);			  /** load VP **/
    *m3 = set_size;
    for(i = 0; i < set_size; i++) {
@@ -677,33 +685,20 @@ Couple		  couple;
 {
    Polyhedron	  polyhedron1, polyhedron2;
    Boolean	  plane_exists;
-   double	  pnts1[MAX_VERTS][3], pnts2[MAX_VERTS][3], dist,
-		  u[3], v[3], lambda[4], VP[3];
-   int		  i, k, m1, m2;
+   double	  dist, u[3], v[3], lambda[4], VP[3];
+   int		  i, k;
 
    plane_exists = FALSE;
 
    polyhedron1 = couple->polyhdrn1;    polyhedron2 = couple->polyhdrn2;
 
-   /** Apply M1 to vertices of polytope 1 **/
+   /** solve eq. (1) for two polytopes, M1 and M2 are applied inside **/
 
-   m1 = polyhedron1->m;
-   for (i = 0; i < m1; i++) {
-      CPVECTOR3(pnts1[i], polyhedron1->verts[i]);
-      VECADD3(pnts1[i], pnts1[i], polyhedron1->trn);
-   }
-
-   /** Apply M2 to vertices of polytope 1 **/
-
-   m2 = polyhedron2->m;
-   for (i = 0; i < m2; i++) {
-      CPVECTOR3(pnts2[i], polyhedron2->verts[i]);
-      VECADD3(pnts2[i], pnts2[i], polyhedron2->trn);
-   }
-
-   /** solve eq. (1) for two polytopes **/
-
-   dist3d(pnts1, m1, pnts2, m2, VP, couple->vert_indx, lambda, &couple->n);
+   if (!couple->warm)
+      couple->n = 0;
+   couple->calls++;
+   dist3d_poly(polyhedron1, polyhedron2, VP, couple->vert_indx, lambda,
+	       &couple->n, &couple->iters);
 
    dist = sqrt(DOT3(VP,VP));   /** distance between polytopes **/
 
@@ -712,14 +707,14 @@ Couple		  couple;
       u[0] = u[1] = u[2] = v[0] = v[1] = v[2] = 0.0;
       for (i = 0; i < couple->n; i++) {
 	 k = couple->vert_indx[i][0];
-	 VECADDS3(u, lambda[i], pnts1[k], u);  /** point in P1 **/
+	 VECADDS3(u, lambda[i], polyhedron1->verts[k], u);  /** point in P1 **/
 	 k = couple->vert_indx[i][1];
-	 VECADDS3(v, lambda[i], pnts2[k], v);  /** point in P2 **/
+	 VECADDS3(v, lambda[i], polyhedron2->verts[k], v);  /** point in P2 **/
       }
 
       /** Store separating plane in P1's local coordinates **/
 
-      VECADD3(u, u, polyhedron1->itrn);
+      VECADD3(v, v, polyhedron2->trn);
       VECADD3(v, v, polyhedron1->itrn);
 
       /** Place separating plane in couple data structure **/
@@ -795,6 +790,43 @@ Couple		  couple;
 }
 
 
+/****************************************************************************
+ *
+ *   Function to test many pairs of polyhedra for collision.  Each test
+ *   only reads the polyhedra and writes its own couple, so the pairs are
+ *   shared out among threads when compiled with OpenMP.
+ *
+ *   On Entry:
+ *	couples - array of n couples.
+ *	      n - number of couples.
+ *	collide - an empty array of size n.
+ *
+ *   On Exit:
+ *	collide - result of Collision for each couple.
+ *
+ *   Function Return :
+ *	the number of couples that are intersecting.
+ *
+ ****************************************************************************/
+
+long Collisions(couples, n, collide)
+Couple		couples[];
+int		n;
+Boolean		collide[];
+{
+   int		i;
+   long		hits = 0;
+
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:hits)
+   for (i = 0; i < n; i++) {
+      collide[i] = Collision(couples[i]);
+      if (collide[i])
+	 hits++;
+   }
+   return hits;
+}
+
+
 /*** RJR 05/26/93 ***********************************************************
  *
  *   Function to initialize a polyhedron.
@@ -833,6 +865,9 @@ int	      m;
    p = verts;
    for (i = 0; i < m; i++) {
       CPVECTOR3(polyhedron->verts[i], p);
+      polyhedron->soa[0][i] = p[0];
+      polyhedron->soa[1][i] = p[1];
+      polyhedron->soa[2][i] = p[2];
       p += 3;
    }
 }
@@ -865,6 +900,115 @@ double	     tx, ty, tz;
    polyhedron->itrn[2] -= tz;
 }
 
+/****************************************************************************
+ *
+ *   Function to initialize a couple.
+ *
+ *   On Entry:
+ *	couple - pointer to a couple structure.
+ *	    p1 - first polyhedron.
+ *	    p2 - second polyhedron.
+ *
+ *   On Exit:
+ *	couple - an initialized couple with no cached plane or points.
+ *
+ *   Function Return : none.
+ *
+ ****************************************************************************/
+
+void init_couple(couple, p1, p2)
+Couple	      couple;
+Polyhedron    p1, p2;
+{
+   couple->polyhdrn1 = p1;	 couple->polyhdrn2 = p2;
+   couple->n = 0;
+   couple->plane_exists = FALSE;
+   couple->warm = TRUE;
+   couple->calls = couple->iters = 0;
+}
+
+
+/****************************************************************************
+ *
+ *   Function returning a time in seconds for the benchmark.
+ *
+ ****************************************************************************/
+
+double seconds()
+{
+#ifdef _OPENMP
+   return omp_get_wtime();
+#else
+   return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+/****************************************************************************
+ *
+ *   Benchmark of many pairs.  npairs polyhedra tumble along the x-axis
+ *   in step with a partner, each couple is tested every step with
+ *   Collisions, once using the cached points to start dist3d_poly and once
+ *   starting it from scratch.
+ *
+ ****************************************************************************/
+
+void bench(npairs, steps)
+int	    npairs, steps;
+{
+   Polyhedron	 polys;
+   Couple	 couples, *pcouples;
+   Boolean	 *collide, warm;
+   double	 *xstp, t;
+   long		 hits, calls, iters;
+   int		 i, k;
+
+   polys    = (Polyhedron)malloc(2 * npairs * sizeof(struct polyhedron));
+   couples  = (Couple)malloc(npairs * sizeof(struct couple));
+   pcouples = (Couple *)malloc(npairs * sizeof(Couple));
+   collide  = (Boolean *)malloc(npairs * sizeof(Boolean));
+   xstp	    = (double *)malloc(2 * npairs * sizeof(double));
+
+   for (warm = FALSE; warm <= TRUE; warm++) {
+      for (i = 0; i < npairs; i++) {
+	 init_polyhedron(&polys[2*i], i % 2 ? box : sphere, i % 2 ? 8 : 342,
+			 0.0, 20.0 * i, 0.0);
+	 init_polyhedron(&polys[2*i+1], i % 3 ? cyl : box, i % 3 ? 36 : 8,
+			 50.0 + i % 7, 20.0 * i, 0.0);
+	 xstp[2*i] = 1.0 + i % 5;   xstp[2*i+1] = -(1.0 + i % 3);
+	 init_couple(&couples[i], &polys[2*i], &polys[2*i+1]);
+	 couples[i].warm = warm;
+	 pcouples[i] = &couples[i];
+      }
+
+      hits = 0;
+      t = seconds();
+      for (k = 0; k < steps; k++) {
+	 for (i = 0; i < 2 * npairs; i++) {
+	    move_polyhedron(&polys[i], xstp[i], 0.0, 0.0);
+	    if (ABS(polys[i].trn[0]) > 100.0)
+	       xstp[i] = -xstp[i];
+	 }
+	 hits += Collisions(pcouples, npairs, collide);
+      }
+      t = seconds() - t;
+
+      calls = iters = 0;
+      for (i = 0; i < npairs; i++) {
+	 calls += couples[i].calls;
+	 iters += couples[i].iters;
+      }
+      printf("%s start: %.0f pairs/second, %ld hits, %ld dist3d_poly calls, "
+	     "%.2f iterations per call\n", warm ? "warm" : "cold",
+	     (double) npairs * steps / t, hits, calls,
+	     calls ? (double) iters / calls : 0.0);
+   }
+
+   free(polys);	  free(couples);   free(pcouples);
+   free(collide); free(xstp);
+}
+
+
 /*** RJR 05/26/93 ***********************************************************
  *
  *   This is the Main Program for the Collision Detection example. This test
@@ -882,8 +1026,14 @@ double	     tx, ty, tz;
  *   disjoint result it is exact, but when it returns an intersection result
  *   it is approximate.
  *
+ *   Given a number of pairs (and optionally of steps) as arguments, the
+ *   program instead runs bench to report pairs tested per second and the
+ *   average number of dist3d_poly iterations with and without warm starting.
+ *
  ****************************************************************************/
-int main()
+int main(argc, argv)
+int		  argc;
+char		  *argv[];
 {
    Polyhedron	  Polyhedron1, Polyhedron2, Polyhedron3;
    Couple	  Couple1, Couple2, Couple3;
@@ -897,6 +1047,11 @@ int main()
    mak_cyl(cyl);
    mak_sph(sphere);
 
+   if (argc > 1) {
+      bench(atoi(argv[1]), argc > 2 ? atoi(argv[2]) : 1000);
+      return 0;
+   }
+
    Polyhedron1 = (Polyhedron)malloc(sizeof(struct polyhedron));
    init_polyhedron(Polyhedron1, sphere, 342,  0.0, 0.0, 0.0);
 
@@ -907,19 +1062,13 @@ int main()
    init_polyhedron(Polyhedron3, cyl, 36, -50.0, 0.0, 0.0);
 
    Couple1 = (Couple)malloc(sizeof(struct couple));
-   Couple1->polyhdrn1 = Polyhedron1;   Couple1->polyhdrn2 = Polyhedron2;
-   Couple1->n = 0;
-   Couple1->plane_exists = FALSE;
+   init_couple(Couple1, Polyhedron1, Polyhedron2);
 
    Couple2 = (Couple)malloc(sizeof(struct couple));
-   Couple2->polyhdrn1 = Polyhedron1;   Couple2->polyhdrn2 = Polyhedron3;
-   Couple2->n = 0;
-   Couple2->plane_exists = FALSE;
+   init_couple(Couple2, Polyhedron1, Polyhedron3);
 
    Couple3 = (Couple)malloc(sizeof(struct couple));
-   Couple3->polyhdrn1 = Polyhedron3;   Couple3->polyhdrn2 = Polyhedron2;
-   Couple3->n = 0;
-   Couple3->plane_exists = FALSE;
+   init_couple(Couple3, Polyhedron3, Polyhedron2);
 
    /** Perform Collision Tests **/
 
@@ -946,4 +1095,5 @@ int main()
    }
    printf("number of tests = %d\n",(steps * 3));
    printf("number of hits = %ld\n", hits);
+   return 0;
 }
@@ -0,0 +1,97 @@
+/*
+** BENCH_HDP.C : Throughput of the HDP encodings on 4K frames
+**
+** Encodes and decodes a 3840x2160 frame of random values over the range,
+** pixel by pixel with the macros and with the array functions, and prints
+** millions of pixels and frames per second, and the largest relative error
+** of a decoded value between LoVal and HiVal.
+**
+** Usage : bench_hdp [frames]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "hdp.h"
+
+#define Width  3840
+#define Height 2160
+#define NbPix  ((long) Width * Height)
+
+static double seconds (void)
+{
+  return (double) clock () / CLOCKS_PER_SEC;
+}
+
+static void report (char *Name, int Frames, double Time)
+{
+  printf ("%-20s %10.1f Mpixel/s %8.1f frames/s\n", Name,
+	  NbPix * Frames / Time / 1e6, Frames / Time);
+}
+
+static double error (realcolor *Src, realcolor *Dec, real LoVal, real HiVal)
+{
+    double Err = 0.0, e;
+    long Index;
+
+  for (Index = 0; Index < 3 * NbPix; Index++)
+    if (Src[0][Index] >= LoVal && Src[0][Index] <= HiVal) {
+      e = fabs (Dec[0][Index] - Src[0][Index]) / Src[0][Index];
+      if (e > Err) Err = e;
+    }
+  return Err;
+}
+
+int main (int argc, char *argv[])
+{
+    int Frames = argc > 1 ? atoi (argv[1]) : 5;
+    realcolor *Src = (realcolor *) malloc (NbPix * sizeof (realcolor));
+    realcolor *Dec = (realcolor *) malloc (NbPix * sizeof (realcolor));
+    bytecolor *Enc = (bytecolor *) malloc (NbPix * sizeof (bytecolor));
+    real LoVal = 0.25, HiVal = 1000.0;
+    double Time;
+    long Index;
+    int Frame;
+
+  if (! Src || ! Dec || ! Enc) {
+    printf ("Not enough memory\n");
+    return 1;
+  }
+  init_HDP_encode (LoVal, HiVal, 8192);
+  init_HDP_decode (LoVal, HiVal, 0.0);
+  init_LOG_encode (LoVal, HiVal);
+  init_LOG_decode (LoVal, HiVal);
+  init_EXP_encode (HiVal);
+  init_EXP_decode (HiVal);
+
+/* Values spread in log over the range, as in a rendered frame */
+  srand (1);
+  for (Index = 0; Index < 3 * NbPix; Index++)
+    Src[0][Index] = LoVal * pow (HiVal / LoVal, (double) rand () / RAND_MAX);
+
+  printf ("%dx%d frames, %d of them\n", Width, Height, Frames);
+
+#define BENCH(Name, ENCODE, DECODE, encode_array, decode_array) \
+  Time = seconds (); \
+  for (Frame = 0; Frame < Frames; Frame++) \
+    for (Index = 0; Index < NbPix; Index++) ENCODE (Src[Index], Enc[Index]); \
+  report (Name " encode", Frames, seconds () - Time); \
+  Time = seconds (); \
+  for (Frame = 0; Frame < Frames; Frame++) encode_array (Src, Enc, NbPix); \
+  report (Name " encode_array", Frames, seconds () - Time); \
+  Time = seconds (); \
+  for (Frame = 0; Frame < Frames; Frame++) \
+    for (Index = 0; Index < NbPix; Index++) DECODE (Enc[Index], Dec[Index]); \
+  report (Name " decode", Frames, seconds () - Time); \
+  Time = seconds (); \
+  for (Frame = 0; Frame < Frames; Frame++) decode_array (Enc, Dec, NbPix); \
+  report (Name " decode_array", Frames, seconds () - Time); \
+  printf ("%-20s %10.3g\n\n", Name " error", error (Src, Dec, LoVal, HiVal));
+
+  BENCH ("HDP", HDP_ENCODE, HDP_DECODE, HDP_encode_array, HDP_decode_array)
+  BENCH ("LOG", LOG_ENCODE, LOG_DECODE, LOG_encode_array, LOG_decode_array)
+  BENCH ("EXP", EXP_ENCODE, EXP_DECODE, EXP_encode_array, EXP_decode_array)
+  return 0;
+}
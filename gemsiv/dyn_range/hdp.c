@@ -4,6 +4,19 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HDP_SSE2
+#define HDP_GATHER
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define HDP_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HDP_SSE2
+#endif
 #include "hdp.h"
 
 /*
@@ -12,6 +25,7 @@
 byte *EncodeLut;
 real *DecodeLut;
 real  LutScale;
+static int EncodeTop;		/* last index of EncodeLut */
 
 /*
 ** Construction of the Encoding Look-Up Table
@@ -33,6 +47,7 @@ int init_HDP_encode (real LoVal, real HiVal, int NbVal)
   if (! EncodeLut) return 0;
 
   NbVal--;
+  EncodeTop = NbVal;
 
 /* Scaling factor = ratio between the encoding LUT and the incoming range */
   LutScale = NbVal / HiVal;
@@ -81,7 +96,7 @@ int init_HDP_decode (real LoVal, real HiVal, real Bright)
 /* Bias factor = ratio of incoming and outcoming range * brightness factor */
   r = Bright * HiVal / LoVal / 256.f;
 
-  for (n = 0; n <= 256; n++) {
+  for (n = 0; n < 256; n++) {
     t = (float) n / 255.f;
     DecodeLut[n] = t / (t-t*r+r) * HiVal;
   }
@@ -95,3 +110,279 @@ void exit_HDP_decode (void)
 {
   free (DecodeLut);
 }
+
+/*
+** Logarithmic Encoding and Decoding Look-Up Tables
+*/
+byte *EncodeLogLut;
+real *DecodeLogLut;
+
+#define LOG_BITS 15		/* float bits dropped for the LUT index */
+#define LOG_SIZE (1 << (32-LOG_BITS-1))
+
+/*
+** Index of a value in the logarithmic encoding LUT : the exponent and
+** the top 8 bits of mantissa of the float, 0 for zero, negatives and NaN
+*/
+int LOG_index (real Val)
+{
+    float f = (float) Val;
+    unsigned int bits;
+
+  if (! (f > 0.f)) return 0;
+  memcpy (&bits, &f, sizeof (bits));
+  return (int) (bits >> LOG_BITS);
+}
+
+/*
+** Construction of the Logarithmic Encoding Look-Up Table
+**
+** Input :
+**    LoVal = Value of code 1
+**    HiVal = Value of code 255
+**
+** Output :
+**    The function returns 0 if the allocation failed
+*/
+int init_LOG_encode (real LoVal, real HiVal)
+{
+    double s, t;
+    unsigned int bits;
+    float f;
+    int n, c;
+
+  EncodeLogLut = (byte *) malloc (LOG_SIZE * sizeof (byte));
+  if (! EncodeLogLut) return 0;
+
+  s = 254.0 / log (HiVal / LoVal);
+  for (n = 0; n < LOG_SIZE; n++) {
+      bits = (unsigned int) n << LOG_BITS | 1u << (LOG_BITS-1);
+      memcpy (&f, &bits, sizeof (f));		/* middle of the bucket */
+      t = f > 0.f && f < HUGE_VAL ? log (f / LoVal) * s + 1.5 : 256.0;
+      c = t < 1.0 ? 0 : t >= 256.0 ? 255 : (int) t;
+      EncodeLogLut[n] = (byte) c;
+  }
+  EncodeLogLut[0] = 0;
+  return (! NULL);
+}
+
+void exit_LOG_encode (void)
+{
+  free (EncodeLogLut);
+}
+
+/*
+** Construction of the Logarithmic Decoding Look-Up Table
+*/
+int init_LOG_decode (real LoVal, real HiVal)
+{
+    int n;
+
+  DecodeLogLut = (real *) malloc (256 * sizeof (real));
+  if (! DecodeLogLut) return 0;
+
+  DecodeLogLut[0] = 0.f;
+  for (n = 1; n < 256; n++)
+    DecodeLogLut[n] = LoVal * pow (HiVal / LoVal, (n-1) / 254.0);
+  return (! NULL);
+}
+
+void exit_LOG_decode (void)
+{
+  free (DecodeLogLut);
+}
+
+/*
+** Exponent Encoding and Decoding
+*/
+real  ExpScale;
+real *DecodeExpLut;
+
+#define EXP_DENORMAL 3.0517578125e-05f	/* 2^-15, the smallest normal */
+#define EXP_DENSCALE 524288.f		/* 2^19, a denormal unit */
+#define EXP_MAX      0.96875f		/* (1 + 15/16) / 2, code 255 */
+#define EXP_BIAS     1776		/* (127-16) << 4 */
+
+void init_EXP_encode (real HiVal)
+{
+  ExpScale = (float) (1.0 / HiVal);
+}
+
+/*
+** Code of a value : the float of Val / HiVal rounded to 4 bits of
+** mantissa, with its exponent + 16 in the top 4 bits (0 for denormals)
+*/
+byte EXP_code (real Val)
+{
+    float s = (float) Val * (float) ExpScale;
+    unsigned int bits;
+
+  if (! (s > 0.f)) return 0;
+  if (s > EXP_MAX) s = EXP_MAX;
+  if (s < EXP_DENORMAL) return (byte) (int) (s * EXP_DENSCALE + 0.5f);
+  memcpy (&bits, &s, sizeof (bits));
+  return (byte) (((bits + (1u << 18)) >> 19) - EXP_BIAS);
+}
+
+int init_EXP_decode (real HiVal)
+{
+    int n;
+
+  DecodeExpLut = (real *) malloc (256 * sizeof (real));
+  if (! DecodeExpLut) return 0;
+
+  for (n = 0; n < 256; n++)
+    DecodeExpLut[n] = (n < 16 ? ldexp (n, -19) :
+		       ldexp (16 + (n & 15), (n >> 4) - 20)) * HiVal;
+  return (! NULL);
+}
+
+void exit_EXP_decode (void)
+{
+  free (DecodeExpLut);
+}
+
+/*
+** Encoding and Decoding of Pixel Arrays
+**
+** The pixels are taken as one array of 3*NbPix components.  With SSE2
+** the LUT indices (or the codes of the exponent encoding) of 4 or 16
+** components are computed at once; with AVX2 the decoding LUT is read
+** by gathers.  All of it is only done when real is float.
+*/
+#define SIMD_REAL (sizeof (real) == sizeof (float))
+
+static void decode_array (const byte *Src, real *Dst, long n, const real *Lut)
+{
+    long i = 0;
+
+#ifdef HDP_GATHER
+  if (SIMD_REAL)
+    for (; i+8 <= n; i += 8) {
+	__m256i k = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (Src+i)));
+	_mm256_storeu_ps ((float *) Dst+i,
+			  _mm256_i32gather_ps ((const float *) Lut, k, 4));
+    }
+#endif
+  for (; i+4 <= n; i += 4) {
+      Dst[i]   = Lut[Src[i]];
+      Dst[i+1] = Lut[Src[i+1]];
+      Dst[i+2] = Lut[Src[i+2]];
+      Dst[i+3] = Lut[Src[i+3]];
+  }
+  for (; i < n; i++)
+      Dst[i] = Lut[Src[i]];
+}
+
+void HDP_encode_array (realcolor *Src, bytecolor *Dst, long NbPix)
+{
+    real *s = Src[0];
+    byte *d = Dst[0];
+    long i = 0, n = 3 * NbPix;
+    double v;
+
+#ifdef HDP_SSE2
+  if (SIMD_REAL) {
+      const __m128 scale = _mm_set1_ps ((float) LutScale);
+      const __m128d half = _mm_set1_pd (0.5);
+      const __m128d top = _mm_set1_pd ((double) EncodeTop);
+      int k[4];
+
+      for (; i+4 <= n; i += 4) {
+	  /* the product in float, the 0.5 added in double, as HDP_ENCODE */
+	  __m128 p = _mm_mul_ps (_mm_loadu_ps ((float *) s+i), scale);
+	  __m128d lo = _mm_add_pd (_mm_cvtps_pd (p), half);
+	  __m128d hi = _mm_add_pd (_mm_cvtps_pd (_mm_movehl_ps (p, p)), half);
+	  lo = _mm_min_pd (_mm_max_pd (lo, _mm_setzero_pd ()), top);
+	  hi = _mm_min_pd (_mm_max_pd (hi, _mm_setzero_pd ()), top);
+	  _mm_storeu_si128 ((__m128i *) k, _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (lo),
+							       _mm_cvttpd_epi32 (hi)));
+	  d[i]   = EncodeLut[k[0]];
+	  d[i+1] = EncodeLut[k[1]];
+	  d[i+2] = EncodeLut[k[2]];
+	  d[i+3] = EncodeLut[k[3]];
+      }
+  }
+#endif
+  for (; i < n; i++) {
+      v = s[i] * LutScale + 0.5;
+      d[i] = EncodeLut[v > 0.0 ? v < EncodeTop ? (int) v : EncodeTop : 0];
+  }
+}
+
+void HDP_decode_array (bytecolor *Src, realcolor *Dst, long NbPix)
+{
+  decode_array (Src[0], Dst[0], 3 * NbPix, DecodeLut);
+}
+
+void LOG_encode_array (realcolor *Src, bytecolor *Dst, long NbPix)
+{
+    real *s = Src[0];
+    byte *d = Dst[0];
+    long i = 0, n = 3 * NbPix;
+
+#ifdef HDP_SSE2
+  if (SIMD_REAL) {
+      int k[4];
+
+      for (; i+4 <= n; i += 4) {
+	  __m128 x = _mm_loadu_ps ((float *) s+i);
+	  __m128i b = _mm_and_si128 (_mm_castps_si128 (x),
+		      _mm_castps_si128 (_mm_cmpgt_ps (x, _mm_setzero_ps ())));
+	  _mm_storeu_si128 ((__m128i *) k, _mm_srli_epi32 (b, LOG_BITS));
+	  d[i]   = EncodeLogLut[k[0]];
+	  d[i+1] = EncodeLogLut[k[1]];
+	  d[i+2] = EncodeLogLut[k[2]];
+	  d[i+3] = EncodeLogLut[k[3]];
+      }
+  }
+#endif
+  for (; i < n; i++)
+      d[i] = EncodeLogLut[LOG_index (s[i])];
+}
+
+void LOG_decode_array (bytecolor *Src, realcolor *Dst, long NbPix)
+{
+  decode_array (Src[0], Dst[0], 3 * NbPix, DecodeLogLut);
+}
+
+#ifdef HDP_SSE2
+static __m128i exp_codes (__m128 x)
+{
+    const __m128 s = _mm_min_ps (_mm_max_ps (_mm_mul_ps (x, _mm_set1_ps ((float) ExpScale)),
+				 _mm_setzero_ps ()), _mm_set1_ps (EXP_MAX));
+    __m128i normal = _mm_sub_epi32 (_mm_srli_epi32 (_mm_add_epi32 (_mm_castps_si128 (s),
+				    _mm_set1_epi32 (1 << 18)), 19), _mm_set1_epi32 (EXP_BIAS));
+    __m128i denormal = _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (s, _mm_set1_ps (EXP_DENSCALE)),
+					 _mm_set1_ps (0.5f)));
+    __m128i small = _mm_castps_si128 (_mm_cmplt_ps (s, _mm_set1_ps (EXP_DENORMAL)));
+
+  return _mm_or_si128 (_mm_and_si128 (small, denormal), _mm_andnot_si128 (small, normal));
+}
+#endif
+
+void EXP_encode_array (realcolor *Src, bytecolor *Dst, long NbPix)
+{
+    real *s = Src[0];
+    byte *d = Dst[0];
+    long i = 0, n = 3 * NbPix;
+
+#ifdef HDP_SSE2
+  if (SIMD_REAL)
+    for (; i+16 <= n; i += 16) {
+	const float *f = (const float *) s+i;
+	__m128i lo = _mm_packs_epi32 (exp_codes (_mm_loadu_ps (f)),
+				      exp_codes (_mm_loadu_ps (f+4)));
+	__m128i hi = _mm_packs_epi32 (exp_codes (_mm_loadu_ps (f+8)),
+				      exp_codes (_mm_loadu_ps (f+12)));
+	_mm_storeu_si128 ((__m128i *) (d+i), _mm_packus_epi16 (lo, hi));
+    }
+#endif
+  for (; i < n; i++)
+      d[i] = EXP_code (s[i]);
+}
+
+void EXP_decode_array (bytecolor *Src, realcolor *Dst, long NbPix)
+{
+  decode_array (Src[0], Dst[0], 3 * NbPix, DecodeExpLut);
+}
@@ -38,3 +38,60 @@ extern void exit_HDP_decode (void);
    RealColor[0] = DecodeLut [ByteColor[0]], \
    RealColor[1] = DecodeLut [ByteColor[1]], \
    RealColor[2] = DecodeLut [ByteColor[2]])
+
+/*
+** Logarithmic Encoding : codes 1..255 are evenly spaced in log (LoVal..HiVal),
+** code 0 is zero; the encoding LUT is indexed by the top 17 bits of a float
+*/
+extern byte *EncodeLogLut;
+extern real *DecodeLogLut;
+
+extern int init_LOG_encode (real,real);
+extern int init_LOG_decode (real,real);
+extern void exit_LOG_encode (void);
+extern void exit_LOG_decode (void);
+extern int LOG_index (real);
+
+#define LOG_ENCODE(RealColor,ByteColor) ( \
+   ByteColor[0] = EncodeLogLut [LOG_index (RealColor[0])], \
+   ByteColor[1] = EncodeLogLut [LOG_index (RealColor[1])], \
+   ByteColor[2] = EncodeLogLut [LOG_index (RealColor[2])])
+
+#define LOG_DECODE(ByteColor,RealColor) ( \
+   RealColor[0] = DecodeLogLut [ByteColor[0]], \
+   RealColor[1] = DecodeLogLut [ByteColor[1]], \
+   RealColor[2] = DecodeLogLut [ByteColor[2]])
+
+/*
+** Exponent Encoding : an 8-bit float of value / HiVal, with 4 bits of
+** exponent and 4 of mantissa (dynamic range 2^19), computed without LUT
+*/
+extern real  ExpScale;
+extern real *DecodeExpLut;
+
+extern void init_EXP_encode (real);
+extern int init_EXP_decode (real);
+extern void exit_EXP_decode (void);
+extern byte EXP_code (real);
+
+#define EXP_ENCODE(RealColor,ByteColor) ( \
+   ByteColor[0] = EXP_code (RealColor[0]), \
+   ByteColor[1] = EXP_code (RealColor[1]), \
+   ByteColor[2] = EXP_code (RealColor[2]))
+
+#define EXP_DECODE(ByteColor,RealColor) ( \
+   RealColor[0] = DecodeExpLut [ByteColor[0]], \
+   RealColor[1] = DecodeExpLut [ByteColor[1]], \
+   RealColor[2] = DecodeExpLut [ByteColor[2]])
+
+/*
+** Encoding and Decoding of Pixel Arrays (SIMD where available)
+** Each gives exactly what the macro above does pixel by pixel, except
+** that HDP_encode_array clamps values out of (0,HiVal) into the LUT
+*/
+extern void HDP_encode_array (realcolor *, bytecolor *, long);
+extern void HDP_decode_array (bytecolor *, realcolor *, long);
+extern void LOG_encode_array (realcolor *, bytecolor *, long);
+extern void LOG_decode_array (bytecolor *, realcolor *, long);
+extern void EXP_encode_array (realcolor *, bytecolor *, long);
+extern void EXP_decode_array (bytecolor *, realcolor *, long);
@@ -3,9 +3,78 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 #include "hdp.h"
 
+/*
+** Parity of the array functions with the macros on NbPix pixels : random
+** values of the whole range, the range ends, zero, tiny and huge values,
+** and a value whose scaled index is just below 0.5 (0.49999997f, where
+** adding 0.5 in float would round up to 1)
+*/
+#define NbPix 1001
+
+static realcolor Src[NbPix], Dec[NbPix], DecArray[NbPix];
+static bytecolor Enc[NbPix], EncArray[NbPix];
+
+static int check (char *Name, int Failed)
+{
+  printf ("Parity of %s arrays : %s\n", Name, Failed ? "FAILED" : "ok");
+  return Failed;
+}
+
+static int parity (real LoVal, real HiVal)
+{
+    static real Edge[] = { 0.f, 1e-30f, 1e-6f, -1.f, 1e30f, 0.f };
+    int Index, Failed = 0;
+    real *Val = Src[0];
+    real Half = nextafterf (0.5f, 0.f);
+
+/* Edge[5] * LutScale == 0.49999997f */
+  Edge[5] = Half / LutScale;
+  while (Edge[5] * LutScale < Half) Edge[5] = nextafterf (Edge[5], 1.f);
+  while (Edge[5] * LutScale > Half) Edge[5] = nextafterf (Edge[5], 0.f);
+
+  srand (1);
+  for (Index = 0; Index < 3 * NbPix; Index++)
+    Val[Index] = Index < 6 ? Edge[Index] : Index < 10 ? Index % 2 ? LoVal : HiVal :
+		 (real) rand () / RAND_MAX * (Index % 3 ? HiVal : 8.f * LoVal);
+
+  for (Index = 0; Index < NbPix; Index++) {
+    LOG_ENCODE (Src[Index], Enc[Index]);
+    LOG_DECODE (Enc[Index], Dec[Index]);
+  }
+  LOG_encode_array (Src, EncArray, NbPix);
+  LOG_decode_array (EncArray, DecArray, NbPix);
+  Failed += check ("LOG", memcmp (Enc, EncArray, sizeof (Enc)) ||
+			  memcmp (Dec, DecArray, sizeof (Dec)));
+
+  for (Index = 0; Index < NbPix; Index++) {
+    EXP_ENCODE (Src[Index], Enc[Index]);
+    EXP_DECODE (Enc[Index], Dec[Index]);
+  }
+  EXP_encode_array (Src, EncArray, NbPix);
+  EXP_decode_array (EncArray, DecArray, NbPix);
+  Failed += check ("EXP", memcmp (Enc, EncArray, sizeof (Enc)) ||
+			  memcmp (Dec, DecArray, sizeof (Dec)));
+
+/* HDP_ENCODE needs values in (0,HiVal) */
+  for (Index = 0; Index < 3 * NbPix; Index++)
+    if (! (Val[Index] >= 0.f && Val[Index] <= HiVal)) Val[Index] = HiVal;
+  for (Index = 0; Index < NbPix; Index++) {
+    HDP_ENCODE (Src[Index], Enc[Index]);
+    HDP_DECODE (Enc[Index], Dec[Index]);
+  }
+  HDP_encode_array (Src, EncArray, NbPix);
+  HDP_decode_array (EncArray, DecArray, NbPix);
+  Failed += check ("HDP", memcmp (Enc, EncArray, sizeof (Enc)) ||
+			  memcmp (Dec, DecArray, sizeof (Dec)));
+  return Failed;
+}
+
 int main (void)
 {
     realcolor RealColor;
@@ -43,7 +112,25 @@ int main (void)
     printf ("After = %.2f\n", RealColor[0]);
   }
 
+/* The same range with the other encodings, and the arrays */
+  init_LOG_encode (LoVal, HiVal);
+  init_LOG_decode (LoVal, HiVal);
+  init_EXP_encode (HiVal);
+  init_EXP_decode (HiVal);
+  Index = parity (LoVal, HiVal);
+
+/* Again with a range of 100000, where EncodeLut[0] and [1] differ */
+  exit_HDP_encode ();
+  exit_HDP_decode ();
+  init_HDP_encode (LoVal / 25, HiVal, NbVal);
+  init_HDP_decode (LoVal / 25, HiVal, Bright);
+  Index += parity (LoVal / 25, HiVal);
+
 /* Destruction of the look-up tables */
     exit_HDP_encode ();
     exit_HDP_decode ();
+    exit_LOG_encode ();
+    exit_LOG_decode ();
+    exit_EXP_decode ();
+    return Index;
 }
@@ -0,0 +1,62 @@
+/****************************************************************************
+**    TEST FILE FOR graph (Dynamic Layout Alg)
+**
+**    HEADER   - FORCES OF THE DYNAMIC LAYOUT ON CONTIGUOUS ARRAYS
+**
+** Author: dr. Szirmay-Kalos Laszlo (szirmay@fsz.bme.hu)
+**	   Technical University of Budapest, Hungary
+*****************************************************************************/
+#include "defines.h"
+
+/*
+*    QUADTREE CELL OF THE BARNES-HUT APPROXIMATION
+*/
+struct QuadCell {
+    double cx, cy;		// center of gravity of the nodes inside
+    double mass;		// number of nodes inside
+    double size;		// side of the square
+    int	   child;		// first of the 4 children, -1 if leaf
+    int	   first, count;	// nodes of a leaf in order[]
+};
+
+/************************************************************************/
+class ForceLayout {
+/************************************************************************/
+    int	     nnode;		// number of nodes
+    double   divisor;		// forces are divided by this
+    double * x, * y;		// positions
+    double * vx, * vy;		// speeds
+    double * fx, * fy;		// driving forces
+    char   * moveable;		// moveable or fixed
+    int	     nrel;		// relations added so far
+    int	   * relfrom, * relto;	// relations as added
+    double * relint;
+    int	   * relstart;		// relations of node i are
+    int	   * relnode;		// relnode[relstart[i] .. relstart[i+1]-1]
+    double * relextra;		// their constraints - unrelated constraint
+
+    QuadCell * cell;		// quadtree, cell[0] is the root
+    int	       ncell, maxcell;
+    int	     * order;		// nodes sorted into the leaves
+
+    int	   NewCells( void );	// allocate 4 children
+    void   BuildCell( int, double, double, double, int, int, int );
+    void   BuildTree( void );
+    void   NodeForce( int, int );	// force on node i, exact or by tree
+public:
+	   ForceLayout( int n, int maxrel, double div );
+	   ~ForceLayout( void );
+
+    void   SetNode( int i, double px, double py, int move );
+    void   AddRelation( int i, int j, double intensity );
+    void   Forces( int exact );		// driving forces of all nodes
+    double Step( double friction, double iinertia, int exact );
+    int	   Solve( double max_time, int exact );
+
+    double X( int i )		{ return x[i];	}
+    double Y( int i )		{ return y[i];	}
+    double SpeedX( int i )	{ return vx[i]; }
+    double SpeedY( int i )	{ return vy[i]; }
+    double ForceX( int i )	{ return fx[i]; }
+    double ForceY( int i )	{ return fy[i]; }
+};
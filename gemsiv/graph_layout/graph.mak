@@ -17,7 +17,7 @@ INCLUDEPATH = C:\BORLANDC\INCLUDE
 
 #		*List Macros*
 
-OBJS = fileio.obj layout.obj graph.obj mswindow.obj vector.obj
+OBJS = fileio.obj layout.obj forces.obj graph.obj mswindow.obj vector.obj
 
 #		*Explicit Rules*
 graph: $(OBJS)
@@ -25,6 +25,7 @@ graph: $(OBJS)
 c0ws.obj+
 fileio.obj+
 layout.obj+
+forces.obj+
 graph.obj+
 mswindow.obj+
 vector.obj
@@ -45,7 +46,9 @@ fileio.obj: fileio.cpp mswindow.hxx vector.hxx defines.h graph.hxx fileio.hxx
 
 graph.obj: graph.cpp mswindow.hxx vector.hxx defines.h graph.hxx
 
-layout.obj: layout.cpp mswindow.hxx vector.hxx defines.h graph.hxx 
+layout.obj: layout.cpp mswindow.hxx vector.hxx defines.h graph.hxx forces.hxx
+
+forces.obj: forces.cpp forces.hxx defines.h
 
 vector.obj: vector.cpp vector.hxx 
 
@@ -3,6 +3,9 @@
  * Using tricks from Darwyn Peachey and Joe Cychosz. */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../gemsv/ch6-7/sampler.h"
 
 #define TOL 1e-7
 #define AMBIENT vec U, black, amb
@@ -86,13 +89,131 @@ vec trace(int level, vec P, vec D)
 	    vcomb(s->kd, color, vcomb(s->kl, U, black))));
 }
 
-int main()
+int size = SIZE;		/* resolution of picture in x and y */
+
+void sample(double x, double y, double rgb[3], void *data)
+{				/* colour at x, y of the picture */
+    vec D;
+
+    D.x = x-.5-size/2,		/* pixel centers as below */
+    D.z = size/2-(y-.5),
+    D.y = size/2/tan(AOV/114.5915590261),
+    D = trace(DEPTH, black, vunit(D));
+    rgb[0] = D.x, rgb[1] = D.y, rgb[2] = D.z;
+}
+
+double seconds()
+{
+    return (double)clock()/CLOCKS_PER_SEC;
+}
+
+/* convergence: error and time of sample patterns against a picture of
+ * 256 multi-jittered samples a pixel, through the same filter */
+void bench(int filter, double contrast)
+{
+    static struct { const char *name; int pattern, first, more; } run[] = {
+	{"center", SAMPLE_CENTER, 1, 0},
+	{"jittered", SAMPLE_JITTER, 4, 0},
+	{"multi-jittered", SAMPLE_MULTIJITTER, 4, 0},
+	{"edge-optimized", SAMPLE_EDGE, 4, 0},
+	{"jittered", SAMPLE_JITTER, 16, 0},
+	{"multi-jittered", SAMPLE_MULTIJITTER, 16, 0},
+	{"edge-optimized", SAMPLE_EDGE, 16, 0},
+	{"multi-jittered", SAMPLE_MULTIJITTER, 4, 16},
+	{"edge-optimized", SAMPLE_EDGE, 4, 16},
+	{"multi-jittered", SAMPLE_MULTIJITTER, 16, 64},
+    };
+    Sampler s;
+    float *ref = malloc(3*sizeof(float)*size*size),
+	  *pic = malloc(3*sizeof(float)*size*size);
+    double t, e, d;
+    long n;
+    int i, k;
+
+    if (!ref || !pic || !SamplerInit(&s, SAMPLE_MULTIJITTER, 256, 0, 0.,
+				     filter, size, size))
+	exit(1);
+    t = seconds();
+    SamplerTile(&s, 0, 0, size, size, sample, 0, ref);
+    printf("%d x %d pixels, reference %.3f s\n", size, size, seconds()-t);
+    printf("pattern         first more  samples/pixel   seconds  rms error\n");
+    SamplerFree(&s);
+    for (i = 0; i < (int)(sizeof run/sizeof run[0]); i++) {
+	if (!SamplerInit(&s, run[i].pattern, run[i].first, run[i].more,
+			 contrast, filter, size, size))
+	    continue;
+	t = seconds();
+	n = SamplerTile(&s, 0, 0, size, size, sample, 0, pic);
+	t = seconds()-t;
+	for (e = 0., k = 0; k < 3*size*size; k++)
+	    d = 255.*(pic[k]-ref[k]), e += d*d;
+	printf("%-15s %5d %4d %14.2f %9.3f %10.3f\n", run[i].name,
+	    run[i].first, run[i].more, (double)n/size/size, t,
+	    sqrt(e/(3*size*size)));
+	SamplerFree(&s);
+    }
+    free(ref), free(pic);
+}
+
+/* minray [-s size] [-p c|j|m|e] [-n samples] [-e extra] [-c contrast]
+ *	  [-f b|t|h|q|B|m|l] [-b]
+ * without switches one ray a pixel, with them the sampler of Gems V
+ * ch6-7/sampler.c; -b compares sample patterns */
+int main(int argc, char **argv)
 {
-    printf("%d %d\n", SIZE, SIZE);
-    while (yx<SIZE*SIZE)
-	U.x = yx%SIZE-SIZE/2,
-	U.z = SIZE/2-yx++/SIZE,
-	U.y = SIZE/2/tan(AOV/114.5915590261),	/* 360/PI~=114 */
+    int sampled = 0, pattern = SAMPLE_MULTIJITTER, filter = FILTER_BOX,
+	first = 4, more = 0, k;
+    double contrast = .1;
+    Sampler smp;
+    float *pic;
+
+    for (; argc > 1 && argv[1][0] == '-'; argc--, argv++)
+	switch (argv[1][1]) {
+	case 'b': sampled = 2; break;
+	case 's': size = atoi(argv[2]), argc--, argv++; break;
+	case 'n': first = atoi(argv[2]), argc--, argv++, sampled |= 1; break;
+	case 'e': more = atoi(argv[2]), argc--, argv++, sampled |= 1; break;
+	case 'c': contrast = atof(argv[2]), argc--, argv++, sampled |= 1; break;
+	case 'p':
+	    pattern = argv[2][0]=='c' ? SAMPLE_CENTER : argv[2][0]=='j' ?
+		SAMPLE_JITTER : argv[2][0]=='e' ? SAMPLE_EDGE :
+		SAMPLE_MULTIJITTER;
+	    argc--, argv++, sampled |= 1;
+	    break;
+	case 'f':
+	    switch (argv[2][0]) {
+	    case 't': filter = FILTER_TRIANGLE; break;
+	    case 'h': filter = FILTER_HERMITE; break;
+	    case 'q': filter = FILTER_BELL; break;
+	    case 'B': filter = FILTER_BSPLINE; break;
+	    case 'm': filter = FILTER_MITCHELL; break;
+	    case 'l': filter = FILTER_LANCZOS3; break;
+	    default: filter = FILTER_BOX; break;
+	    }
+	    argc--, argv++, sampled |= 1;
+	    break;
+	}
+    if (sampled & 2) {
+	bench(filter, contrast);
+	return 0;
+    }
+    printf("%d %d\n", size, size);
+    if (sampled) {
+	pic = malloc(3*sizeof(float)*size*size);
+	if (!pic || !SamplerInit(&smp, pattern, first, more, contrast, filter,
+				 size, size))
+	    return 1;
+	SamplerTile(&smp, 0, 0, size, size, sample, 0, pic);
+	for (k = 0; k < size*size; k++)
+	    printf("%.0f %.0f %.0f\n", 255.*pic[3*k], 255.*pic[3*k+1],
+		255.*pic[3*k+2]);
+	return 0;
+    }
+    while (yx<size*size)
+	U.x = yx%size-size/2,
+	U.z = size/2-yx++/size,
+	U.y = size/2/tan(AOV/114.5915590261),	/* 360/PI~=114 */
 	U = vcomb(255., trace(DEPTH, black, vunit(U)), black),
 	printf("%.0f %.0f %.0f\n", U.x, U.y, U.z);		/* yowsa! Portable! ;) */
+    return 0;
 }
@@ -0,0 +1,361 @@
+/*
+ * NurbBench.c - Time DrawSubdivision against TessellateSurfaces.
+ *
+ * Tessellates a grid of tori (the surface of Main.c) at a range of
+ * tolerances, once a triangle at a time through DrawTriangle and once
+ * into an indexed mesh, and prints triangles per second, the triangles,
+ * and the vertices of the mesh.  With OpenMP, the mesh made on one
+ * thread is checked against the one made on all of them.  The seams
+ * are checked by counting the open edges of the mesh, those that don't
+ * have exactly two triangles on them; closed tori have none.  So are
+ * the seams between surfaces, with each torus cut into four.
+ *
+ * Then samples the tori on grids of several sizes, point by point with
+ * CalcPoint (as DrawEvaluation used to) and a grid at a time with
+ * CalcGrid, and prints samples per second and the largest differences
+ * of the points and normals.
+ *
+ * Usage: NurbBench [tori-per-side [repetitions]]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "nurbs.h"
+#include "drawing.h"
+
+void (*DrawTriangle)( SurfSample *, SurfSample *, SurfSample * );
+
+static long numDrawn;
+
+static void
+CountTriangle( SurfSample * v0, SurfSample * v1, SurfSample * v2 )
+{
+    numDrawn++;
+}
+
+/* One unit is 100 pixels, as in Main.c */
+
+void
+ScreenProject( Point4 * worldPt, Point3 * screenPt )
+{
+    screenPt->x = worldPt->x / worldPt->w * 100;
+    screenPt->y = worldPt->y / worldPt->w * 100;
+    screenPt->z = worldPt->z / worldPt->w * 100;
+}
+
+static double
+seconds( void )
+{
+#ifdef _OPENMP
+    return( omp_get_wtime() );
+#else
+    return( (double) clock() / CLOCKS_PER_SEC );
+#endif
+}
+
+/* The torus of Main.c, moved to (x, y) */
+
+static NurbSurface *
+generateTorus( double majorRadius, double minorRadius, double x, double y )
+{
+    double xvalues[] = { 0.0, -1.0, -1.0, -1.0, 0.0, 1.0, 1.0, 1.0, 0.0 };
+    double yvalues[] = { 1.0, 1.0, 0.0, -1.0, -1.0, -1.0, 0.0, 1.0, 1.0 };
+    double zvalues[] = { 0.0, 1.0, 1.0, 1.0, 0.0, -1.0, -1.0, -1.0, 0.0 };
+    double offsets[] = { -1.0, -1.0, 0.0, 1.0, 1.0, 1.0, 0.0, -1.0, -1.0 };
+    long knots[] = { 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 4 };
+    long i, j;
+    double r2over2 = sqrt( 2.0 ) / 2.0;
+    double weight;
+    NurbSurface * torus = (NurbSurface *) malloc( sizeof(NurbSurface) );
+
+    CHECK( torus );
+    torus->numU = 9;
+    torus->numV = 9;
+    torus->orderU = 3;
+    torus->orderV = 3;
+    AllocNurb( torus, NULL, NULL );
+
+    for (i = 0; i < 9; i++)
+	for (j = 0; j < 9; j++)
+	{
+	    weight = ((j & 1) ? r2over2 : 1.0) * ((i & 1) ? r2over2 : 1.0);
+	    torus->points[i][j].x = (xvalues[j]
+				    * (majorRadius + offsets[i] * minorRadius) + x) * weight;
+	    torus->points[i][j].y = (yvalues[j]
+				    * (majorRadius + offsets[i] * minorRadius) + y) * weight;
+	    torus->points[i][j].z = (zvalues[i] * minorRadius) * weight;
+	    torus->points[i][j].w = weight;
+	}
+
+    for (i = 0; i < torus->numU + torus->orderU; i++)
+	torus->kvU[i] = torus->kvV[i] = (double) knots[i];
+    return torus;
+}
+
+/* The quarter of a torus with u in [2 qu, 2 qu + 2] and v in [2 qv, 2 qv + 2] */
+
+static NurbSurface *
+generateQuarter( NurbSurface * torus, long qu, long qv )
+{
+    long knots[] = { 0, 0, 0, 1, 1, 2, 2, 2 };
+    long i, j;
+    NurbSurface * quarter = (NurbSurface *) malloc( sizeof(NurbSurface) );
+
+    CHECK( quarter );
+    quarter->numU = 5;
+    quarter->numV = 5;
+    quarter->orderU = 3;
+    quarter->orderV = 3;
+    AllocNurb( quarter, NULL, NULL );
+
+    for (i = 0; i < 5; i++)
+	for (j = 0; j < 5; j++)
+	    quarter->points[i][j] = torus->points[4 * qv + i][4 * qu + j];
+    for (i = 0; i < 8; i++)
+    {
+	quarter->kvU[i] = (double) (knots[i] + 2 * qu);
+	quarter->kvV[i] = (double) (knots[i] + 2 * qv);
+    }
+    return quarter;
+}
+
+/* Sample n on a numU by numV grid with CalcPoint */
+
+static void
+PointGrid( NurbSurface * n, long numU, long numV, SurfSample * samps )
+{
+    long i, j;
+    double u, v, d;
+    Point3 p, utan, vtan;
+    SurfSample * samp;
+
+    for (i = 0; i < numV; i++)
+    {
+	v = ((double) i / (double) (numV - 1))
+	    * (n->kvV[n->numV] - n->kvV[n->orderV-1]) + n->kvV[n->orderV-1];
+	for (j = 0; j < numU; j++)
+	{
+	    u = ((double) j / (double) (numU - 1))
+		* (n->kvU[n->numU] - n->kvU[n->orderU-1]) + n->kvU[n->orderU-1];
+	    samp = &samps[i * numU + j];
+	    CalcPoint( u, v, n, &samp->point, &utan, &vtan );
+	    (void) V3Cross( &utan, &vtan, &p );
+	    d = V3Length( &p );
+	    if (d != 0.0)
+	    {
+		p.x /= d;
+		p.y /= d;
+		p.z /= d;
+	    }
+	    samp->normLen = d;
+	    samp->normal = p;
+	    samp->u = u;
+	    samp->v = v;
+	}
+    }
+}
+
+/* Order vertices, and edges, by their coordinates */
+
+static SurfSample * sortVerts;
+
+static int
+ComparePoints( const void * a, const void * b )
+{
+    Point3 * p = &sortVerts[*(const long *) a].point;
+    Point3 * q = &sortVerts[*(const long *) b].point;
+
+    if (p->x != q->x)
+	return( p->x < q->x ? -1 : 1 );
+    if (p->y != q->y)
+	return( p->y < q->y ? -1 : 1 );
+    if (p->z != q->z)
+	return( p->z < q->z ? -1 : 1 );
+    return( 0 );
+}
+
+static int
+CompareEdges( const void * a, const void * b )
+{
+    const long * p = (const long *) a, * q = (const long *) b;
+
+    if (p[0] != q[0])
+	return( p[0] < q[0] ? -1 : 1 );
+    return( p[1] < q[1] ? -1 : p[1] > q[1] );
+}
+
+/*
+ * Number of edges of the mesh, between vertices at the same points,
+ * that don't have exactly two triangles on them.
+ */
+static long
+OpenEdges( NurbMesh * m )
+{
+    long * order, * id, * edges, i, j, p, q, open = 0L;
+
+    CHECK( order = (long *) malloc( (m->numVerts + 1L) * sizeof( long ) ) );
+    CHECK( id = (long *) malloc( (m->numVerts + 1L) * sizeof( long ) ) );
+    CHECK( edges = (long *) malloc( (6L * m->numTris + 1L) * sizeof( long ) ) );
+    for (i = 0; i < m->numVerts; i++)
+	order[i] = i;
+    sortVerts = m->verts;
+    qsort( order, m->numVerts, sizeof( long ), ComparePoints );
+    for (i = 0; i < m->numVerts; i++)
+	id[order[i]] = (i && ! ComparePoints( &order[i - 1], &order[i] ))
+		       ? id[order[i - 1]] : i;
+
+    for (i = 0; i < 3L * m->numTris; i++)
+    {
+	p = id[m->tris[i]];
+	q = id[m->tris[i % 3L == 2L ? i - 2L : i + 1L]];
+	edges[2L * i] = MIN( p, q );
+	edges[2L * i + 1L] = MAX( p, q );
+    }
+    qsort( edges, 3L * m->numTris, 2L * sizeof( long ), CompareEdges );
+    for (i = 0; i < 3L * m->numTris; i = j)
+    {
+	for (j = i + 1L; (j < 3L * m->numTris)
+			 && ! CompareEdges( &edges[2L * i], &edges[2L * j] ); j++);
+	if (j - i != 2L)
+	    open++;
+    }
+
+    free( order );
+    free( id );
+    free( edges );
+    return( open );
+}
+
+/* True if the two meshes are the same */
+
+static Boolean
+SameMesh( NurbMesh * a, NurbMesh * b )
+{
+    return( (a->numVerts == b->numVerts) && (a->numTris == b->numTris)
+	    && ! memcmp( a->verts, b->verts, a->numVerts * sizeof( SurfSample ) )
+	    && ! memcmp( a->tris, b->tris, 3L * a->numTris * sizeof( long ) ) );
+}
+
+int
+main( int argc, char * argv[] )
+{
+    long side = argc > 1 ? atol( argv[1] ) : 10L;
+    long reps = argc > 2 ? atol( argv[2] ) : 3L;
+    long n = side * side, i, r;
+    double tol, t, drawn, tessed;
+    NurbSurface ** surfs, ** quarters;
+    NurbMesh mesh;
+    const char * same = "";
+    SurfSample * a, * b;
+    long grid;
+
+    CHECK( surfs = (NurbSurface **) malloc( n * sizeof( NurbSurface * ) ) );
+    for (i = 0; i < n; i++)
+	surfs[i] = generateTorus( 1.3, 0.3, 3.5 * (i % side), 3.5 * (i / side) );
+    CHECK( quarters = (NurbSurface **) malloc( 4L * n * sizeof( NurbSurface * ) ) );
+    for (i = 0; i < 4L * n; i++)
+	quarters[i] = generateQuarter( surfs[i / 4L], i % 2L, (i / 2L) % 2L );
+    DrawTriangle = CountTriangle;
+
+#ifdef _OPENMP
+    printf( "%ld surfaces, %ld repetitions, %d threads\n", n, reps,
+	    omp_get_max_threads() );
+#else
+    printf( "%ld surfaces, %ld repetitions\n", n, reps );
+#endif
+    printf( "%9s %14s %14s %10s %10s %6s %6s\n", "tolerance", "DrawSubdiv/s",
+	    "Tessellate/s", "triangles", "vertices", "open", "same" );
+
+    for (tol = 2.0; tol >= 0.06; tol /= 2.0)
+    {
+	SubdivTolerance = tol;
+	t = seconds();
+	for (r = 0; r < reps; r++)
+	{
+	    numDrawn = 0L;
+	    for (i = 0; i < n; i++)
+		DrawSubdivision( surfs[i] );
+	}
+	drawn = numDrawn * reps / (seconds() - t);
+
+	t = seconds();
+	for (r = 0; r < reps; r++)
+	{
+	    if (r)
+		FreeNurbMesh( &mesh );
+	    TessellateSurfaces( surfs, n, tol, &mesh );
+	}
+	tessed = mesh.numTris * reps / (seconds() - t);
+
+#ifdef _OPENMP
+	{
+	    NurbMesh one;
+	    int threads = omp_get_max_threads();
+
+	    omp_set_num_threads( 1 );
+	    TessellateSurfaces( surfs, n, tol, &one );
+	    omp_set_num_threads( threads );
+	    same = SameMesh( &mesh, &one ) ? "yes" : "NO";
+	    FreeNurbMesh( &one );
+	}
+#endif
+	printf( "%9.4g %14.0f %14.0f %10ld %10ld %6ld %6s\n", tol, drawn, tessed,
+		mesh.numTris, mesh.numVerts, OpenEdges( &mesh ), same );
+	if (numDrawn > mesh.numTris)	/* The mesh also splits T-junctions */
+	    printf( "?DrawSubdivision made %ld triangles\n", numDrawn );
+	FreeNurbMesh( &mesh );
+    }
+
+    printf( "\n%9s %14s %10s %10s %6s\n", "tolerance", "quarters",
+	    "triangles", "vertices", "open" );
+    for (tol = 2.0; tol >= 0.06; tol /= 2.0)
+    {
+	TessellateSurfaces( quarters, 4L * n, tol, &mesh );
+	printf( "%9.4g %14ld %10ld %10ld %6ld\n", tol, 4L * n, mesh.numTris,
+		mesh.numVerts, OpenEdges( &mesh ) );
+	FreeNurbMesh( &mesh );
+    }
+
+    printf( "\n%5s %14s %14s %10s %10s\n", "grid", "CalcPoint/s",
+	    "CalcGrid/s", "points", "normals" );
+    for (grid = 11L; grid <= 301L; grid = 3L * grid - 2L)
+    {
+	double perPoint, perGrid, dp = 0.0, dn = 0.0, e;
+	long m = grid * grid, reps2 = MAX( 1L, reps * 100000L / (m * n) );
+
+	CHECK( a = (SurfSample *) malloc( m * sizeof( SurfSample ) ) );
+	CHECK( b = (SurfSample *) malloc( m * sizeof( SurfSample ) ) );
+	t = seconds();
+	for (r = 0; r < reps2; r++)
+	    for (i = 0; i < n; i++)
+		PointGrid( surfs[i], grid, grid, a );
+	perPoint = (double) m * n * reps2 / (seconds() - t);
+	t = seconds();
+	for (r = 0; r < reps2; r++)
+	    for (i = 0; i < n; i++)
+		CalcGrid( surfs[i], grid, grid, b );
+	perGrid = (double) m * n * reps2 / (seconds() - t);
+
+	for (i = 0; i < m; i++)
+	{
+	    Point3 diff;
+
+	    e = V3Length( V3Sub( &a[i].point, &b[i].point, &diff ) );
+	    dp = MAX( dp, e );
+	    e = V3Length( V3Sub( &a[i].normal, &b[i].normal, &diff ) );
+	    dn = MAX( dn, e );
+	}
+	printf( "%5ld %14.0f %14.0f %10.3g %10.3g\n", grid, perPoint, perGrid,
+		dp, dn );
+	free( a );
+	free( b );
+    }
+    return( 0 );
+}
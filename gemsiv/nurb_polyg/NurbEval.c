@@ -11,6 +11,13 @@
 #include "nurbs.h"
 #include "drawing.h"
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NURB_SSE2
+#endif
+
 
 /*
  * Return the current knot the parameter u is less than or equal to.
@@ -194,6 +201,201 @@ CalcPoint(double u, double v, NurbSurface * n,
     p->z = r.z / r.w;
 }
 
+/*
+ * Grid evaluation.  Sampling a whole grid, the basis functions (and
+ * their derivatives) of each row and each column are found once, in
+ * tables.  Each row of samples then blends the rows of control points
+ * into one curve (and its v derivative), and each sample blends orderU
+ * points of those: 3 * orderU point blends a sample instead of the
+ * 3 * orderU * orderV of CalcPoint, and no basis functions.  A point is
+ * blended in all four coordinates at once with SSE2 or AVX.
+ */
+
+/*
+ * out = w[0] * p[0] + ... + w[k-1] * p[k-1]
+ */
+static void
+BlendPoints( long k, double * w, Point4 * p, Point4 * out )
+{
+    long i;
+#if defined(__AVX__)
+    __m256d sum = _mm256_setzero_pd();
+
+    for (i = 0; i < k; i++)
+	sum = _mm256_add_pd( sum, _mm256_mul_pd( _mm256_set1_pd( w[i] ),
+						 _mm256_loadu_pd( &p[i].x ) ) );
+    _mm256_storeu_pd( &out->x, sum );
+#elif defined(NURB_SSE2)
+    __m128d xy = _mm_setzero_pd(), zw = _mm_setzero_pd(), wi;
+
+    for (i = 0; i < k; i++)
+    {
+	wi = _mm_set1_pd( w[i] );
+	xy = _mm_add_pd( xy, _mm_mul_pd( wi, _mm_loadu_pd( &p[i].x ) ) );
+	zw = _mm_add_pd( zw, _mm_mul_pd( wi, _mm_loadu_pd( &p[i].z ) ) );
+    }
+    _mm_storeu_pd( &out->x, xy );
+    _mm_storeu_pd( &out->z, zw );
+#else
+    out->x = out->y = out->z = out->w = 0.0;
+    for (i = 0; i < k; i++)
+    {
+	out->x += w[i] * p[i].x;
+	out->y += w[i] * p[i].y;
+	out->z += w[i] * p[i].z;
+	out->w += w[i] * p[i].w;
+    }
+#endif
+}
+
+/*
+ * dst[i] += w * src[i], for i = 0..num-1
+ */
+static void
+AddScaledPoints( long num, double w, Point4 * src, Point4 * dst )
+{
+    long i;
+#if defined(__AVX__)
+    __m256d wv = _mm256_set1_pd( w );
+
+    for (i = 0; i < num; i++)
+	_mm256_storeu_pd( &dst[i].x,
+			  _mm256_add_pd( _mm256_loadu_pd( &dst[i].x ),
+					 _mm256_mul_pd( wv, _mm256_loadu_pd( &src[i].x ) ) ) );
+#elif defined(NURB_SSE2)
+    __m128d wv = _mm_set1_pd( w );
+
+    for (i = 0; i < num; i++)
+    {
+	_mm_storeu_pd( &dst[i].x, _mm_add_pd( _mm_loadu_pd( &dst[i].x ),
+				  _mm_mul_pd( wv, _mm_loadu_pd( &src[i].x ) ) ) );
+	_mm_storeu_pd( &dst[i].z, _mm_add_pd( _mm_loadu_pd( &dst[i].z ),
+				  _mm_mul_pd( wv, _mm_loadu_pd( &src[i].z ) ) ) );
+    }
+#else
+    for (i = 0; i < num; i++)
+    {
+	dst[i].x += w * src[i].x;
+	dst[i].y += w * src[i].y;
+	dst[i].z += w * src[i].z;
+	dst[i].w += w * src[i].w;
+    }
+#endif
+}
+
+/*
+ * Tabulate the basis functions for num samples spread evenly over the
+ * parameter range of one direction (m points of order k, knots kv).
+ * Sample s is at params[s], its first control point is first[s], and
+ * the basis values and derivatives of its control points are
+ * b[s*k..s*k+k-1] and d[s*k..s*k+k-1], in control point order.
+ */
+static void
+BasisTable( double * kv, long m, long k, long num,
+	    double * params, long * first, double * b, double * d )
+{
+    long s, j, brkPoint;
+    double bvals[MAXORDER], dvals[MAXORDER];
+
+    for (s = 0; s < num; s++)
+    {
+	params[s] = (num > 1 ? (double) s / (double) (num - 1) : 0.0)
+		    * (kv[m] - kv[k-1]) + kv[k-1];
+	brkPoint = FindBreakPoint( params[s], kv, m-1, k );
+	first[s] = brkPoint - k + 1;
+	BasisFunctions( params[s], brkPoint, kv, k, bvals );
+	BasisDerivatives( params[s], brkPoint, kv, k, dvals );
+	for (j = 0; j < k; j++)
+	{
+	    b[s*k + j] = bvals[k - 1 - j];
+	    d[s*k + j] = dvals[k - 1 - j];
+	}
+    }
+}
+
+/*
+ * Evaluate surface n on a grid of numU by numV samples, evenly spaced
+ * over its parameter range, into samps[0..numU*numV-1] (a row of numU
+ * for each v).  Each sample gets its point, unit normal (normLen is the
+ * length before normalizing, 0.0 if degenerate) and u, v, as
+ * DrawEvaluation makes them with CalcPoint.
+ */
+void
+CalcGrid( NurbSurface * n, long numU, long numV, SurfSample * samps )
+{
+    long i, j, r, kU = n->orderU, kV = n->orderV, * firstU, * firstV;
+    double * us, * vs, * bu, * du, * bv, * dv, wsqrdiv, d;
+    Point4 * row, * rowv, pt, ptu, ptv;
+    Point3 utan, vtan;
+    SurfSample * samp;
+
+    CHECK( us = (double *) malloc( (numU + numV) * (2 * MAXORDER + 1)
+				   * sizeof( double ) ) );
+    vs = us + numU;
+    bu = vs + numV;
+    du = bu + numU * kU;
+    bv = du + numU * kU;
+    dv = bv + numV * kV;
+    CHECK( firstU = (long *) malloc( (numU + numV) * sizeof( long ) ) );
+    firstV = firstU + numU;
+    CHECK( row = (Point4 *) malloc( 2 * n->numU * sizeof( Point4 ) ) );
+    rowv = row + n->numU;
+
+    BasisTable( n->kvU, n->numU, kU, numU, us, firstU, bu, du );
+    BasisTable( n->kvV, n->numV, kV, numV, vs, firstV, bv, dv );
+
+    for (i = 0; i < numV; i++)
+    {
+	/* The curve (and its v derivative) along this row */
+	for (j = 0; j < n->numU; j++)
+	{
+	    row[j].x = row[j].y = row[j].z = row[j].w = 0.0;
+	    rowv[j] = row[j];
+	}
+	for (r = 0; r < kV; r++)
+	{
+	    AddScaledPoints( n->numU, bv[i*kV + r], n->points[firstV[i] + r], row );
+	    AddScaledPoints( n->numU, dv[i*kV + r], n->points[firstV[i] + r], rowv );
+	}
+
+	for (j = 0; j < numU; j++)
+	{
+	    BlendPoints( kU, &bu[j*kU], &row[firstU[j]], &pt );
+	    BlendPoints( kU, &du[j*kU], &row[firstU[j]], &ptu );
+	    BlendPoints( kU, &bu[j*kU], &rowv[firstU[j]], &ptv );
+
+	    /* Project, using the quotient rule for the tangents */
+	    samp = &samps[i * numU + j];
+	    wsqrdiv = 1.0 / (pt.w * pt.w);
+	    utan.x = (pt.w * ptu.x - ptu.w * pt.x) * wsqrdiv;
+	    utan.y = (pt.w * ptu.y - ptu.w * pt.y) * wsqrdiv;
+	    utan.z = (pt.w * ptu.z - ptu.w * pt.z) * wsqrdiv;
+	    vtan.x = (pt.w * ptv.x - ptv.w * pt.x) * wsqrdiv;
+	    vtan.y = (pt.w * ptv.y - ptv.w * pt.y) * wsqrdiv;
+	    vtan.z = (pt.w * ptv.z - ptv.w * pt.z) * wsqrdiv;
+	    samp->point.x = pt.x / pt.w;
+	    samp->point.y = pt.y / pt.w;
+	    samp->point.z = pt.z / pt.w;
+
+	    (void) V3Cross( &utan, &vtan, &samp->normal );
+	    d = V3Length( &samp->normal );
+	    if (d != 0.0)
+	    {
+		samp->normal.x /= d;
+		samp->normal.y /= d;
+		samp->normal.z /= d;
+	    }
+	    samp->normLen = d;
+	    samp->u = us[j];
+	    samp->v = vs[i];
+	}
+    }
+
+    free( us );
+    free( firstU );
+    free( row );
+}
+
 /*
  * Draw a mesh of points by evaluating the surface at evenly spaced
  * points.
@@ -201,9 +403,7 @@ CalcPoint(double u, double v, NurbSurface * n,
 void
 DrawEvaluation( NurbSurface * n )
 {
-    Point3 p, utan, vtan;
     register long i, j;
-    register double u, v, d;
     SurfSample ** pts ;
 
     long Granularity = 10;  /* Controls the number of steps in u and v */
@@ -218,39 +418,7 @@ DrawEvaluation( NurbSurface * n )
 
     /* Compute points on curve */
 
-    for (i = 0; i <= Granularity; i++)
-    {
-	v = ((double) i / (double) Granularity)
-	    * (n->kvV[n->numV] - n->kvV[n->orderV-1])
-	    + n->kvV[n->orderV-1];
-
-	for (j = 0; j <= Granularity; j++)
-	{
-	    u = ((double) j / (double) Granularity)
-		* (n->kvU[n->numU] - n->kvU[n->orderU-1])
-		+ n->kvU[n->orderU-1];
-
-	    CalcPoint( u, v, n, &(pts[i][j].point), &utan, &vtan );
-	    (void) V3Cross( &utan, &vtan, &p );
-	    d = V3Length( &p );
-	    if (d != 0.0)
-	    {
-		p.x /= d;
-		p.y /= d;
-		p.z /= d;
-	    }
-	    else
-	    {
-		p.x = 0;
-		p.y = 0;
-		p.z = 0;
-	    }
-	    pts[i][j].normLen = d;
-	    pts[i][j].normal = p;
-	    pts[i][j].u = u;
-	    pts[i][j].v = v;
-	}
-    }
+    CalcGrid( n, Granularity+1L, Granularity+1L, pts[0] );
 
     /* Draw the grid */
 
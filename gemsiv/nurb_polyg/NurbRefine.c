@@ -18,14 +18,22 @@
  * This is from Bartels, Beatty & Barsky, p. 407
  */
 static void
-CalcAlpha( double * ukv, double * wkv, long m, long n, long k, double *** alpha )
+CalcAlpha( NurbArena * arena,
+	   double * ukv, double * wkv, long m, long n, long k, double *** alpha )
 {
     register long i, j;
     long brkPoint, r, rm1, last, s;
     double omega;
     double aval[MAXORDER];
 
-    if (! *alpha)	/* Must allocate alpha */
+    if (arena)		/* Scratch alpha, given back with the arena */
+    {
+	*alpha = (double **) ArenaAlloc( arena, (k+1) * sizeof( double * ) );
+	for (i = 0; i <= k; i++)
+	    (*alpha)[i] = (double *) ArenaAlloc( arena, (m + n + 1)
+						 * sizeof( double ) );
+    }
+    else if (! *alpha)	/* Must allocate alpha */
     {
 	CHECK( *alpha = (double **) malloc( (long) ((k+1) * sizeof( double * ))) );
 	for (i = 0; i <= k; i++)
@@ -70,6 +78,17 @@ CalcAlpha( double * ukv, double * wkv, long m, long n, long k, double *** alpha
  */
 void
 RefineSurface( NurbSurface * src, NurbSurface * dest, Boolean dirflag )
+{
+    RefineSurfaceIn( NULL, src, dest, dirflag );
+}
+
+/*
+ * As RefineSurface, but with the alpha matrix allocated from arena
+ * (if it isn't NULL).
+ */
+void
+RefineSurfaceIn( NurbArena * arena,
+		 NurbSurface * src, NurbSurface * dest, Boolean dirflag )
 {
     register long i, j, out;
     register Point4 * dp, * sp;
@@ -81,14 +100,14 @@ RefineSurface( NurbSurface * src, NurbSurface * dest, Boolean dirflag )
 
     if (dirflag)
     {
-	CalcAlpha( src->kvU, dest->kvU, src->numU - 1, dest->numU - src->numU,
+	CalcAlpha( arena, src->kvU, dest->kvU, src->numU - 1, dest->numU - src->numU,
 		   src->orderU, &alpha );
 	maxj = dest->numU;
 	maxout = src->numV;
     }
     else
     {
-	CalcAlpha( src->kvV, dest->kvV, src->numV - 1, dest->numV - src->numV,
+	CalcAlpha( arena, src->kvV, dest->kvV, src->numV - 1, dest->numV - src->numV,
 		   src->orderV, &alpha );
 	maxj = dest->numV;
 	maxout = dest->numU;
@@ -129,6 +148,8 @@ RefineSurface( NurbSurface * src, NurbSurface * dest, Boolean dirflag )
 	}
 
     /* Free up the alpha matrix */
+    if (arena)
+	return;
     for (i = 0; i <= (dirflag ? src->orderU : src->orderV); i++)
 	free( alpha[i] );
     free( alpha );
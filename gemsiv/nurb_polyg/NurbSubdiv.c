@@ -7,7 +7,11 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "nurbs.h"
 #include "drawing.h"
@@ -20,6 +24,52 @@ double SubdivTolerance;	    /* Size, in pixels of facets produced */
 #define maxV(surf) ((surf)->numV-1L)
 #define maxU(surf) ((surf)->numU-1L)
 
+#define WELD 0.000001	    /* Points closer than this in x, y and z are welded */
+#define CELL (64.0 * WELD)  /* Size of the cells vertices are hashed on */
+#define MAXCHAIN 64	    /* Most vertices split into one edge */
+
+/*
+ * Vertices with their surface, hashed on the cell of space they're in
+ * so the triangles that meet at a point can share its vertex, whatever
+ * surface they're on.
+ */
+typedef struct VertexStore {
+    long numVerts, maxVerts;
+    SurfSample * verts;
+    long * surfs;
+    long * posns;	    /* First vertex at the same position */
+    long * table;	    /* Vertex indices, -1 if empty */
+    long tableSize;	    /* A power of two */
+} VertexStore;
+
+/*
+ * The edges of a mesh between positions, each listed at the lower of
+ * its two ends, once for every triangle that uses it.
+ */
+typedef struct EdgeLists {
+    long * first;	    /* Edges at p are [first[p]..first[p+1]-1] */
+    long * ends;	    /* Position at the other end */
+    long * where;	    /* 3 * triangle + side */
+} EdgeLists;
+
+/* Indexed triangles of one piece of work */
+typedef struct TessBuffer {
+    long surf;		    /* Index of the surface they're on */
+    VertexStore vs;
+    long numTris, maxTris;
+    long * tris;
+} TessBuffer;
+
+/*
+ * Where subdivision gets its memory and puts its triangles.  Every
+ * surface made by splitting comes from the arena.  Triangles go into
+ * out, or to DrawTriangle if it's NULL.
+ */
+typedef struct SubdivContext {
+    NurbArena * arena;
+    TessBuffer * out;
+} SubdivContext;
+
 /*
  * Split a knot vector at the center, by adding multiplicity k knots near
  * the middle of the parameter range.  Tries to start with an existing knot,
@@ -27,7 +77,8 @@ double SubdivTolerance;	    /* Size, in pixels of facets produced */
  * a Bezier curve).
  */
 static long
-SplitKV( double * srckv,
+SplitKV( NurbArena * arena,
+	 double * srckv,
 	 double ** destkv,
 	 long * splitPt,    /* Where the knot interval is split */
 	 long m, long k )
@@ -68,8 +119,8 @@ SplitKV( double * srckv,
     }
 
     extra = k - same;
-    CHECK( *destkv = (double *) malloc( (long) (sizeof( double )
-					* (m+k+extra+1L) ) ) );
+    *destkv = (double *) ArenaAlloc( arena, (long) (sizeof( double )
+					* (m+k+extra+1L) ) );
 
     if (same < k)	    /* Must add knots */
     {
@@ -299,7 +350,8 @@ MakeNewCorners( NurbSurface * parent,
  * projected onto those edges.
  */
 static void
-SplitSurface( NurbSurface * parent,
+SplitSurface( SubdivContext * ctx,
+	      NurbSurface * parent,
 	      NurbSurface * kid0, NurbSurface * kid1,
 	      Boolean dirflag )	    /* If true subdivided in U, else in V */
 {
@@ -316,27 +368,29 @@ SplitSurface( NurbSurface * parent,
     tmp = *parent;	/* Copy order, # of points, etc. */
     if (dirflag)
     {
-	tmp.numU = parent->numU + SplitKV( parent->kvU,
+	tmp.numU = parent->numU + SplitKV( ctx->arena,
+					    parent->kvU,
 					    &newkv,
 					    &splitPt,
 					    maxU(parent),
 					    parent->orderU );
-	AllocNurb( &tmp, newkv, NULL );
+	AllocNurbIn( ctx->arena, &tmp, newkv, NULL );
 	for (i = 0L; i < tmp.numV + tmp.orderV; i++)
 	    tmp.kvV[i] = parent->kvV[i];
     }
     else
     {
-	tmp.numV = parent->numV + SplitKV( parent->kvV,
+	tmp.numV = parent->numV + SplitKV( ctx->arena,
+					    parent->kvV,
 					    &newkv,
 					    &splitPt,
 					    maxV(parent),
 					    parent->orderV );
-	AllocNurb( &tmp, NULL, newkv );
+	AllocNurbIn( ctx->arena, &tmp, NULL, newkv );
 	for (i = 0L; i < tmp.numU + tmp.orderU; i++)
 	    tmp.kvU[i] = parent->kvU[i];
     }
-    RefineSurface( parent, &tmp, dirflag );
+    RefineSurfaceIn( ctx->arena, parent, &tmp, dirflag );
 
     /*
      * Build the two child surfaces, and copy the data from the refined
@@ -351,7 +405,7 @@ SplitSurface( NurbSurface * parent,
     kid0->numV = dirflag ? parent->numV : splitPt+1L;
     kid0->kvU = kid0->kvV = NULL;
     kid0->points = NULL;
-    AllocNurb( kid0, NULL, NULL );
+    AllocNurbIn( ctx->arena, kid0, NULL, NULL );
 
     for (i = 0L; i < kid0->numV; i++)	/* Copy the point and kv data */
 	for (j = 0L; j < kid0->numU; j++)
@@ -370,7 +424,7 @@ SplitSurface( NurbSurface * parent,
     kid1->numV = dirflag ? parent->numV : tmp.numV - splitPt;
     kid1->kvU = kid1->kvV = NULL;
     kid1->points = NULL;
-    AllocNurb( kid1, NULL, NULL );
+    AllocNurbIn( ctx->arena, kid1, NULL, NULL );
 
     for (i = 0L; i < kid1->numV; i++)	/* Copy the point and kv data */
 	for (j = 0L; j < kid1->numU; j++)
@@ -384,7 +438,7 @@ SplitSurface( NurbSurface * parent,
     /* Construct new corners on the boundry between the two kids */
     MakeNewCorners( parent, kid0, kid1, dirflag );
 
-    FreeNurb( &tmp );	    /* Get rid of refined parent */
+    /* The refined parent (tmp) goes back with the arena */
 }
 
 /*
@@ -522,11 +576,417 @@ TestFlat( NurbSurface * n, double tolerance )
 	return( TRUE );
 }
 
+/*
+ * Hash a vertex's cell.  Neighbouring cells only differ in
+ * the low bits of their coordinates, so each word is folded down with
+ * the 64 bit finalizer of MurmurHash3.
+ */
+static unsigned long long
+Mix64( unsigned long long k )
+{
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ULL;
+    k ^= k >> 33;
+    return( k );
+}
+
+#define CELLOF( x ) ((long long) floor( (x) * (1.0 / CELL) ))
+
+static long
+HashCell( long long x, long long y, long long z )
+{
+    return( (long) (Mix64( (unsigned long long) x
+			   ^ Mix64( (unsigned long long) y
+				    ^ Mix64( (unsigned long long) z ) ) ) >> 1) );
+}
+
+static void
+InitVertexStore( VertexStore * vs )
+{
+    long i;
+
+    vs->numVerts = 0L;
+    vs->maxVerts = 64L;
+    vs->tableSize = 128L;
+    CHECK( vs->verts = (SurfSample *) malloc( vs->maxVerts * sizeof( SurfSample ) ) );
+    CHECK( vs->surfs = (long *) malloc( vs->maxVerts * sizeof( long ) ) );
+    CHECK( vs->posns = (long *) malloc( vs->maxVerts * sizeof( long ) ) );
+    CHECK( vs->table = (long *) malloc( vs->tableSize * sizeof( long ) ) );
+    for (i = 0; i < vs->tableSize; i++)
+	vs->table[i] = -1L;
+}
+
+static void
+FreeVertexStore( VertexStore * vs )
+{
+    free( vs->verts );
+    free( vs->surfs );
+    free( vs->posns );
+    free( vs->table );
+}
+
+/*
+ * Return the index of the vertex for samp on surface surf, adding it if
+ * it isn't there.  Samples within WELD of each other share a vertex if
+ * their normals agree, even on different surfaces.  If they don't (a
+ * crease), the new vertex takes the position of the old one, so no crack
+ * can open between them.
+ */
+static long
+AddVertex( VertexStore * vs, long surf, SurfSample * samp )
+{
+    long i, k, mask, pos;
+    long long x, y, z, lo[3], hi[3];
+    SurfSample * old;
+    Point3 point;
+
+    if (2L * (vs->numVerts + 1L) > vs->tableSize)	/* Grow the table */
+    {
+	free( vs->table );
+	vs->tableSize *= 2L;
+	CHECK( vs->table = (long *) malloc( vs->tableSize * sizeof( long ) ) );
+	mask = vs->tableSize - 1L;
+	for (i = 0; i < vs->tableSize; i++)
+	    vs->table[i] = -1L;
+	for (k = 0; k < vs->numVerts; k++)
+	{
+	    old = &vs->verts[k];
+	    for (i = HashCell( CELLOF( old->point.x ), CELLOF( old->point.y ),
+			       CELLOF( old->point.z ) ) & mask;
+		 vs->table[i] >= 0L; i = (i + 1L) & mask);
+	    vs->table[i] = k;
+	}
+    }
+
+    /* Look in the cells within WELD of the point, usually just its own */
+    mask = vs->tableSize - 1L;
+    point = samp->point;
+    pos = -1L;
+    lo[0] = CELLOF( point.x - WELD );  hi[0] = CELLOF( point.x + WELD );
+    lo[1] = CELLOF( point.y - WELD );  hi[1] = CELLOF( point.y + WELD );
+    lo[2] = CELLOF( point.z - WELD );  hi[2] = CELLOF( point.z + WELD );
+    for (x = lo[0]; x <= hi[0]; x++)
+	for (y = lo[1]; y <= hi[1]; y++)
+	    for (z = lo[2]; z <= hi[2]; z++)
+		for (i = HashCell( x, y, z ) & mask;
+		     (k = vs->table[i]) >= 0L; i = (i + 1L) & mask)
+		{
+		    old = &vs->verts[k];
+		    if ((fabs( old->point.x - samp->point.x ) > WELD)
+			|| (fabs( old->point.y - samp->point.y ) > WELD)
+			|| (fabs( old->point.z - samp->point.z ) > WELD))
+			continue;
+		    if (V3Dot( &old->normal, &samp->normal ) > 1.0 - EPSILON)
+			return( k );
+		    point = old->point;
+		    pos = vs->posns[k];
+		}
+
+    if (vs->numVerts == vs->maxVerts)
+    {
+	vs->maxVerts *= 2L;
+	CHECK( vs->verts = (SurfSample *) realloc( vs->verts,
+				    vs->maxVerts * sizeof( SurfSample ) ) );
+	CHECK( vs->surfs = (long *) realloc( vs->surfs,
+				    vs->maxVerts * sizeof( long ) ) );
+	CHECK( vs->posns = (long *) realloc( vs->posns,
+				    vs->maxVerts * sizeof( long ) ) );
+    }
+    k = vs->numVerts++;
+    vs->verts[k] = *samp;
+    vs->verts[k].point = point;
+    vs->surfs[k] = surf;
+    vs->posns[k] = (pos >= 0L) ? pos : k;
+    for (i = HashCell( CELLOF( point.x ), CELLOF( point.y ),
+		       CELLOF( point.z ) ) & mask;
+	 vs->table[i] >= 0L; i = (i + 1L) & mask);
+    vs->table[i] = k;
+    return( k );
+}
+
+/*
+ * List the edges of the triangles, between the positions of their
+ * vertices, at the lower end.
+ */
+static void
+ListEdges( EdgeLists * el, long * posns, long numVerts,
+	   long * tris, long numTris )
+{
+    long i, p, q;
+
+    CHECK( el->first = (long *) calloc( numVerts + 2L, sizeof( long ) ) );
+    CHECK( el->ends = (long *) malloc( (3L * numTris + 1L) * sizeof( long ) ) );
+    CHECK( el->where = (long *) malloc( (3L * numTris + 1L) * sizeof( long ) ) );
+    for (i = 0; i < 3L * numTris; i++)
+    {
+	p = posns[tris[i]];
+	q = posns[tris[i % 3L == 2L ? i - 2L : i + 1L]];
+	el->first[MIN( p, q ) + 2L]++;
+    }
+    for (p = 2L; p <= numVerts + 1L; p++)
+	el->first[p] += el->first[p - 1L];
+    for (i = 0; i < 3L * numTris; i++)
+    {
+	p = posns[tris[i]];
+	q = posns[tris[i % 3L == 2L ? i - 2L : i + 1L]];
+	el->ends[el->first[MIN( p, q ) + 1L]] = MAX( p, q );
+	el->where[el->first[MIN( p, q ) + 1L]++] = i;
+    }
+}
+
+static void
+FreeEdgeLists( EdgeLists * el )
+{
+    free( el->first );
+    free( el->ends );
+    free( el->where );
+}
+
+/*
+ * True if the k'th edge of el is used by only one triangle.
+ */
+static Boolean
+IsOpen( EdgeLists * el, long p, long k )
+{
+    long i, uses = 0L;
+
+    for (i = el->first[p]; i < el->first[p + 1L]; i++)
+	if (el->ends[i] == el->ends[k])
+	    uses++;
+    return( (uses == 1L) && (el->ends[k] != p) );
+}
+
+/*
+ * The screen position of a point of the mesh.
+ */
+static void
+ScreenPoint( Point3 * p, Point3 * s )
+{
+    Point4 h;
+
+    h.x = p->x;
+    h.y = p->y;
+    h.z = p->z;
+    h.w = 1.0;
+    ScreenProject( &h, s );
+}
+
+/*
+ * Look for a path of open edges from vertex a to vertex b, whose
+ * vertices are within tolerance of the line a b on the screen and go
+ * along it in order.  others[first[p]..first[p+1]-1] are the vertices at
+ * the far ends of the open edges at position p.  The vertices between a
+ * and b, and how far along a b they are, go in chain and along.  Returns
+ * their number, or 0 if there's no such path.
+ */
+static long
+FindChain( VertexStore * vs, long * first, long * others,
+	   long a, long b, double tolerance, long * chain, double * along )
+{
+    Point3 sa, sb, ab, sx, ax, cross;
+    long i, x, cur, best, n;
+    double len2, t, d, tcur, bestT, bestD;
+
+    ScreenPoint( &vs->verts[a].point, &sa );
+    ScreenPoint( &vs->verts[b].point, &sb );
+    (void) V3Sub( &sb, &sa, &ab );
+    len2 = V3SquaredLength( &ab );
+    if (len2 < EPSILON)
+	return( 0L );
+
+    cur = vs->posns[a];
+    tcur = 0.0;
+    for (n = 0L; n < MAXCHAIN; n++)
+    {
+	best = -1L;
+	bestT = bestD = 0.0;
+	for (i = first[cur]; i < first[cur + 1L]; i++)
+	{
+	    x = others[i];
+	    if (vs->posns[x] == vs->posns[b])
+	    {
+		if (n > 0L)
+		    return( n );
+		continue;
+	    }
+	    ScreenPoint( &vs->verts[x].point, &sx );
+	    (void) V3Sub( &sx, &sa, &ax );
+	    t = V3Dot( &ax, &ab ) / len2;
+	    d = V3Length( V3Cross( &ax, &ab, &cross ) ) / sqrt( len2 );
+	    if ((t <= tcur) || (t >= 1.0) || (d > tolerance)
+		|| ((best >= 0L) && (d >= bestD)))
+		continue;
+	    best = x;
+	    bestT = t;
+	    bestD = d;
+	}
+	if (best < 0L)
+	    return( 0L );
+	chain[n] = best;
+	along[n] = bestT;
+	cur = vs->posns[best];
+	tcur = bestT;
+    }
+    return( 0L );
+}
+
+/*
+ * Remove the T-junctions left where the two sides of a seam, between
+ * surfaces or between pieces of one, were subdivided to different
+ * depths.  An edge used by only one triangle, with a path of such edges
+ * along it on the other side, has the triangle fanned out from its far
+ * corner to the vertices of the path.  The vertices of the path are
+ * used if they're on the same surface; if not, a vertex at the same
+ * position is added with the normal and (u, v) interpolated along the
+ * edge.  Repeats until no triangle is split.
+ */
+static void
+SplitTJunctions( VertexStore * vs, long ** ptris, long * pnumTris,
+		 double tolerance )
+{
+    EdgeLists el;
+    SurfSample samp, * sa, * sb;
+    long * tris = *ptris, numTris = *pnumTris, maxTris = numTris;
+    long * first, * others, chain[MAXCHAIN], w[MAXCHAIN + 1];
+    double along[MAXCHAIN], f;
+    char * done, * open;
+    long i, j, k, n, t, side, a, b, c, p, numVerts, numOld, split;
+
+    do {
+	numVerts = vs->numVerts;
+	numOld = numTris;
+	ListEdges( &el, vs->posns, numVerts, tris, numTris );
+
+	/* The open edges at each position, both ways */
+	CHECK( first = (long *) calloc( numVerts + 2L, sizeof( long ) ) );
+	CHECK( open = (char *) malloc( 3L * numTris + 1L ) );
+	for (p = n = 0; p < numVerts; p++)
+	    for (k = el.first[p]; k < el.first[p + 1L]; k++)
+		if ((open[k] = IsOpen( &el, p, k )))
+		{
+		    first[p + 2L]++;
+		    first[el.ends[k] + 2L]++;
+		    n += 2L;
+		}
+	for (p = 2L; p <= numVerts + 1L; p++)
+	    first[p] += first[p - 1L];
+	CHECK( others = (long *) malloc( (n + 1L) * sizeof( long ) ) );
+	for (p = 0; p < numVerts; p++)
+	    for (k = el.first[p]; k < el.first[p + 1L]; k++)
+		if (open[k])
+		{
+		    t = el.where[k] / 3L;
+		    side = el.where[k] % 3L;
+		    a = tris[3L * t + side];
+		    b = tris[3L * t + (side + 1L) % 3L];
+		    others[first[vs->posns[a] + 1L]++] = b;
+		    others[first[vs->posns[b] + 1L]++] = a;
+		}
+
+	CHECK( done = (char *) calloc( numOld + 1L, 1 ) );
+	for (p = split = 0; p < numVerts; p++)
+	    for (k = el.first[p]; k < el.first[p + 1L]; k++)
+	    {
+		if (! open[k])
+		    continue;
+		t = el.where[k] / 3L;
+		side = el.where[k] % 3L;
+		if (done[t])	    /* Already split, see it again next time */
+		    continue;
+		a = tris[3L * t + side];
+		b = tris[3L * t + (side + 1L) % 3L];
+		c = tris[3L * t + (side + 2L) % 3L];
+		n = FindChain( vs, first, others, a, b, tolerance, chain, along );
+		if (! n)
+		    continue;
+
+		for (j = 0; j < n; j++)
+		    if (vs->surfs[chain[j]] == vs->surfs[a])
+			w[j] = chain[j];
+		    else
+		    {
+			f = along[j];
+			sa = &vs->verts[a];
+			sb = &vs->verts[b];
+			samp = *sa;
+			samp.point = vs->verts[chain[j]].point;
+			samp.normal.x = (1.0 - f) * sa->normal.x + f * sb->normal.x;
+			samp.normal.y = (1.0 - f) * sa->normal.y + f * sb->normal.y;
+			samp.normal.z = (1.0 - f) * sa->normal.z + f * sb->normal.z;
+			samp.normLen = (1.0 - f) * sa->normLen + f * sb->normLen;
+			samp.u = (1.0 - f) * sa->u + f * sb->u;
+			samp.v = (1.0 - f) * sa->v + f * sb->v;
+			if (V3Length( &samp.normal ) > EPSILON)
+			    (void) V3Normalize( &samp.normal );
+			w[j] = AddVertex( vs, vs->surfs[a], &samp );
+		    }
+		w[n] = b;
+
+		if (numTris + n > maxTris)
+		{
+		    maxTris = 2L * (numTris + n);
+		    CHECK( tris = (long *) realloc( tris,
+					    3L * maxTris * sizeof( long ) ) );
+		}
+		tris[3L * t] = a;
+		tris[3L * t + 1L] = w[0];
+		tris[3L * t + 2L] = c;
+		for (j = 1; j <= n; j++, numTris++)
+		{
+		    tris[3L * numTris] = w[j - 1L];
+		    tris[3L * numTris + 1L] = w[j];
+		    tris[3L * numTris + 2L] = c;
+		}
+		done[t] = 1;
+		split++;
+	    }
+
+	free( done );
+	free( open );
+	free( others );
+	free( first );
+	FreeEdgeLists( &el );
+    } while (split);
+
+    *ptris = tris;
+    *pnumTris = numTris;
+}
+
+/*
+ * Send a triangle to the context's buffer, or to DrawTriangle.
+ */
+static void
+OutputTriangle( SubdivContext * ctx,
+		SurfSample * s0, SurfSample * s1, SurfSample * s2 )
+{
+    TessBuffer * out = ctx->out;
+    long * tri;
+
+    if (! out)
+    {
+	(*DrawTriangle)( s0, s1, s2 );
+	return;
+    }
+
+    if (out->numTris == out->maxTris)
+    {
+	out->maxTris = out->maxTris ? 2L * out->maxTris : 64L;
+	CHECK( out->tris = (long *) realloc( out->tris,
+				    3L * out->maxTris * sizeof( long ) ) );
+    }
+    tri = &out->tris[3L * out->numTris++];
+    tri[0] = AddVertex( &out->vs, out->surf, s0 );
+    tri[1] = AddVertex( &out->vs, out->surf, s1 );
+    tri[2] = AddVertex( &out->vs, out->surf, s2 );
+}
+
 /*
  * Turn a sufficiently flat surface into triangles.
  */
 static void
-EmitTriangles( NurbSurface * n )
+EmitTriangles( SubdivContext * ctx, NurbSurface * n )
 {
     Point3 vecnn, vec0n;		/* Diagonal vectors */
     double len2nn, len20n;		/* Diagonal lengths squared */
@@ -568,53 +1028,63 @@ EmitTriangles( NurbSurface * n )
 
     if ( len2nn < len20n )
     {
-	(*DrawTriangle)( &n->c00, &n->cnn, &n->cn0 );
-	(*DrawTriangle)( &n->c00, &n->c0n, &n->cnn );
+	OutputTriangle( ctx, &n->c00, &n->cnn, &n->cn0 );
+	OutputTriangle( ctx, &n->c00, &n->c0n, &n->cnn );
     }
     else
     {
-	(*DrawTriangle)( &n->c0n, &n->cnn, &n->cn0 );
-	(*DrawTriangle)( &n->c0n, &n->cn0, &n->c00 );
+	OutputTriangle( ctx, &n->c0n, &n->cnn, &n->cn0 );
+	OutputTriangle( ctx, &n->c0n, &n->cn0, &n->c00 );
     }
 }
 
+/*
+ * Pick the direction to split a surface that isn't flat, given the
+ * direction its parent was split in.
+ */
+static Boolean
+SplitDirection( NurbSurface * n, Boolean dirflag )
+{
+    if ( ((! n->flatV) && (! n->flatU)) || ((n->flatV) && (n->flatU)) )
+	return( ! dirflag );	/* If twisted or curved in both directions, */
+				/* then alternate subdivision direction */
+    /* Only split in directions that aren't flat */
+    return( n->flatU ? FALSE : TRUE );
+}
+
 /*
  * The recursive subdivision algorithm.	 Test if the surface is flat.
  * If so, split it into triangles.  Otherwise, split it into two halves,
  * and invoke the procedure on each half.
  */
 static void
-DoSubdivision( NurbSurface * n, double tolerance, Boolean dirflag, long level )
+DoSubdivision( SubdivContext * ctx,
+	       NurbSurface * n, double tolerance, Boolean dirflag, long level )
 {
     NurbSurface left, right;	/* ...or top or bottom. Whatever spins your wheels. */
+    ArenaMark mark;
 
     if (TestFlat( n, tolerance ))
     {
-	EmitTriangles( n );
+	EmitTriangles( ctx, n );
     }
     else
     {
-	if ( ((! n->flatV) && (! n->flatU)) || ((n->flatV) && (n->flatU)) )
-	    dirflag = ! dirflag;    /* If twisted or curved in both directions, */
-	else			    /* then alternate subdivision direction */
-	{
-	    if (n->flatU)	    /* Only split in directions that aren't flat */
-		dirflag = FALSE;
-	    else
-		dirflag = TRUE;
-	}
-	SplitSurface( n, &left, &right, dirflag );
-	DoSubdivision( &left, tolerance, dirflag, level + 1L );
-	DoSubdivision( &right, tolerance, dirflag, level + 1L );
-	FreeNurb( &left );
-	FreeNurb( &right );	    /* Deallocate surfaces made by SplitSurface */
+	dirflag = SplitDirection( n, dirflag );
+	MarkArena( ctx->arena, &mark );
+	SplitSurface( ctx, n, &left, &right, dirflag );
+	DoSubdivision( ctx, &left, tolerance, dirflag, level + 1L );
+	DoSubdivision( ctx, &right, tolerance, dirflag, level + 1L );
+	ReleaseArena( ctx->arena, &mark );  /* Deallocate surfaces made by SplitSurface */
     }
 }
 
 /*
- * Main entry point for subdivision */
-void
-DrawSubdivision( NurbSurface * surf )
+ * Set up the flags, the projected corners and the corner normals of
+ * a surface before it is subdivided.
+ */
+static void
+InitCorners( NurbSurface * surf )
 {
     surf->flatV = FALSE;
     surf->flatU = FALSE;
@@ -636,7 +1106,179 @@ DrawSubdivision( NurbSurface * surf )
     GetNormal( surf, 0L, maxU(surf) );
     GetNormal( surf, maxV(surf), 0L );
     GetNormal( surf, maxV(surf), maxU(surf) );
+}
+
+/*
+ * Main entry point for subdivision */
+void
+DrawSubdivision( NurbSurface * surf )
+{
+    NurbArena arena;
+    SubdivContext ctx;
+
+    InitCorners( surf );
+
+    InitArena( &arena );
+    ctx.arena = &arena;
+    ctx.out = NULL;
+    DoSubdivision( &ctx, surf, SubdivTolerance, TRUE, 0L );
+    FreeArena( &arena );
+}
+
+/*
+ * Parallel tessellation into an indexed mesh.
+ *
+ * The surfaces are first split, breadth first and in order, until there
+ * are PIECES pieces of work for every thread (or nothing is left to
+ * split).  A pass splits every piece that isn't flat, with the same
+ * choices DoSubdivision would make, and puts its halves in its place,
+ * so the pieces are in the order DoSubdivision would reach them.  The
+ * pieces are then subdivided on all threads, each with its own scratch
+ * arena and each piece into its own buffer.  Last, the buffers are
+ * joined in order, which shares the vertices along the seams between
+ * pieces and between surfaces, and the T-junctions along the seams are
+ * split.  The mesh doesn't depend on the number of threads.
+ */
 
-    DoSubdivision( surf, SubdivTolerance, TRUE, 0L );
-    /* Note surf is deallocated by the subdivision process */
+#define PIECES 8	    /* Pieces of work per thread */
+
+typedef struct Piece {
+    NurbSurface surf;
+    long index;		    /* Index of the surface it's part of */
+    Boolean dirflag;	    /* Direction its parent was split in */
+} Piece;
+
+void
+TessellateSurfaces( NurbSurface ** surfs, long numSurfs,
+		    double tolerance, NurbMesh * mesh )
+{
+    NurbArena splitArena;	    /* Pieces made before the threads start */
+    SubdivContext ctx;
+    Piece * pieces, * next;
+    TessBuffer * bufs;
+    VertexStore all;
+    long numPieces, numNext, want, i, j, k, p, * remap, * tris;
+    VertexStore * vs;
+    Boolean split;
+
+#ifdef _OPENMP
+    want = PIECES * (long) omp_get_max_threads();
+#else
+    want = 1L;
+#endif
+
+    CHECK( pieces = (Piece *) malloc( numSurfs * sizeof( Piece ) ) );
+    for (i = 0; i < numSurfs; i++)
+    {
+	InitCorners( surfs[i] );
+	pieces[i].surf = *surfs[i];
+	pieces[i].index = i;
+	pieces[i].dirflag = TRUE;
+    }
+    numPieces = numSurfs;
+
+    InitArena( &splitArena );
+    ctx.arena = &splitArena;
+    ctx.out = NULL;
+    for (split = TRUE; split && (numPieces < want); )
+    {
+	CHECK( next = (Piece *) malloc( 2L * numPieces * sizeof( Piece ) ) );
+	split = FALSE;
+	for (i = numNext = 0; i < numPieces; i++)
+	{
+	    if (TestFlat( &pieces[i].surf, tolerance ))
+	    {
+		next[numNext++] = pieces[i];
+		continue;
+	    }
+	    next[numNext].index = next[numNext+1].index = pieces[i].index;
+	    next[numNext].dirflag = next[numNext+1].dirflag
+		= SplitDirection( &pieces[i].surf, pieces[i].dirflag );
+	    SplitSurface( &ctx, &pieces[i].surf, &next[numNext].surf,
+			  &next[numNext+1].surf, next[numNext].dirflag );
+	    numNext += 2L;
+	    split = TRUE;
+	}
+	free( pieces );
+	pieces = next;
+	numPieces = numNext;
+    }
+
+    CHECK( bufs = (TessBuffer *) malloc( numPieces * sizeof( TessBuffer ) ) );
+    for (i = 0; i < numPieces; i++)
+    {
+	bufs[i].surf = pieces[i].index;
+	InitVertexStore( &bufs[i].vs );
+	bufs[i].numTris = bufs[i].maxTris = 0L;
+	bufs[i].tris = NULL;
+    }
+
+#pragma omp parallel private( i )
+    {
+	NurbArena arena;
+	SubdivContext tctx;
+	ArenaMark mark;
+
+	InitArena( &arena );
+	tctx.arena = &arena;
+	MarkArena( &arena, &mark );
+#pragma omp for schedule( dynamic, 1 )
+	for (i = 0; i < numPieces; i++)
+	{
+	    tctx.out = &bufs[i];
+	    DoSubdivision( &tctx, &pieces[i].surf, tolerance,
+			   pieces[i].dirflag, 0L );
+	    ReleaseArena( &arena, &mark );
+	}
+	FreeArena( &arena );
+    }
+
+    /*
+     * Join the buffers, in order, through one vertex store, which welds
+     * the vertices along the seams between pieces and between surfaces.
+     * Then split the triangles along the seams that were subdivided
+     * further on one side than on the other.
+     */
+
+    for (i = k = 0; i < numPieces; i++)
+	k += bufs[i].numTris;
+    CHECK( tris = (long *) malloc( (3L * k + 1L) * sizeof( long ) ) );
+    InitVertexStore( &all );
+    for (p = k = 0; p < numPieces; p++)
+    {
+	vs = &bufs[p].vs;
+	CHECK( remap = (long *) malloc( (vs->numVerts + 1L) * sizeof( long ) ) );
+	for (j = 0; j < vs->numVerts; j++)
+	    remap[j] = AddVertex( &all, bufs[p].surf, &vs->verts[j] );
+	for (j = 0; j < 3L * bufs[p].numTris; j++)
+	    tris[k++] = remap[bufs[p].tris[j]];
+	free( remap );
+	FreeVertexStore( vs );
+	free( bufs[p].tris );
+    }
+    k /= 3L;
+    SplitTJunctions( &all, &tris, &k, tolerance );
+
+    mesh->numVerts = all.numVerts;
+    mesh->verts = all.verts;
+    mesh->surfs = all.surfs;
+    mesh->numTris = k;
+    mesh->tris = tris;
+    free( all.posns );
+    free( all.table );
+
+    free( bufs );
+    free( pieces );
+    FreeArena( &splitArena );
+}
+
+void
+FreeNurbMesh( NurbMesh * mesh )
+{
+    free( mesh->verts );
+    free( mesh->surfs );
+    free( mesh->tris );
+    mesh->verts = NULL;
+    mesh->surfs = mesh->tris = NULL;
+    mesh->numVerts = mesh->numTris = 0L;
 }
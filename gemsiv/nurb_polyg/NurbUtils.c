@@ -37,6 +37,33 @@ AllocNurb( NurbSurface * n, double * ukv, double * vkv )
 						 * (long) sizeof( Point4 )) );
 }
 
+/*
+ * Allocate a NURB from an arena, or with malloc if arena is NULL.
+ * Surfaces from an arena are given back by ReleaseArena, not FreeNurb.
+ */
+
+void
+AllocNurbIn( NurbArena * arena, NurbSurface * n, double * ukv, double * vkv )
+{
+    long i;
+    Point4 * rows;
+
+    if (! arena)
+    {
+	AllocNurb( n, ukv, vkv );
+	return;
+    }
+
+    n->kvU = ukv ? ukv : (double *) ArenaAlloc( arena, (n->numU + n->orderU)
+							* sizeof( double ) );
+    n->kvV = vkv ? vkv : (double *) ArenaAlloc( arena, (n->numV + n->orderV)
+							* sizeof( double ) );
+    n->points = (Point4 **) ArenaAlloc( arena, n->numV * sizeof( Point4 * ) );
+    rows = (Point4 *) ArenaAlloc( arena, n->numV * n->numU * sizeof( Point4 ) );
+    for (i = 0; i < n->numV; i++)
+	n->points[i] = &rows[i * n->numU];
+}
+
 /*
  * Release storage for a patch
  */
@@ -88,3 +115,80 @@ CloneNurb( NurbSurface * src, NurbSurface * dst )
 	for (j = 0; j < src->numU; j++)
 	    dst->points[i][j] = src->points[i][j];
 }
+
+/*
+ * Arena allocation.  Blocks are kept when the arena is released, so
+ * a subdivision that reuses an arena stops calling malloc once the
+ * blocks cover its deepest recursion.
+ */
+
+#define ARENABLOCK 65536L   /* Smallest block size, in bytes */
+
+void
+InitArena( NurbArena * arena )
+{
+    CHECK( arena->first = (ArenaBlock *) malloc( sizeof( ArenaBlock )
+						 + ARENABLOCK ) );
+    arena->first->next = NULL;
+    arena->first->size = ARENABLOCK;
+    arena->first->used = 0L;
+    arena->cur = arena->first;
+}
+
+void *
+ArenaAlloc( NurbArena * arena, long size )
+{
+    ArenaBlock * b = arena->cur, * nb;
+    void * p;
+
+    size = (size + 15L) & ~15L;	    /* Keep Point4's aligned */
+    if (b->used + size > b->size)
+    {
+	if (b->next && b->next->size >= size)
+	    nb = b->next;	    /* Reuse a block released earlier */
+	else
+	{
+	    long bsize = MAX( size, ARENABLOCK );
+
+	    CHECK( nb = (ArenaBlock *) malloc( sizeof( ArenaBlock ) + bsize ) );
+	    nb->size = bsize;
+	    nb->next = b->next;
+	    b->next = nb;
+	}
+	nb->used = 0L;
+	arena->cur = b = nb;
+    }
+    p = (char *) b->data + b->used;
+    b->used += size;
+    return( p );
+}
+
+void
+MarkArena( NurbArena * arena, ArenaMark * mark )
+{
+    mark->block = arena->cur;
+    mark->used = arena->cur->used;
+}
+
+/*
+ * Give back everything allocated since the mark was taken.
+ */
+void
+ReleaseArena( NurbArena * arena, ArenaMark * mark )
+{
+    arena->cur = mark->block;
+    arena->cur->used = mark->used;
+}
+
+void
+FreeArena( NurbArena * arena )
+{
+    ArenaBlock * b, * next;
+
+    for (b = arena->first; b; b = next)
+    {
+	next = b->next;
+	free( b );
+    }
+    arena->first = arena->cur = NULL;
+}
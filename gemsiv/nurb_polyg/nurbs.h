@@ -53,6 +53,40 @@ typedef struct NurbSurface {
 
 extern double SubdivTolerance;	/* Screen space tolerance for subdivision */
 
+/*
+ * Scratch memory for subdivision.  Memory is handed out from big blocks
+ * and given back all at once, by releasing to a mark taken earlier.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock * next;
+    long size, used;	    /* In bytes */
+    double data[1];	    /* The memory, 8 byte aligned */
+} ArenaBlock;
+
+typedef struct NurbArena {
+    ArenaBlock * first, * cur;
+} NurbArena;
+
+typedef struct ArenaMark {
+    ArenaBlock * block;
+    long used;
+} ArenaMark;
+
+/*
+ * Indexed triangles produced by TessellateSurfaces.  The triangles that
+ * meet at a point share its vertex, even across surfaces, unless the
+ * normals differ there (a crease), in which case the vertices still
+ * share the same position.  Seams have no T-junctions: every edge
+ * between two surfaces, or two pieces of one, has the same vertices on
+ * both sides.
+ */
+typedef struct NurbMesh {
+    long numVerts, numTris;
+    SurfSample * verts;	    /* Vertices, [0..numVerts-1] */
+    long * surfs;	    /* Index of the (first) surface of each vertex */
+    long * tris;	    /* Vertex indices, [0..3*numTris-1] */
+} NurbMesh;
+
 #define CHECK( n ) \
     { if (!(n)) { fprintf( stderr, "Ran out of memory\n" ); exit(-1); } }
 
@@ -65,11 +99,22 @@ extern double SubdivTolerance;	/* Screen space tolerance for subdivision */
 
 extern void DrawSubdivision( NurbSurface * );
 extern void DrawEvaluation( NurbSurface * );
+extern void TessellateSurfaces( NurbSurface **, long, double, NurbMesh * );
+extern void FreeNurbMesh( NurbMesh * );
 
 extern long FindBreakPoint( double u, double * kv, long m, long k );
 extern void AllocNurb( NurbSurface *, double *, double * );
+extern void AllocNurbIn( NurbArena *, NurbSurface *, double *, double * );
 extern void CloneNurb( NurbSurface *, NurbSurface * );
 extern void FreeNurb( NurbSurface * );
 extern void RefineSurface( NurbSurface *, NurbSurface *, Boolean );
+extern void RefineSurfaceIn( NurbArena *, NurbSurface *, NurbSurface *, Boolean );
+
+extern void InitArena( NurbArena * );
+extern void * ArenaAlloc( NurbArena *, long );
+extern void MarkArena( NurbArena *, ArenaMark * );
+extern void ReleaseArena( NurbArena *, ArenaMark * );
+extern void FreeArena( NurbArena * );
 
 extern void CalcPoint( double, double, NurbSurface *, Point3 *, Point3 *, Point3 * );
+extern void CalcGrid( NurbSurface *, long, long, SurfSample * );
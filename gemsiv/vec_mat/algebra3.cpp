@@ -161,18 +161,9 @@ vec2 prod(const vec2& a, const vec2& b)
 *								*
 ****************************************************************/
 
-// CONSTRUCTORS
-
-vec3::vec3() {}
-
-vec3::vec3(const double x, const double y, const double z)
-{ n[VX] = x; n[VY] = y; n[VZ] = z; }
+// The rest are inline, in algebra3.h.
 
-vec3::vec3(const double d)
-{ n[VX] = n[VY] = n[VZ] = d; }
-
-vec3::vec3(const vec3& v)
-{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; }
+// CONSTRUCTORS
 
 vec3::vec3(const vec2& v)
 { n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = 1.0; }
@@ -180,10 +171,6 @@ vec3::vec3(const vec2& v)
 vec3::vec3(const vec2& v, double d)
 { n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = d; }
 
-vec3::vec3(const vec4& v) // it is up to caller to avoid divide-by-zero
-{ n[VX] = v.n[VX] / v.n[VW]; n[VY] = v.n[VY] / v.n[VW];
-  n[VZ] = v.n[VZ] / v.n[VW]; }
-
 vec3::vec3(const vec4& v, int dropAxis) {
     switch (dropAxis) {
 	case VX: n[VX] = v.n[VY]; n[VY] = v.n[VZ]; n[VZ] = v.n[VW]; break;
@@ -194,39 +181,8 @@ vec3::vec3(const vec4& v, int dropAxis) {
 }
 
 
-// ASSIGNMENT OPERATORS
-
-vec3& vec3::operator = (const vec3& v)
-{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; return *this; }
-
-vec3& vec3::operator += ( const vec3& v )
-{ n[VX] += v.n[VX]; n[VY] += v.n[VY]; n[VZ] += v.n[VZ]; return *this; }
-
-vec3& vec3::operator -= ( const vec3& v )
-{ n[VX] -= v.n[VX]; n[VY] -= v.n[VY]; n[VZ] -= v.n[VZ]; return *this; }
-
-vec3& vec3::operator *= ( const double d )
-{ n[VX] *= d; n[VY] *= d; n[VZ] *= d; return *this; }
-
-vec3& vec3::operator /= ( const double d )
-{ double d_inv = 1./d; n[VX] *= d_inv; n[VY] *= d_inv; n[VZ] *= d_inv;
-  return *this; }
-
-double& vec3::operator [] ( int i) {
-    if (i < VX || i > VZ)
-	V_ERROR("vec3 [] operator: illegal access; index = " << i << '\n')
-    return n[i];
-}
-
-
 // SPECIAL FUNCTIONS
 
-double vec3::length()
-{  return sqrt(length2()); }
-
-double vec3::length2()
-{  return n[VX]*n[VX] + n[VY]*n[VY] + n[VZ]*n[VZ]; }
-
 vec3& vec3::normalize() // it is up to caller to avoid divide-by-zero
 { *this /= length(); return *this; }
 
@@ -237,40 +193,9 @@ return *this; }
 
 // FRIENDS
 
-vec3 operator - (const vec3& a)
-{  return vec3(-a.n[VX],-a.n[VY],-a.n[VZ]); }
-
-vec3 operator + (const vec3& a, const vec3& b)
-{ return vec3(a.n[VX]+ b.n[VX], a.n[VY] + b.n[VY], a.n[VZ] + b.n[VZ]); }
-
-vec3 operator - (const vec3& a, const vec3& b)
-{ return vec3(a.n[VX]-b.n[VX], a.n[VY]-b.n[VY], a.n[VZ]-b.n[VZ]); }
-
-vec3 operator * (const vec3& a, const double d)
-{ return vec3(d*a.n[VX], d*a.n[VY], d*a.n[VZ]); }
-
-vec3 operator * (const double d, const vec3& a)
-{ return a*d; }
-
-vec3 operator * (const mat4& a, const vec3& v)
-{ return a * vec4(v); }
-
 vec3 operator * (const vec3& v, mat4& a)
 { return a.transpose() * v; }
 
-double operator * (const vec3& a, const vec3& b)
-{ return (a.n[VX]*b.n[VX] + a.n[VY]*b.n[VY] + a.n[VZ]*b.n[VZ]); }
-
-vec3 operator / (const vec3& a, const double d)
-{ double d_inv = 1./d; return vec3(a.n[VX]*d_inv, a.n[VY]*d_inv,
-  a.n[VZ]*d_inv); }
-
-vec3 operator ^ (const vec3& a, const vec3& b) {
-    return vec3(a.n[VY]*b.n[VZ] - a.n[VZ]*b.n[VY],
-		a.n[VZ]*b.n[VX] - a.n[VX]*b.n[VZ],
-		a.n[VX]*b.n[VY] - a.n[VY]*b.n[VX]);
-}
-
 int operator == (const vec3& a, const vec3& b)
 { return (a.n[VX] == b.n[VX]) && (a.n[VY] == b.n[VY]) && (a.n[VZ] == b.n[VZ]);
 }
@@ -314,9 +239,6 @@ vec3 max(const vec3& a, const vec3& b)
 { return vec3(MAX(a.n[VX], b.n[VX]), MAX(a.n[VY], b.n[VY]), MAX(a.n[VZ],
   b.n[VZ])); }
 
-vec3 prod(const vec3& a, const vec3& b)
-{ return vec3(a.n[VX] * b.n[VX], a.n[VY] * b.n[VY], a.n[VZ] * b.n[VZ]); }
-
 
 /****************************************************************
 *								*
@@ -324,62 +246,13 @@ vec3 prod(const vec3& a, const vec3& b)
 *								*
 ****************************************************************/
 
-// CONSTRUCTORS
-
-vec4::vec4() {}
-
-vec4::vec4(const double x, const double y, const double z, const double w)
-{ n[VX] = x; n[VY] = y; n[VZ] = z; n[VW] = w; }
-
-vec4::vec4(const double d)
-{  n[VX] = n[VY] = n[VZ] = n[VW] = d; }
-
-vec4::vec4(const vec4& v)
-{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; n[VW] = v.n[VW]; }
-
-vec4::vec4(const vec3& v)
-{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; n[VW] = 1.0; }
-
-vec4::vec4(const vec3& v, const double d)
-{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ];  n[VW] = d; }
-
+// The rest are inline, in algebra3.h.
 
-// ASSIGNMENT OPERATORS
-
-vec4& vec4::operator = (const vec4& v)
-{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; n[VW] = v.n[VW];
-return *this; }
-
-vec4& vec4::operator += ( const vec4& v )
-{ n[VX] += v.n[VX]; n[VY] += v.n[VY]; n[VZ] += v.n[VZ]; n[VW] += v.n[VW];
-return *this; }
-
-vec4& vec4::operator -= ( const vec4& v )
-{ n[VX] -= v.n[VX]; n[VY] -= v.n[VY]; n[VZ] -= v.n[VZ]; n[VW] -= v.n[VW];
-return *this; }
-
-vec4& vec4::operator *= ( const double d )
-{ n[VX] *= d; n[VY] *= d; n[VZ] *= d; n[VW] *= d; return *this; }
-
-vec4& vec4::operator /= ( const double d )
-{ double d_inv = 1./d; n[VX] *= d_inv; n[VY] *= d_inv; n[VZ] *= d_inv;
-  n[VW] *= d_inv; return *this; }
-
-double& vec4::operator [] ( int i) {
-    if (i < VX || i > VW)
-	V_ERROR("vec4 [] operator: illegal access; index = " << i << '\n')
-    return n[i];
-}
+// CONSTRUCTORS
 
 
 // SPECIAL FUNCTIONS
 
-double vec4::length()
-{ return sqrt(length2()); }
-
-double vec4::length2()
-{ return n[VX]*n[VX] + n[VY]*n[VY] + n[VZ]*n[VZ] + n[VW]*n[VW]; }
-
 vec4& vec4::normalize() // it is up to caller to avoid divide-by-zero
 { *this /= length(); return *this; }
 
@@ -390,41 +263,9 @@ n[VW] = (*fct)(n[VW]); return *this; }
 
 // FRIENDS
 
-vec4 operator - (const vec4& a)
-{ return vec4(-a.n[VX],-a.n[VY],-a.n[VZ],-a.n[VW]); }
-
-vec4 operator + (const vec4& a, const vec4& b)
-{ return vec4(a.n[VX] + b.n[VX], a.n[VY] + b.n[VY], a.n[VZ] + b.n[VZ],
-  a.n[VW] + b.n[VW]); }
-
-vec4 operator - (const vec4& a, const vec4& b)
-{  return vec4(a.n[VX] - b.n[VX], a.n[VY] - b.n[VY], a.n[VZ] - b.n[VZ],
-   a.n[VW] - b.n[VW]); }
-
-vec4 operator * (const vec4& a, const double d)
-{ return vec4(d*a.n[VX], d*a.n[VY], d*a.n[VZ], d*a.n[VW] ); }
-
-vec4 operator * (const double d, const vec4& a)
-{ return a*d; }
-
-vec4 operator * (const mat4& a, const vec4& v) {
-    #define ROWCOL(i) a.v[i].n[0]*v.n[VX] + a.v[i].n[1]*v.n[VY] \
-    + a.v[i].n[2]*v.n[VZ] + a.v[i].n[3]*v.n[VW]
-    return vec4(ROWCOL(0), ROWCOL(1), ROWCOL(2), ROWCOL(3));
-    #undef ROWCOL
-}
-
 vec4 operator * (const vec4& v, mat4& a)
 { return a.transpose() * v; }
 
-double operator * (const vec4& a, const vec4& b)
-{ return (a.n[VX]*b.n[VX] + a.n[VY]*b.n[VY] + a.n[VZ]*b.n[VZ] +
-  a.n[VW]*b.n[VW]); }
-
-vec4 operator / (const vec4& a, const double d)
-{ double d_inv = 1./d; return vec4(a.n[VX]*d_inv, a.n[VY]*d_inv, a.n[VZ]*d_inv,
-  a.n[VW]*d_inv); }
-
 int operator == (const vec4& a, const vec4& b)
 { return (a.n[VX] == b.n[VX]) && (a.n[VY] == b.n[VY]) && (a.n[VZ] == b.n[VZ])
   && (a.n[VW] == b.n[VW]); }
@@ -469,10 +310,6 @@ vec4 max(const vec4& a, const vec4& b)
 { return vec4(MAX(a.n[VX], b.n[VX]), MAX(a.n[VY], b.n[VY]), MAX(a.n[VZ],
   b.n[VZ]), MAX(a.n[VW], b.n[VW])); }
 
-vec4 prod(const vec4& a, const vec4& b)
-{ return vec4(a.n[VX] * b.n[VX], a.n[VY] * b.n[VY], a.n[VZ] * b.n[VZ],
-  a.n[VW] * b.n[VW]); }
-
 
 /****************************************************************
 *								*
@@ -624,26 +461,16 @@ void swap(mat3& a, mat3& b)
 *								*
 ****************************************************************/
 
-// CONSTRUCTORS
-
-mat4::mat4() {}
+// The rest are inline, in algebra3.h.
 
-mat4::mat4(const vec4& v0, const vec4& v1, const vec4& v2, const vec4& v3)
-{ v[0] = v0; v[1] = v1; v[2] = v2; v[3] = v3; }
+// CONSTRUCTORS
 
 mat4::mat4(const double d)
 { v[0] = v[1] = v[2] = v[3] = vec4(d); }
 
-mat4::mat4(const mat4& m)
-{ v[0] = m.v[0]; v[1] = m.v[1]; v[2] = m.v[2]; v[3] = m.v[3]; }
-
 
 // ASSIGNMENT OPERATORS
 
-mat4& mat4::operator = ( const mat4& m )
-{ v[0] = m.v[0]; v[1] = m.v[1]; v[2] = m.v[2]; v[3] = m.v[3];
-return *this; }
-
 mat4& mat4::operator += ( const mat4& m )
 { v[0] += m.v[0]; v[1] += m.v[1]; v[2] += m.v[2]; v[3] += m.v[3];
 return *this; }
@@ -658,12 +485,6 @@ mat4& mat4::operator *= ( const double d )
 mat4& mat4::operator /= ( const double d )
 { v[0] /= d; v[1] /= d; v[2] /= d; v[3] /= d; return *this; }
 
-vec4& mat4::operator [] ( int i) {
-    if (i < VX || i > VW)
-	V_ERROR("mat4 [] operator: illegal access; index = " << i << '\n')
-    return v[i];
-}
-
 // SPECIAL FUNCTIONS;
 
 mat4 mat4::transpose() {
@@ -724,17 +545,6 @@ mat4 operator + (const mat4& a, const mat4& b)
 mat4 operator - (const mat4& a, const mat4& b)
 { return mat4(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]); }
 
-mat4 operator * (mat4& a, mat4& b) {
-    #define ROWCOL(i, j) a.v[i].n[0]*b.v[0][j] + a.v[i].n[1]*b.v[1][j] + \
-    a.v[i].n[2]*b.v[2][j] + a.v[i].n[3]*b.v[3][j]
-    return mat4(
-    vec4(ROWCOL(0,0), ROWCOL(0,1), ROWCOL(0,2), ROWCOL(0,3)),
-    vec4(ROWCOL(1,0), ROWCOL(1,1), ROWCOL(1,2), ROWCOL(1,3)),
-    vec4(ROWCOL(2,0), ROWCOL(2,1), ROWCOL(2,2), ROWCOL(2,3)),
-    vec4(ROWCOL(3,0), ROWCOL(3,1), ROWCOL(3,2), ROWCOL(3,3))
-    );
-}
-
 mat4 operator * (const mat4& a, const double d)
 { return mat4(a.v[0] * d, a.v[1] * d, a.v[2] * d, a.v[3] * d); }
 
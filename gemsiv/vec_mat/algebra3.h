@@ -6,8 +6,27 @@
 *								*
 ****************************************************************/
 
+#ifndef ALGEBRA3_H
+#define ALGEBRA3_H
+
 #include <iostream>
 #include <cstdlib>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Compiled with ALGEBRA3_EXPR defined (the library and everything using
+// it alike), the arithmetic of vec3 and vec4 builds expression templates,
+// see algebra3expr.h, so that a*d + b is done in one pass and no temporary.
+#ifdef ALGEBRA3_EXPR
+#include <type_traits>
+namespace algebra3 {
+struct node;
+template <class E, int N> struct expr;
+template <class T, bool = std::is_base_of<node, T>::value> struct operand;
+}
+#endif
 
 // this line defines a new type: pointer to a function which returns a
 // double and takes as argument a double
@@ -130,6 +149,13 @@ vec3& operator *= ( const double d );	    // multiplication by a constant
 vec3& operator /= ( const double d );	    // division by a constant
 double& operator [] ( int i);		    // indexing
 
+#ifdef ALGEBRA3_EXPR
+template <class E> vec3(const algebra3::expr<E, 3>& e);	    // evaluation
+template <class E> vec3& operator = ( const algebra3::expr<E, 3>& e );
+template <class E> vec3& operator += ( const algebra3::expr<E, 3>& e );
+template <class E> vec3& operator -= ( const algebra3::expr<E, 3>& e );
+#endif
+
 // special functions
 
 double length();			    // length of a vec3
@@ -139,15 +165,19 @@ vec3& apply(V_FCT_PTR fct);		    // apply a func. to each component
 
 // friends
 
+#ifndef ALGEBRA3_EXPR
 friend vec3 operator - (const vec3& v);			    // -v1
 friend vec3 operator + (const vec3& a, const vec3& b);	    // v1 + v2
 friend vec3 operator - (const vec3& a, const vec3& b);	    // v1 - v2
 friend vec3 operator * (const vec3& a, const double d);	    // v1 * 3.0
 friend vec3 operator * (const double d, const vec3& a);	    // 3.0 * v1
+#endif
 friend vec3 operator * (const mat4& a, const vec3& v);	    // M . v
 friend vec3 operator * (const vec3& v, mat4& a);	    // v . M
 friend double operator * (const vec3& a, const vec3& b);    // dot product
+#ifndef ALGEBRA3_EXPR
 friend vec3 operator / (const vec3& a, const double d);	    // v1 / 3.0
+#endif
 friend vec3 operator ^ (const vec3& a, const vec3& b);	    // cross product
 friend int operator == (const vec3& a, const vec3& b);	    // v1 == v2 ?
 friend int operator != (const vec3& a, const vec3& b);	    // v1 != v2 ?
@@ -156,10 +186,15 @@ friend std::istream& operator >> (std::istream& s, vec3& v);	    // input from s
 friend void swap(vec3& a, vec3& b);			    // swap v1 & v2
 friend vec3 min(const vec3& a, const vec3& b);		    // min(v1, v2)
 friend vec3 max(const vec3& a, const vec3& b);		    // max(v1, v2)
+#ifndef ALGEBRA3_EXPR
 friend vec3 prod(const vec3& a, const vec3& b);		    // term by term *
+#endif
 
 // necessary friend declarations
 
+#ifdef ALGEBRA3_EXPR
+template <class T, bool E> friend struct algebra3::operand;
+#endif
 friend class vec2;
 friend class vec4;
 friend class mat3;
@@ -199,6 +234,13 @@ vec4& operator *= ( const double d );	    // multiplication by a constant
 vec4& operator /= ( const double d );	    // division by a constant
 double& operator [] ( int i);		    // indexing
 
+#ifdef ALGEBRA3_EXPR
+template <class E> vec4(const algebra3::expr<E, 4>& e);	    // evaluation
+template <class E> vec4& operator = ( const algebra3::expr<E, 4>& e );
+template <class E> vec4& operator += ( const algebra3::expr<E, 4>& e );
+template <class E> vec4& operator -= ( const algebra3::expr<E, 4>& e );
+#endif
+
 // special functions
 
 double length();			    // length of a vec4
@@ -208,15 +250,19 @@ vec4& apply(V_FCT_PTR fct);		    // apply a func. to each component
 
 // friends
 
+#ifndef ALGEBRA3_EXPR
 friend vec4 operator - (const vec4& v);			    // -v1
 friend vec4 operator + (const vec4& a, const vec4& b);	    // v1 + v2
 friend vec4 operator - (const vec4& a, const vec4& b);	    // v1 - v2
 friend vec4 operator * (const vec4& a, const double d);	    // v1 * 3.0
 friend vec4 operator * (const double d, const vec4& a);	    // 3.0 * v1
+#endif
 friend vec4 operator * (const mat4& a, const vec4& v);	    // M . v
 friend vec4 operator * (const vec4& v, mat4& a);	    // v . M
 friend double operator * (const vec4& a, const vec4& b);    // dot product
+#ifndef ALGEBRA3_EXPR
 friend vec4 operator / (const vec4& a, const double d);	    // v1 / 3.0
+#endif
 friend int operator == (const vec4& a, const vec4& b);	    // v1 == v2 ?
 friend int operator != (const vec4& a, const vec4& b);	    // v1 != v2 ?
 friend std::ostream& operator << (std::ostream& s, vec4& v);	    // output to stream
@@ -224,10 +270,15 @@ friend std::istream& operator >> (std::istream& s, vec4& v);	    // input from s
 friend void swap(vec4& a, vec4& b);			    // swap v1 & v2
 friend vec4 min(const vec4& a, const vec4& b);		    // min(v1, v2)
 friend vec4 max(const vec4& a, const vec4& b);		    // max(v1, v2)
+#ifndef ALGEBRA3_EXPR
 friend vec4 prod(const vec4& a, const vec4& b);		    // term by term *
+#endif
 
 // necessary friend declarations
 
+#ifdef ALGEBRA3_EXPR
+template <class T, bool E> friend struct algebra3::operand;
+#endif
 friend class vec3;
 friend class mat4;
 friend vec3 operator * (const mat4& a, const vec3& v);	    // linear transform
@@ -363,3 +414,334 @@ mat4 translation3D(vec3& v);				    // translation 3D
 mat4 rotation3D(vec3& Axis, const double angleDeg);	    // rotation 3D
 mat4 scaling3D(vec3& scaleVector);			    // scaling 3D
 mat4 perspective3D(const double d);			    // perspective 3D
+
+/****************************************************************
+*								*
+*	    Inline vec3, vec4 and mat4 operations		*
+*								*
+****************************************************************/
+
+// The operations of a transform-heavy inner loop are defined here rather
+// than in algebra3.cpp, so that they inline.  With SSE2, vec4 and mat4 go
+// two components at a time, and vec3 two and one.  Every sum is taken in
+// the order of the scalar code, so the results are the same to the bit.
+
+#ifdef __SSE2__
+#define A3_LOAD(p)	_mm_loadu_pd(p)
+#define A3_STORE(p, x)	_mm_storeu_pd(p, x)
+#define A3_SET1(d)	_mm_set1_pd(d)
+#define A3_ADD(a, b)	_mm_add_pd(a, b)
+#define A3_SUB(a, b)	_mm_sub_pd(a, b)
+#define A3_MUL(a, b)	_mm_mul_pd(a, b)
+#endif
+
+// vec3
+
+inline vec3::vec3() {}
+
+inline vec3::vec3(const double x, const double y, const double z)
+{ n[VX] = x; n[VY] = y; n[VZ] = z; }
+
+inline vec3::vec3(const double d)
+{ n[VX] = n[VY] = n[VZ] = d; }
+
+inline vec3::vec3(const vec3& v)
+{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; }
+
+inline vec3::vec3(const vec4& v) // it is up to caller to avoid divide-by-zero
+{ n[VX] = v.n[VX] / v.n[VW]; n[VY] = v.n[VY] / v.n[VW];
+  n[VZ] = v.n[VZ] / v.n[VW]; }
+
+inline vec3& vec3::operator = (const vec3& v)
+{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; return *this; }
+
+inline vec3& vec3::operator += ( const vec3& v )
+{ n[VX] += v.n[VX]; n[VY] += v.n[VY]; n[VZ] += v.n[VZ]; return *this; }
+
+inline vec3& vec3::operator -= ( const vec3& v )
+{ n[VX] -= v.n[VX]; n[VY] -= v.n[VY]; n[VZ] -= v.n[VZ]; return *this; }
+
+inline vec3& vec3::operator *= ( const double d )
+{ n[VX] *= d; n[VY] *= d; n[VZ] *= d; return *this; }
+
+inline vec3& vec3::operator /= ( const double d )
+{ double d_inv = 1./d; n[VX] *= d_inv; n[VY] *= d_inv; n[VZ] *= d_inv;
+  return *this; }
+
+inline double& vec3::operator [] ( int i) {
+    if (i < VX || i > VZ)
+	V_ERROR("vec3 [] operator: illegal access; index = " << i << '\n')
+    return n[i];
+}
+
+inline double vec3::length()
+{  return sqrt(length2()); }
+
+inline double vec3::length2()
+{  return n[VX]*n[VX] + n[VY]*n[VY] + n[VZ]*n[VZ]; }
+
+#ifndef ALGEBRA3_EXPR
+inline vec3 operator - (const vec3& a)
+{  return vec3(-a.n[VX],-a.n[VY],-a.n[VZ]); }
+
+inline vec3 operator + (const vec3& a, const vec3& b) {
+#ifdef __SSE2__
+    vec3 r;
+    A3_STORE(r.n, A3_ADD(A3_LOAD(a.n), A3_LOAD(b.n)));
+    r.n[VZ] = a.n[VZ] + b.n[VZ];
+    return r;
+#else
+    return vec3(a.n[VX]+ b.n[VX], a.n[VY] + b.n[VY], a.n[VZ] + b.n[VZ]);
+#endif
+}
+
+inline vec3 operator - (const vec3& a, const vec3& b) {
+#ifdef __SSE2__
+    vec3 r;
+    A3_STORE(r.n, A3_SUB(A3_LOAD(a.n), A3_LOAD(b.n)));
+    r.n[VZ] = a.n[VZ] - b.n[VZ];
+    return r;
+#else
+    return vec3(a.n[VX]-b.n[VX], a.n[VY]-b.n[VY], a.n[VZ]-b.n[VZ]);
+#endif
+}
+
+inline vec3 operator * (const vec3& a, const double d) {
+#ifdef __SSE2__
+    vec3 r;
+    A3_STORE(r.n, A3_MUL(A3_SET1(d), A3_LOAD(a.n)));
+    r.n[VZ] = d*a.n[VZ];
+    return r;
+#else
+    return vec3(d*a.n[VX], d*a.n[VY], d*a.n[VZ]);
+#endif
+}
+
+inline vec3 operator * (const double d, const vec3& a)
+{ return a*d; }
+
+inline vec3 operator / (const vec3& a, const double d)
+{ return a*(1./d); }
+
+inline vec3 prod(const vec3& a, const vec3& b)
+{ return vec3(a.n[VX] * b.n[VX], a.n[VY] * b.n[VY], a.n[VZ] * b.n[VZ]); }
+#endif
+
+inline double operator * (const vec3& a, const vec3& b)
+{ return (a.n[VX]*b.n[VX] + a.n[VY]*b.n[VY] + a.n[VZ]*b.n[VZ]); }
+
+inline vec3 operator ^ (const vec3& a, const vec3& b) {
+    return vec3(a.n[VY]*b.n[VZ] - a.n[VZ]*b.n[VY],
+		a.n[VZ]*b.n[VX] - a.n[VX]*b.n[VZ],
+		a.n[VX]*b.n[VY] - a.n[VY]*b.n[VX]);
+}
+
+// vec4
+
+inline vec4::vec4() {}
+
+inline vec4::vec4(const double x, const double y, const double z, const double w)
+{ n[VX] = x; n[VY] = y; n[VZ] = z; n[VW] = w; }
+
+inline vec4::vec4(const double d)
+{  n[VX] = n[VY] = n[VZ] = n[VW] = d; }
+
+inline vec4::vec4(const vec4& v)
+{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; n[VW] = v.n[VW]; }
+
+inline vec4::vec4(const vec3& v)
+{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; n[VW] = 1.0; }
+
+inline vec4::vec4(const vec3& v, const double d)
+{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ];  n[VW] = d; }
+
+inline vec4& vec4::operator = (const vec4& v)
+{ n[VX] = v.n[VX]; n[VY] = v.n[VY]; n[VZ] = v.n[VZ]; n[VW] = v.n[VW];
+return *this; }
+
+inline vec4& vec4::operator += ( const vec4& v ) {
+#ifdef __SSE2__
+    A3_STORE(n, A3_ADD(A3_LOAD(n), A3_LOAD(v.n)));
+    A3_STORE(n+2, A3_ADD(A3_LOAD(n+2), A3_LOAD(v.n+2)));
+#else
+    n[VX] += v.n[VX]; n[VY] += v.n[VY]; n[VZ] += v.n[VZ]; n[VW] += v.n[VW];
+#endif
+    return *this;
+}
+
+inline vec4& vec4::operator -= ( const vec4& v ) {
+#ifdef __SSE2__
+    A3_STORE(n, A3_SUB(A3_LOAD(n), A3_LOAD(v.n)));
+    A3_STORE(n+2, A3_SUB(A3_LOAD(n+2), A3_LOAD(v.n+2)));
+#else
+    n[VX] -= v.n[VX]; n[VY] -= v.n[VY]; n[VZ] -= v.n[VZ]; n[VW] -= v.n[VW];
+#endif
+    return *this;
+}
+
+inline vec4& vec4::operator *= ( const double d ) {
+#ifdef __SSE2__
+    A3_STORE(n, A3_MUL(A3_LOAD(n), A3_SET1(d)));
+    A3_STORE(n+2, A3_MUL(A3_LOAD(n+2), A3_SET1(d)));
+#else
+    n[VX] *= d; n[VY] *= d; n[VZ] *= d; n[VW] *= d;
+#endif
+    return *this;
+}
+
+inline vec4& vec4::operator /= ( const double d )
+{ return *this *= 1./d; }
+
+inline double& vec4::operator [] ( int i) {
+    if (i < VX || i > VW)
+	V_ERROR("vec4 [] operator: illegal access; index = " << i << '\n')
+    return n[i];
+}
+
+inline double vec4::length()
+{ return sqrt(length2()); }
+
+inline double vec4::length2()
+{ return n[VX]*n[VX] + n[VY]*n[VY] + n[VZ]*n[VZ] + n[VW]*n[VW]; }
+
+#ifndef ALGEBRA3_EXPR
+inline vec4 operator - (const vec4& a)
+{ return vec4(-a.n[VX],-a.n[VY],-a.n[VZ],-a.n[VW]); }
+
+inline vec4 operator + (const vec4& a, const vec4& b) {
+#ifdef __SSE2__
+    vec4 r;
+    A3_STORE(r.n, A3_ADD(A3_LOAD(a.n), A3_LOAD(b.n)));
+    A3_STORE(r.n+2, A3_ADD(A3_LOAD(a.n+2), A3_LOAD(b.n+2)));
+    return r;
+#else
+    return vec4(a.n[VX] + b.n[VX], a.n[VY] + b.n[VY], a.n[VZ] + b.n[VZ],
+		a.n[VW] + b.n[VW]);
+#endif
+}
+
+inline vec4 operator - (const vec4& a, const vec4& b) {
+#ifdef __SSE2__
+    vec4 r;
+    A3_STORE(r.n, A3_SUB(A3_LOAD(a.n), A3_LOAD(b.n)));
+    A3_STORE(r.n+2, A3_SUB(A3_LOAD(a.n+2), A3_LOAD(b.n+2)));
+    return r;
+#else
+    return vec4(a.n[VX] - b.n[VX], a.n[VY] - b.n[VY], a.n[VZ] - b.n[VZ],
+		a.n[VW] - b.n[VW]);
+#endif
+}
+
+inline vec4 operator * (const vec4& a, const double d) {
+#ifdef __SSE2__
+    vec4 r;
+    A3_STORE(r.n, A3_MUL(A3_SET1(d), A3_LOAD(a.n)));
+    A3_STORE(r.n+2, A3_MUL(A3_SET1(d), A3_LOAD(a.n+2)));
+    return r;
+#else
+    return vec4(d*a.n[VX], d*a.n[VY], d*a.n[VZ], d*a.n[VW] );
+#endif
+}
+
+inline vec4 operator * (const double d, const vec4& a)
+{ return a*d; }
+
+inline vec4 operator / (const vec4& a, const double d)
+{ return a*(1./d); }
+
+inline vec4 prod(const vec4& a, const vec4& b)
+{ return vec4(a.n[VX] * b.n[VX], a.n[VY] * b.n[VY], a.n[VZ] * b.n[VZ],
+  a.n[VW] * b.n[VW]); }
+#endif
+
+inline double operator * (const vec4& a, const vec4& b)
+{ return (a.n[VX]*b.n[VX] + a.n[VY]*b.n[VY] + a.n[VZ]*b.n[VZ] +
+  a.n[VW]*b.n[VW]); }
+
+// mat4
+
+inline mat4::mat4() {}
+
+inline mat4::mat4(const vec4& v0, const vec4& v1, const vec4& v2, const vec4& v3)
+{ v[0] = v0; v[1] = v1; v[2] = v2; v[3] = v3; }
+
+inline mat4::mat4(const mat4& m)
+{ v[0] = m.v[0]; v[1] = m.v[1]; v[2] = m.v[2]; v[3] = m.v[3]; }
+
+inline mat4& mat4::operator = ( const mat4& m )
+{ v[0] = m.v[0]; v[1] = m.v[1]; v[2] = m.v[2]; v[3] = m.v[3];
+return *this; }
+
+inline vec4& mat4::operator [] ( int i) {
+    if (i < VX || i > VW)
+	V_ERROR("mat4 [] operator: illegal access; index = " << i << '\n')
+    return v[i];
+}
+
+inline vec4 operator * (const mat4& a, const vec4& v) {
+#ifdef __SSE2__
+    // rows 0 and 1, then 2 and 3, a column at a time
+    vec4 r;
+    for (int i = 0; i < 4; i += 2) {
+	__m128d p0 = A3_LOAD(a.v[i].n), p1 = A3_LOAD(a.v[i].n+2);
+	__m128d q0 = A3_LOAD(a.v[i+1].n), q1 = A3_LOAD(a.v[i+1].n+2);
+	__m128d s = A3_MUL(_mm_unpacklo_pd(p0, q0), A3_SET1(v.n[VX]));
+	s = A3_ADD(s, A3_MUL(_mm_unpackhi_pd(p0, q0), A3_SET1(v.n[VY])));
+	s = A3_ADD(s, A3_MUL(_mm_unpacklo_pd(p1, q1), A3_SET1(v.n[VZ])));
+	s = A3_ADD(s, A3_MUL(_mm_unpackhi_pd(p1, q1), A3_SET1(v.n[VW])));
+	A3_STORE(r.n + i, s);
+    }
+    return r;
+#else
+    #define ROWCOL(i) a.v[i].n[0]*v.n[VX] + a.v[i].n[1]*v.n[VY] \
+    + a.v[i].n[2]*v.n[VZ] + a.v[i].n[3]*v.n[VW]
+    return vec4(ROWCOL(0), ROWCOL(1), ROWCOL(2), ROWCOL(3));
+    #undef ROWCOL
+#endif
+}
+
+inline vec3 operator * (const mat4& a, const vec3& v)
+{ return a * vec4(v); }
+
+inline mat4 operator * (mat4& a, mat4& b) {
+#ifdef __SSE2__
+    // row i of the product is the rows of b weighted by row i of a
+    mat4 r;
+    for (int i = 0; i < 4; i++) {
+	const double *p = a.v[i].n;
+	for (int j = 0; j < 4; j += 2) {
+	    __m128d s = A3_MUL(A3_SET1(p[0]), A3_LOAD(b.v[0].n + j));
+	    s = A3_ADD(s, A3_MUL(A3_SET1(p[1]), A3_LOAD(b.v[1].n + j)));
+	    s = A3_ADD(s, A3_MUL(A3_SET1(p[2]), A3_LOAD(b.v[2].n + j)));
+	    s = A3_ADD(s, A3_MUL(A3_SET1(p[3]), A3_LOAD(b.v[3].n + j)));
+	    A3_STORE(r.v[i].n + j, s);
+	}
+    }
+    return r;
+#else
+    #define ROWCOL(i, j) a.v[i].n[0]*b.v[0][j] + a.v[i].n[1]*b.v[1][j] + \
+    a.v[i].n[2]*b.v[2][j] + a.v[i].n[3]*b.v[3][j]
+    return mat4(
+    vec4(ROWCOL(0,0), ROWCOL(0,1), ROWCOL(0,2), ROWCOL(0,3)),
+    vec4(ROWCOL(1,0), ROWCOL(1,1), ROWCOL(1,2), ROWCOL(1,3)),
+    vec4(ROWCOL(2,0), ROWCOL(2,1), ROWCOL(2,2), ROWCOL(2,3)),
+    vec4(ROWCOL(3,0), ROWCOL(3,1), ROWCOL(3,2), ROWCOL(3,3))
+    );
+    #undef ROWCOL
+#endif
+}
+
+#ifdef __SSE2__
+#undef A3_LOAD
+#undef A3_STORE
+#undef A3_SET1
+#undef A3_ADD
+#undef A3_SUB
+#undef A3_MUL
+#endif
+
+#ifdef ALGEBRA3_EXPR
+#include "algebra3expr.h"
+#endif
+
+#endif // ALGEBRA3_H
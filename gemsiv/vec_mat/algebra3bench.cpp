@@ -0,0 +1,136 @@
+/****************************************************************
+*								*
+* algebra3bench: times transform-heavy loops of algebra3	*
+*								*
+****************************************************************/
+
+// Built twice: algebra3bench with the inline operators of algebra3.h, and
+// algebra3bench_expr with ALGEBRA3_EXPR defined, so that the vector
+// arithmetic builds expression templates.  Each loop prints nanoseconds
+// an item and a checksum of its results; the checksums of the two should
+// be the same.
+//
+// Usage: algebra3bench [items [repetitions]]
+//
+// The times mean little unless it is compiled with optimization
+// (cmake -DCMAKE_BUILD_TYPE=Release).
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include "algebra3.h"
+
+static int n, reps;
+
+static double seconds()
+{ return (double)clock() / CLOCKS_PER_SEC; }
+
+static double uniform()
+{ return 2.0 * rand() / RAND_MAX - 1.0; }
+
+static double checksum(vec3 *v)
+{
+    double s = 0.0;
+    for (int i = 0; i < n; i++)
+	s += v[i][VX] + v[i][VY] + v[i][VZ];
+    return s;
+}
+
+static double checksum(vec4 *v)
+{
+    double s = 0.0;
+    for (int i = 0; i < n; i++)
+	s += v[i][VX] + v[i][VY] + v[i][VZ] + v[i][VW];
+    return s;
+}
+
+static void report(const char *name, double t, double sum)
+{
+    printf("%-34s %8.2f %24.17g\n", name, 1e9 * t / ((double)reps * n), sum);
+}
+
+int main(int argc, char *argv[])
+{
+    n = argc > 1 ? atoi(argv[1]) : 4096;
+    reps = argc > 2 ? atoi(argv[2]) : 1000;
+
+    vec3 *a = new vec3[n], *b = new vec3[n], *c = new vec3[n], *r = new vec3[n];
+    vec4 *p = new vec4[n], *q = new vec4[n];
+    mat4 *m = new mat4[n], *mr = new mat4[n];
+    double *s = new double[n];
+    vec3 axis(0.3, -0.5, 0.8), shift(1.0, 2.0, 3.0);
+    mat4 move = translation3D(shift), turn = rotation3D(axis, 30.0);
+    mat4 view = move * turn;
+    int i, k;
+    double t;
+
+    srand(1);
+    for (i = 0; i < n; i++) {
+	a[i] = vec3(uniform(), uniform(), uniform());
+	b[i] = vec3(uniform(), uniform(), uniform());
+	c[i] = vec3(uniform(), uniform(), uniform());
+	p[i] = vec4(uniform(), uniform(), uniform(), 1.0);
+	s[i] = uniform();
+	vec3 ax(uniform(), uniform(), uniform() + 2.0);
+	m[i] = rotation3D(ax, 90.0 * uniform());
+	m[i][VX][VW] = uniform();
+    }
+
+#ifdef ALGEBRA3_EXPR
+    printf("algebra3, expression templates\n");
+#else
+    printf("algebra3, inline operators\n");
+#endif
+    printf("%d items, %d repetitions\n", n, reps);
+    printf("%-34s %8s %24s\n", "loop", "ns/item", "checksum");
+
+    t = seconds();
+    for (k = 0; k < reps; k++)
+	for (i = 0; i < n; i++)
+	    r[i] = view * a[i];
+    report("r = M * a (vec3, projective)", seconds() - t, checksum(r));
+
+    t = seconds();
+    for (k = 0; k < reps; k++)
+	for (i = 0; i < n; i++)
+	    q[i] = view * p[i];
+    report("q = M * p (vec4)", seconds() - t, checksum(q));
+
+    t = seconds();
+    for (k = 0; k < reps; k++)
+	for (i = 0; i < n; i++)
+	    mr[i] = view * m[i];
+    for (i = 0; i < n; i++)
+	q[i] = mr[i][VX] + mr[i][VY] + mr[i][VZ] + mr[i][VW];
+    report("M * m (mat4)", seconds() - t, checksum(q));
+
+    t = seconds();
+    for (k = 0; k < reps; k++)
+	for (i = 0; i < n; i++)
+	    r[i] = a[i] * s[i] + b[i];
+    report("r = a*s + b", seconds() - t, checksum(r));
+
+    t = seconds();
+    for (k = 0; k < reps; k++)
+	for (i = 0; i < n; i++)
+	    r[i] = a[i] * (1.0 - s[i]) + b[i] * s[i] - c[i] / 3.0;
+    report("r = a*(1-s) + b*s - c/3", seconds() - t, checksum(r));
+
+    t = seconds();
+    for (k = 0; k < reps; k++)
+	for (i = 0; i < n; i++)
+	    q[i] = p[i] * s[i] + view * (p[i] - prod(p[i], p[i]));
+    report("q = p*s + M * (p - prod(p, p))", seconds() - t, checksum(q));
+
+    t = seconds();
+    for (k = 0; k < reps; k++)
+	for (i = 0; i < n; i++) {
+	    vec3 e1 = b[i] - a[i], e2 = c[i] - a[i];
+	    r[i] = (e1 ^ e2) * (1.0 / (e1 * e2 + 4.0)) + a[i];
+	}
+    report("triangle normal", seconds() - t, checksum(r));
+
+    delete [] a; delete [] b; delete [] c; delete [] r;
+    delete [] p; delete [] q; delete [] m; delete [] mr; delete [] s;
+    return 0;
+}
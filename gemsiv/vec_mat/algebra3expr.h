@@ -0,0 +1,181 @@
+/****************************************************************
+*								*
+* Expression templates for vec3 and vec4, included by algebra3.h *
+* when ALGEBRA3_EXPR is defined.				*
+*								*
+****************************************************************/
+
+// Unary -, +, -, * and / by a double, and prod() of vec3s and vec4s
+// return a small object describing the operation instead of its result.
+// Nothing is computed until the expression is assigned to (or used to
+// construct) a vec3 or vec4, which then takes each component of the whole
+// expression in one pass:
+//
+//	vec3 p = a*s + b - c/t;		// one loop, no temporary vec3
+//
+// Each component is computed in the order of the eager operators, so the
+// results are the same.  Components are independent, so p = p*s + q is
+// safe.  An expression keeps references to its vec3 and vec4 operands,
+// so it must not outlive them; do not keep one in an `auto' variable.
+// Functions that take a vec3 or vec4, and the operators that are not
+// listed above (dot and cross products, mat4 * vec4, ==, ...), make a
+// vec3 or vec4 of an expression first, as does vec3(a + b).length().
+
+namespace algebra3 {
+
+struct node {};
+
+// base of the expressions of N components
+template <class E, int N> struct expr : node {
+    static const int dim = N;
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// a vec3 or vec4 operand
+template <int N> struct ref : expr<ref<N>, N> {
+    const double *p;
+    explicit ref(const double *q) : p(q) {}
+    double operator [] (int i) const { return p[i]; }
+};
+
+template <class A, class B, class Op> struct binary
+    : expr<binary<A, B, Op>, A::dim> {
+    A a;
+    B b;
+    binary(const A& x, const B& y) : a(x), b(y) {}
+    double operator [] (int i) const { return Op::apply(a[i], b[i]); }
+};
+
+template <class A> struct scaled : expr<scaled<A>, A::dim> {
+    A a;
+    double d;
+    scaled(const A& x, double s) : a(x), d(s) {}
+    double operator [] (int i) const { return d*a[i]; }
+};
+
+template <class A> struct negated : expr<negated<A>, A::dim> {
+    A a;
+    explicit negated(const A& x) : a(x) {}
+    double operator [] (int i) const { return -a[i]; }
+};
+
+struct add { static double apply(double x, double y) { return x + y; } };
+struct sub { static double apply(double x, double y) { return x - y; } };
+struct mul { static double apply(double x, double y) { return x * y; } };
+
+// operand<T>::get(t) is t as an expression: vec3 and vec4 by reference,
+// expressions by value; dim is 0 for anything else
+template <class T, bool> struct operand {
+    static const int dim = 0;
+};
+
+template <class T> struct operand<T, true> {
+    static const int dim = T::dim;
+    typedef T type;
+    static const T& get(const T& e) { return e; }
+};
+
+template <> struct operand<vec3, false> {
+    static const int dim = 3;
+    typedef ref<3> type;
+    static type get(const vec3& v) { return type(v.n); }
+};
+
+template <> struct operand<vec4, false> {
+    static const int dim = 4;
+    typedef ref<4> type;
+    static type get(const vec4& v) { return type(v.n); }
+};
+
+// the type of an operation, if its operands are vectors of one size
+template <class A, class B, class Op,
+	  bool = operand<A>::dim != 0 && operand<A>::dim == operand<B>::dim>
+struct binary_of {};
+
+template <class A, class B, class Op> struct binary_of<A, B, Op, true> {
+    typedef binary<typename operand<A>::type, typename operand<B>::type, Op>
+	type;
+};
+
+template <class A, bool = operand<A>::dim != 0> struct unary_of {};
+
+template <class A> struct unary_of<A, true> {
+    typedef scaled<typename operand<A>::type> scaled_type;
+    typedef negated<typename operand<A>::type> negated_type;
+};
+
+} // namespace algebra3
+
+// EVALUATION
+
+template <class E> inline vec3::vec3(const algebra3::expr<E, 3>& e)
+{ const E& x = e.self(); n[VX] = x[VX]; n[VY] = x[VY]; n[VZ] = x[VZ]; }
+
+template <class E> inline vec3& vec3::operator = (const algebra3::expr<E, 3>& e)
+{ const E& x = e.self(); n[VX] = x[VX]; n[VY] = x[VY]; n[VZ] = x[VZ];
+  return *this; }
+
+template <class E> inline vec3& vec3::operator += (const algebra3::expr<E, 3>& e)
+{ const E& x = e.self(); n[VX] += x[VX]; n[VY] += x[VY]; n[VZ] += x[VZ];
+  return *this; }
+
+template <class E> inline vec3& vec3::operator -= (const algebra3::expr<E, 3>& e)
+{ const E& x = e.self(); n[VX] -= x[VX]; n[VY] -= x[VY]; n[VZ] -= x[VZ];
+  return *this; }
+
+template <class E> inline vec4::vec4(const algebra3::expr<E, 4>& e)
+{ const E& x = e.self(); n[VX] = x[VX]; n[VY] = x[VY]; n[VZ] = x[VZ];
+  n[VW] = x[VW]; }
+
+template <class E> inline vec4& vec4::operator = (const algebra3::expr<E, 4>& e)
+{ const E& x = e.self(); n[VX] = x[VX]; n[VY] = x[VY]; n[VZ] = x[VZ];
+  n[VW] = x[VW]; return *this; }
+
+template <class E> inline vec4& vec4::operator += (const algebra3::expr<E, 4>& e)
+{ const E& x = e.self(); n[VX] += x[VX]; n[VY] += x[VY]; n[VZ] += x[VZ];
+  n[VW] += x[VW]; return *this; }
+
+template <class E> inline vec4& vec4::operator -= (const algebra3::expr<E, 4>& e)
+{ const E& x = e.self(); n[VX] -= x[VX]; n[VY] -= x[VY]; n[VZ] -= x[VZ];
+  n[VW] -= x[VW]; return *this; }
+
+// OPERATORS (of vec3s, vec4s and expressions)
+
+template <class A>
+inline typename algebra3::unary_of<A>::negated_type operator - (const A& a)
+{ return typename algebra3::unary_of<A>::negated_type(
+  algebra3::operand<A>::get(a)); }
+
+template <class A, class B>
+inline typename algebra3::binary_of<A, B, algebra3::add>::type
+operator + (const A& a, const B& b)
+{ return typename algebra3::binary_of<A, B, algebra3::add>::type(
+  algebra3::operand<A>::get(a), algebra3::operand<B>::get(b)); }
+
+template <class A, class B>
+inline typename algebra3::binary_of<A, B, algebra3::sub>::type
+operator - (const A& a, const B& b)
+{ return typename algebra3::binary_of<A, B, algebra3::sub>::type(
+  algebra3::operand<A>::get(a), algebra3::operand<B>::get(b)); }
+
+template <class A>
+inline typename algebra3::unary_of<A>::scaled_type
+operator * (const A& a, const double d)
+{ return typename algebra3::unary_of<A>::scaled_type(
+  algebra3::operand<A>::get(a), d); }
+
+template <class A>
+inline typename algebra3::unary_of<A>::scaled_type
+operator * (const double d, const A& a)
+{ return a*d; }
+
+template <class A>
+inline typename algebra3::unary_of<A>::scaled_type
+operator / (const A& a, const double d)
+{ return a*(1./d); }
+
+template <class A, class B>
+inline typename algebra3::binary_of<A, B, algebra3::mul>::type
+prod(const A& a, const B& b)
+{ return typename algebra3::binary_of<A, B, algebra3::mul>::type(
+  algebra3::operand<A>::get(a), algebra3::operand<B>::get(b)); }
@@ -90,3 +90,22 @@ void	 makeVertexNormals(Smooth smooth);
 void	 setFuzzFraction(Smooth smooth, float fuzzFraction);
 void	 enableEdgePreservation(Smooth smooth, float minDot);
 void	 disableEdgePreservation(Smooth smooth);
+
+/********* indexed welding and smoothing (weld.c) ************/
+
+/* the corners of all the polygons in order; corner c is at
+   verts[index[c]] and has normal normals[normIndex[c]] */
+typedef struct WeldMeshstruct {
+    int		numVerts;   /* welded vertices */
+    Point3	*verts;	    /* first position seen of each */
+    int		numCorners; /* polygon corners */
+    int		*index;	    /* welded vertex of each corner */
+    int		numNormals; /* smoothed normals */
+    Vector3	*normals;
+    int		*normIndex; /* normal of each corner */
+    } WeldMesh_def;
+typedef WeldMesh_def *WeldMesh;
+
+WeldMesh weldPolygons(Smooth smooth, int numPolys, int *polySizes, int polySize,
+		      Point3 *verts);
+void	 freeWeldMesh(WeldMesh mesh);
@@ -0,0 +1,363 @@
+/* weld.c - Weld polygon corners into indexed vertices and smooth normals.
+
+  This does what makeVertexNormals() does, for meshes with millions of
+  vertices.  The polygons come as one array of corners, and the result
+  is index buffers: a welded vertex for each corner and a normal for each
+  corner.  The options are those of the Smooth (setFuzzFraction(),
+  enableEdgePreservation()); its polygon list isn't used.
+
+    mesh = weldPolygons(smooth, numPolys, polySizes, polySize, verts);
+    ... mesh->verts[mesh->index[c]], mesh->normals[mesh->normIndex[c]] ...
+    freeWeldMesh(mesh);
+
+  Polygon i has polySizes[i] corners, or polySize if polySizes is NULL.
+
+  Two corners are the same vertex if each coordinate differs by no more
+  than the fuzz, which is fuzzFraction of the largest dimension of the
+  model (0 welds only equal points).  A corner is welded to the first
+  vertex made that is within the fuzz of it, or else makes a new one.
+
+  The vertices are found through a grid of cells 4 fuzzes wide, in an
+  open-addressing hash table of the occupied cells sized to the input.
+  A vertex is listed in the cell it falls in; a corner looks in that cell,
+  and in the next one along an axis only if it is within the fuzz of
+  that side, so it mostly looks in one cell, and never in more than 8.
+
+  The corners are taken in chunks, on all threads with OpenMP: each
+  chunk first finds its equal corners in a table of its own, then its
+  distinct points are welded into the final table in order, each at its
+  own position.	 A corner equal to one before it gets the same vertex
+  anyway, so the result is that of welding the corners one by one,
+  whatever the chunks or the number of threads.
+
+  The normals are grouped per vertex as processHashNode() does: the
+  first corner not yet done starts a group, which takes in every other
+  such corner whose polygon normal is within minDot of its own (or all
+  of them, without edge preservation).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "smooth.h"
+
+#define WELDCHUNK  65536	/* corners welded in one chunk */
+#define CELLFUZZ   4		/* cell size, in fuzzes */
+
+typedef struct WeldTablestruct {
+    int	    *cells;	/* x, y, z and first vertex of each slot; -1 if free */
+    int	    size;	/* slots, a power of two */
+    int	    used;
+    Point3  *verts;
+    int	    *next;	/* next vertex in the same cell */
+    int	    numVerts, maxVerts;
+    } WeldTable_def;
+typedef WeldTable_def *WeldTable;
+
+typedef struct WeldGridstruct {
+    Point3  min;	/* corner of cell 0, 0, 0 */
+    float   cell;	/* cell size */
+    float   fuzz;
+    } WeldGrid_def;
+typedef WeldGrid_def *WeldGrid;
+
+static void initWeldTable(WeldTable table, int expect) {
+int i;
+    for (table->size = 16; table->size < 2*expect; table->size *= 2) ;
+    table->cells = NEWA(int, 4*table->size);
+    for (i=0; i<table->size; i++) table->cells[4*i+3] = -1;
+    table->used = 0;
+    table->maxVerts = expect > 16 ? expect : 16;
+    table->verts = NEWA(Point3, table->maxVerts);
+    table->next = NEWA(int, table->maxVerts);
+    table->numVerts = 0;
+    }
+
+static void freeWeldTable(WeldTable table) {
+    free(table->cells);
+    free(table->verts);
+    free(table->next);
+    }
+
+static unsigned hashCell(int x, int y, int z) {
+    unsigned h = (unsigned)x * 73856093u ^ (unsigned)y * 19349663u ^
+		 (unsigned)z * 83492791u;
+    return(h ^ (h >> 15));
+    }
+
+/* slot of cell x, y, z, or of the free slot it would go in */
+static int findCell(WeldTable table, int x, int y, int z) {
+int mask = table->size - 1;
+int i = hashCell(x, y, z) & mask;
+int *c;
+    for (;; i = (i+1) & mask) {
+	c = &table->cells[4*i];
+	if (c[3] < 0 || (c[0] == x && c[1] == y && c[2] == z)) return(i);
+	};
+    }
+
+/* double the table when it's half full */
+static void growWeldTable(WeldTable table) {
+int *old = table->cells, oldSize = table->size, i, s;
+    table->size *= 2;
+    table->cells = NEWA(int, 4*table->size);
+    for (i=0; i<table->size; i++) table->cells[4*i+3] = -1;
+    for (i=0; i<oldSize; i++) if (old[4*i+3] >= 0) {
+	s = findCell(table, old[4*i], old[4*i+1], old[4*i+2]);
+	memcpy(&table->cells[4*s], &old[4*i], 4*sizeof(int));
+	};
+    free(old);
+    }
+
+/* the vertex p is welded to in the table, made if there isn't one */
+static int weldVertex(WeldTable table, WeldGrid grid, Point3 *p) {
+float f[3], q[3];
+int c[3], lo[3], hi[3], x, y, z, i, v, s, best = -1;
+Point3 *w;
+    q[0] = (p->x - grid->min.x) / grid->cell;
+    q[1] = (p->y - grid->min.y) / grid->cell;
+    q[2] = (p->z - grid->min.z) / grid->cell;
+    for (i=0; i<3; i++) {
+	c[i] = (int)floorf(q[i]);
+	f[i] = (q[i] - c[i]) * grid->cell;	/* distance into the cell */
+	lo[i] = c[i] - (f[i] <= grid->fuzz);
+	hi[i] = c[i] + (grid->cell - f[i] <= grid->fuzz);
+	};
+    for (x=lo[0]; x<=hi[0]; x++)
+      for (y=lo[1]; y<=hi[1]; y++)
+	for (z=lo[2]; z<=hi[2]; z++) {
+	  s = findCell(table, x, y, z);
+	  for (v=table->cells[4*s+3]; v>=0; v=table->next[v]) {
+	    w = &table->verts[v];
+	    if (fabsf(w->x - p->x) <= grid->fuzz &&
+		fabsf(w->y - p->y) <= grid->fuzz &&
+		fabsf(w->z - p->z) <= grid->fuzz && (best < 0 || v < best))
+		best = v;
+	    };
+	  };
+    if (best >= 0) return(best);
+
+    /* a new vertex, at the head of its cell's list */
+    if (table->numVerts == table->maxVerts) {
+	table->maxVerts *= 2;
+	table->verts = (Point3 *)realloc(table->verts,
+					 table->maxVerts * sizeof(Point3));
+	table->next = (int *)realloc(table->next, table->maxVerts * sizeof(int));
+	};
+    if (2 * (table->used + 1) > table->size) growWeldTable(table);
+    v = table->numVerts++;
+    table->verts[v] = *p;
+    s = findCell(table, c[0], c[1], c[2]);
+    if (table->cells[4*s+3] < 0) {
+	table->cells[4*s] = c[0];
+	table->cells[4*s+1] = c[1];
+	table->cells[4*s+2] = c[2];
+	table->used++;
+	table->next[v] = -1;
+	}
+    else table->next[v] = table->cells[4*s+3];
+    table->cells[4*s+3] = v;
+    return(v);
+    }
+
+/* Newell's method, as makePolyNormal() */
+static void polyNormal(Point3 *vp, int n, Vector3 *normal) {
+Point3 *p0, *p1;
+float len;
+int i;
+    normal->x = normal->y = normal->z = 0.f;
+    for (i=0; i<n; i++) {
+	p0 = &vp[i];
+	p1 = &vp[i == n-1 ? 0 : i+1];
+	normal->x += (p1->y - p0->y) * (p1->z + p0->z);
+	normal->y += (p1->z - p0->z) * (p1->x + p0->x);
+	normal->z += (p1->x - p0->x) * (p1->y + p0->y);
+	};
+    len = sqrtf(normal->x*normal->x + normal->y*normal->y + normal->z*normal->z);
+    if (len != 0.f) { normal->x /= len; normal->y /= len; normal->z /= len; };
+    }
+
+/* group the corners cl[0..n-1] of one vertex; returns the number of
+   groups, and if normals isn't NULL, stores the normal of each group
+   from normals[first] on and the group of each corner in normIndex.
+   done[] is scratch for n flags. */
+static int groupCorners(int *cl, int n, int *polyOf, Vector3 *polyNorm,
+			Smooth smooth, char *done, Vector3 *normals, int first,
+			int *normIndex) {
+int i, j, groups = 0;
+Vector3 *head, *test, sum;
+float len;
+    memset(done, 0, n);
+    for (i=0; i<n; i++) {
+	if (done[i]) continue;
+	head = &polyNorm[polyOf[cl[i]]];
+	sum = *head;
+	if (normIndex) normIndex[cl[i]] = first + groups;
+	for (j=i+1; j<n; j++) {
+	    if (done[j]) continue;
+	    test = &polyNorm[polyOf[cl[j]]];
+	    if ((!(smooth->edgeTest)) ||
+		(test->x*head->x + test->y*head->y + test->z*head->z >
+		 smooth->minDot)) {
+		sum.x += test->x; sum.y += test->y; sum.z += test->z;
+		done[j] = 1;
+		if (normIndex) normIndex[cl[j]] = first + groups;
+		};
+	    };
+	if (normals) {
+	    len = sqrtf(sum.x*sum.x + sum.y*sum.y + sum.z*sum.z);
+	    if (len != 0.f) { sum.x /= len; sum.y /= len; sum.z /= len; };
+	    normals[first + groups] = sum;
+	    };
+	groups++;
+	};
+    return(groups);
+    }
+
+WeldMesh weldPolygons(Smooth smooth, int numPolys, int *polySizes, int polySize,
+		      Point3 *verts) {
+WeldMesh mesh = NEWTYPE(WeldMesh_def);
+WeldTable_def table;
+WeldGrid_def grid;
+Point3 min, max;
+Vector3 *polyNorm;
+int *polyStart, *polyOf, *vertStart, *vertCorners, *groupStart;
+int numCorners, numChunks, maxDeg, i, k;
+float d;
+
+    /* where each polygon starts, and the polygon of each corner */
+    polyStart = NEWA(int, numPolys+1);
+    polyStart[0] = 0;
+    for (i=0; i<numPolys; i++)
+	polyStart[i+1] = polyStart[i] + (polySizes ? polySizes[i] : polySize);
+    numCorners = polyStart[numPolys];
+    if (numCorners <= 0) {		/* nothing to weld */
+	mesh->numVerts = mesh->numCorners = mesh->numNormals = 0;
+	mesh->verts = NULL;
+	mesh->index = mesh->normIndex = NULL;
+	mesh->normals = NULL;
+	free(polyStart);
+	return(mesh);
+	};
+    polyOf = NEWA(int, numCorners);
+    for (i=0; i<numPolys; i++)
+	for (k=polyStart[i]; k<polyStart[i+1]; k++) polyOf[k] = i;
+
+    /* the fuzz, from the largest dimension of the model */
+    min = max = verts[0];
+    for (i=1; i<numCorners; i++) {
+	if (verts[i].x < min.x) min.x = verts[i].x;
+	if (verts[i].y < min.y) min.y = verts[i].y;
+	if (verts[i].z < min.z) min.z = verts[i].z;
+	if (verts[i].x > max.x) max.x = verts[i].x;
+	if (verts[i].y > max.y) max.y = verts[i].y;
+	if (verts[i].z > max.z) max.z = verts[i].z;
+	};
+    d = max.x - min.x;
+    if (max.y - min.y > d) d = max.y - min.y;
+    if (max.z - min.z > d) d = max.z - min.z;
+    grid.min = min;
+    grid.fuzz = d * smooth->fuzzFraction;
+    grid.cell = CELLFUZZ * grid.fuzz;
+    if (grid.cell < d * 1e-6f) grid.cell = d * 1e-6f;	/* keep cells in int */
+    if (grid.cell == 0.f) grid.cell = 1.f;
+    smooth->fuzz = grid.fuzz;
+
+    /* the equal corners of each chunk, then its points welded in order */
+    mesh->numCorners = numCorners;
+    mesh->index = NEWA(int, numCorners);
+    numChunks = (numCorners + WELDCHUNK - 1) / WELDCHUNK;
+    initWeldTable(&table, numCorners / 4);
+#pragma omp parallel for ordered schedule(dynamic)
+    for (k=0; k<numChunks; k++) {
+	WeldTable_def local;
+	WeldGrid_def equal = grid;
+	int c, end = (k+1)*WELDCHUNK < numCorners ? (k+1)*WELDCHUNK : numCorners;
+	int *map;
+	equal.fuzz = 0.f;
+	initWeldTable(&local, (end - k*WELDCHUNK) / 4);
+	for (c=k*WELDCHUNK; c<end; c++)
+	    mesh->index[c] = weldVertex(&local, &equal, &verts[c]);
+#pragma omp ordered
+	{
+	map = NEWA(int, local.numVerts);
+	for (c=0; c<local.numVerts; c++)
+	    map[c] = weldVertex(&table, &grid, &local.verts[c]);
+	}
+	for (c=k*WELDCHUNK; c<end; c++) mesh->index[c] = map[mesh->index[c]];
+	free(map);
+	freeWeldTable(&local);
+	};
+    mesh->numVerts = table.numVerts;
+    mesh->verts = (Point3 *)realloc(table.verts,
+				    (table.numVerts > 0 ? table.numVerts : 1) *
+				    sizeof(Point3));
+    free(table.cells);
+    free(table.next);
+
+    /* the polygon normals */
+    polyNorm = NEWA(Vector3, numPolys > 0 ? numPolys : 1);
+#pragma omp parallel for schedule(static)
+    for (i=0; i<numPolys; i++)
+	polyNormal(&verts[polyStart[i]], polyStart[i+1] - polyStart[i],
+		   &polyNorm[i]);
+
+    /* the corners of each vertex, in order */
+    vertStart = NEWA(int, mesh->numVerts+1);
+    vertCorners = NEWA(int, numCorners);
+    memset(vertStart, 0, (mesh->numVerts+1) * sizeof(int));
+    for (i=0; i<numCorners; i++) vertStart[mesh->index[i]+1]++;
+    for (i=0, maxDeg=0; i<mesh->numVerts; i++) {
+	if (vertStart[i+1] > maxDeg) maxDeg = vertStart[i+1];
+	vertStart[i+1] += vertStart[i];
+	};
+    for (i=0; i<numCorners; i++) vertCorners[vertStart[mesh->index[i]]++] = i;
+    for (i=mesh->numVerts; i>0; i--) vertStart[i] = vertStart[i-1];
+    vertStart[0] = 0;
+
+    /* count the groups of each vertex, then make their normals */
+    groupStart = NEWA(int, mesh->numVerts+1);
+    groupStart[0] = 0;
+#pragma omp parallel
+    {
+    char *done = NEWA(char, maxDeg > 0 ? maxDeg : 1);
+    int v;
+#pragma omp for schedule(dynamic, 4096)
+    for (v=0; v<mesh->numVerts; v++)
+	groupStart[v+1] = groupCorners(&vertCorners[vertStart[v]],
+				       vertStart[v+1] - vertStart[v], polyOf,
+				       polyNorm, smooth, done, NULL, 0, NULL);
+#pragma omp single
+    {
+    for (v=0; v<mesh->numVerts; v++) groupStart[v+1] += groupStart[v];
+    mesh->numNormals = groupStart[mesh->numVerts];
+    mesh->normals = NEWA(Vector3, mesh->numNormals > 0 ? mesh->numNormals : 1);
+    mesh->normIndex = NEWA(int, numCorners);
+    }
+#pragma omp for schedule(dynamic, 4096)
+    for (v=0; v<mesh->numVerts; v++)
+	(void) groupCorners(&vertCorners[vertStart[v]],
+			    vertStart[v+1] - vertStart[v], polyOf, polyNorm,
+			    smooth, done, mesh->normals, groupStart[v],
+			    mesh->normIndex);
+    free(done);
+    }
+
+    free(polyStart);
+    free(polyOf);
+    free(polyNorm);
+    free(vertStart);
+    free(vertCorners);
+    free(groupStart);
+    return(mesh);
+    }
+
+void freeWeldMesh(WeldMesh mesh) {
+    free(mesh->verts);
+    free(mesh->index);
+    free(mesh->normals);
+    free(mesh->normIndex);
+    free(mesh);
+    }
@@ -0,0 +1,163 @@
+/* weldbench.c - check weldPolygons() against makeVertexNormals() and time it */
+/* compares the normals of the two on test.c's height field of triangles and
+   quadrilaterals, then welds a jittered triangle soup of the same field */
+/* use: weldbench [triangles [compare-resolution]] */
+
+#include <stdlib.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "smooth.h"
+
+/* from Graphics Gems library ; for standalone compile */
+
+/* normalizes the input vector and returns it */
+Vector3 *V3Normalize(Vector3 *v) {
+	float len = sqrtf(V3Dot(v, v));
+	if (len != 0.0) { v->x /= len;  v->y /= len; v->z /= len; }
+	return(v);
+}
+
+/* return vector sum c = a+b */
+Vector3 *V3Add(Vector3 *a, Vector3 *b, Vector3 *c) {
+	c->x = a->x+b->x;  c->y = a->y+b->y;	c->z = a->z+b->z;
+	return(c);
+}
+
+/* return the dot product of vectors a and b */
+float V3Dot(Vector3 *a, Vector3 *b) {
+	return((a->x*b->x)+(a->y*b->y)+(a->z*b->z));
+}
+
+void freeSmooth(Smooth smooth);
+
+/* z=f(x,y), as test.c */
+float fofxy(float x, float y) {
+	float h;
+	h = 2.f * (0.5f - x); if (h < 0) h = -h; h = h * y;
+	return(h);
+}
+
+static double seconds(void) {
+#ifdef _OPENMP
+	return(omp_get_wtime());
+#else
+	return((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
+
+static void setPoint(Point3 *p, float x, float y, float jitter) {
+	p->x = x + jitter * (2.f * rand() / RAND_MAX - 1.f);
+	p->y = y + jitter * (2.f * rand() / RAND_MAX - 1.f);
+	p->z = fofxy(x, y) + jitter * (2.f * rand() / RAND_MAX - 1.f);
+}
+
+/* test.c's mesh: cell by cell, two triangles or a quadrilateral;
+   returns the number of polygons */
+int buildMesh(int res, int mixed, float jitter, Point3 *verts, int *sizes) {
+	int x, y, n = 0;
+	float d = 1.f/((float)res), lx, ly, hx, hy;
+	Point3 *p = verts;
+	for (y=0; y<res; y++) {
+		ly = y * d;
+		hy = (y+1) * d;
+		for (x=0; x<res; x++) {
+			lx = x * d;
+			hx = (x+1) * d;
+			if (!mixed || (x+y)%2 == 0) {
+				setPoint(p++, lx, ly, jitter);
+				setPoint(p++, hx, ly, jitter);
+				setPoint(p++, lx, hy, jitter);
+				setPoint(p++, hx, ly, jitter);
+				setPoint(p++, hx, hy, jitter);
+				setPoint(p++, lx, hy, jitter);
+				sizes[n++] = 3;  sizes[n++] = 3;
+			} else {
+				setPoint(p++, lx, ly, jitter);
+				setPoint(p++, hx, ly, jitter);
+				setPoint(p++, hx, hy, jitter);
+				setPoint(p++, lx, hy, jitter);
+				sizes[n++] = 4;
+			};
+		};
+	};
+	return(n);
+}
+
+int main(int ac, char *av[]) {
+	int triangles = ac > 1 ? atoi(av[1]) : 2000000;
+	int cres = ac > 2 ? atoi(av[2]) : 100;
+	int res, numPolys, i, c, k, differ = 0;
+	int *sizes;
+	Point3 *verts, *n, *w;
+	Smooth smooth;
+	Polygon poly;
+	WeldMesh mesh;
+	double t, e, diff = 0.;
+
+	/* the two smoothers on the same mesh */
+	verts = NEWA(Point3, 6*cres*cres);
+	sizes = NEWA(int, 2*cres*cres);
+	numPolys = buildMesh(cres, 1, 0.f, verts, sizes);
+	smooth = initAllTables();
+	for (i=0, c=0; i<numPolys; c+=sizes[i++])
+		includePolygon(sizes[i], &verts[c], smooth, NULL);
+	enableEdgePreservation(smooth, 0.0);
+	t = seconds();
+	makeVertexNormals(smooth);
+	t = seconds() - t;
+	e = seconds();
+	mesh = weldPolygons(smooth, numPolys, sizes, 0, verts);
+	e = seconds() - e;
+	for (poly=smooth->polygonTable, c=0; poly!=NULL; poly=poly->next)
+		for (k=0; k<poly->numVerts; k++, c++) {
+			n = &poly->normals[k];
+			w = &mesh->normals[mesh->normIndex[c]];
+			if (fabs(n->x - w->x) > diff) diff = fabs(n->x - w->x);
+			if (fabs(n->y - w->y) > diff) diff = fabs(n->y - w->y);
+			if (fabs(n->z - w->z) > diff) diff = fabs(n->z - w->z);
+			differ += fabs(n->x - w->x) + fabs(n->y - w->y) +
+				  fabs(n->z - w->z) > 1e-4;
+		};
+	printf("%d polygons, %d corners: %d vertices, %d normals\n",
+	       numPolys, mesh->numCorners, mesh->numVerts, mesh->numNormals);
+	printf("makeVertexNormals %.3f s, weldPolygons %.3f s\n", t, e);
+	printf("normals differ at %d corners, by up to %.3g\n\n", differ, diff);
+	freeWeldMesh(mesh);
+	freeSmooth(smooth);
+	free(verts);
+	free(sizes);
+
+	/* a jittered triangle soup, welded and smoothed */
+	res = (int)sqrt(triangles / 2.);
+	verts = NEWA(Point3, 6*(size_t)res*res);
+	sizes = NEWA(int, 2*(size_t)res*res);
+	if (verts == NULL || sizes == NULL) { printf("out of memory\n"); exit(-1); };
+	numPolys = buildMesh(res, 0, 1e-3f / res, verts, sizes);
+	smooth = initAllTables();
+	setFuzzFraction(smooth, 0.1f / res);
+	enableEdgePreservation(smooth, 0.0);
+	t = seconds();
+	mesh = weldPolygons(smooth, numPolys, NULL, 3, verts);
+	t = seconds() - t;
+	printf("%d triangles: %d vertices (%d in the grid), %d normals\n",
+	       numPolys, mesh->numVerts, (res+1)*(res+1), mesh->numNormals);
+	printf("weldPolygons %.3f s, %.0f triangles/s\n", t, numPolys / t);
+	for (c=0, differ=0; c<mesh->numCorners; c++) {
+		w = &mesh->verts[mesh->index[c]];
+		differ += fabs(w->x - verts[c].x) > smooth->fuzz ||
+			  fabs(w->y - verts[c].y) > smooth->fuzz ||
+			  fabs(w->z - verts[c].z) > smooth->fuzz;
+	};
+	printf("%d corners farther than the fuzz from their vertex\n", differ);
+	freeWeldMesh(mesh);
+	mesh = weldPolygons(smooth, 0, NULL, 3, NULL);
+	printf("no polygons: %d vertices, %d normals\n",
+	       mesh->numVerts, mesh->numNormals);
+	freeWeldMesh(mesh);
+	free(verts);
+	free(sizes);
+	return(0);
+}
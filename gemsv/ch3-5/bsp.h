@@ -58,6 +58,7 @@ void BSPfreeTree(BSPNODE **bspNode);
 
 boolean BSPdidViewerCollideWithScene(const POINT *from, const POINT *to,
 				     const BSPNODE *bspTree);
+void BSPsetPlaneSelection(int candidates, int samples);
 
 VERTEX *allocVertex(float xx,float yy,float zz);
 FACE *allocFace(const COLOR *color, VERTEX *vlist,const PLANE *plane);
@@ -78,7 +79,12 @@ void BSPpartitionFaceListWithPlane(const PLANE *plane,FACE **faceList,
 				   FACE **faceSameDir, FACE **faceOppDir);
 void drawFaceList(FILE *, const FACE *faceList); 
 
+typedef enum {POOL_VERTEX, POOL_FACE, POOL_BSPNODE, POOL_PARTITIONNODE,
+	      POOL_KINDS} POOL_KIND;
+
 char *MYMALLOC(unsigned num);
 void MYFREE(char *ptr);
+char *MYPOOLALLOC(POOL_KIND kind);
+void MYPOOLFREE(POOL_KIND kind, char *ptr);
 long MYMEMORYCOUNT(void);
 #endif  /* _BSP_INCLUDED */
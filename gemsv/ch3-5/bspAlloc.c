@@ -8,7 +8,7 @@ VERTEX *allocVertex(float xx,float yy,float zz)
 {
    VERTEX *newVertex;
 
-   if ((newVertex= (VERTEX *) MYMALLOC(sizeof(VERTEX))) == NULL_VERTEX) {
+   if ((newVertex= (VERTEX *) MYPOOLALLOC(POOL_VERTEX)) == NULL_VERTEX) {
       fprintf(stderr,"?Unable to malloc vertex.\n");
       exit(1);
    }
@@ -24,7 +24,7 @@ FACE *allocFace(const COLOR *color,VERTEX *vlist,const PLANE *plane)
 {
    FACE *newFace;
 
-   if ((newFace= (FACE *) MYMALLOC(sizeof(FACE))) == NULL_FACE) {
+   if ((newFace= (FACE *) MYPOOLALLOC(POOL_FACE)) == NULL_FACE) {
       fprintf(stderr,"?Unable to alloc face.\n");
       exit(1);
    }
@@ -69,7 +69,7 @@ void freeVertexList(VERTEX **vlist)
    while (vtrav != NULL_VERTEX) {
       vdel= vtrav; vtrav= vtrav->vnext;
 
-      MYFREE((char *) vdel);
+      MYPOOLFREE(POOL_VERTEX,(char *) vdel);
    }
    *vlist= NULL_VERTEX;
 } /* freeVertexList() */
@@ -81,7 +81,7 @@ void freeFaceList(FACE **flist)
    while (ftrav != NULL_FACE) {
       fdel= ftrav; ftrav= ftrav->fnext; freeVertexList(&fdel->vhead); 
 
-      MYFREE((char *)fdel);
+      MYPOOLFREE(POOL_FACE,(char *)fdel);
 
    }
    *flist= NULL_FACE;
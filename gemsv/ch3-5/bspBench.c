@@ -0,0 +1,152 @@
+/* bspBench.c: times construction of and collision queries against BSP trees
+ * of a scene of boxes, with the original and the sampled choice of planes.
+ *
+ * Usage: bspBench [boxes [segments]]
+ */
+#include "bsp.h"
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* local functions */
+int main(int argc,char *argv[]);
+static FACE *makeScene(int boxes);
+static void addBox(FACE **fhead,FACE **ftail,const float lo[3],const float hi[3]);
+static void countTree(const BSPNODE *bspNode,int depth,long *nodes,int *maxDepth);
+static double seconds(void);
+static float uniform(float lo,float hi);
+static void bench(int boxes,int segments,int candidates,int samples);
+
+/* Main driver */
+int main(int argc,char *argv[])
+{
+   int boxes= (argc > 1) ? atoi(argv[1]) : 1000;
+   int segments= (argc > 2) ? atoi(argv[2]) : 100000;
+
+   printf("%d boxes, %d faces, %d segments\n",boxes,6*boxes,segments);
+   bench(boxes,segments,100,0);	/* original selection */
+   bench(boxes,segments,16,64);	/* sampled selection */
+   return(0);
+} /* main() */
+
+/* Builds a tree of the scene, reports its size and the time taken, and
+ * then times collision queries of random segments against it.
+ */
+static void bench(int boxes,int segments,int candidates,int samples)
+{
+   FACE *faceList; BSPNODE *root;
+   long nodes= 0L; int maxDepth= 0, hits= 0, ii;
+   double start, build, query;
+   POINT *from, *to;
+
+   srand(1);
+   faceList= makeScene(boxes);
+   BSPsetPlaneSelection(candidates,samples);
+   start= seconds();
+   root= BSPconstructTree(&faceList);
+   build= seconds() - start;
+   countTree(root,1,&nodes,&maxDepth);
+
+   from= (POINT *) malloc(segments * sizeof(POINT));
+   to= (POINT *) malloc(segments * sizeof(POINT));
+   if (from == NULL || to == NULL) {fprintf(stderr,"?Unable to malloc\n");exit(1);}
+   for (ii= 0; ii < segments; ii++) {
+      from[ii].xx= uniform(0.0,100.0); from[ii].yy= uniform(0.0,100.0);
+      from[ii].zz= uniform(0.0,100.0);
+      to[ii].xx= from[ii].xx + uniform(-2.0,2.0);
+      to[ii].yy= from[ii].yy + uniform(-2.0,2.0);
+      to[ii].zz= from[ii].zz + uniform(-2.0,2.0);
+   }
+   start= seconds();
+#pragma omp parallel for reduction(+:hits) schedule(dynamic,256)
+   for (ii= 0; ii < segments; ii++)
+      hits+= BSPdidViewerCollideWithScene(&from[ii],&to[ii],root);
+   query= seconds() - start;
+
+   printf("candidates %3d samples %3d: build %8.3f ms, %7ld nodes, depth %3d;"
+	  " query %6.3f us/segment, %d hits\n",candidates,samples,1e3*build,
+	  nodes,maxDepth,1e6*query/(segments ? segments : 1),hits);
+
+   free(from); free(to);
+   BSPfreeTree(&root);
+} /* bench() */
+
+/* Returns a list of boxes scattered over a jittered grid in [0,100]^3 */
+static FACE *makeScene(int boxes)
+{
+   FACE *fhead= NULL_FACE, *ftail= NULL_FACE;
+   int side= 1, ii;
+   float cell;
+
+   while (side * side * side < boxes) side++;
+   cell= 100.0 / side;
+   for (ii= 0; ii < boxes; ii++) {
+      float lo[3], hi[3]; int axis, cc[3];
+      cc[0]= ii % side; cc[1]= (ii / side) % side; cc[2]= ii / (side * side);
+      for (axis= 0; axis < 3; axis++) {
+	 lo[axis]= (cc[axis] + uniform(0.05,0.3)) * cell;
+	 hi[axis]= (cc[axis] + uniform(0.7,0.95)) * cell;
+      }
+      addBox(&fhead,&ftail,lo,hi);
+   }
+   return(fhead);
+} /* makeScene() */
+
+/* Appends the six faces of a box to a list of faces. Each face's vertices
+ * are counterclockwise seen from outside and the first is duplicated at
+ * the end.
+ */
+static void addBox(FACE **fhead,FACE **ftail,const float lo[3],const float hi[3])
+{
+   static const int quads[6][4]= { /* corners: bit 0 x, bit 1 y, bit 2 z */
+      {0,4,6,2}, {1,3,7,5}, {0,1,5,4}, {2,6,7,3}, {0,2,3,1}, {4,5,7,6}
+   };
+   static COLOR color= {1.0, 1.0, 1.0};
+   int ff, vv;
+
+   for (ff= 0; ff < 6; ff++) {
+      VERTEX *vhead= NULL_VERTEX, *vtail= NULL_VERTEX; PLANE plane;
+      for (vv= 0; vv <= 4; vv++) {
+	 int corner= quads[ff][vv % 4];
+	 appendVertex(&vhead,&vtail,
+		      allocVertex((corner & 1) ? hi[0] : lo[0],
+				  (corner & 2) ? hi[1] : lo[1],
+				  (corner & 4) ? hi[2] : lo[2]));
+      }
+      computePlane(vhead->xx,vhead->yy,vhead->zz,
+		   vhead->vnext->xx,vhead->vnext->yy,vhead->vnext->zz,
+		   vhead->vnext->vnext->xx,vhead->vnext->vnext->yy,
+		   vhead->vnext->vnext->zz,&plane);
+      appendFace(fhead,ftail,allocFace(&color,vhead,&plane));
+   }
+} /* addBox() */
+
+/* Counts the nodes of a tree and finds its depth */
+static void countTree(const BSPNODE *bspNode,int depth,long *nodes,int *maxDepth)
+{
+   (*nodes)++;
+   if (depth > *maxDepth) *maxDepth= depth;
+   if (bspNode->kind == PARTITION_NODE) {
+      countTree(bspNode->node->negativeSide,depth+1,nodes,maxDepth);
+      countTree(bspNode->node->positiveSide,depth+1,nodes,maxDepth);
+   }
+} /* countTree() */
+
+/* Returns wall clock time in seconds where available */
+static double seconds(void)
+{
+#ifdef _OPENMP
+   return(omp_get_wtime());
+#else
+   return((double) clock() / CLOCKS_PER_SEC);
+#endif
+} /* seconds() */
+
+/* Returns a random number between lo and hi */
+static float uniform(float lo,float hi)
+{
+   return(lo + (hi - lo) * (float) rand() / RAND_MAX);
+} /* uniform() */
+
+/*** bspBench.c ***/
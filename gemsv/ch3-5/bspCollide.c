@@ -5,14 +5,14 @@
 #include "bsp.h"
 
 /* flags to indicate if any piece of a line segment is inside any polyhedron
- *     or outside all polyhedra
+ *     or outside all polyhedra, kept per query so queries may run in parallel
  */
-static boolean anyPieceOfLineIn, anyPieceOfLineOut;
+typedef struct { boolean anyPieceOfLineIn, anyPieceOfLineOut; } LINEFLAGS;
 
 /* local functions - see function definition */
 static int BSPclassifyPoint(const POINT *point, const BSPNODE *bspNode);
 static void BSPclassifyLineInterior(const POINT *from, const POINT *to,
-				    const BSPNODE *bspNode);
+				    const BSPNODE *bspNode, LINEFLAGS *flags);
 				    
 /* Returns a boolean to indicate whether or not a collision had occurred 
  * between the viewer and any static objects in an environment represented as 
@@ -34,14 +34,15 @@ boolean BSPdidViewerCollideWithScene(const POINT *from, const POINT *to,
     */
    if (sign1 == 0 || sign2 == 0 || sign1 != sign2) return(1);
    else {
-      anyPieceOfLineIn= anyPieceOfLineOut= 0; /* clear flags */
+      LINEFLAGS flags;
+      flags.anyPieceOfLineIn= flags.anyPieceOfLineOut= 0; /* clear flags */
       /* since we already classified the endpoints, try interior of line */ 
       /*    this routine will set the flags to appropriate values */
-      BSPclassifyLineInterior(from,to,bspTree);
+      BSPclassifyLineInterior(from,to,bspTree,&flags);
 
       /* if line interior is inside and outside an object, collision detected*/
       /* else no collision detected */
-      return( (anyPieceOfLineIn && anyPieceOfLineOut) ? 1 : 0 );
+      return( (flags.anyPieceOfLineIn && flags.anyPieceOfLineOut) ? 1 : 0 );
    }
 } /*  BSPdidViewerCollideWithScene() */
 
@@ -85,9 +86,10 @@ static int BSPclassifyPoint(const POINT *point,const BSPNODE *bspNode)
  * from    - endpoint of line segment
  * to      - other endpoint of line segment
  * bspNode - a node in BSP tree     
+ * flags   - flags set for pieces found inside or outside
  */
 static void BSPclassifyLineInterior(const POINT *from,const POINT *to,
-				    const BSPNODE *bspNode)
+				    const BSPNODE *bspNode,LINEFLAGS *flags)
 				    
 {
    if (bspNode->kind == PARTITION_NODE) { /* compare line segment with plane */
@@ -113,28 +115,28 @@ static void BSPclassifyLineInterior(const POINT *from,const POINT *to,
 	 /* filter split line segments down appropriate branches */
 	 iPoint.xx= ixx; iPoint.yy= iyy; iPoint.zz= izz;
 	 if (sign1 == NEGATIVE) { assert(sign2 == POSITIVE);
-	    BSPclassifyLineInterior(from,&iPoint,bspNode->node->negativeSide);
-	    BSPclassifyLineInterior(to,&iPoint,bspNode->node->positiveSide);
+	    BSPclassifyLineInterior(from,&iPoint,bspNode->node->negativeSide,flags);
+	    BSPclassifyLineInterior(to,&iPoint,bspNode->node->positiveSide,flags);
 	 }
 	 else { assert(sign1 == POSITIVE && sign2 == NEGATIVE); 
-	    BSPclassifyLineInterior(from,&iPoint,bspNode->node->positiveSide);
-	    BSPclassifyLineInterior(to,&iPoint,bspNode->node->negativeSide);
+	    BSPclassifyLineInterior(from,&iPoint,bspNode->node->positiveSide,flags);
+	    BSPclassifyLineInterior(to,&iPoint,bspNode->node->negativeSide,flags);
 	 }
       }
       else {			/* no split,so on same side */
 	 if (sign1 == ZERO && sign2 == ZERO) {
-	    BSPclassifyLineInterior(from,to,bspNode->node->negativeSide);
-	    BSPclassifyLineInterior(from,to,bspNode->node->positiveSide);
+	    BSPclassifyLineInterior(from,to,bspNode->node->negativeSide,flags);
+	    BSPclassifyLineInterior(from,to,bspNode->node->positiveSide,flags);
 	 }
 	 else if (sign1 == NEGATIVE || sign2 == NEGATIVE) {
-	    BSPclassifyLineInterior(from,to,bspNode->node->negativeSide);
+	    BSPclassifyLineInterior(from,to,bspNode->node->negativeSide,flags);
 	 }
 	 else { assert(sign1 == POSITIVE || sign2 == POSITIVE);
-	    BSPclassifyLineInterior(from,to,bspNode->node->positiveSide);
+	    BSPclassifyLineInterior(from,to,bspNode->node->positiveSide,flags);
 	 }
       }
    }
-   else if (bspNode->kind == IN_NODE) anyPieceOfLineIn= 1; /* line inside */
-   else { assert(bspNode->kind == OUT_NODE); anyPieceOfLineOut= 1; }
+   else if (bspNode->kind == IN_NODE) flags->anyPieceOfLineIn= 1; /* inside */
+   else { assert(bspNode->kind == OUT_NODE); flags->anyPieceOfLineOut= 1; }
 } /* BSPclassifyLineInterior() */
 /*** bspCollide.c ***/
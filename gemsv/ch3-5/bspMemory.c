@@ -1,27 +1,99 @@
 /* bspMemory.c: module to allocate and free memory and also to count them.
- * Copyright (c) Norman Chin 
+ * Copyright (c) Norman Chin
  */
-#include "bsp.h"		
+#include "bsp.h"
 #include <stdlib.h>
 
 static long memoryCount= 0L;
 
+/* Vertices, faces and nodes come from pools, one per kind of record and per
+ * thread.  A pool hands out records from large contiguous chunks and keeps
+ * freed records on a free list for reuse, so a tree is laid out densely and
+ * threads building subtrees at the same time never share a pool.  Chunks
+ * are kept for the life of the program.
+ */
+#define POOL_CHUNK 4096		/* records per chunk */
+
+#if defined(_MSC_VER)
+#define POOL_THREAD __declspec(thread)
+#elif defined(__GNUC__)
+#define POOL_THREAD __thread
+#else
+#define POOL_THREAD
+#endif
+
+typedef struct freeTag { struct freeTag *next; } FREEREC;
+
+typedef struct {
+   char *next, *end;		/* unused part of current chunk */
+   FREEREC *freeList;		/* records given back */
+} POOL;
+
+static POOL_THREAD POOL pools[POOL_KINDS];
+
+static const unsigned poolSize[POOL_KINDS]= {
+   sizeof(VERTEX), sizeof(FACE), sizeof(BSPNODE), sizeof(PARTITIONNODE)
+};
+
+/* Adds num to the memory counter, which may be shared by several threads */
+static void countMemory(long num)
+{
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+   memoryCount+= num;
+} /* countMemory() */
+
 /* Allocates memory of num bytes */
 char *MYMALLOC(unsigned num)
 {
    char *memory= malloc(num);	/* checked for null by caller */
 
-   ++memoryCount;		/* increment memory counter for debugging */
+   countMemory(1L);		/* increment memory counter for debugging */
    return(memory);
 } /* myMalloc() */
 
 /* Frees memory pointed to by ptr */
-void MYFREE(char *ptr) 
+void MYFREE(char *ptr)
 {
-   --memoryCount;		/* decrement memory counter for debugging */
+   countMemory(-1L);		/* decrement memory counter for debugging */
    free(ptr);
 } /* myFree() */
 
+/* Allocates a record of the given kind from this thread's pool */
+char *MYPOOLALLOC(POOL_KIND kind)
+{
+   POOL *pool= &pools[kind];
+   char *memory;
+
+   if (pool->freeList != NULL) { /* reuse a freed record */
+      memory= (char *) pool->freeList;
+      pool->freeList= pool->freeList->next;
+   }
+   else {
+      if (pool->next == pool->end) { /* start a new chunk */
+	 pool->next= malloc(POOL_CHUNK * poolSize[kind]);
+	 if (pool->next == NULL) return(NULL); /* checked for null by caller */
+	 pool->end= pool->next + POOL_CHUNK * poolSize[kind];
+      }
+      memory= pool->next;
+      pool->next+= poolSize[kind];
+   }
+
+   countMemory(1L);		/* increment memory counter for debugging */
+   return(memory);
+} /* myPoolAlloc() */
+
+/* Gives a record back to this thread's pool */
+void MYPOOLFREE(POOL_KIND kind, char *ptr)
+{
+   FREEREC *rec= (FREEREC *) ptr;
+
+   countMemory(-1L);		/* decrement memory counter for debugging */
+   rec->next= pools[kind].freeList;
+   pools[kind].freeList= rec;
+} /* myPoolFree() */
+
 /* Returns how many memory blocks are still allocated up to this point */
 long MYMEMORYCOUNT(void)
 {
@@ -2,46 +2,96 @@
  * Copyright (c) Norman Chin 
  */
 #include "bsp.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /* local functions */
-static void BSPchoosePlane(FACE *faceList,PLANE *plane);
+static BSPNODE *constructTree(FACE **faceList,int numFaces);
+static int countFaces(const FACE *faceList);
+static void BSPchoosePlane(FACE *faceList,int numFaces,PLANE *plane);
+static void chooseSampledPlane(FACE *faceList,int numFaces,PLANE *plane);
 static boolean doesFaceStraddlePlane(const FACE *face,const PLANE *plane);
+static int classifyFace(const FACE *face,const PLANE *plane);
 static BSPNODE *allocBspNode(NODE_TYPE kind,FACE *sameDir,FACE *oppDir);
 static PARTITIONNODE *allocPartitionNode(FACE *sameDir,FACE *oppDir);
 static void freePartitionNode(PARTITIONNODE **partitionNode);
 
+/* Subtrees with fewer faces than this are built by the thread that
+ * partitioned their parent.
+ */
+#define PARALLEL_FACES 256
+
 /* Returns a BSP tree of scene from a list of convex faces.
  * These faces' vertices are oriented in counterclockwise order where the last 
  * vertex is a duplicate of the first, i.e., a square has five vertices. 
+ * When compiled with OpenMP the two branches of large nodes are built at
+ * the same time by different threads.
  *
  * faceList - list of faces
  */
 BSPNODE *BSPconstructTree(FACE **faceList)
+{
+   BSPNODE *root;
+   int numFaces= countFaces(*faceList);
+
+#ifdef _OPENMP
+   if (!omp_in_parallel()) {
+#pragma omp parallel
+#pragma omp single
+      root= constructTree(faceList,numFaces);
+      return(root);
+   }
+#endif
+   root= constructTree(faceList,numFaces);
+   return(root);
+} /* BSPconstructTree() */
+
+/* Builds the BSP tree for BSPconstructTree().
+ *
+ * faceList - list of faces
+ * numFaces - number of faces in list
+ */
+static BSPNODE *constructTree(FACE **faceList,int numFaces)
 {
    BSPNODE *newBspNode; PLANE plane; 
    FACE *sameDirList,*oppDirList, *faceNegList,*facePosList;
+   int numNeg, numPos;
 
    /* choose plane to split scene with */
-   BSPchoosePlane(*faceList,&plane); 
+   BSPchoosePlane(*faceList,numFaces,&plane); 
    BSPpartitionFaceListWithPlane(&plane,faceList,&faceNegList,&facePosList,
 				 &sameDirList,&oppDirList);
    assert(*faceList == NULL_FACE); assert(sameDirList != NULL_FACE);
 
    /* construct the tree */
    newBspNode= allocBspNode(PARTITION_NODE,sameDirList,oppDirList);
+   numNeg= countFaces(faceNegList); numPos= countFaces(facePosList);
 
-   /* construct tree's "-" branch */
+   /* construct tree's "-" branch, as a separate task if large enough */
    if (faceNegList == NULL_FACE) 
     newBspNode->node->negativeSide= allocBspNode(IN_NODE,NULL_FACE,NULL_FACE);
-   else newBspNode->node->negativeSide= BSPconstructTree(&faceNegList);
+   else {
+#pragma omp task if (numNeg + numPos >= PARALLEL_FACES && numPos > 0)
+      newBspNode->node->negativeSide= constructTree(&faceNegList,numNeg);
+   }
 
    /* construct tree's "+" branch */
    if (facePosList == NULL_FACE) 
     newBspNode->node->positiveSide=allocBspNode(OUT_NODE,NULL_FACE,NULL_FACE);
-   else newBspNode->node->positiveSide= BSPconstructTree(&facePosList);
+   else newBspNode->node->positiveSide= constructTree(&facePosList,numPos);
 
+#pragma omp taskwait
    return(newBspNode);
-} /* BSPconstructTree() */
+} /* constructTree() */
+
+/* Returns the number of faces in a list */
+static int countFaces(const FACE *faceList)
+{
+   int count= 0;
+   for (; faceList != NULL_FACE; faceList= faceList->fnext) count++;
+   return(count);
+} /* countFaces() */
 
 /* Traverses BSP tree to render scene back-to-front based on viewer position.
  *
@@ -84,12 +134,38 @@ void BSPfreeTree(BSPNODE **bspNode)
    if ((*bspNode)->kind == PARTITION_NODE) 
       freePartitionNode(&(*bspNode)->node);
 
-   MYFREE((char *) *bspNode); *bspNode= NULL_BSPNODE;
+   MYPOOLFREE(POOL_BSPNODE,(char *) *bspNode); *bspNode= NULL_BSPNODE;
 
 } /* BSPfreeTree() */
 
 #define MAXINT 500
 
+/* Plane selection.  With no samples, the first candidates faces on the list
+ * are tried against all faces for the fewest splits.  Otherwise candidates
+ * faces spread evenly through the list are each tried against samples faces
+ * spread through the list, and the one with the lowest estimated cost of
+ * splits and imbalance is chosen.
+ */
+#define MAX_CANDIDATES 100
+#define MAX_SAMPLES 256
+#define SPLIT_COST 8		/* a split costs as much as this imbalance */
+
+static int numCandidates= MAX_CANDIDATES, numSamples= 0;
+
+/* Sets how partitioning planes are chosen.  The default, (100, 0), is the
+ * original exhaustive method; bspBench times (16, 64) against it.
+ *
+ * candidates - number of faces to consider as partitioning planes
+ * samples    - number of faces to test each candidate against, or 0 for
+ *              the original exhaustive method
+ */
+void BSPsetPlaneSelection(int candidates, int samples)
+{
+   numCandidates= (candidates < 1) ? 1 :
+                  (candidates > MAX_CANDIDATES ? MAX_CANDIDATES : candidates);
+   numSamples= (samples < 0) ? 0 : (samples > MAX_SAMPLES ? MAX_SAMPLES : samples);
+} /* BSPsetPlaneSelection() */
+
 /* Chooses plane with which to partition. 
  * The algorithm is to examine the first MAX_CANDIDATES on face list. For
  * each candidate, count how many splits it would make against the scene.
@@ -97,18 +173,20 @@ void BSPfreeTree(BSPNODE **bspNode)
  * partitioning plane.
  *
  * faceList - list of faces
+ * numFaces - number of faces in list
  * plane    - plane equation returned
  */
-static void BSPchoosePlane(FACE *faceList,PLANE *plane)
+static void BSPchoosePlane(FACE *faceList,int numFaces,PLANE *plane)
 {
    FACE *rootrav; int ii;
    int minCount= MAXINT; 
    FACE *chosenRoot= faceList;	/* pick first face for now */
 
    assert(faceList != NULL_FACE);
+   if (numSamples > 0) { chooseSampledPlane(faceList,numFaces,plane); return; }
+
    /* for all candidates... */
-#define MAX_CANDIDATES 100
-   for (rootrav= faceList, ii= 0; rootrav != NULL_FACE && ii< MAX_CANDIDATES;
+   for (rootrav= faceList, ii= 0; rootrav != NULL_FACE && ii< numCandidates;
 	rootrav= rootrav->fnext, ii++) {
       FACE *ftrav; int count= 0;
       /* for all faces in scene other than itself... */
@@ -123,6 +201,70 @@ static void BSPchoosePlane(FACE *faceList,PLANE *plane)
    *plane= chosenRoot->plane;	/* return partitioning plane */
 } /* BSPchoosePlane() */
 
+/* Chooses plane with which to partition from a sample of the faces.
+ *
+ * faceList - list of faces
+ * numFaces - number of faces in list
+ * plane    - plane equation returned
+ */
+static void chooseSampledPlane(FACE *faceList,int numFaces,PLANE *plane)
+{
+   FACE *candidates[MAX_CANDIDATES], *samples[MAX_SAMPLES], *ftrav;
+   int nc, ns, ii, jj, cstep, sstep;
+   long minCost= -1;
+   FACE *chosenRoot= faceList;
+
+   /* pick faces evenly spaced through the list */
+   cstep= (numFaces + numCandidates - 1) / numCandidates;
+   sstep= (numFaces + numSamples - 1) / numSamples;
+   for (ftrav= faceList, ii= nc= ns= 0; ftrav != NULL_FACE;
+	ftrav= ftrav->fnext, ii++) {
+      if (ii % cstep == 0 && nc < numCandidates) candidates[nc++]= ftrav;
+      if (ii % sstep == 0 && ns < numSamples) samples[ns++]= ftrav;
+   }
+
+   for (ii= 0; ii < nc; ii++) {
+      int splits= 0, neg= 0, pos= 0; long cost;
+      for (jj= 0; jj < ns; jj++) {
+	 if (samples[jj] == candidates[ii]) continue;
+	 switch (classifyFace(samples[jj],&candidates[ii]->plane)) {
+	 case NEGATIVE: neg++; break;
+	 case POSITIVE: pos++; break;
+	 case ZERO: break;
+	 default: splits++; neg++; pos++; break;
+	 }
+      }
+      cost= (long) splits * SPLIT_COST + (neg > pos ? neg - pos : pos - neg);
+      if (minCost < 0 || cost < minCost) {
+	 minCost= cost; chosenRoot= candidates[ii];
+	 if (cost == 0) break;
+      }
+   }
+   *plane= chosenRoot->plane;	/* return partitioning plane */
+} /* chooseSampledPlane() */
+
+/* Returns which side of the plane a face is on, NEGATIVE, POSITIVE or ZERO
+ * if it is embedded in the plane, or 2 if it straddles the plane.
+ *
+ * face  - face to check 
+ * plane - plane 
+ */
+static int classifyFace(const FACE *face, const PLANE *plane)
+{
+   boolean anyNegative= 0, anyPositive= 0;
+   VERTEX *vtrav; 
+
+   for (vtrav= face->vhead; vtrav->vnext !=NULL_VERTEX; vtrav= vtrav->vnext) {
+      float value= plane->aa*vtrav->xx + plane->bb*vtrav->yy +
+	           plane->cc*vtrav->zz + plane->dd;
+      SIGN sign= FSIGN(value);
+      if (sign == NEGATIVE) anyNegative= 1; 
+      else if (sign == POSITIVE) anyPositive= 1;
+   }
+   if (anyNegative && anyPositive) return(2);
+   return(anyNegative ? NEGATIVE : (anyPositive ? POSITIVE : ZERO));
+} /* classifyFace() */
+
 /* Returns a boolean to indicate whether the face straddles the plane
  *
  * face  - face to check 
@@ -169,7 +311,7 @@ boolean BSPisViewerInPositiveSideOfPlane(const PLANE *plane,const POINT *positio
 static BSPNODE *allocBspNode(NODE_TYPE kind,FACE *sameDir,FACE *oppDir)
 {
    BSPNODE *newBspNode;
-   if ((newBspNode= (BSPNODE *) MYMALLOC(sizeof(BSPNODE))) == NULL_BSPNODE) {
+   if ((newBspNode= (BSPNODE *) MYPOOLALLOC(POOL_BSPNODE)) == NULL_BSPNODE) {
       fprintf(stderr,"?Unable to malloc bspnode.\n");
       exit(1);
    }
@@ -191,7 +333,7 @@ static BSPNODE *allocBspNode(NODE_TYPE kind,FACE *sameDir,FACE *oppDir)
 static PARTITIONNODE *allocPartitionNode(FACE *sameDir,FACE *oppDir)
 {
    PARTITIONNODE *newPartitionNode;
-   if ((newPartitionNode= (PARTITIONNODE *) MYMALLOC(sizeof(PARTITIONNODE)))==
+   if ((newPartitionNode= (PARTITIONNODE *) MYPOOLALLOC(POOL_PARTITIONNODE))==
        NULL_PARTITIONNODE) {
       fprintf(stderr,"?Unable to malloc partitionnode.\n");
       exit(1);
@@ -214,7 +356,7 @@ static void freePartitionNode(PARTITIONNODE **partitionNode)
    BSPfreeTree(&(*partitionNode)->negativeSide);
    BSPfreeTree(&(*partitionNode)->positiveSide);
 
-   MYFREE((char *) *partitionNode); *partitionNode= NULL_PARTITIONNODE;
+   MYPOOLFREE(POOL_PARTITIONNODE,(char *) *partitionNode); *partitionNode= NULL_PARTITIONNODE;
 } /* freePartitionNode() */
 
 /* Dumps information on faces. This should be replaced with user-supplied    
@@ -3,12 +3,11 @@
  * Andreas Leipelt, "Ray Tracing a Swept Sphere"
  * from "Graphics Gems", Academic Press
  *
- * Implementation of the polynomial class. The code is
- * not complete ! You need to insert a root solver in
- * the method 'root_between' .
+ * Implementation of the polynomial class.
  */
 
 #include <math.h>
+#include <float.h>
 #include "poly.h"
 
 // constructor of the polynomial class 
@@ -67,13 +66,74 @@ double polynomial::max(double a, double b)
   return Max;
 }
 
+// root of p in [lo;hi], where p changes its sign from flo to fhi, by
+// regula falsi with the Illinois modification
+static double falsi(polynomial& p, double lo, double hi,
+                    double flo, double fhi)
+{
+  double x = lo, fx;
+  int side = 0;
+
+  for (int i=0; i < 100; i++) {
+    x = (lo*fhi - hi*flo) / (fhi - flo);
+    if (hi - lo <= 4.0*DBL_EPSILON*(1.0 + fabs(x))) break;
+    fx = p.eval(x);
+    if (fx == 0.0) break;
+    if ((fx < 0.0) == (flo < 0.0)) {
+      lo = x;  flo = fx;
+      if (side == -1) fhi *= 0.5;
+      side = -1;
+    }
+    else {
+      hi = x;  fhi = fx;
+      if (side == 1) flo *= 0.5;
+      side = 1;
+    }
+  }
+  return x;
+}
+
+// Finds the roots in (a;b] in increasing order.  Between two roots of
+// the derivative the polynomial is monotone, so it has a root there
+// if it changes its sign, or if it touches zero at the end.  (Sturm
+// sequences, as in Hook and McAree, "Using Sturm Sequences to Bracket
+// Real Roots of Polynomial Equations", "Graphics Gems I", would count
+// the roots, but their remainders lose roots close together to
+// rounding.)
 int polynomial::roots_between(double a, double b, double *roots)
 {
-  // This function should return the number of roots between
-  // a  and  b  and the array 'roots' should contain these roots.
-  // Refer to Hook and McAree, "Using Sturm Sequences to Bracket
-  // Real Roots of Polynomial Equations" in "Graphics Gems I"
-  return 0;
+  polynomial p = *this;
+  double ends[MAX_DEGREE+1], big = 0.0, lo, hi, flo, fhi, size;
+  int i, k = 0, n;
+
+  if (a >= b) return 0;
+  // leading coefficients lost in cancellation would only give roots
+  // far away
+  for (i=0; i <= p.deg; i++)
+    if (fabs(p.coef[i]) > big) big = fabs(p.coef[i]);
+  while (p.deg > 0 && fabs(p.coef[p.deg]) <= polyeps*big)
+    p.coef[p.deg--] = 0.0;
+  if (p.deg < 1) return 0;
+
+  ends[0] = a;
+  n = p.derivative().roots_between(a, b, ends+1) + 1;
+  ends[n] = b;
+  flo = p.eval(a);
+  for (i=1; i <= n; i++) {
+    lo = ends[i-1];  hi = ends[i];
+    fhi = p.eval(hi);
+    // the size of the terms at hi, against which a zero is measured
+    size = 0.0;
+    for (int j=p.deg; j >= 0; j--) size = size*fabs(hi) + fabs(p.coef[j]);
+    if (fabs(fhi) <= polyeps*polyeps*size) {
+      if (hi > a && (k == 0 || hi > roots[k-1])) roots[k++] = hi;
+      fhi = 0.0;
+    }
+    else if (flo != 0.0 && (flo < 0.0) != (fhi < 0.0) && hi > lo)
+      roots[k++] = falsi(p, lo, hi, flo, fhi);
+    flo = fhi;
+  }
+  return k;
 }
 
 polynomial operator+(const polynomial& p, const polynomial& q)
@@ -8,33 +8,13 @@
  */
 
 #include <cmath>
-#include "poly.h"
+#include "sweep.h"
 
 #define rayeps   1E-8  // tolerance for intersection test
 
 // refer to  Andrew Woo, "Fast Ray-Box Intersection",
 // "Graphics Gems I"
-extern char HitBoundingBox(double*,double*,double*,double*);
-
-// class of the swept sphere primitive
-class swept_sph {
-  polynomial m[3]; // center of the sphere
-    polynomial laberhurzbla[3];
-  polynomial r;    // radius of the sphere
-  polynomial r2;   // r2 = r*r
-  double a, b;     // the interval [a;b], where  m  and  r  live
-  double minB[3],  // lower left corner of the bounding box
-         maxB[3];  // upper right corner of the bounding box
-  double param;    // parameter of last intersection, used for member
-                   // 'normal'
-  public:
-
-  swept_sph() {}
-  swept_sph(polynomial*,polynomial,double,double);
-  int  intersect(double*,double*,double*);
-  void normal(double*,double*);
-  int  inside(double*);
-};
+extern "C" char HitBoundingBox(double*,double*,double*,double*,double*);
 
 // constructor of the swept_sph-class
 swept_sph::swept_sph(polynomial *M, polynomial R, double A, double B)
@@ -49,13 +29,56 @@ swept_sph::swept_sph(polynomial *M, polynomial R, double A, double B)
   r = R;
   r2 = r*r;
   a = A;  b = B;
-  // Calculate the axis aligned bounding box
+  mm = m[0]*m[0] + m[1]*m[1] + m[2]*m[2] - r2;
+  // Calculate the axis aligned bounding box, and the boxes of the
+  // pieces of [a;b], which are tighter around a curved trajectory
   for (i=0; i < 3; i++) {
     minB[i] = (m[i] - r).min(a, b);
     maxB[i] = (m[i] + r).max(a, b);
+    for (int k=0; k < SEGMENTS; k++) {
+      double lo = a + (b - a)*k/SEGMENTS, hi = a + (b - a)*(k+1)/SEGMENTS;
+      segMin[k][i] = (m[i] - r).min(lo, hi);
+      segMax[k][i] = (m[i] + r).max(lo, hi);
+    }
   }
 }
 
+// The intersection is at the smallest distance  l  from the origin,
+// over the spheres at  a, b  and the roots of  s  in between, where
+// the sphere at parameter  t  is at distance  l = p(t) +- sqrt(p(t)*p(t)
+// - q(t))  along the ray.  Returns  l,  or 1E20 if it misses, and the
+// parameter in  *t.
+double swept_sph::closest(polynomial& p, polynomial& q, polynomial& s,
+                          double lo, double hi, double *t)
+{
+  double roots[MAX_DEGREE+2];
+  double p_val, q_val, D, test, l = 1E20;
+  int n = s.roots_between(lo, hi, roots);
+
+  roots[n++] = lo;
+  roots[n]   = hi;
+  // test all possible values
+  for (int i=0; i <= n; i++) {
+    // calculate the real solutions of the equation
+    // l = p_val +- sqrt(p_val*p_val - q_val)
+    p_val = p.eval(roots[i]);
+    q_val = q.eval(roots[i]);
+    D = p_val*p_val - q_val;
+    if (D >= 0.0) {
+      // check, if the candidate  roots[i]  leads to a better
+      // intersection value  l
+      D = sqrt(D);
+      test = p_val - D;
+      if (test < rayeps) test = p_val + D;
+      if ((test >= rayeps) && (test < l)) {
+	*t = roots[i];
+	l = test;
+      }
+    }
+  }
+  return l;
+}
+
 int swept_sph::intersect(double *origin, double *dir, double *l)
 // origin : origin of the ray
 // dir    : unit direction of the ray
@@ -63,13 +86,11 @@ int swept_sph::intersect(double *origin, double *dir, double *l)
 {
   int i;
   polynomial p, q, dp, dq, s;
-  double save[3];
-  double roots[MAX_DEGREE];
-  double p_val, q_val, D, test;
+  double save[3], coord[3];
 
-  if (!HitBoundingBox(minB, maxB, origin, dir)) return 0;
+  if (!HitBoundingBox(minB, maxB, origin, dir, coord)) return 0;
   // save the constant term of the trajectory
-  for (int i=0; i < 3; i++) {
+  for (i=0; i < 3; i++) {
     save[i] = m[i].coef[0];
     m[i].coef[0] -= origin[i];
   }
@@ -79,47 +100,83 @@ int swept_sph::intersect(double *origin, double *dir, double *l)
   dp = p.derivative();
   dq = q.derivative();
   s = dq*dq + 4.0*dp*(dp*q - p*dq);
-  int n = s.roots_between(a, b, roots);
-  roots[n++] = a;
-  roots[n]   = b;
-  *l = 1E20;
-  // test all possible values
-  for (i=0; i <= n; i++) {
-    // calculate the real solutions of the equation
-    // l = p_val +- sqrt(p_val*p_val - q_val)
-    p_val = p.eval(roots[i]);
-    q_val = q.eval(roots[i]);
-    D = p_val*p_val - q_val;
-    if (D >= 0.0) {
-      // check, if the candidate  roots[i]  leads to a better
-      // intersection value  l
-      D = sqrt(D);
-      test = p_val - D;
-      if (test < rayeps) test = p_val + D;
-      if ((test >= rayeps) && (test < *l)) {
-	param = roots[i];
-	*l = test;
-      }
-    }
-  }
+  *l = closest(p, q, s, a, b, &param);
   // restore the constant term of the trajectory
   for (i=0; i < 3; i++) m[i].coef[0] = save[i];
   if (*l < 1E20) return 1;
   else return 0;
 }
 
+int swept_sph::intersect(int n, double (*origin)[3], double (*dir)[3],
+                         double *l, double *t)
+// n      : number of rays
+// origin : origins of the rays
+// dir    : unit directions of the rays
+// l      : intersection parameters of the rays, 1E20 if they miss
+// t      : parameters of the spheres they hit, for member 'normal'
+//
+// The rays of a packet mostly share their origin, so  q = (m - o)^2 - r2
+// is only found again when it changes.  A ray only searches the pieces
+// of  [a;b]  whose boxes it hits: the sphere it hits first is in one of
+// them.  Returns the number of rays that hit.
+{
+  polynomial p, q, dp, dq, s;
+  double coord[3], o[3], lo, hi;
+  int hits = 0, have = 0, i, j, k;
+
+  for (j=0; j < n; j++) {
+    l[j] = 1E20;
+    if (!HitBoundingBox(minB, maxB, origin[j], dir[j], coord)) continue;
+    lo = b;  hi = a;
+    for (k=0; k < SEGMENTS; k++)
+      if (HitBoundingBox(segMin[k], segMax[k], origin[j], dir[j], coord)) {
+        if (lo > a + (b - a)*k/SEGMENTS) lo = a + (b - a)*k/SEGMENTS;
+        hi = k+1 < SEGMENTS ? a + (b - a)*(k+1)/SEGMENTS : b;
+      }
+    if (lo > hi) continue;
+
+    if (!have || origin[j][0] != o[0] || origin[j][1] != o[1] ||
+        origin[j][2] != o[2]) {
+      // q = mm - 2 o*m + o*o
+      for (i=0; i < 3; i++) o[i] = origin[j][i];
+      have = 1;
+      q = mm;
+      for (i=0; i < 3; i++)
+        for (k=0; k <= m[i].deg; k++) q.coef[k] -= 2.0*o[i]*m[i].coef[k];
+      q.coef[0] += o[0]*o[0] + o[1]*o[1] + o[2]*o[2];
+      dq = q.derivative();
+    }
+    // p = dir*m - dir*o
+    p = dir[j][0] * m[0] + dir[j][1] * m[1] + dir[j][2] * m[2];
+    p.coef[0] -= dir[j][0]*o[0] + dir[j][1]*o[1] + dir[j][2]*o[2];
+    dp = p.derivative();
+    s = dq*dq + 4.0*dp*(dp*q - p*dq);
+    l[j] = closest(p, q, s, lo, hi, &t[j]);
+    if (l[j] < 1E20) hits++;
+  }
+  return hits;
+}
+
 void swept_sph::normal(double *IP, double* Nrm)
 // IP  : intersection point
 // Nrm : normal at IP
 {
-  double R = r.eval(param);
+  normal(param, IP, Nrm);
+}
+
+void swept_sph::normal(double t, double *IP, double* Nrm)
+// t   : parameter of the sphere hit, as the packet 'intersect' gives it
+// IP  : intersection point
+// Nrm : normal at IP
+{
+  double R = r.eval(t);
   // if the radius is zero, return an arbitrary normal.
   if (R < polyeps) {
     Nrm[0] = Nrm[1] = 0.0;
     Nrm[2] = 1.0;
     return;
   }
-  for (int i=0; i < 3; i++) Nrm[i] = (IP[i] - m[i].eval(param))/R;
+  for (int i=0; i < 3; i++) Nrm[i] = (IP[i] - m[i].eval(t))/R;
 }
 
 // returns 1, if the point P lies inside.
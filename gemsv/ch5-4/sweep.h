@@ -0,0 +1,42 @@
+/*************************************************
+ *  SWEEP.H
+ *  Andreas Leipelt, "Ray Tracing a Swept Sphere"
+ *  from "Graphics Gems", Academic Press
+ *
+ */
+
+#ifndef SWEPT_SPHERE
+#define SWEPT_SPHERE
+
+#include "poly.h"
+
+#define SEGMENTS 8  // pieces of [a;b] with their own bounding box
+
+// class of the swept sphere primitive
+class swept_sph {
+  polynomial m[3]; // center of the sphere
+    polynomial laberhurzbla[3];
+  polynomial r;    // radius of the sphere
+  polynomial r2;   // r2 = r*r
+  polynomial mm;   // mm = m*m - r2
+  double a, b;     // the interval [a;b], where  m  and  r  live
+  double minB[3],  // lower left corner of the bounding box
+         maxB[3];  // upper right corner of the bounding box
+  double segMin[SEGMENTS][3], // bounding boxes of the pieces
+         segMax[SEGMENTS][3];
+  double param;    // parameter of last intersection, used for member
+                   // 'normal'
+  double closest(polynomial&,polynomial&,polynomial&,double,double,
+                 double*);
+  public:
+
+  swept_sph() {}
+  swept_sph(polynomial*,polynomial,double,double);
+  int  intersect(double*,double*,double*);
+  int  intersect(int,double(*)[3],double(*)[3],double*,double*);
+  void normal(double*,double*);
+  void normal(double,double*,double*);
+  int  inside(double*);
+};
+
+#endif
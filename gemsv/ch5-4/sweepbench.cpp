@@ -0,0 +1,86 @@
+/*************************************************
+ *  SWEEPBENCH.CPP
+ *  times the packet  intersect  of the swept sphere against
+ *  the one that takes a ray at a time
+ *
+ *  Shoots a grid of rays from an eye at a sphere swept along an
+ *  arc, and prints rays a second, the rays that hit, the rays that
+ *  hit in one and not in the other, and the largest difference of
+ *  the distances.
+ *
+ *  Usage: sweepbench [size [repetitions]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "sweep.h"
+
+static double seconds()
+{
+  return (double) clock() / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+  int size = argc > 1 ? atoi(argv[1]) : 128;
+  int reps = argc > 2 ? atoi(argv[2]) : 5;
+  int n = size*size, i, j, k, hits, differ;
+  double (*origin)[3] = new double[n][3];
+  double (*dir)[3] = new double[n][3];
+  double *l = new double[n], *ln = new double[n], *t = new double[n];
+  double eye[3] = { 0.0, 0.0, -6.0 }, len, diff, time;
+  polynomial M[3], R;
+
+  // the center moves on the parabola (3t - 1.5, 1.5 - 3t^2, t),
+  // the radius grows from .3 to .5, for t in [0;1]
+  M[0].deg = 1;  M[0].coef[0] = -1.5;  M[0].coef[1] = 3.0;
+  M[1].deg = 2;  M[1].coef[0] =  1.5;  M[1].coef[2] = -3.0;
+  M[2].deg = 1;  M[2].coef[1] = 1.0;
+  R.deg = 1;  R.coef[0] = 0.3;  R.coef[1] = 0.2;
+  swept_sph S(M, R, 0.0, 1.0);
+
+  for (i=0; i < size; i++)
+    for (j=0; j < size; j++) {
+      double *d = dir[i*size + j];
+      for (k=0; k < 3; k++) origin[i*size + j][k] = eye[k];
+      d[0] = 4.0*(j + 0.5)/size - 2.0 - eye[0];
+      d[1] = 4.0*(i + 0.5)/size - 2.0 - eye[1];
+      d[2] = -eye[2];
+      len = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+      for (k=0; k < 3; k++) d[k] /= len;
+    }
+
+  for (i=0; i < n; i++)
+    if (!S.intersect(origin[i], dir[i], &l[i])) l[i] = 1E20;
+  hits = S.intersect(n, origin, dir, ln, t);
+  for (i=0, differ=0, diff=0.0; i < n; i++) {
+    differ += (l[i] < 1E20) != (ln[i] < 1E20);
+    if (l[i] < 1E20 && ln[i] < 1E20 && fabs(l[i] - ln[i]) > diff)
+      diff = fabs(l[i] - ln[i]);
+  }
+
+  printf("%d rays, %d repetitions\n", n, reps);
+  printf("%-12s %12s %8s %8s %12s\n",
+         "intersect", "rays/s", "hits", "differ", "distances");
+
+  time = seconds();
+  for (k=0; k < reps; k++)
+    for (i=0; i < n; i++)
+      if (!S.intersect(origin[i], dir[i], &l[i])) l[i] = 1E20;
+  time = seconds() - time;
+  for (i=0, j=0; i < n; i++) j += l[i] < 1E20;
+  printf("%-12s %12.0f %8d\n", "ray", n*reps/time, j);
+
+  time = seconds();
+  for (k=0; k < reps; k++)
+    S.intersect(n, origin, dir, ln, t);
+  time = seconds() - time;
+  printf("%-12s %12.0f %8d %8d %12.3g\n", "packet", n*reps/time,
+         hits, differ, diff);
+
+  delete [] origin;  delete [] dir;
+  delete [] l;  delete [] ln;  delete [] t;
+  return 0;
+}
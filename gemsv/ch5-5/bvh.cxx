@@ -0,0 +1,152 @@
+#include <iostream>
+#include <math.h>
+#include "global.h"
+
+//      NODES AND BUILD ITEMS
+
+struct bvhnode {
+        double lo[3], hi[3];                    // BOUNDING BOX
+        bvhnode *c[2];                          // CHILDREN (0: LEAF)
+        int axis;                               // SPLITTING AXIS
+        list<object*> objs;                     // OBJECTS OF A LEAF
+};
+
+struct bvhitem {
+        object *o;                              // BOUNDED OBJECT
+        double lo[3], hi[3];                    // ITS BOX
+        double m[3];                            // CENTER OF ITS BOX
+};
+
+const int BINS=16;                              // SAH CANDIDATES PER NODE
+const int LEAFSIZE=2;                           // ALWAYS A LEAF AT OR BELOW THIS
+const int MAXLEAF=16;                           // NEVER A LEAF ABOVE THIS
+const double COST=1.;                           // NODE VS. OBJECT TEST COST
+
+struct bvhbox {                                 // GROWING BOX
+        double lo[3], hi[3];
+        bvhbox() {lo[0]=lo[1]=lo[2]=HUGE_VAL; hi[0]=hi[1]=hi[2]=-HUGE_VAL;}
+        void operator+=(const double p[3])
+                {for(int k=0;k<3;k++) {if(p[k]<lo[k])lo[k]=p[k]; if(p[k]>hi[k])hi[k]=p[k];}}
+        void operator+=(const bvhitem& i) {*this+=i.lo; *this+=i.hi;}
+        double area() const {                   // HALF SURFACE AREA
+                if(lo[0]>hi[0]) return 0.;
+                double x=hi[0]-lo[0], y=hi[1]-lo[1], z=hi[2]-lo[2];
+                return x*y+y*z+z*x;
+        }
+};
+
+//      METHODS OF class bvh
+
+bvh::~bvh() {delete[] nodes;}
+
+int bvh::build(int first, int n, int depth) {   // NODE OVER items[first..]
+        int k=nn++; bvhnode *N=&nodes[k];
+        bvhbox b, cb;                           // BOXES OF ITEMS, CENTERS
+        for(int i=first; i<first+n; i++) {b+=items[i]; cb+=items[i].m;}
+        for(int a=0; a<3; a++) {N->lo[a]=b.lo[a]; N->hi[a]=b.hi[a];}
+        N->c[0]=N->c[1]=(bvhnode*)0; N->axis=0;
+        if(n<=LEAFSIZE) {                       // SMALL ENOUGH
+                for(int i=first; i<first+n; i++) N->objs+=items[i].o;
+                return k;
+        }
+        int axis=0;                             // LONGEST AXIS OF CENTERS
+        for(int a=1; a<3; a++)
+                if(cb.hi[a]-cb.lo[a]>cb.hi[axis]-cb.lo[axis]) axis=a;
+        double w=cb.hi[axis]-cb.lo[axis];
+        int mid=first+n/2;                      // FALLBACK: HALVE LIST,
+                                                // SO DEPTH STAYS BELOW BVHDEPTH
+        if(w>0. && depth<BVHDEPTH/2) {          // SURFACE AREA HEURISTIC
+                bvhbox bb[BINS]; int bn[BINS];
+                for(int j=0; j<BINS; j++) bn[j]=0;
+                for(int i=first; i<first+n; i++) {
+                        int j=(int)(BINS*(items[i].m[axis]-cb.lo[axis])/w);
+                        if(j>=BINS) j=BINS-1;
+                        bb[j]+=items[i]; bn[j]++;
+                }
+                double ra[BINS]; int rn[BINS];  // RIGHT SIDES FROM BIN j
+                bvhbox r; int m=0;
+                for(int j=BINS-1; j>0; j--)
+                        {r+=bb[j].lo; r+=bb[j].hi; m+=bn[j]; ra[j]=r.area(); rn[j]=m;}
+                bvhbox l; int best=0; double cmin=HUGE_VAL; m=0;
+                for(int j=0; j<BINS-1; j++) {   // SPLIT AFTER BIN j
+                        l+=bb[j].lo; l+=bb[j].hi; m+=bn[j];
+                        if(!m || !rn[j+1]) continue;
+                        double c=l.area()*m+ra[j+1]*rn[j+1];
+                        if(c<cmin) {cmin=c; best=j;}
+                }
+                double A=b.area();
+                if(A>0. && n<=MAXLEAF && COST+cmin/A>=n) {      // CHEAPER AS
+                        for(int i=first; i<first+n; i++)        // A LEAF
+                                N->objs+=items[i].o;
+                        return k;
+                }
+                int i=first, j=first+n-1;       // PARTITION AT THE SPLIT
+                while(i<=j) {
+                        int bi=(int)(BINS*(items[i].m[axis]-cb.lo[axis])/w);
+                        if(bi>=BINS) bi=BINS-1;
+                        if(bi<=best) i++;
+                        else {bvhitem t=items[i]; items[i]=items[j]; items[j--]=t;}
+                }
+                if(i>first && i<first+n) mid=i;
+        }
+        N->axis=axis;
+        int c0=build(first, mid-first, depth+1);
+        int c1=build(mid, first+n-mid, depth+1);
+        N=&nodes[k];
+        N->c[0]=&nodes[c0]; N->c[1]=&nodes[c1];
+        return k;
+}
+
+void bvh::preprocess(list<object*> *lo) {               // PREPROCESSING
+        int n=0;
+        for(object* o=lo->first(); o; o=lo->next()) n++;
+        items=new bvhitem[n>0?n:1];
+        n=0;
+        for(object* o=lo->first(); o; o=lo->next()) {   // BOUNDED OBJECTS
+                vector l, h;
+                if(!o->bounds(l,h)) {inf+=o; continue;} // INFINITE ONES
+                bvhitem& i=items[n++]; i.o=o;
+                for(int a=0; a<3; a++)
+                        {i.lo[a]=l[a]; i.hi[a]=h[a]; i.m[a]=(l[a]+h[a])/2.;}
+        }
+        delete[] nodes; nodes=(bvhnode*)0; nn=0;
+        if(n>0) {
+                nodes=new bvhnode[2*n-1];
+                build(0, n, 1);
+        }
+        delete[] items;
+        if(verbose)
+                std::cout<<"bvh: "<<n<<" bounded, "<<nn<<" nodes\n";
+}
+
+static int hits(const bvhnode *N, const walk& w) {      // RAY MEETS BOX
+        double t0=0., t1=w.tmax<0.?HUGE_VAL:w.tmax;     // BEFORE NEAREST HIT
+        for(int a=0; a<3; a++) {
+                double ta=(N->lo[a]-w.o[a])*w.inv[a];
+                double tb=(N->hi[a]-w.o[a])*w.inv[a];
+                if(ta>tb) {double t=ta; ta=tb; tb=t;}
+                if(ta>t0) t0=ta;
+                if(tb<t1) t1=tb;
+                if(t0>t1) return 0;
+        }
+        return 1;
+}
+
+list<object*>* bvh::firstlist(const ray& r, walk& w) {
+        for(int a=0; a<3; a++) {w.o[a]=r.o[a]; w.inv[a]=1./r.d[a];}
+        w.n=0;
+        if(nodes) w.stack[w.n++]=nodes;                 // START AT ROOT
+        return &inf;                                    // TEST UNBOUNDED FIRST
+}
+
+list<object*>* bvh::nextlist(walk& w) {                 // NEXT LEAF ALONG RAY
+        while(w.n>0) {
+                const bvhnode *N=w.stack[--w.n];
+                if(!hits(N,w)) continue;                // MISSED OR TOO FAR
+                if(!N->c[0]) return (list<object*>*)&N->objs;
+                int near=w.inv[N->axis]<0.;             // NEARER CHILD LAST
+                w.stack[w.n++]=N->c[1-near];            // SO IT IS VISITED
+                w.stack[w.n++]=N->c[near];              // FIRST
+        }
+        return (list<object*>*)0;
+}
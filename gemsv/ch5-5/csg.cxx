@@ -8,3 +8,24 @@ std::ostream& operator<<(std::ostream& o, csgmer& c) {c.out(o); return o;}
 std::ostream& operator<<(std::ostream& o, csgint& c) {c.out(o); return o;}
 std::ostream& operator<<(std::ostream& o, csgdif& c) {c.out(o); return o;}
 
+
+int csg::bounds(vector& lo, vector& hi) {       // BOX AROUND ALL PARTS
+        int first=1;
+        for(object*o=l->first();o;o=l->next()) {
+                vector bl, bh;
+                if(!o->bounds(bl,bh)) return 0;         // UNBOUNDED PART
+                for(int k=0; k<8; k++) {                // CORNERS OF PART'S
+                        vector p=T*vector(k&1?bh[0]:bl[0],      // BOX IN OUR
+                                          k&2?bh[1]:bl[1],      // COORDINATES
+                                          k&4?bh[2]:bl[2]);
+                        if(first) {lo=p; hi=p; first=0; continue;}
+                        lo=vector(p[0]<lo[0]?p[0]:lo[0],
+                                  p[1]<lo[1]?p[1]:lo[1],
+                                  p[2]<lo[2]?p[2]:lo[2]);
+                        hi=vector(p[0]>hi[0]?p[0]:hi[0],
+                                  p[1]>hi[1]?p[1]:hi[1],
+                                  p[2]>hi[2]?p[2]:hi[2]);
+                }
+        }
+        return !first;                                  // EMPTY: NO BOUNDS
+}
@@ -15,11 +15,11 @@ std::ostream& operator<<(std::ostream& o, finish& f) {
         return o;
 }
 
-extern vector norm(vector& v);
-
 intensity finish::surfoptics(color& c, vector& n, const ray& r, intersect& i){
         intensity I(this->ka, this->ka, this->ka);
-        for(lightsource *ls=lightsources.first(); ls; ls=lightsources.next()) {
+        listelem<lightsource*> *e;                      // LOCAL, SO THREADS CAN
+                                                        // WALK lightsources AT ONCE
+        for(lightsource *ls=lightsources.first(e); ls; ls=lightsources.next(e)) {
                 list<light*>* L=ls->illum(i);
                 for(light *l=L->first(); l; l=L->next()) {
                         double f=n%l->v;
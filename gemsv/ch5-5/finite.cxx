@@ -24,3 +24,15 @@ list<intersect*> *sphere::shape(ray& r) {
         }
         return l;
 }
+
+int sphere::bounds(vector& lo, vector& hi) {            // TRANSFORMED SPHERE
+        vector x=T<<vector(1.,0.,0.);                   // COLUMNS OF THE
+        vector y=T<<vector(0.,1.,0.);                   // LINEAR PART OF T
+        vector z=T<<vector(0.,0.,1.);
+        vector e(this->r*sqrt(x[0]*x[0]+y[0]*y[0]+z[0]*z[0]),
+                 this->r*sqrt(x[1]*x[1]+y[1]*y[1]+z[1]*z[1]),
+                 this->r*sqrt(x[2]*x[2]+y[2]*y[2]+z[2]*z[2]));
+        vector m=T*this->c;                             // CENTER
+        lo=m-e; hi=m+e;
+        return 1;
+}
@@ -10,15 +10,30 @@ const double Pi=3.1415926535;
 inline double RAD(double r) {return Pi*r/180.;}     // DEG-TO-RAD CONVERSION
 const double EPS=1e-4;                              // VERY SMALL NUMBER
 
+//      MEMORY OF RAYS AND OF THE SCENE (memory.cxx)
+
+struct pooled {                                 // FROM THE RAY ARENA WHILE
+        static void* operator new(size_t n);    // TRACING, FROM POOLS
+        static void operator delete(void* p, size_t n); // OTHERWISE
+};
+
+extern int usearena;                            // 0: PLAIN new AND delete
+extern void arenabegin();                       // THIS THREAD TRACES NOW
+extern void arenareset();                       // DROPS A PIXEL'S RECORDS
+extern void arenaend(long *nalloc, size_t *top);// THREAD HAS FINISHED
+extern size_t poolbytes();                      // BYTES IN SCENE POOLS
+extern void memstart();                         // COUNTMEM: FRAME STARTS
+extern void memreport(const char *what);        // COUNTMEM: FRAME ENDS
+
 //      LIST TEMPLATE
 
-template <class T> struct listelem {
+template <class T> struct listelem : pooled {
         T o;                                            // OBJECT
         listelem<T> *n;                                 // NEXT ELEMENT
         listelem(T o) {this->o=o; n=(listelem<T>*)0;}
 };
 
-template <class T> class list {
+template <class T> class list : public pooled {
         listelem<T> *h, *t, *a;                         // HEAD, TAIL, ACTUAL
 public:
         list() {h=t=(listelem<T>*)0;}
@@ -29,6 +44,9 @@ public:
         }
         T first() {a=h; return a?a->o:(T)0;}
         T next() {a=a->n; return a?a->o:(T)0;}
+        T first(listelem<T>*& c) const {c=h; return c?c->o:(T)0;}
+        T next(listelem<T>*& c) const {c=c->n; return c?c->o:(T)0;}
+                                        // OWN CURSOR c: FOR CONCURRENT READERS
         int operator[](T o) {                                   // o ON LIST?
                 for(listelem<T>*e=h;e;e=e->n) if(e->o==o) return 1;
                 return 0;
@@ -37,7 +55,7 @@ public:
 
 //      DECLARATION TEMPLATE (SIMILAR TO LIST BUT MAY BE ENHANCED)
 
-template <class T> struct declaration {
+template <class T> struct declaration : pooled {
         char *i;                                                // IDENTIFIER
         T *p;                                                   // OBJECT
         declaration<T> *n;                                      // NEXT
@@ -67,7 +85,7 @@ public:
 
 class xform;
 
-class vector {
+class vector : public pooled {
         friend std::ostream& operator<<(std::ostream& o, vector& v);
         friend vector operator-(const vector& v);
         friend class xform;
@@ -150,7 +168,7 @@ struct ray {
 
 class object;
 
-struct intersect {
+struct intersect : pooled {
         double t;                                       // RAY PARAMETER
         vector p;                                       // SURFACE POINT
         vector n;                                       // SURFACE NORMAL
@@ -296,6 +314,7 @@ public:
         intensity operator+(const intensity& i)
                 {return intensity(r+i.r,g+i.g,b+i.b);}
         void operator+=(const intensity& i) {r+=i.r; g+=i.g; b+=i.b;}
+        void get(double c[3]) const {c[0]=r; c[1]=g; c[2]=b;}
         operator icolor() {
                 unsigned char ir=r<1.?(unsigned char)(r*255.):255;
                 unsigned char ig=g<1.?(unsigned char)(g*255.):255;
@@ -328,7 +347,7 @@ class finish;
 class fog {
 };
 
-class pigment {
+class pigment : public pooled {
         friend std::ostream& operator<<(std::ostream& o, pigment& p);
 protected:
         color q;                                        // QUICK COLOR
@@ -472,7 +491,7 @@ class radial : public colormapped {
 
 //      TEXTURES - II. NORMAL
 
-class normal {
+class normal : public pooled {
         friend std::ostream& operator<<(std::ostream& o, normal& n);
         vector t;                                       // TURBULENCE
         double f, p;                                    // FREQUENCY, PHASE
@@ -546,7 +565,7 @@ class bumpmap : public normal {
 
 //      TEXTURES - III. FINISH
 
-class finish {
+class finish : public pooled {
         friend std::ostream& operator<<(std::ostream& o, finish& f);
         double kd, kb, kc;                      // DIFFUSE, BRILLIANCE, CRAND
         double ka;                              // AMBIENT
@@ -577,7 +596,7 @@ public:
 
 //      TEXTURES - IV. TOP LEVEL
 
-class texture {
+class texture : public pooled {
         friend std::ostream& operator<<(std::ostream& o, texture& t);
         pigment *p;
         normal *n;
@@ -673,15 +692,33 @@ public:
                 return l;
         }
         virtual int operator&(const halfspace& h) const {return 1;}   // INTERSECTS h
+        virtual int bounds(vector& lo, vector& hi)      // BOUNDING BOX, OR 0
+                {return 0;}                             // IF NOT FINITE
 };
 
 //      INTERSECTION ACCELERATION TECHNIQUES
 
+struct cell;                                    // DECLARED IN voronoi.cxx
+struct bvhnode;                                 // DECLARED IN bvh.cxx
+struct bvhitem;
+
+const int BVHDEPTH=64;                          // MAXIMAL DEPTH OF BVH
+
+struct walk {                                   // STATE OF ONE QUERY, SO THAT
+        cell *a;                                // RAYS MAY BE TRACED BY MANY
+        const ray *r;                           // THREADS AT THE SAME TIME
+        double t;
+        double tmax;                            // NEAREST HIT SO FAR (OR <0)
+        double o[3], inv[3];                    // RAY ORIGIN, 1/DIRECTION
+        const bvhnode *stack[BVHDEPTH];         // BVH NODES STILL TO VISIT
+        int n;                                  // NUMBER OF THEM
+};
+
 class method {
         list<object*> *lo;                              // SCENE OBJECTS
-        virtual list<object*> *firstlist(const ray& r)
+        virtual list<object*> *firstlist(const ray& r, walk& w)
                 {return lo;}                            // BRUTE-FORCE METHOD
-        virtual list<object*> *nextlist()
+        virtual list<object*> *nextlist(walk& w)
                 {return (list<object*>*)0;}             // BRUTE-FORCE METHOD
 public:
         method() {lo=new list<object*>;}
@@ -689,13 +726,14 @@ public:
         virtual void preprocess(list<object*> *l)
                 {delete lo; lo=l;}                      // NO PREPROCESSING
         intersect operator()(const ray& r) {                  // GENERAL SCHEME
-                intersect imin, *i;
-                for(list<object*>*lo=firstlist(r); lo; lo=nextlist()) {
-                        for(object *o=lo->first(); o; o=lo->next()) {
+                intersect imin, *i; walk w; listelem<object*> *c;
+                w.tmax=-1.;
+                for(list<object*>*lo=firstlist(r,w); lo; lo=nextlist(w)) {
+                        for(object *o=lo->first(c); o; o=lo->next(c)) {
                                 list<intersect*> *li=o->test(r);
                                 if(((i=li->first()))) {
                                         if(!imin.o || i->t<imin.t )
-                                                imin=*i;
+                                                {imin=*i; w.tmax=imin.t;}
                                 }
                                 for(i=li->first(); i; i=li->next())
                                         delete i;
@@ -729,6 +767,7 @@ public:
         }
         int operator&(halfspace& h)
                 {halfspace H=T/h; return (c-H.n*(r+H.d))*H.n<=EPS;}
+        int bounds(vector& lo, vector& hi);
 };
 
 class box : public object {
@@ -793,6 +832,7 @@ public:
                 for(object*o=l->first();o;o=l->next()) if(*o&H) return 1;
                 return 0;
         }
+        int bounds(vector& lo, vector& hi);
 };
 
 class csguni : public csg {
@@ -842,7 +882,7 @@ public:
 
 //      OBJECTS SPECIFIED -  V. LIGHT SOURCES
 
-struct light {
+struct light : pooled {
         intensity i;
         vector v;
         light(intensity& i, vector& v) {this->i=i; this->v=v;}
@@ -907,20 +947,32 @@ public:
 
 //      ACCELERATION TECHNIQUES - I. VIA VORONOI-DIAGRAM
 
-struct cell;                                    // DECLARED IN voronoi.cxx
-
 class voronoi : public method {
         cell *C;                                // CELL CLOSEST TO CENTROID
-        cell **s;                               // ARRAY OF STARTING CELLS
+        cell **s;                               // STARTING CELLS, PER THREAD
+        int ns;                                 // NUMBER OF THEM PER THREAD
         long traverse;                          // TRAVERSE CODE (disperse)
         void disperse(object *o, cell*C);
-        cell* a;
-        const ray* r;
-        double t;              // USED BY step()
-        void step();                            // USED BY first-,nextlist()
-        list<object*> *firstlist(const ray& r);
-        list<object*> *nextlist();
+        void step(walk& w);                     // USED BY first-,nextlist()
+        list<object*> *firstlist(const ray& r, walk& w);
+        list<object*> *nextlist(walk& w);
+public:
+        void preprocess(list<object*> *lo);
+};
+
+//      ACCELERATION TECHNIQUES - II. BOUNDING VOLUME HIERARCHY
+
+class bvh : public method {
+        list<object*> inf;                      // OBJECTS WITHOUT BOUNDS
+        bvhnode *nodes;                         // nodes[0] IS THE ROOT
+        int nn;                                 // NUMBER OF NODES
+        bvhitem *items;                         // USED BY build()
+        int build(int first, int n, int depth);
+        list<object*> *firstlist(const ray& r, walk& w);
+        list<object*> *nextlist(walk& w);
 public:
+        bvh() {nodes=(bvhnode*)0; nn=0;}
+        ~bvh();
         void preprocess(list<object*> *lo);
 };
 
@@ -931,5 +983,5 @@ extern int verbose;                             // PRINTOUTS
 extern list<object*> objects;                   // SCENE OBJECTS
 extern list<lightsource*> lightsources;         // LIGHTSOURCES
 extern camera actcamera;                        // CAMERA
-extern intensity trace(ray& r);                 // RECURSIVE RAY TRACING
+extern intensity trace(const ray& r);           // RECURSIVE RAY TRACING
 extern fog actfog;                              // FOG
@@ -2,17 +2,18 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "global.h"
+#include "../ch6-7/sampler.h"
 
 //      GLOBAL CONSTANTS
 
 int verbose=0;                                      // WHAT TO PRINT OUT
 
-double drand48() {
-	return 1.f;
-}
-
 //      INPUT FILE CONTAINING RANDOM OBJECTS
 
 const char* randomfilename="random.pov";
@@ -21,8 +22,7 @@ int nrandom=0;                          // NUMBER OF RANDOM OBJECTS
 double rho=.0001;                       // DEFAULT DENSITY OF RANDOM SPHERES
 
 double random(double a, double b) {                     // a<=random(a,b)<=b
-//      double r=(double)rand()/(double)RAND_MAX;       // 0.<=r<=1.
-        double r=drand48();                             // 0.<=r<=1.
+        double r=(double)rand()/(double)RAND_MAX;       // 0.<=r<=1.
         return a+r*(b-a);
 }
 
@@ -52,50 +52,53 @@ extern const char* inputfilename;                         // DEFINED IN THE lex
 extern int yyparse(void);                           // GENERATED BY yacc FILE
 extern intensity background;                        // DEFINED IN yacc FILE
 
-//      DEBUGGING
+//      PICTURE IN TILES
 
-#ifdef COUNTMEM
-extern "C" {void* malloc(size_t); void free(void*);}
-long nbytes=0L;
-void *operator new(size_t size) {
-        nbytes+=size;
-        void *p=malloc(size+8); std::cout<<nbytes<<"\n";
-        *(long*)p=size;
-        return p+8;
-}
-void operator delete(void *p) {
-        p-=8;
-        nbytes-=*(long*)p;
-        free(p);
-}
-#endif
-
-//      PICTURE BUFFER
-
-const int MAXRES=1024;
-icolor buf[MAXRES];                                 // ONE ROW OF R,G,B BYTES
 int xres=200, yres=200;                             // ACTUAL RESOLUTION
+int tile=32;                                        // WIDTH, HEIGHT OF TILES
+int nthreads=0;                                     // 0: ONE PER CORE
+int nbench=0;                                       // LARGEST BENCHMARK SCENE
 
 //      OUTPUT FILE
 
 const char* outputfilename="picture";                     // DEFAULT OUTPUT NAME
+FILE* outputfile;                                   // OPEN WHILE TRACING
 
 void outinit(int xres, int yres) {                  // INITIALIZE OUTPUT FILE
-        FILE *f;
-        if(!(f=fopen(outputfilename,"wb")))
+        if(!(outputfile=fopen(outputfilename,"wb")))
                 return;
-        fwrite((void*)&xres, sizeof(int), 1, f);
-        fwrite((void*)&yres, sizeof(int), 1, f);
-        fclose(f);
+        fwrite((void*)&xres, sizeof(int), 1, outputfile);
+        fwrite((void*)&yres, sizeof(int), 1, outputfile);
+        if(xres>0 && yres>0) {                      // WHOLE SIZE, SO TILES
+                fseek(outputfile,                   // MAY BE WRITTEN IN
+                      (long)xres*yres*sizeof(icolor)-1, SEEK_CUR);
+                fputc(0, outputfile);               // ANY ORDER
+        }
 }
 
-void output(icolor b[]) {                           // OUTPUT ONE ROW
-        FILE *f;
-        if(!(f=fopen(outputfilename,"ab")))
+void output(icolor b[], int x, int y, int w, int h) {   // OUTPUT ONE TILE
+        if(!outputfile)
                 return;
-        fwrite((void*)b, sizeof(icolor), xres, f);
-        fclose(f);
+        for(int i=0; i<h; i++) {                    // ROW BY ROW, SO THE
+                fseek(outputfile, 2*sizeof(int)+    // FILE FILLS IN AS
+                      ((long)(y+i)*xres+x)*sizeof(icolor), SEEK_SET);
+                fwrite((void*)(b+i*w), sizeof(icolor), w, outputfile);
+        }
+        fflush(outputfile);                         // TILES ARE FINISHED
+}
+
+void outdone() {                                    // CLOSE OUTPUT FILE
+        if(outputfile)
+                fclose(outputfile);
+        outputfile=(FILE*)0;
+}
 
+double seconds() {                                  // WALL CLOCK TIME
+#ifdef _OPENMP
+        return omp_get_wtime();
+#else
+        return (double)clock()/CLOCKS_PER_SEC;
+#endif
 }
 
 //      INTERSECTION ACCELERATION METHODS
@@ -115,6 +118,138 @@ intensity trace(const ray& r) {
         return i.o->shade(r,i);
 }
 
+//      SAMPLING
+
+// Without any of the sampling switches each pixel is one ray, as always.
+// With them the pixels of a tile are sampled and filtered by the sampler
+// of sampler.c, which takes extra samples where they differ in contrast.
+
+int sampled=0;                                  // 1: SAMPLER, 0: ONE RAY
+int spattern=SAMPLE_MULTIJITTER;                // SAMPLE POSITIONS
+int sfilter=FILTER_BOX;                         // RECONSTRUCTION FILTER
+int sfirst=4, smore=0;                          // SAMPLES, EXTRA SAMPLES
+double scontrast=.1;                            // CONTRAST FOR EXTRA ONES
+Sampler sampler;
+
+static void sample(double x, double y, double rgb[3], void*) {
+        intensity I=trace(actcamera.getray((2.*x-xres)/xres,(yres-2.*y)/yres));
+        I.get(rgb);
+        arenareset();                           // ONE SAMPLE'S RECORDS
+}
+
+//      TRACING OF TILES
+
+// Each thread takes the next tile not yet taken, traces it into a buffer
+// of its own and writes it into the file, so threads that draw cheap
+// tiles simply take more of them.  Only the file is shared while tracing;
+// the scene, the camera and the acceleration method are only read.
+
+long nrecords;                                  // RAY RECORDS OF A FRAME
+size_t maxrecords;                              // MOST BYTES OF A PIXEL
+long nsamples;                                  // SAMPLES OF A FRAME
+
+void render() {
+        int ntx=(xres+tile-1)/tile, nty=(yres+tile-1)/tile;
+        int ntiles=ntx*nty, remained=ntiles;
+        nrecords=0L; maxrecords=0; nsamples=0L;
+#pragma omp parallel
+        {
+                icolor *buf=new icolor[tile*tile];  // THIS THREAD'S TILE
+                float *rgb=new float[3*tile*tile];  // ITS FILTERED SAMPLES
+                long ns=0L;
+                arenabegin();                       // AND ITS RAY RECORDS
+#pragma omp for schedule(dynamic,1)
+                for(int k=0; k<ntiles; k++) {       // TILES, TOP ROW FIRST
+                        int x0=k%ntx*tile, y0=k/ntx*tile;
+                        int w=xres-x0<tile?xres-x0:tile;
+                        int h=yres-y0<tile?yres-y0:tile;
+                        if(sampled) {
+                                ns+=SamplerTile(&sampler, x0, y0, w, h,
+                                                sample, (void*)0, rgb);
+                                for(int i=0; i<w*h; i++)
+                                        buf[i]=(icolor)intensity(rgb[3*i],
+                                                rgb[3*i+1], rgb[3*i+2]);
+                        } else for(int i=0; i<h; i++)
+                                for(int j=0; j<w; j++) {
+                                        double x=(2*(x0+j)-xres+0.5)/xres;
+                                        double y=(yres-2*(y0+i)-0.5)/yres;
+                                        intensity I=trace(actcamera.getray(x,y));
+                                        buf[i*w+j]=(icolor)I;
+                                        arenareset();
+                                }
+#pragma omp critical
+                        {
+                                output(buf, x0, y0, w, h);
+                                fprintf(stderr, "tiles remained: %6d\r", --remained);
+                        }
+                }
+                long n; size_t top;
+                arenaend(&n, &top);
+                delete[] buf;
+                delete[] rgb;
+#pragma omp critical
+                {
+                        nrecords+=n;
+                        if(top>maxrecords) maxrecords=top;
+                        nsamples+=ns;
+                }
+        }
+}
+
+//      SCENE-SCALING BENCHMARK
+
+// Times the preprocessing and the tracing of random scenes of 100, 1000,
+// ... spheres with each acceleration method.  Brute force and the
+// Voronoi-diagram are left out above the sizes where they take too long.
+
+list<object*> *randomscene(int n) {             // n SPHERES AS IN random.pov
+        list<object*> *l=new list<object*>;
+        color W(1.,1.,1.); solid p(W); finish f; f.setkd(1.);
+        double h=pow(n/rho, 1./3.)/2.;              // HALF WIDTH OF SCENE CUBE
+        for(int i=0; i<n; i++) {
+                vector c(random(-h,h),random(-h,h),random(0.,2*h));
+                sphere *s=new sphere(c,1.);
+                s->setp(p); s->setf(f);
+                *l+=s;
+        }
+        return l;
+}
+
+void benchmark(int nmax) {
+        const char *names[3]={"brute-force", "voronoi", "bvh"};
+        const int largest[3]={1000, 1000, 0};       // 0: NO LIMIT
+        color W(1.,1.,1.); vector o(0.,0.,0.);
+        for(int k=0; k<2; k++) {                    // LIGHTS AS IN random.pov
+                lightsource *ls=new lightsource;
+                ls->setp(o); ls->setc(W); lightsources+=ls;
+        }
+        printf("%d x %d pixels, %d thread(s)\n", xres, yres, nthreads);
+        printf(" objects method       preprocess     trace\n");
+        for(int n=100; ; n*=10) {
+                if(n>nmax) n=nmax;
+                srand(1);
+                list<object*> *l=randomscene(n);
+                for(int m=0; m<3; m++) {
+                        if(largest[m] && n>largest[m]) continue;
+                        query=m==0?new method:m==1?(method*)new voronoi:new bvh;
+                        double t0=seconds();
+                        query->preprocess(l);
+                        double t1=seconds();
+                        memstart();
+                        render();
+                        double t2=seconds();
+                        fprintf(stderr, "\r");
+                        printf("%8d %-12s %9.3fs %9.3fs\n", n, names[m], t1-t0, t2-t1);
+                        memreport(names[m]);
+                        fflush(stdout);
+                        delete query;
+                }
+                for(object *p=l->first(); p; p=l->next()) delete p;
+                delete l;
+                if(n==nmax) break;
+        }
+}
+
 //      MAIN PROGRAM
 
 void usage() {
@@ -122,11 +257,25 @@ void usage() {
         std::cout<<"where\n";
         std::cout<<"    SWITCH can be\n";
         std::cout<<"        -a v             :accelerate via Voronoi-diagram\n";
+        std::cout<<"        -a h             :accelerate via bounding volume hierarchy\n";
         std::cout<<"        -a b             :brute-force intersection (default)\n";
+        std::cout<<"        -b #             :times all methods on random scenes\n";
+        std::cout<<"                          of up to # objects\n";
+        std::cout<<"        -c REAL          :contrast above which a pixel gets\n";
+        std::cout<<"                          the extra samples (0.1)\n";
+        std::cout<<"        -e #             :extra samples of contrasty pixels (0)\n";
+        std::cout<<"        -f b|t|h|q|B|m|l :filter: box (default), triangle, Hermite,\n";
+        std::cout<<"                          bell, B-spline, Mitchell, Lanczos3\n";
+        std::cout<<"        -m               :plain new and delete for all records\n";
+        std::cout<<"        -n #             :number of threads (default: cores)\n";
         std::cout<<"        -o FILENAME      :name of output file\n";
+        std::cout<<"        -p c|j|m|e       :sample positions: center, jittered,\n";
+        std::cout<<"                          multi-jittered (default), edge-optimized\n";
         std::cout<<"        -r #             :creates # number of random objects\n";
         std::cout<<"                          (also writes them into random.pov)\n";
         std::cout<<"        -r -1            :reads objects from random.pov\n";
+        std::cout<<"        -s #             :samples of every pixel (4)\n";
+        std::cout<<"        -t #             :width and height of tiles (32)\n";
         std::cout<<"        -v               :verbose printout\n";
         std::cout<<"        -x #             :horizontal resolution of image\n";
         std::cout<<"        -y #             :vertical resolution of image\n";
@@ -148,17 +297,72 @@ int main(int argc, char** argv) {
                                 delete query;
                                 query=new voronoi;
                                 break;
+                            case 'H': case 'h':         // VIA BOUNDING VOLUMES
+                                delete query;
+                                query=new bvh;
+                                break;
                         }
                         argc--; argv++;
                         break;
+                    case 'b':                           // SCALING BENCHMARK
+                        nbench=atoi(argv[2]);
+                        argc--; argv++;
+                        break;
+                    case 'c':                           // CONTRAST THRESHOLD
+                        scontrast=atof(argv[2]); sampled=1;
+                        argc--; argv++;
+                        break;
+                    case 'e':                           // EXTRA SAMPLES
+                        smore=atoi(argv[2]); sampled=1;
+                        argc--; argv++;
+                        break;
+                    case 'f':                           // RECONSTRUCTION FILTER
+                        switch(argv[2][0]) {
+                            case 'b': sfilter=FILTER_BOX; break;
+                            case 't': sfilter=FILTER_TRIANGLE; break;
+                            case 'h': sfilter=FILTER_HERMITE; break;
+                            case 'q': sfilter=FILTER_BELL; break;
+                            case 'B': sfilter=FILTER_BSPLINE; break;
+                            case 'm': sfilter=FILTER_MITCHELL; break;
+                            case 'l': sfilter=FILTER_LANCZOS3; break;
+                        }
+                        sampled=1;
+                        argc--; argv++;
+                        break;
+                    case 'm':                           // NO ARENAS, POOLS
+                        usearena=0;
+                        break;
+                    case 'n':                           // NUMBER OF THREADS
+                        nthreads=atoi(argv[2]);
+                        argc--; argv++;
+                        break;
                     case 'o':                           // OUTPUT FILE NAME
                         outputfilename=argv[2];
                         argc--; argv++;
                         break;
+                    case 'p':                           // SAMPLE POSITIONS
+                        switch(argv[2][0]) {
+                            case 'C': case 'c': spattern=SAMPLE_CENTER; break;
+                            case 'J': case 'j': spattern=SAMPLE_JITTER; break;
+                            case 'M': case 'm': spattern=SAMPLE_MULTIJITTER; break;
+                            case 'E': case 'e': spattern=SAMPLE_EDGE; break;
+                        }
+                        sampled=1;
+                        argc--; argv++;
+                        break;
                     case 'r':                           // USE RANDOM OBJECTS
                         nrandom=atoi(argv[2]);
                         argc--; argv++;
                         break;
+                    case 's':                           // SAMPLES PER PIXEL
+                        sfirst=atoi(argv[2]); sampled=1;
+                        argc--; argv++;
+                        break;
+                    case 't':                           // TILE SIZE
+                        tile=atoi(argv[2]);
+                        if(tile<1) tile=1;
+                        argc--; argv++;
+                        break;
                     case 'v':                           // VERBOSE OUTPUT
                         verbose=1;
                         break;
@@ -174,6 +378,23 @@ int main(int argc, char** argv) {
                 argc--;
                 argv++;
         }
+#ifdef _OPENMP
+        if(nthreads>0)                                  // BEFORE preprocess,
+                omp_set_num_threads(nthreads);          // WHICH SETS UP
+        nthreads=omp_get_max_threads();                 // PER-THREAD STATE
+#else
+        nthreads=1;
+#endif
+        if(sampled && !SamplerInit(&sampler, spattern, sfirst, smore,
+                                   scontrast, sfilter, xres, yres)) {
+                fprintf(stderr, "oopov: bad sampling (edge-optimized "
+                        "patterns have 4 or 16 samples)\n");
+                exit(1);
+        }
+        if(nbench>0) {                                  // NO INPUT FILE
+                benchmark(nbench);
+                exit(0);
+        }
         if(argc>1)                                      // NAME OF INPUT FILE
                 inputfilename=argv[1];                  // COMES AS ARGUMENT
         else if(nrandom>0) {
@@ -189,16 +410,19 @@ int main(int argc, char** argv) {
         fprintf(stderr, "\n");
         query->preprocess(&objects);                    // PREPROCESS OBJECTS
         outinit(xres, yres);                            // INITIALIZE OUTPUT
-        for(int i=0; i<yres; i++) {            // TRACE
-                for(int j=0; j<xres; j++) {
-                        double x=(2*j-xres+0.5)/xres;
-                        double y=(yres-2*i-0.5)/yres;
-                        intensity I=trace(actcamera.getray(x,y));
-                        buf[j]=(icolor)I;
-                }
-                output(buf);
-                fprintf(stderr, "rows remained: %4d\r", yres-i-1);
-        }
-        fprintf(stderr, "\n");
+        double start=seconds();
+        memstart();
+        render();                                       // TRACE
+        fprintf(stderr, "\n%.3f seconds on %d thread(s)\n",
+                seconds()-start, nthreads);
+        if(usearena)
+                fprintf(stderr, "%ld ray records, at most %lu bytes a pixel, "
+                        "%lu bytes of scene pools\n", nrecords,
+                        (unsigned long)maxrecords, (unsigned long)poolbytes());
+        if(sampled)
+                fprintf(stderr, "%.2f samples a pixel\n",
+                        (double)nsamples/((double)xres*yres));
+        memreport("frame");
+        outdone();
         exit(0);
 }
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <iostream>
+
+#include "global.h"
+
+//      ARENAS AND POOLS
+
+// While a thread traces it allocates the records of a ray (intersections,
+// lights, lists and their elements) by bumping a pointer through an arena
+// of its own, and deleting them does nothing; the whole arena is dropped
+// after each pixel.  At other times, that is while the scene is read and
+// preprocessed, these objects come from pools with one free list for each
+// size.  Both only ever ask the system for large chunks.  Each record has
+// a header telling where it came from, so that it goes back there whenever
+// it is deleted: a pooled record deleted while tracing returns to its pool,
+// and an arena record deleted after arenaend() is left to its arena.  The
+// pools are meant for building the scene; they are locked all the same.
+
+int usearena=1;                                 // 0: PLAIN new AND delete
+
+const size_t ALIGN=16;                          // ALIGNMENT OF RECORDS
+const size_t CHUNK=64*1024;                     // BYTES ASKED FOR AT ONCE
+const size_t POOLED=256;                        // LARGEST POOLED SIZE
+const size_t HEAD=ALIGN;                        // HEADER OF A RECORD
+
+enum {FROMSYSTEM, FROMPOOL, FROMARENA};         // WHERE A RECORD CAME FROM
+
+struct chunk {
+        chunk *n;                               // NEXT CHUNK
+        size_t size;                            // BYTES AFTER THIS HEADER
+};
+
+struct arena {
+        chunk *h, *a;                           // FIRST, ACTUAL CHUNKS
+        char *p, *e;                            // FREE PART OF ACTUAL
+        long nalloc;                            // RECORDS SINCE arenabegin()
+        size_t top;                             // MOST BYTES IN USE
+        arena() {h=a=(chunk*)0; p=e=(char*)0; nalloc=0L; top=0;}
+};
+
+struct freerec {freerec *n;};
+
+static thread_local arena *rayarena;            // SET WHILE TRACING
+static thread_local arena threadarena;          // KEPT FOR THE NEXT FRAME
+static freerec *pool[POOLED/ALIGN+1];           // FREE LISTS BY SIZE
+static char *poolp, *poole;                     // FREE PART OF POOL CHUNK
+static size_t pooled_bytes;                     // BYTES OF POOL CHUNKS
+
+static size_t roundup(size_t n) {return (n+ALIGN-1)&~(ALIGN-1);}
+
+static void *mark(void *p, int from) {          // HEADER, AND RECORD AFTER
+        *(int*)p=from;
+        return (char*)p+HEAD;
+}
+
+static size_t inuse(const arena& A) {           // BYTES HANDED OUT
+        size_t n=0;
+        for(chunk *c=A.h; c!=A.a; c=c->n) n+=c->size;
+        return A.a?n+(A.p-((char*)A.a+roundup(sizeof(chunk)))):0;
+}
+
+static void *arenaalloc(arena& A, size_t n) {
+        n=roundup(n);
+        if(!A.p || A.p+n>A.e) {                 // NEXT CHUNK, OR A NEW ONE
+                chunk *c=A.a?A.a->n:A.h;
+                if(c && c->size<n) c=(chunk*)0;
+                if(!c) {
+                        size_t size=n>CHUNK?n:CHUNK;
+                        c=(chunk*)::operator new(sizeof(chunk)+ALIGN+size);
+                        c->size=size;
+                        chunk **l=A.a?&A.a->n:&A.h;     // LINK IN AFTER a
+                        c->n=*l; *l=c;
+                }
+                A.a=c;
+                A.p=(char*)c+roundup(sizeof(chunk)); A.e=A.p+c->size;
+        }
+        void *p=A.p; A.p+=n;
+        A.nalloc++;
+        return p;
+}
+
+void arenabegin() {                             // THIS THREAD STARTS TRACING
+        rayarena=&threadarena;
+        rayarena->nalloc=0L; rayarena->top=0;
+        arenareset();
+}
+
+void arenareset() {                             // DROP THE RECORDS OF A PIXEL
+        arena *A=rayarena;
+        if(!A || !A->h) return;
+        size_t n=inuse(*A);
+        if(n>A->top) A->top=n;
+        A->a=A->h;
+        A->p=(char*)A->h+roundup(sizeof(chunk)); A->e=A->p+A->h->size;
+}
+
+void arenaend(long *nalloc, size_t *top) {      // THIS THREAD HAS FINISHED
+        arenareset();
+        if(nalloc) *nalloc=threadarena.nalloc;
+        if(top) *top=threadarena.top;
+        rayarena=(arena*)0;
+}
+
+void* pooled::operator new(size_t n) {
+        n+=HEAD;
+        if(!usearena || (!rayarena && n>POOLED))
+                return mark(::operator new(n), FROMSYSTEM);
+        if(rayarena)
+                return mark(arenaalloc(*rayarena, n), FROMARENA);
+        size_t k=roundup(n)/ALIGN;
+        void *p;
+#pragma omp critical(pools)
+        {
+        if(pool[k]) {                           // REUSE A FREED ONE
+                freerec *r=pool[k]; pool[k]=r->n;
+                p=r;
+        } else {
+                n=k*ALIGN;
+                if(!poolp || poolp+n>poole) {   // REST OF CHUNK IS LOST
+                        poolp=(char*)::operator new(CHUNK);
+                        poole=poolp+CHUNK;
+                        pooled_bytes+=CHUNK;
+                }
+                p=poolp; poolp+=n;
+        }
+        }
+        return mark(p, FROMPOOL);
+}
+
+void pooled::operator delete(void *p, size_t n) {
+        if(!p) return;
+        p=(char*)p-HEAD;
+        switch(*(int*)p) {
+        case FROMARENA: return;                 // GOES WITH ITS ARENA
+        case FROMSYSTEM: ::operator delete(p); return;
+        }
+        size_t k=roundup(n+HEAD)/ALIGN;
+        freerec *r=(freerec*)p;
+#pragma omp critical(pools)
+        {r->n=pool[k]; pool[k]=r;}
+}
+
+size_t poolbytes() {return pooled_bytes;}
+
+//      INSTRUMENTATION
+
+// Compiled with -DCOUNTMEM every call of the global new and delete is
+// counted, with the bytes in use and the most bytes in use, so that the
+// allocations of a frame can be seen.
+
+#ifdef COUNTMEM
+static long ncalls=0L;                          // CALLS OF new
+static long nbytes=0L;                          // BYTES IN USE
+static long npeak=0L;                           // MOST BYTES IN USE
+static long ntotal=0L;                          // BYTES ASKED FOR
+
+void *operator new(size_t size) {
+        void *p=malloc(size+ALIGN);
+        if(!p) throw std::bad_alloc();
+        *(size_t*)p=size;
+#pragma omp critical(countmem)
+        {
+                ncalls++; ntotal+=size; nbytes+=size;
+                if(nbytes>npeak) npeak=nbytes;
+        }
+        return (char*)p+ALIGN;
+}
+
+void operator delete(void *p) throw() {
+        if(!p) return;
+        p=(char*)p-ALIGN;
+#pragma omp critical(countmem)
+        nbytes-=*(size_t*)p;
+        free(p);
+}
+#endif
+
+void memstart() {                               // START OF A FRAME
+#ifdef COUNTMEM
+        ncalls=0L; ntotal=0L; npeak=nbytes;
+#endif
+}
+
+void memreport(const char *what) {              // END OF A FRAME
+#ifdef COUNTMEM
+        fprintf(stderr, "%s: %ld calls of new, %ld bytes, "
+                "%ld bytes in use at most\n", what, ncalls, ntotal, npeak);
+#else
+        (void)what;
+#endif
+}
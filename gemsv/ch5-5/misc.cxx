@@ -31,4 +31,4 @@ std::ostream& operator<<(std::ostream& o, intensity& i) {
 }
 std::ostream& operator<<(std::ostream& o, object& p) {p.out(o); return o;}
 
-vector norm(vector& v) {return v*(1./sqrt(v%v));}
+vector norm(const vector& v) {return v*(1./sqrt(v%v));}
@@ -3,6 +3,9 @@
 #include <vector>
 #include "global.h"
 #include "voronoi.h"                            // D-DIM. VORONOI TEMPLATE
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 struct cell : public VECTOR<3> {                // 3-DIMENSIONAL VORONOI-CELL
         vector p;                               // POSITION OF PARTICLE
@@ -17,7 +20,8 @@ struct cell : public VECTOR<3> {                // 3-DIMENSIONAL VORONOI-CELL
                 *((VECTOR<3>*)this)=VECTOR<3>(x); p=v; {if(o)lh+=o;} t=0L;
         }
         int operator&(const vector& p) {              // CELL CONTAINS POINT p
-                for(cell*n=ln.first();n;n=ln.next())
+                listelem<cell*> *c;                     // MAY RUN IN PARALLEL
+                for(cell*n=ln.first(c);n;n=ln.next(c))
                         if(!(halfspace(this->p,n->p)&p)) return 0;
                 return 1;
         }
@@ -55,6 +59,22 @@ static int lexcmp(const void *v1, const void *v2) {
         return 0;
 }
 
+static int nthreads() {                         // THREADS THAT MAY TRACE
+#ifdef _OPENMP
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+}
+
+static int thread() {                           // THREAD TRACING NOW
+#ifdef _OPENMP
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+}
+
 //      METHODS OF class voronoi
 
 void voronoi::disperse(object *o, cell *C) {
@@ -142,43 +162,45 @@ void voronoi::preprocess(list<object*> *lo) {           // PREPROCESSING
                         {ddmin=dd;this->C=c;}
                 first=0;
         }
-        n=1<<(lmax+1);
-        s=new cell*[n]; for(auto i=0;i<n;i++) s[i]=this->C;  // START FOR firstlist
+        ns=1<<(lmax+1); n=ns*nthreads();                // EACH THREAD KEEPS
+        s=new cell*[n]; for(auto i=0;i<n;i++) s[i]=this->C;  // ITS OWN STARTS
         delete lv; // ???
 }
 
-void voronoi::step() {                                  // ONE STEP ALONG RAY r
+void voronoi::step(walk& w) {                           // ONE STEP ALONG RAY w.r
         double tmin=0.; cell* nmin=(cell*)0;            // INITIALIZE SEARCH
-        for(cell*n=a->ln.first(); n; n=a->ln.next()) {  // NEIGHBORING CELLS
-                vector u=n->p-a->p;                     // NORMAL OF BISECTOR
-                double d=r->d%u;                        // DENOMINATOR
+        listelem<cell*> *c;
+        for(cell*n=w.a->ln.first(c); n; n=w.a->ln.next(c)) { // NEIGHBORING CELLS
+                vector u=n->p-w.a->p;                   // NORMAL OF BISECTOR
+                double d=w.r->d%u;                      // DENOMINATOR
                 if(fabs(d)<EPS) continue;               // PARALLEL FACE
-                vector v=(n->p+a->p)*.5-r->o;
+                vector v=(n->p+w.a->p)*.5-w.r->o;
                 double t=(v%u)/d;                       // t AT INTERSECTION
-                if(t<=this->t) continue;                // WOULD BE A BACK STEP
+                if(t<=w.t) continue;                    // WOULD BE A BACK STEP
             if(t<EPS) {                               // r->o ON BISECTOR PL.
-                        if(u%r->d>0.) {tmin=EPS; nmin=n; continue;}
+                        if(u%w.r->d>0.) {tmin=EPS; nmin=n; continue;}
                         else continue;
             }
                 if(!tmin || t<tmin) {tmin=t; nmin=n;}   // CLOSER INTERSECTION
         }
-        this->t=tmin; a=nmin;
+        w.t=tmin; w.a=nmin;
 }
 
-list<object*>* voronoi::firstlist(const ray& r) {
+list<object*>* voronoi::firstlist(const ray& r, walk& w) {
         int i=r.c>=0?r.c:(1<<(lmax+1))-1;      // INDEX INTO s
-        a=s[i];                                         // INITIALIZE step()
-        if(!((*a)&r.o)) {                               // COHERENCE FAILED
-                ray R(a->p,norm(r.o-a->p),0,0);         // PATH OF WALK
-                this->r=&R; t=0.;                       // INITIALIZE step()
-                for(step(); a; step())                  // WALK
-                        if((*a)&r.o) {s[i]=a; break;}   // SUCCESS
+        cell **s=this->s+ns*thread();                   // THIS THREAD'S STARTS
+        w.a=s[i];                                       // INITIALIZE step()
+        if(!((*w.a)&r.o)) {                             // COHERENCE FAILED
+                ray R(w.a->p,norm(r.o-w.a->p),0,0);     // PATH OF WALK
+                w.r=&R; w.t=0.;                         // INITIALIZE step()
+                for(step(w); w.a; step(w))              // WALK
+                        if((*w.a)&r.o) {s[i]=w.a; break;} // SUCCESS
         }
-        this->r=&r; t=0.;                               // INITIALIZE step()
-        return a?&a->lo:(list<object*>*)0;
+        w.r=&r; w.t=0.;                                 // INITIALIZE step()
+        return w.a?&w.a->lo:(list<object*>*)0;
 }
 
-list<object*>* voronoi::nextlist() {
-        step();                                         // ONE STEP
-        return a?&a->lo:(list<object*>*)0;              // SUCCESS OR FAIL
+list<object*>* voronoi::nextlist(walk& w) {
+        step(w);                                        // ONE STEP
+        return w.a?&w.a->lo:(list<object*>*)0;          // SUCCESS OR FAIL
 }
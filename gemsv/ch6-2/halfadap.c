@@ -3,10 +3,14 @@
  * selective precipitation                                                  *
  *                                                                          *
  * Limitation:                                                              *
- * Only process image with size 2^n x 2^n where n is positive integer.      *
+ * spacefilterwindow() only process image with size 2^n x 2^n where n is    *
+ * positive integer. spacefilter() takes any size, see below.               *
  *==========================================================================*/
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 unsigned char **path;	   /* space filling curve path */
 /*
@@ -134,6 +138,7 @@ void spacefilterwindow(int **picture, int **out, int maxclustersize,
          ||(convolution <= 0  && lastconvolution >=0 
             && labs(convolution-lastconvolution)>thresh)) 
         edge=TRUE; /* force output dots */
+      lastconvolution = convolution;
     }    
 
     /* Output dots if necessary */
@@ -146,6 +151,8 @@ void spacefilterwindow(int **picture, int **out, int maxclustersize,
       if (do_sp) /* switch on/off selective precipitation */
       {
         windowlen = accumulator/BLACK;
+        if (windowlen > currclustersize)  /* the carry may add one dot */
+          windowlen = currclustersize;
         winsum = 0;
         for (i=0; i<windowlen; i++)
           winsum += cluster[i];
@@ -188,3 +195,289 @@ void spacefilterwindow(int **picture, int **out, int maxclustersize,
   } /* while */
   free(cluster);
 }
+
+
+/*==========================================================================*
+ * The same halftoning for any image size, without path[] and on several   *
+ * processors.                                                              *
+ *                                                                          *
+ * The curve is a Hilbert curve computed as we go: curvepoint() turns a    *
+ * distance along the curve into a pixel. Its squares are the smallest     *
+ * power of two covering the short side of the image, put one after the    *
+ * other along the long side; cells out of the image are skipped.          *
+ *                                                                          *
+ * The curve is cut in segments of seglen cells, which go to the threads.  *
+ * To hide the seams, a segment starts SEAMCLUSTERS clusters before its    *
+ * first cell without writing, so that it gets there carrying about the   *
+ * gray the segment before would have carried; there it breaks the        *
+ * cluster. The filter always sees the pixels across the seams.            *
+ *==========================================================================*/
+#define SEAMCLUSTERS 8
+
+typedef struct {
+  int width, height;   /* image */
+  int order;           /* squares are 2^order cells on a side */
+  int across;          /* squares follow each other along x */
+  long total;          /* cells in all the squares */
+} Curve;
+
+typedef struct {
+  int v, x, y;         /* gray value and place of a pixel */
+  long d;              /* distance along the curve, -1 past the end */
+} CurvePixel;
+
+static void initcurve(Curve *c, int width, int height)
+{
+  int shortside = width < height ? width : height;
+  int longside = width < height ? height : width;
+  long side;
+
+  c->width = width;
+  c->height = height;
+  for (c->order=0; (1L << c->order) < shortside; c->order++)
+    ;
+  side = 1L << c->order;
+  c->across = width >= height;
+  c->total = (longside + side - 1) / side * side * side;
+}
+
+/*
+ * Pixel at distance d along the curve; returns FALSE if it is out of
+ * the image.
+ */
+static int curvepoint(Curve *c, long d, int *x, int *y)
+{
+  long t = d & ((1L << 2*c->order) - 1);
+  long base = (d >> 2*c->order) << c->order;
+  int s, rx, ry, tmp;
+
+  *x = *y = 0;
+  for (s=1; s < (1 << c->order); s*=2)
+  {
+    rx = 1 & (int)(t/2);
+    ry = 1 & (int)(t ^ rx);
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {  *x = s-1 - *x;  *y = s-1 - *y;  }
+      tmp = *x;  *x = *y;  *y = tmp;
+    }
+    *x += s*rx;
+    *y += s*ry;
+    t /= 4;
+  }
+  if (c->across)
+    *x += (int)base;
+  else
+  {  tmp = *x;  *x = *y;  *y = tmp + (int)base;  }
+  return *x < c->width && *y < c->height;
+}
+
+/*
+ * Next pixel of the image from distance *d on. Past the end of the
+ * curve it gives the last pixel again, with d = -1. Out of the image,
+ * the curve fills whole quarters, halves... of the padding, which are
+ * skipped at once.
+ */
+#define outside(c,x,y,j)  (((x) >> (j) << (j)) >= (c)->width ||        \
+                           ((y) >> (j) << (j)) >= (c)->height)
+
+static void nextpixel(Curve *c, int **picture, long *d, CurvePixel *last,
+                      CurvePixel *p)
+{
+  int x, y, j;
+
+  while (*d < c->total)
+  {
+    if (curvepoint(c, *d, &x, &y))
+    {
+      p->v = picture[x][y];
+      p->x = x;
+      p->y = y;
+      p->d = (*d)++;
+      return;
+    }
+    for (j=0; j < c->order && outside(c, x, y, j+1); j++)
+      ;
+    *d = (*d >> 2*j << 2*j) + (1L << 2*j);
+  }
+  *p = *last;
+  p->d = -1;
+}
+
+/*
+ * Halftone the cells start to end-1 of the curve, going along it from
+ * cell from; as spacefilterwindow() but for the seams. cluster[] holds
+ * maxclustersize pixels.
+ */
+static void spacefiltersegment(int **picture, int **out, Curve *c,
+                               long start, long end, long from,
+                               CurvePixel *cluster, int maxclustersize,
+                               int thresh, char do_sp, char do_ac)
+{
+  char edge;             /* Flag indicate sudden change detected */
+  char ending;           /* flag indicates end of the segment */
+  char started;          /* cluster broken at start */
+  int accumulator;       /* Accumulate gray value */
+  int currclustersize;   /* Record size of current cluster */
+  int windowlen;         /* Size of the moving window */
+  int winsum;            /* Current moving window's sum */
+  int maxsum;            /* Maximum moving window's sum recorded */
+  int rightplace;        /* Position of the moving window with max sum */
+  CurvePixel window[7];  /* Pixels under the filter, current is window[3] */
+  CurvePixel none;
+  long d = from;         /* Next distance along the curve */
+  int last, i, dot;      /* temp variables */
+  long filter[7] = {-1, -5, 0, 13, 0, -5, -1};  /* 1D -ve Lap. Gauss. filter */
+  long convolution;      /* Convolution value in this turn */
+  long lastconvolution;  /* Convolution value in last turn */
+
+  none.v = none.x = none.y = 0;
+  for (i=0 ; i<7 ; i++)
+    nextpixel(c, picture, &d, i ? &window[i-1] : &none, &window[i]);
+  if (window[0].d < 0)
+    return;              /* nothing there */
+
+  convolution=0;
+  currclustersize=0;
+  accumulator=0;
+  for (i=0 ; i<7 ; i++)
+  {
+    if (i<3 && window[i].d >= 0)
+    {
+      cluster[currclustersize] = window[i];
+      accumulator += window[i].v;
+      currclustersize++;
+    }
+    convolution += filter[i]*(long)window[i].v;
+  }
+  lastconvolution = convolution;
+  edge=FALSE;
+  ending=(window[3].d < 0 || window[3].d >= end);
+  started=(from == start);
+
+  while (TRUE)
+  {
+    if (do_ac) /* switch on/off adaptive clustering */
+    {
+      /* do convolution */
+      convolution = 0;
+      for (i=0 ; i<7 ; i++)
+        convolution += filter[i]*window[i].v;
+
+      /* detect sudden change */
+      if ( (convolution >= 0 && lastconvolution <=0 
+            && labs(convolution-lastconvolution)>thresh)
+         ||(convolution <= 0  && lastconvolution >=0 
+            && labs(convolution-lastconvolution)>thresh)) 
+        edge=TRUE; /* force output dots */
+      lastconvolution = convolution;
+    }    
+    if (!started && window[3].d >= start)
+    {
+      edge=TRUE; /* the cluster before is the segment before's */
+      started=TRUE;
+    }
+
+    /* Output dots if necessary */
+    if (edge || currclustersize >= maxclustersize || ending)
+    {
+      edge=FALSE;
+      
+      /* Search the best position within cluster to precipitate */
+      rightplace = 0;
+      if (do_sp) /* switch on/off selective precipitation */
+      {
+        windowlen = accumulator/BLACK;
+        if (windowlen > currclustersize)  /* the carry may add one dot */
+          windowlen = currclustersize;
+        winsum = 0;
+        for (i=0; i<windowlen; i++)
+          winsum += cluster[i].v;
+        for (maxsum=winsum, last=0; i<currclustersize; i++, last++)
+        {
+          winsum+= cluster[i].v - cluster[last].v;
+          if (winsum > maxsum)
+          {
+            rightplace=last+1;
+            maxsum=winsum;
+          }
+        }
+      }
+
+      /* Output dots, in this segment only */
+      for (i=0 ; i<currclustersize ; i++)
+      {
+        if (accumulator>=BLACK && i>=rightplace)  /* precipitates */
+        {
+          dot=BLACK;
+          accumulator-=BLACK;
+        }
+        else
+          dot=WHITE;
+        if (cluster[i].d >= start && cluster[i].d < end)
+          out[cluster[i].x][cluster[i].y]=dot;
+      } /* for */
+      currclustersize=0;
+
+      if (ending)
+        break;
+    } /* if */
+
+    cluster[currclustersize] = window[3];
+    accumulator += window[3].v;
+    currclustersize++;
+    if (window[4].d < 0 || window[4].d >= end)
+      ending = TRUE;
+    for (i=0 ; i<6 ; i++)
+      window[i] = window[i+1];
+    nextpixel(c, picture, &d, &window[5], &window[6]);
+  } /* while */
+}
+
+/*
+ * Description of parameters:
+ *   picture, out,    As spacefilterwindow(), picture[x][y] with
+ *                    0 <= x < width and 0 <= y < height.
+ *   maxclustersize, thresh, do_sp, do_ac, as spacefilterwindow().
+ *   seglen,          Cells of the curve in a segment. To go along the
+ *                    whole curve at once, as spacefilterwindow() does,
+ *                    set seglen = 0. The dots do not depend on the
+ *                    number of threads.
+ */
+void spacefilter(int **picture, int **out, int width, int height,
+                 int maxclustersize, int thresh, char do_sp, char do_ac,
+                 long seglen)
+{
+  Curve c;
+  long nseg, seam;
+
+  if (width < 1 || height < 1 || maxclustersize < 1)
+    return;
+  initcurve(&c, width, height);
+  if (seglen <= 0 || seglen > c.total)
+    seglen = c.total;
+  nseg = (c.total + seglen - 1) / seglen;
+  seam = (long)SEAMCLUSTERS * maxclustersize;
+
+#pragma omp parallel
+  {
+    CurvePixel *cluster;   /* one cluster a thread */
+    long k, start, end;
+
+    if ((cluster=(CurvePixel*)malloc(sizeof(CurvePixel)*maxclustersize))
+        ==NULL)
+      fprintf(stderr,"not enough memory for cluster\n");
+#pragma omp for schedule(dynamic)
+    for (k=0 ; k<nseg ; k++)
+    {
+      start = k*seglen;
+      end = start + seglen < c.total ? start + seglen : c.total;
+      if (cluster != NULL)
+        spacefiltersegment(picture, out, &c, start, end,
+                           start > seam ? start - seam : 0,
+                           cluster, maxclustersize, thresh, do_sp, do_ac);
+    }
+    free(cluster);
+  }
+}
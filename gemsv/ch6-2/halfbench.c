@@ -0,0 +1,269 @@
+/*
+ * halfbench.c - check and time spacefilter() against spacefilterwindow().
+ *
+ * Makes a picture of gradients and noise, halftones it with
+ * spacefilterwindow() along a path[] of the Hilbert curve made by
+ * genspacefill() below, and with spacefilter() along the whole curve,
+ * checking that the dots are the same. Then halftones it with
+ * spacefilter() in segments, and pictures of other sizes, checking
+ * how far the mean gray of the dots is from the picture. Speeds are
+ * in megapixels a second; memory is what each one needs besides the
+ * picture and the dots. The segments must give the same dots on one
+ * thread as on several.
+ *
+ * usage: halfbench [size [width height [repetitions [seglen]]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define LEFT    0
+#define RIGHT   1
+#define UP      2
+#define DOWN    3
+#define END     255
+
+extern unsigned char **path;
+void spacefilterwindow(int **, int **, int, int, char, char);
+void spacefilter(int **, int **, int, int, int, int, char, char, long);
+
+typedef struct {        /* a cluster entry, as in halfadap.c */
+  int v, x, y;
+  long d;
+} CurvePixel;
+
+static int pathsize;    /* path[] is pathsize x pathsize */
+
+/*
+ * path[] along the Hilbert curve of spacefilter(), for a 2^n x 2^n
+ * picture.
+ */
+int genspacefill()
+{
+  long d, n = (long)pathsize * pathsize;
+  int s, rx, ry, tmp, x, y, px = 0, py = 0;
+
+  for (d=0 ; d<n ; d++)
+  {
+    long t = d;
+
+    x = y = 0;
+    for (s=1 ; s<pathsize ; s*=2)
+    {
+      rx = 1 & (int)(t/2);
+      ry = 1 & (int)(t ^ rx);
+      if (ry == 0)
+      {
+        if (rx == 1)
+        {  x = s-1 - x;  y = s-1 - y;  }
+        tmp = x;  x = y;  y = tmp;
+      }
+      x += s*rx;
+      y += s*ry;
+      t /= 4;
+    }
+    if (d > 0)
+      path[px][py] = x > px ? RIGHT : x < px ? LEFT : y > py ? UP : DOWN;
+    px = x;
+    py = y;
+  }
+  path[px][py] = END;
+  return 0;
+}
+
+static double seconds()
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static void report(char *what, double mp, double t, double kb, int same)
+{
+  printf("%-32s %10.1f MP/s %10.1f KB", what, mp / t, kb);
+  if (same >= 0)
+    printf("  %s", same ? "same" : "DIFFERENT");
+  printf("\n");
+}
+
+static int **makeplane(int width, int height)
+{
+  int **p = (int **)malloc(width * sizeof(int *));
+  int x;
+
+  if (p == NULL)
+    return NULL;
+  for (x=0 ; x<width ; x++)
+    if ((p[x] = (int *)calloc(height, sizeof(int))) == NULL)
+      return NULL;
+  return p;
+}
+
+static void freeplane(int **p, int width)
+{
+  int x;
+
+  for (x=0 ; x<width ; x++)
+    free(p[x]);
+  free(p);
+}
+
+static void makepicture(int **picture, int width, int height)
+{
+  int x, y;
+
+  srand(1);
+  for (x=0 ; x<width ; x++)
+    for (y=0 ; y<height ; y++)
+      if (x < width/2)                          /* gradient */
+        picture[x][y] = 255L * (x + y) / (width/2 + height);
+      else if (y < height/2)                    /* flat gray, sharp edges */
+        picture[x][y] = (x/32 + y/32) & 1 ? 200 : 40;
+      else                                      /* noise */
+        picture[x][y] = rand() & 255;
+}
+
+static int sameplanes(int **a, int **b, int width, int height)
+{
+  int x;
+
+  for (x=0 ; x<width ; x++)
+    if (memcmp(a[x], b[x], height * sizeof(int)))
+      return 0;
+  return 1;
+}
+
+/* mean gray of the dots less that of the picture, in gray levels */
+static double grayerror(int **picture, int **out, int width, int height)
+{
+  double sum = 0;
+  int x, y;
+
+  for (x=0 ; x<width ; x++)
+    for (y=0 ; y<height ; y++)
+      sum += out[x][y] - picture[x][y];
+  return sum / ((double)width * height);
+}
+
+/* halftone width x height with spacefilter() in segments */
+static void timesegments(int width, int height, int maxclustersize,
+                         int thresh, int reps, long seglen)
+{
+  int **picture = makeplane(width, height);
+  int **out = makeplane(width, height);
+  int **out2 = makeplane(width, height);
+  double mp = (double)width * height / 1e6, t;
+  double kb = (double)sizeof(CurvePixel) * maxclustersize / 1e3;
+  char what[40];
+  int i, threads = 1;
+
+  if (picture == NULL || out == NULL || out2 == NULL)
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  makepicture(picture, width, height);
+  t = seconds();
+  for (i=0 ; i<reps ; i++)
+    spacefilter(picture, out, width, height, maxclustersize, thresh,
+                1, 1, 0);
+  sprintf(what, "%dx%d, whole curve", width, height);
+  report(what, mp * reps, seconds() - t, kb, -1);
+  printf("%32s %10.3f\n", "gray error", grayerror(picture, out, width, height));
+  t = seconds();
+  for (i=0 ; i<reps ; i++)
+    spacefilter(picture, out2, width, height, maxclustersize, thresh,
+                1, 1, seglen);
+  sprintf(what, "%dx%d, segments of %ld", width, height, seglen);
+  report(what, mp * reps, seconds() - t, kb * threads, -1);
+  printf("%32s %10.3f\n", "gray error", grayerror(picture, out2, width, height));
+#ifdef _OPENMP
+  omp_set_num_threads(1);
+  spacefilter(picture, out, width, height, maxclustersize, thresh,
+              1, 1, seglen);
+  omp_set_num_threads(threads > 1 ? threads : 4);
+  spacefilter(picture, out2, width, height, maxclustersize, thresh,
+              1, 1, seglen);
+  omp_set_num_threads(threads);
+  sprintf(what, "1 thread against %d", threads > 1 ? threads : 4);
+  printf("%-32s %37s\n", what,
+         sameplanes(out, out2, width, height) ? "same" : "DIFFERENT");
+#endif
+  freeplane(picture, width);
+  freeplane(out, width);
+  freeplane(out2, width);
+}
+
+int main(int argc, char *argv[])
+{
+  int size = argc > 1 ? atoi(argv[1]) : 1024;
+  int width = argc > 3 ? atoi(argv[2]) : 1920;
+  int height = argc > 3 ? atoi(argv[3]) : 1080;
+  int reps = argc > 4 ? atoi(argv[4]) : 3;
+  long seglen = argc > 5 ? atol(argv[5]) : 1L << 16;
+  int maxclustersize = 8, thresh = 200;
+  int **picture, **out, **out2;
+  double mp = (double)size * size / 1e6, t;
+  int x, i;
+
+  if (size < 4 || (size & (size - 1)))
+  {
+    fprintf(stderr, "size must be a power of two, at least 4\n");
+    exit(1);
+  }
+  pathsize = size;
+  picture = makeplane(size, size);
+  out = makeplane(size, size);
+  out2 = makeplane(size, size);
+  path = (unsigned char **)malloc(size * sizeof(unsigned char *));
+  if (picture == NULL || out == NULL || out2 == NULL || path == NULL)
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (x=0 ; x<size ; x++)
+    if ((path[x] = (unsigned char *)malloc(size)) == NULL)
+    {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+  makepicture(picture, size, size);
+  printf("%d x %d picture, clusters of %d, threshold %d, %d repetitions\n",
+         size, size, maxclustersize, thresh, reps);
+
+  t = seconds();
+  for (i=0 ; i<reps ; i++)
+    spacefilterwindow(picture, out, maxclustersize, thresh, 1, 1);
+  report("spacefilterwindow()", mp * reps, seconds() - t,
+         ((double)size * size + size * sizeof(char *)
+          + maxclustersize * sizeof(int)) / 1e3, -1);
+  t = seconds();
+  for (i=0 ; i<reps ; i++)
+    spacefilter(picture, out2, size, size, maxclustersize, thresh, 1, 1, 0);
+  report("spacefilter(), whole curve", mp * reps, seconds() - t,
+         (double)sizeof(CurvePixel) * maxclustersize / 1e3,
+         sameplanes(out, out2, size, size));
+  spacefilterwindow(picture, out, maxclustersize, thresh, 0, 0);
+  spacefilter(picture, out2, size, size, maxclustersize, thresh, 0, 0, 0);
+  printf("%-32s %37s\n", "no clustering or precipitation",
+         sameplanes(out, out2, size, size) ? "same" : "DIFFERENT");
+  printf("%32s %10.3f\n", "gray error", grayerror(picture, out, size, size));
+
+  timesegments(size, size, maxclustersize, thresh, reps, seglen);
+  timesegments(width, height, maxclustersize, thresh, reps, seglen);
+  timesegments(height, width, maxclustersize, thresh, reps, seglen);
+#ifdef _OPENMP
+  printf("%32s %10d\n", "threads", omp_get_max_threads());
+#endif
+  return 0;
+}
@@ -0,0 +1,332 @@
+/* sampler.c: adaptive, stratified sampling of pixels and their
+   reconstruction, see sampler.h.
+
+   Sample positions are a function of the pixel alone (the patterns are
+   made once by SamplerInit() and picked by hashing the pixel), so that a
+   pixel sampled twice, say by two tiles whose filters overlap, gets the
+   same samples both times, and tiles may be done on any thread. */
+
+#include <stdlib.h>
+#include <math.h>
+#include "sampler.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct {		/* Point2 of multi.c */
+    double x, y;
+} MJPoint;
+
+typedef float sample[2];	/* of sampat.c */
+
+extern void MultiJitter(MJPoint p[], int m, int n);
+extern void Jitter1(int x, int y, int s, double *xj, double *yj);
+extern void JitterInit();
+extern sample foursamples[3][4], sixteensamples[3][16];
+
+typedef struct {
+    double x, y, c[3];
+} Sample;
+
+/* random numbers for JitterInit() */
+double xranf()
+{
+    return (double)rand() / ((double)RAND_MAX + 1.);
+}
+
+/*
+ *	filters of filter_rcg.c
+ */
+
+static double hermite_filter(double t)
+{
+    /* f(t) = 2|t|^3 - 3|t|^2 + 1, -1 <= t <= 1 */
+    if (t < 0.0) t = -t;
+    if (t < 1.0) return (2.0 * t - 3.0) * t * t + 1.0;
+    return 0.0;
+}
+
+static double box_filter(double t)
+{
+    if ((t > -0.5) && (t <= 0.5)) return 1.0;
+    return 0.0;
+}
+
+static double triangle_filter(double t)
+{
+    if (t < 0.0) t = -t;
+    if (t < 1.0) return 1.0 - t;
+    return 0.0;
+}
+
+static double bell_filter(double t)	/* box (*) box (*) box */
+{
+    if (t < 0) t = -t;
+    if (t < .5) return .75 - (t * t);
+    if (t < 1.5) {
+	t = (t - 1.5);
+	return .5 * (t * t);
+    }
+    return 0.0;
+}
+
+static double B_spline_filter(double t)	/* box (*) box (*) box (*) box */
+{
+    double tt;
+
+    if (t < 0) t = -t;
+    if (t < 1) {
+	tt = t * t;
+	return (.5 * tt * t) - tt + (2.0 / 3.0);
+    } else if (t < 2) {
+	t = 2 - t;
+	return (1.0 / 6.0) * (t * t * t);
+    }
+    return 0.0;
+}
+
+static double sinc(double x)
+{
+    x *= M_PI;
+    if (x != 0) return sin(x) / x;
+    return 1.0;
+}
+
+static double Lanczos3_filter(double t)
+{
+    if (t < 0) t = -t;
+    if (t < 3.0) return sinc(t) * sinc(t/3.0);
+    return 0.0;
+}
+
+#define	B	(1.0 / 3.0)
+#define	C	(1.0 / 3.0)
+
+static double Mitchell_filter(double t)
+{
+    double tt;
+
+    tt = t * t;
+    if (t < 0) t = -t;
+    if (t < 1.0) {
+	t = (((12.0 - 9.0 * B - 6.0 * C) * (t * tt))
+	   + ((-18.0 + 12.0 * B + 6.0 * C) * tt)
+	   + (6.0 - 2 * B));
+	return t / 6.0;
+    } else if (t < 2.0) {
+	t = (((-1.0 * B - 6.0 * C) * (t * tt))
+	   + ((6.0 * B + 30.0 * C) * tt)
+	   + ((-12.0 * B - 48.0 * C) * t)
+	   + (8.0 * B + 24 * C));
+	return t / 6.0;
+    }
+    return 0.0;
+}
+
+static const struct {
+    double (*kernel)(double);
+    double support;
+} filters[] = {
+    {box_filter, 0.5}, {triangle_filter, 1.0}, {hermite_filter, 1.0},
+    {bell_filter, 1.5}, {B_spline_filter, 2.0}, {Mitchell_filter, 2.0},
+    {Lanczos3_filter, 3.0}
+};
+
+/*
+ *	patterns
+ */
+
+/* columns of an m x n grid of k cells, as square as k allows */
+static int columns(int k)
+{
+    int m = (int)sqrt((double)k);
+
+    while (m > 1 && k % m) m--;
+    return m;
+}
+
+/* npat patterns of k samples into p */
+static int makepatterns(Sampler *s, float *p, int k)
+{
+    MJPoint q[SAMPLER_MAX];
+    int i, j;
+
+    if (k == 0) return 1;
+    switch (s->pattern) {
+    case SAMPLE_CENTER:
+	p[0] = p[1] = .5f;
+	return 1;
+    case SAMPLE_MULTIJITTER:
+	for (i = 0; i < s->npat; i++) {
+	    MultiJitter(q, columns(k), k / columns(k));
+	    for (j = 0; j < k; j++) {
+		*p++ = (float)q[j].x;
+		*p++ = (float)q[j].y;
+	    }
+	}
+	return 1;
+    case SAMPLE_EDGE:
+	if (k != 4 && k != 16) return 0;
+	for (i = 0; i < s->npat; i++)
+	    for (j = 0; j < k; j++) {
+		*p++ = k == 4 ? foursamples[i][j][0] : sixteensamples[i][j][0];
+		*p++ = k == 4 ? foursamples[i][j][1] : sixteensamples[i][j][1];
+	    }
+	return 1;
+    }
+    return 1;			/* SAMPLE_JITTER: looked up as needed */
+}
+
+int SamplerInit(Sampler *s, int pattern, int first, int more,
+		double contrast, int filter, int xres, int yres)
+{
+    static int jitterinit = 0;
+
+    s->pfirst = s->pmore = 0;
+    if (pattern < SAMPLE_CENTER || pattern > SAMPLE_EDGE ||
+	filter < FILTER_BOX || filter > FILTER_LANCZOS3)
+	return 0;
+    if (pattern == SAMPLE_CENTER)
+	first = 1, more = 0;
+    if (first < 1 || more < 0 || first + more > SAMPLER_MAX)
+	return 0;
+    s->pattern = pattern;
+    s->filter = filter;
+    s->first = first;
+    s->more = more;
+    s->contrast = contrast;
+    s->xres = xres;
+    s->yres = yres;
+    s->kernel = filters[filter].kernel;
+    s->support = filters[filter].support;
+    s->npat = pattern == SAMPLE_CENTER ? 1 :
+	      pattern == SAMPLE_EDGE ? 3 :
+	      pattern == SAMPLE_JITTER ? 0 : SAMPLER_NPAT;
+    if (pattern == SAMPLE_JITTER && !jitterinit) {
+	JitterInit();
+	jitterinit = 1;
+    }
+    s->pfirst = (float *)malloc((s->npat * first + 1) * 2 * sizeof(float));
+    s->pmore = (float *)malloc((s->npat * more + 1) * 2 * sizeof(float));
+    if (!s->pfirst || !s->pmore ||
+	!makepatterns(s, s->pfirst, first) ||
+	!makepatterns(s, s->pmore, more)) {
+	SamplerFree(s);
+	return 0;
+    }
+    return 1;
+}
+
+void SamplerFree(Sampler *s)
+{
+    free(s->pfirst);
+    free(s->pmore);
+    s->pfirst = s->pmore = 0;
+}
+
+/* k samples of pixel x, y from set `set' (0: first, 1: more) into q */
+static void positions(const Sampler *s, int x, int y, int set, int k,
+		      Sample *q)
+{
+    int i;
+
+    if (s->pattern == SAMPLE_JITTER) {
+	int m = columns(k);
+	for (i = 0; i < k; i++) {
+	    double xj, yj;
+	    Jitter1(x, y, set * s->first + i, &xj, &yj);
+	    q[i].x = x + (i % m + xj) / m;
+	    q[i].y = y + (i / m + yj) / (k / m);
+	}
+    } else {
+	unsigned h = ((unsigned)x * 73856093u ^ (unsigned)y * 19349663u)
+		     % (unsigned)s->npat;
+	const float *p = (set ? s->pmore : s->pfirst) + 2 * h * k;
+	for (i = 0; i < k; i++) {
+	    q[i].x = x + p[2*i];
+	    q[i].y = y + p[2*i+1];
+	}
+    }
+}
+
+/* takes the samples of pixel x, y into q and returns how many */
+static int samplepixel(const Sampler *s, int x, int y, SampleFunc f,
+		       void *data, Sample *q)
+{
+    int i, c, n = s->first;
+
+    positions(s, x, y, 0, s->first, q);
+    for (i = 0; i < n; i++)
+	f(q[i].x, q[i].y, q[i].c, data);
+    if (!s->more)
+	return n;
+    for (c = 0; c < 3; c++) {	/* contrast of the first samples */
+	double lo = q[0].c[c], hi = q[0].c[c];
+	for (i = 1; i < n; i++) {
+	    if (q[i].c[c] < lo) lo = q[i].c[c];
+	    if (q[i].c[c] > hi) hi = q[i].c[c];
+	}
+	if (hi + lo > 0. && (hi - lo) / (hi + lo) > s->contrast)
+	    break;
+    }
+    if (c == 3)
+	return n;
+    positions(s, x, y, 1, s->more, q + n);
+    for (i = n; i < n + s->more; i++)
+	f(q[i].x, q[i].y, q[i].c, data);
+    return n + s->more;
+}
+
+/* samples the pixels within reach of the filter of the w x h pixels at
+   x0, y0, and puts their filtered colours into rgb, row by row */
+long SamplerTile(const Sampler *s, int x0, int y0, int w, int h,
+		 SampleFunc f, void *data, float *rgb)
+{
+    Sample q[SAMPLER_MAX];
+    double *acc, r = s->support;
+    int b = s->filter == FILTER_BOX ? 0 : (int)ceil(r - .5);
+    int xa = x0 - b < 0 ? 0 : x0 - b, xb = x0 + w + b > s->xres ? s->xres : x0 + w + b;
+    int ya = y0 - b < 0 ? 0 : y0 - b, yb = y0 + h + b > s->yres ? s->yres : y0 + h + b;
+    int x, y, i, j, k, c, n;
+    long taken = 0L;
+
+    acc = (double *)calloc((size_t)w * h * 4, sizeof(double));
+    if (!acc)
+	return 0L;
+    for (y = ya; y < yb; y++)
+	for (x = xa; x < xb; x++) {
+	    n = samplepixel(s, x, y, f, data, q);
+	    taken += n;
+	    for (k = 0; k < n; k++) {
+		int ia, ib, ja, jb;
+		if (!b) {	/* box: only its own pixel */
+		    double *a = acc + 4 * ((y - y0) * w + (x - x0));
+		    for (c = 0; c < 3; c++) a[c] += q[k].c[c];
+		    a[3] += 1.;
+		    continue;
+		}
+		ia = (int)floor(q[k].x - .5 - r); if (ia < x0) ia = x0;
+		ib = (int)ceil(q[k].x - .5 + r); if (ib > x0 + w - 1) ib = x0 + w - 1;
+		ja = (int)floor(q[k].y - .5 - r); if (ja < y0) ja = y0;
+		jb = (int)ceil(q[k].y - .5 + r); if (jb > y0 + h - 1) jb = y0 + h - 1;
+		for (j = ja; j <= jb; j++) {
+		    double wy = s->kernel(q[k].y - (j + .5));
+		    if (wy == 0.) continue;
+		    for (i = ia; i <= ib; i++) {
+			double wt = wy * s->kernel(q[k].x - (i + .5));
+			double *a = acc + 4 * ((j - y0) * w + (i - x0));
+			for (c = 0; c < 3; c++) a[c] += wt * q[k].c[c];
+			a[3] += wt;
+		    }
+		}
+	    }
+	}
+    for (k = 0; k < w * h; k++)
+	for (c = 0; c < 3; c++) {
+	    double v = acc[4*k+3] > 0. ? acc[4*k+c] / acc[4*k+3] : 0.;
+	    rgb[3*k+c] = v > 0. ? (float)v : 0.f;
+	}
+    free(acc);
+    return taken;
+}
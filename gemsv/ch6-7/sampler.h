@@ -0,0 +1,63 @@
+/* sampler.h: adaptive, stratified sampling of pixels and their
+   reconstruction with the filters of Graphics Gems III ``General
+   Filtered Image Rescaling''.
+
+   A renderer hands SamplerTile() a function giving the colour seen at a
+   point of the image plane.  Every pixel gets `first' samples; those
+   whose samples differ in contrast by more than `contrast' in any channel
+   get `more' samples besides.  The sample positions come from one of the
+   generators of the books, and the pixel values are the samples weighted
+   by a filter centered on each pixel. */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {				/* sample positions */
+    SAMPLE_CENTER,		/* one sample at the center of a pixel */
+    SAMPLE_JITTER,		/* jittered grid, Gems ``FastJitter'' tables */
+    SAMPLE_MULTIJITTER,		/* Gems IV ``Multi-Jittered Sampling'' */
+    SAMPLE_EDGE			/* Gems V patterns optimized for edges, 4 or 16 */
+};
+
+enum {				/* reconstruction filters, by support */
+    FILTER_BOX,			/* 0.5 */
+    FILTER_TRIANGLE,		/* 1 */
+    FILTER_HERMITE,		/* 1 */
+    FILTER_BELL,		/* 1.5 */
+    FILTER_BSPLINE,		/* 2 */
+    FILTER_MITCHELL,		/* 2 */
+    FILTER_LANCZOS3		/* 3 */
+};
+
+#define SAMPLER_MAX	256	/* most samples in a pixel */
+#define SAMPLER_NPAT	64	/* patterns of each size kept */
+
+/* colour at x, y in pixels; pixel i, j covers [i,i+1) x [j,j+1) */
+typedef void (*SampleFunc)(double x, double y, double rgb[3], void *data);
+
+typedef struct {
+    int pattern, filter;	/* SAMPLE_ and FILTER_ above */
+    int first, more;		/* samples of every pixel, extra ones */
+    double contrast;		/* threshold for the extra samples */
+    int xres, yres;		/* size of the image */
+    double support;		/* of the filter, in pixels */
+    double (*kernel)(double);	/* the filter */
+    int npat;			/* patterns of each size */
+    float *pfirst, *pmore;	/* npat*first, npat*more positions (x,y) */
+} Sampler;
+
+extern int  SamplerInit(Sampler *s, int pattern, int first, int more,
+			double contrast, int filter, int xres, int yres);
+extern void SamplerFree(Sampler *s);
+extern long SamplerTile(const Sampler *s, int x0, int y0, int w, int h,
+			SampleFunc f, void *data, float *rgb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
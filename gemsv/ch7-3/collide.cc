@@ -1,112 +1,138 @@
 // -*- C++ -*-
 // by Bill Bouma and George Vanecek Jr. Aug, 1994.
-// Compile by: g++ -O2 -s -o cull cull.cc algebra3.o -lm
+// Compile by: g++ -O2 -c collide.cc
+// The example program is in cull.cc.
 
-#include <iostream>
-using std::cout;
-using std::endl;
+#include "collide.h"
 
-const float pi = 3.141592f;
-
-#include "../../gemsiv/vec_mat/algebra3.h"           // See Graphics Gems IV, pg534-557
-typedef vec3          Point;    // Points are not Vectors
-typedef vec3          Vector;   // Vectors are not Points
-typedef unsigned int  Index;    // Array Indices
-typedef unsigned int  Counter;
+MovingPolyhedron::MovingPolyhedron ( const char           pId,
+                                     const Vector&        rv,
+                                     const Vector&        vv,
+                                     const Vector&        wv,
+                                     const mat4&          m,
+                                     const Counter        nP,
+                                     const Polygon* const ps )
+: id(pId), polys(ps), nPolys(nP), r(rv), v(vv), w(wv), R(m)
+{
+  Counter nPts = 0;
+  first = new Index[nPolys+1];
+  for( Index gi = 0; gi < nPolys; ++gi ) {
+    first[gi] = nPts;
+    nPts += polys[gi].nPoints();
+  }
+  first[nPolys] = nPts;
 
-class Polygon {
-public:
-  Polygon           ( const char         pId,
-                      const Vector&      nV,
-                      const Counter      nPs,
-                      const Point* const p )
-  : id(pId), nPts(nPs), pts(p), normalVector(nV){ }
-  const Vector& normal( ) const { return normalVector; }
-  char            name( ) const { return id; }
-  Counter      nPoints( ) const { return nPts; }
-  const Point&   point( const Index i ) const { return pts[i]; }
-private:
-  const char          id;            // Unique Id
-  const Counter       nPts;          // pts[0..nPts-1]
-  const Point*  const pts;           // Points around Polygon
-  const Vector        normalVector;  // Unit Vector
-};
+  // Lay the points out by axis so the plane test runs down arrays.
+  x = new double[3*nPts];
+  y = x + nPts;
+  z = y + nPts;
+  for( Index gi = 0; gi < nPolys; ++gi )
+    for( Index pi = 0; pi < polys[gi].nPoints(); ++pi ) {
+      Point p = polys[gi].point(pi);
+      x[first[gi]+pi] = p[VX];
+      y[first[gi]+pi] = p[VY];
+      z[first[gi]+pi] = p[VZ];
+    }
+}
 
-class MovingPolyhedron {
-public:
-  MovingPolyhedron ( const char           pId,
-                     const Vector&        rv,
-                     const Vector&        vv,
-                     const Vector&        wv,
-                     const mat4&          m,
-                     const Counter        nP,
-                     const Polygon* const ps )
-  : id(pId), polys(ps), nPolys(nP), r(rv), v(vv), w(wv), R(m) { }
-  const Polygon&    polygon( const Index i ) const { return polys[i]; }
-  void                 cull( const MovingPolyhedron& ) const;
-private:
-  const char           id;      // Unique Id
-  const Polygon* const polys;   // Points in local coordinates
-  const Counter        nPolys;  // polys[0..nPolys-1]
-  Vector               r;       // Center of Rotation (in world coords.)
-  Vector               v;       // Linear Velocity (in world coords.)
-  Vector               w;       // Angular Velocity (in world coords.)
-  mat4                 R;       // Orientation Matrix
-};
+MovingPolyhedron::~MovingPolyhedron( )
+{
+  delete [] x;
+  delete [] first;
+}
 
-void MovingPolyhedron::cull( const MovingPolyhedron& j ) const
+// Set culled[gi] for each polygon of this polyhedron that cannot be
+// hit by j, and return how many there are.  If witness is given,
+// witness[gi] is the point that last showed polygon gi is not culled
+// (or NoWitness); it is tried first and updated.  hits and tries count
+// the cached points that are tried and that are still witnesses.
+Counter MovingPolyhedron::cull( const MovingPolyhedron& j,
+                                bool                    culled[],
+                                Index                   witness[],
+                                Counter*                hits,
+                                Counter*                tries ) const
 {
   const mat4   RIi = ((mat4&)R).transpose();
-  const Vector aij = RIi * (v - j.v - (w ^ r) + (j.w ^ j.r)); 
+  const Vector aij = RIi * (v - j.v - (w ^ r) + (j.w ^ j.r));
   const Vector wij = RIi * (j.w - w);
+  Counter      nCulled = 0;
   for( Index gi = 0; gi < nPolys; ++gi ) {
-    const Polygon& g = polygon(gi);
-    for( Index pi = 0; pi < g.nPoints(); ++pi )
-      if( ( aij + (g.point(pi) ^ wij )) * g.normal() > 0.0 )
-        break;
-    cout << "Polygon " << g.name() << " of Polyhedron " << id
-         << " is" << ( pi == g.nPoints()  ? " " : " not ")
-         << "culled." << endl;
+    const Vector& n = polys[gi].normal();
+    Vector        d = wij ^ n;
+    const double  c = aij * n;
+    const double  dx = d[VX], dy = d[VY], dz = d[VZ];
+    const double* px = x + first[gi];
+    const double* py = y + first[gi];
+    const double* pz = z + first[gi];
+    const Index   nPts = first[gi+1] - first[gi];
+
+    // An empty polygon has no point in front of the plane.
+    if( nPts == 0 ) {
+      culled[gi] = true;
+      ++nCulled;
+      continue;
+    }
+
+    if( witness && witness[gi] != NoWitness ) {
+      const Index k = witness[gi];
+      if( tries ) ++*tries;
+      if( c + px[k]*dx + py[k]*dy + pz[k]*dz > 0.0 ) {
+        if( hits ) ++*hits;
+        culled[gi] = false;
+        continue;
+      }
+    }
+
+    // Largest value of the plane test over the polygon, with no early
+    // exit so the loop vectorizes.
+    double best = c + px[0]*dx + py[0]*dy + pz[0]*dz;
+    for( Index pi = 1; pi < nPts; ++pi ) {
+      const double t = c + px[pi]*dx + py[pi]*dy + pz[pi]*dz;
+      best = t > best ? t : best;
+    }
+
+    culled[gi] = !(best > 0.0);
+    if( culled[gi] )
+      ++nCulled;
+    else if( witness ) {
+      Index pi = 0;
+      while( !(c + px[pi]*dx + py[pi]*dy + pz[pi]*dz > 0.0) )
+        ++pi;
+      witness[gi] = pi;
+    }
+  }
+  return nCulled;
+}
+
+PolyhedronPair::PolyhedronPair( const MovingPolyhedron& pi,
+                                const MovingPolyhedron& pj )
+: i(pi), j(pj), nCull(0), hits(0), tries(0)
+{
+  isCulled = new bool[i.nPolygons()];
+  witness  = new Index[i.nPolygons()];
+  for( Index gi = 0; gi < i.nPolygons(); ++gi ) {
+    isCulled[gi] = false;
+    witness[gi]  = NoWitness;
   }
 }
 
-const Counter NPolyPoints = 4;
-const Counter NFaces      = 6;
-static const Point leftPoints[NPolyPoints]  = {
-  Point(-1,-1,-1), Point(-1,-1, 1), Point(-1, 1, 1), Point(-1, 1,-1) };
-static const Point rightPoints[NPolyPoints] = {
-  Point( 1,-1,-1), Point( 1, 1,-1), Point( 1, 1, 1), Point( 1,-1, 1) };
-static const Point topPoints[NPolyPoints]   = {
-  Point(-1, 1,-1), Point(-1, 1, 1), Point( 1, 1, 1), Point( 1, 1,-1) };
-static const Point bottomPoints[NPolyPoints]= {
-  Point(-1,-1,-1), Point( 1,-1,-1), Point( 1,-1, 1), Point(-1,-1, 1) };
-static const Point backPoints[NPolyPoints]  = {
-  Point(-1,-1,-1), Point(-1, 1,-1), Point( 1, 1,-1), Point( 1,-1,-1) };
-static const Point frontPoints[NPolyPoints] = {
-  Point(-1,-1, 1), Point( 1,-1, 1), Point( 1, 1, 1), Point(-1, 1, 1) };
-static const Polygon cube[NFaces]= {
-  Polygon( 'a', Vector(-1, 0, 0), NPolyPoints, leftPoints   ),
-  Polygon( 'b', Vector( 1, 0, 0), NPolyPoints, rightPoints  ),
-  Polygon( 'c', Vector( 0, 1, 0), NPolyPoints, topPoints    ),
-  Polygon( 'd', Vector( 0,-1, 0), NPolyPoints, bottomPoints ),
-  Polygon( 'e', Vector( 0, 0,-1), NPolyPoints, backPoints   ),
-  Polygon( 'f', Vector( 0, 0, 1), NPolyPoints, frontPoints  )
-};
+PolyhedronPair::~PolyhedronPair( )
+{
+  delete [] isCulled;
+  delete [] witness;
+}
+
+void PolyhedronPair::cull( )
+{
+  nCull = i.cull( j, isCulled, witness, &hits, &tries );
+}
 
-int main()
+// Cull each pair.  A pair only writes to itself, so the pairs may be
+// done in any order and on any number of threads.
+void cullPairs( PolyhedronPair* const pairs[], const Counter n )
 {
-  MovingPolyhedron A( 'A',
-                      Vector(10,10, 0 ), // Position
-                      Vector( 0, 0, 0 ), // Velocity
-                      Vector( 0, 0, 0 ), // Angular Velocity
-                      identity3D(),
-                      NFaces, cube );
-  MovingPolyhedron B( 'B',
-                      Vector(10,10,10 ), // Position
-                      Vector( 0, 0,-1 ), // Velocity
-                      Vector( 0, 1, 0 ), // Angular Velocity
-                      identity3D(),
-                      NFaces, cube );
-  A.cull( B );
-  B.cull( A );               
+  const int nPairs = (int)n;
+#pragma omp parallel for schedule(dynamic, 64)
+  for( int k = 0; k < nPairs; ++k )
+    pairs[k]->cull();
 }
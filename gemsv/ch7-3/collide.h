@@ -0,0 +1,106 @@
+// -*- C++ -*-
+// by Bill Bouma and George Vanecek Jr. Aug, 1994.
+//
+// Culling of the polygons of a moving polyhedron that cannot be hit
+// by another moving polyhedron, packaged as a library.  A polygon of i
+// can be culled against j if no point of it moves towards j, that is
+// if (aij + p ^ wij) * n <= 0 for all of its points p.  That test is
+// linear in p, so it is done as c + p * d <= 0 with c = aij * n and
+// d = wij ^ n, over points stored as separate x, y, z arrays.
+//
+// A PolyhedronPair keeps, for each polygon, the point that last showed
+// it could not be culled.  From one step to the next that point almost
+// always still does, so it is tried first.  Pairs are independent and
+// cullPairs() shares them out among threads when built with OpenMP.
+
+#ifndef COLLIDE_H
+#define COLLIDE_H
+
+#include "../../gemsiv/vec_mat/algebra3.h"           // See Graphics Gems IV, pg534-557
+typedef vec3          Point;    // Points are not Vectors
+typedef vec3          Vector;   // Vectors are not Points
+typedef unsigned int  Index;    // Array Indices
+typedef unsigned int  Counter;
+
+const Index NoWitness = ~0u;    // No cached point for a polygon
+
+class Polygon {
+public:
+  Polygon           ( const char         pId,
+                      const Vector&      nV,
+                      const Counter      nPs,
+                      const Point* const p )
+  : id(pId), nPts(nPs), pts(p), normalVector(nV){ }
+  const Vector& normal( ) const { return normalVector; }
+  char            name( ) const { return id; }
+  Counter      nPoints( ) const { return nPts; }
+  const Point&   point( const Index i ) const { return pts[i]; }
+private:
+  const char          id;            // Unique Id
+  const Counter       nPts;          // pts[0..nPts-1]
+  const Point*  const pts;           // Points around Polygon
+  const Vector        normalVector;  // Unit Vector
+};
+
+class MovingPolyhedron {
+public:
+  MovingPolyhedron ( const char           pId,
+                     const Vector&        rv,
+                     const Vector&        vv,
+                     const Vector&        wv,
+                     const mat4&          m,
+                     const Counter        nP,
+                     const Polygon* const ps );
+  ~MovingPolyhedron( );
+  const Polygon&    polygon( const Index i ) const { return polys[i]; }
+  Counter         nPolygons( ) const { return nPolys; }
+  char                 name( ) const { return id; }
+  void               moveTo( const Vector& rv, const mat4& m ) { r = rv; R = m; }
+  void          setVelocity( const Vector& vv, const Vector& wv ) { v = vv; w = wv; }
+  Counter              cull( const MovingPolyhedron&,
+                             bool          culled[],
+                             Index         witness[] = 0,
+                             Counter*      hits      = 0,
+                             Counter*      tries     = 0 ) const;
+private:
+  MovingPolyhedron( const MovingPolyhedron& );
+  void           operator=( const MovingPolyhedron& );
+
+  const char           id;      // Unique Id
+  const Polygon* const polys;   // Points in local coordinates
+  const Counter        nPolys;  // polys[0..nPolys-1]
+  Vector               r;       // Center of Rotation (in world coords.)
+  Vector               v;       // Linear Velocity (in world coords.)
+  Vector               w;       // Angular Velocity (in world coords.)
+  mat4                 R;       // Orientation Matrix
+  Index*               first;   // first[gi]..first[gi+1]-1 in x, y, z
+  double*              x;       // Points of all the polygons, by axis
+  double*              y;
+  double*              z;
+};
+
+class PolyhedronPair {
+public:
+  PolyhedronPair( const MovingPolyhedron& pi, const MovingPolyhedron& pj );
+  ~PolyhedronPair( );
+  void                  cull( );
+  bool                culled( const Index gi ) const { return isCulled[gi]; }
+  Counter            nCulled( ) const { return nCull; }
+  Counter          cacheHits( ) const { return hits; }
+  Counter         cacheTries( ) const { return tries; }
+private:
+  PolyhedronPair( const PolyhedronPair& );
+  void           operator=( const PolyhedronPair& );
+
+  const MovingPolyhedron& i;    // Polyhedron whose polygons are culled
+  const MovingPolyhedron& j;    // against this one
+  bool*                isCulled;// Result for each polygon of i
+  Index*               witness; // Cached point of each polygon of i
+  Counter              nCull;   // Polygons culled by the last cull()
+  Counter              hits;    // Cached points that were still witnesses
+  Counter              tries;   // Cached points tried
+};
+
+void cullPairs( PolyhedronPair* const pairs[], const Counter n );
+
+#endif
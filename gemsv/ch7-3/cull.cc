@@ -0,0 +1,147 @@
+// -*- C++ -*-
+// by Bill Bouma and George Vanecek Jr. Aug, 1994.
+// Compile by: g++ -O2 -s -o cull cull.cc collide.o algebra3.o -lm
+//
+// With no arguments, culls the faces of two cubes against each other.
+// Given a number of pairs (and optionally of steps), times cullPairs()
+// on that many pairs of spinning, drifting cubes and reports the time
+// per step and how often the cached points were still witnesses.
+
+#include <iostream>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+using std::cout;
+using std::endl;
+
+const float pi = 3.141592f;
+
+#include "collide.h"
+
+const Counter NPolyPoints = 4;
+const Counter NFaces      = 6;
+static const Point leftPoints[NPolyPoints]  = {
+  Point(-1,-1,-1), Point(-1,-1, 1), Point(-1, 1, 1), Point(-1, 1,-1) };
+static const Point rightPoints[NPolyPoints] = {
+  Point( 1,-1,-1), Point( 1, 1,-1), Point( 1, 1, 1), Point( 1,-1, 1) };
+static const Point topPoints[NPolyPoints]   = {
+  Point(-1, 1,-1), Point(-1, 1, 1), Point( 1, 1, 1), Point( 1, 1,-1) };
+static const Point bottomPoints[NPolyPoints]= {
+  Point(-1,-1,-1), Point( 1,-1,-1), Point( 1,-1, 1), Point(-1,-1, 1) };
+static const Point backPoints[NPolyPoints]  = {
+  Point(-1,-1,-1), Point(-1, 1,-1), Point( 1, 1,-1), Point( 1,-1,-1) };
+static const Point frontPoints[NPolyPoints] = {
+  Point(-1,-1, 1), Point( 1,-1, 1), Point( 1, 1, 1), Point(-1, 1, 1) };
+static const Polygon cube[NFaces]= {
+  Polygon( 'a', Vector(-1, 0, 0), NPolyPoints, leftPoints   ),
+  Polygon( 'b', Vector( 1, 0, 0), NPolyPoints, rightPoints  ),
+  Polygon( 'c', Vector( 0, 1, 0), NPolyPoints, topPoints    ),
+  Polygon( 'd', Vector( 0,-1, 0), NPolyPoints, bottomPoints ),
+  Polygon( 'e', Vector( 0, 0,-1), NPolyPoints, backPoints   ),
+  Polygon( 'f', Vector( 0, 0, 1), NPolyPoints, frontPoints  )
+};
+
+static void report( const MovingPolyhedron& i, const MovingPolyhedron& j )
+{
+  bool culled[NFaces];
+  i.cull( j, culled );
+  for( Index gi = 0; gi < i.nPolygons(); ++gi )
+    cout << "Polygon " << i.polygon(gi).name() << " of Polyhedron "
+         << i.name() << " is" << ( culled[gi] ? " " : " not ")
+         << "culled." << endl;
+}
+
+static double seconds( )
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static double uniform( const double lo, const double hi )
+{
+  return lo + (hi - lo) * rand() / RAND_MAX;
+}
+
+static void bench( const Counter nPairs, const Counter nSteps )
+{
+  const Counter     nPolyhedra = 2 * nPairs;
+  MovingPolyhedron** polyhedra = new MovingPolyhedron*[nPolyhedra];
+  Vector*           starts     = new Vector[nPolyhedra];
+  Vector*           velocities = new Vector[nPolyhedra];
+  Vector*           axes       = new Vector[nPolyhedra];
+  double*           spins      = new double[nPolyhedra];
+  PolyhedronPair**  pairs      = new PolyhedronPair*[nPairs];
+  const double      dt         = 0.01;
+
+  for( Index k = 0; k < nPolyhedra; ++k ) {
+    starts[k]     = Vector( uniform(-10,10), uniform(-10,10), uniform(-10,10) );
+    velocities[k] = Vector( uniform(-1,1), uniform(-1,1), uniform(-1,1) );
+    axes[k]       = Vector( uniform(-1,1), uniform(-1,1), uniform(-1,1) ).normalize();
+    spins[k]      = uniform( -90, 90 );     // degrees per unit time
+    polyhedra[k] = new MovingPolyhedron( 'A' + k % 26, starts[k], velocities[k],
+                     axes[k] * (spins[k] * pi / 180.0),
+                     identity3D(), NFaces, cube );
+  }
+  for( Index k = 0; k < nPairs; ++k )
+    pairs[k] = new PolyhedronPair( *polyhedra[2*k], *polyhedra[2*k+1] );
+
+  double time = 0.0;
+  for( Index s = 0; s < nSteps; ++s ) {
+    const double t = s * dt;
+    for( Index k = 0; k < nPolyhedra; ++k )
+      polyhedra[k]->moveTo( starts[k] + velocities[k] * t,
+                            rotation3D( axes[k], spins[k] * t ) );
+    const double start = seconds();
+    cullPairs( pairs, nPairs );
+    time += seconds() - start;
+  }
+
+  Counter hits = 0, tries = 0;
+  for( Index k = 0; k < nPairs; ++k ) {
+    hits  += pairs[k]->cacheHits();
+    tries += pairs[k]->cacheTries();
+  }
+  cout << nPairs << " pairs: " << 1e3 * time / nSteps << " ms/step, "
+       << 1e9 * time / ((double)nSteps * nPairs) << " ns/pair, cache hit rate "
+       << ( tries ? 100.0 * hits / tries : 0.0 ) << "%" << endl;
+
+  for( Index k = 0; k < nPairs; ++k )
+    delete pairs[k];
+  for( Index k = 0; k < nPolyhedra; ++k )
+    delete polyhedra[k];
+  delete [] pairs;
+  delete [] spins;
+  delete [] axes;
+  delete [] velocities;
+  delete [] starts;
+  delete [] polyhedra;
+}
+
+int main( int argc, char* argv[] )
+{
+  if( argc > 1 ) {
+    bench( atoi(argv[1]), argc > 2 ? atoi(argv[2]) : 100 );
+    return 0;
+  }
+
+  MovingPolyhedron A( 'A',
+                      Vector(10,10, 0 ), // Position
+                      Vector( 0, 0, 0 ), // Velocity
+                      Vector( 0, 0, 0 ), // Angular Velocity
+                      identity3D(),
+                      NFaces, cube );
+  MovingPolyhedron B( 'B',
+                      Vector(10,10,10 ), // Position
+                      Vector( 0, 0,-1 ), // Velocity
+                      Vector( 0, 1, 0 ), // Angular Velocity
+                      identity3D(),
+                      NFaces, cube );
+  report( A, B );
+  report( B, A );
+  return 0;
+}
@@ -197,7 +197,7 @@ probe:
             ent = CodeTabOf (i);
             continue;
         }
-        if ( (long)HashTabOf (i) > 0 )
+        if ( (long)HashTabOf (i) >= 0 )     /* 0 is a string too */
             goto probe;
 nomatch:
         output ( (code_int) ent );
@@ -297,6 +297,8 @@ void output(code_int code)
                 cur_accum >>= 8;
                 cur_bits -= 8;
         }
+        cur_accum = 0;          /* ready for the next image */
+        cur_bits = 0;
 
         flush_char();
         
@@ -415,3 +417,259 @@ void flush_char()
 }       
 
 /* The End */
+
+/******************************************************************************
+ *
+ * The same compression, from memory to memory
+ *
+ ******************************************************************************/
+
+/*
+ * compress() above keeps its state in statics, reads the pixels through
+ * a function and writes them a byte each time.  encode_gif() gives the
+ * same codes ( so the same bytes ), but the string table is a linear
+ * probing hash of 2**(GIFBITS+1) entries, the codes are packed in an
+ * unsigned long and written some bytes each time, and all the state
+ * lives in the stack, so many images can be encoded at once.
+ */
+
+#define LZWHBITS        (GIFBITS + 1)
+#define LZWHSIZE        ((code_int) 1 << LZWHBITS)
+#define LZWHASH(k)      ((code_int) (((unsigned long) (k) * 2654435761UL \
+                                      & 0xFFFFFFFFUL) >> (32 - LZWHBITS)))
+
+/* bytes that we write from the accumulator each time */
+#define ACCUM_BYTES     ((int) sizeof(unsigned long) - 2)
+
+typedef struct {
+    int n_bits;
+    code_int maxcode;
+    code_int free_ent;
+    int clear_flg;
+    int init_bits;
+    code_int ClearCode;
+    code_int EOFCode;
+    unsigned long accum;
+    int bits;
+    char_type *out;
+} lzw_state;
+
+static void
+lzw_output( s, code )
+register lzw_state *s;
+code_int code;
+{
+    register int i;
+
+    s->accum |= (unsigned long) code << s->bits;
+    s->bits += s->n_bits;
+    if ( s->bits >= 8 * ACCUM_BYTES ) {
+        for ( i = 0; i < ACCUM_BYTES; i++ ) {
+            *s->out++ = (char_type) (s->accum & 0xff);
+            s->accum >>= 8;
+        }
+        s->bits -= 8 * ACCUM_BYTES;
+    }
+
+    /*
+     * Like output() ...
+     */
+    if ( s->free_ent > s->maxcode || s->clear_flg ) {
+        if ( s->clear_flg ) {
+            s->maxcode = MAXCODE (s->n_bits = s->init_bits);
+            s->clear_flg = 0;
+        } else {
+            s->n_bits++;
+            if ( s->n_bits == maxbits )
+                s->maxcode = maxmaxcode;
+            else
+                s->maxcode = MAXCODE(s->n_bits);
+        }
+    }
+}
+
+/*
+ * Compress the <npix> pixels, and return the GIF packets ( without the
+ * code size before and the empty packet after ) and their <length>.
+ */
+static char_type *
+lzw_encode( init_bits, pixels, npix, length )
+int init_bits;
+byte *pixels;
+long npix;
+int *length;
+{
+    lzw_state s;
+    int *keys;
+    unsigned short *codes;
+    char_type *raw, *packets;
+    register char_type *ptr;
+    register int key;
+    register code_int i;
+    register code_int ent;
+    register long p;
+    long rawlen, n;
+    int c;
+
+    keys = (int *) Malloc( LZWHSIZE * sizeof(int) );
+    codes = (unsigned short *) Malloc( LZWHSIZE * sizeof(unsigned short) );
+    /* ( codes never have more than 12 bits, even with the CLEARs ) */
+    raw = (char_type *) Malloc( 2 * npix + 64 );
+
+    s.init_bits = init_bits;
+    s.n_bits = init_bits;
+    s.maxcode = MAXCODE(init_bits);
+    s.ClearCode = (1 << (init_bits - 1));
+    s.EOFCode = s.ClearCode + 1;
+    s.free_ent = s.ClearCode + 2;
+    s.clear_flg = 0;
+    s.accum = 0;
+    s.bits = 0;
+    s.out = raw;
+
+    memset( keys, 0xff, LZWHSIZE * sizeof(int) );
+    lzw_output( &s, s.ClearCode );
+
+    ent = npix > 0 ? pixels[0] : EOF;
+    for ( p = 1; p < npix; p++ ) {
+        c = pixels[p];
+        key = (ent << 8) | c;
+        for ( i = LZWHASH(key); keys[i] >= 0; i = (i + 1) & (LZWHSIZE - 1) )
+            if ( keys[i] == key )
+                break;
+        if ( keys[i] == key ) {
+            ent = codes[i];
+            continue;
+        }
+
+        lzw_output( &s, ent );
+        ent = c;
+        if ( s.free_ent < maxmaxcode ) {
+            codes[i] = (unsigned short) s.free_ent++;
+            keys[i] = key;
+        } else {
+            /* table clear, like cl_block() */
+            memset( keys, 0xff, LZWHSIZE * sizeof(int) );
+            s.free_ent = s.ClearCode + 2;
+            s.clear_flg = 1;
+            lzw_output( &s, s.ClearCode );
+        }
+    }
+    lzw_output( &s, ent );
+    lzw_output( &s, s.EOFCode );
+
+    /* The rest of the bits */
+    while ( s.bits > 0 ) {
+        *s.out++ = (char_type) (s.accum & 0xff);
+        s.accum >>= 8;
+        s.bits -= 8;
+    }
+    rawlen = s.out - raw;
+
+    /*
+     * Cut it in packets of 254 bytes ( like char_out() ).
+     */
+    packets = (char_type *) Malloc( rawlen + rawlen / 254 + 1 );
+    for ( ptr = packets, p = 0; p < rawlen; p += n ) {
+        n = LUGMIN( 254, rawlen - p );
+        *ptr++ = (char_type) n;
+        memcpy( ptr, raw + p, n );
+        ptr += n;
+    }
+    *length = (int) (ptr - packets);
+
+    Free( keys );
+    Free( codes );
+    Free( raw );
+    return packets;
+}
+
+/*
+ * The GIF raster of a mapped image: the code size, the packets
+ * and the empty packet at the end.
+ */
+byte *
+encode_gif( image, length )
+bitmap_hdr *image;
+int *length;
+{
+    char_type *packets, *out;
+    int n;
+
+    if ( image->magic != LUGUSED )
+        errornull( 19 );
+    if ( image->depth > 8 )
+        errornull( 15 );
+
+    /* el primer codigo libre sera de +1 bits */
+    packets = lzw_encode( image->depth + 1, image->r,
+                          (long) image->xsize * image->ysize, &n );
+    out = (char_type *) Malloc( n + 2 );
+    out[0] = (char_type) image->depth;
+    memcpy( out + 1, packets, n );
+    out[n + 1] = 0;
+    *length = n + 2;
+    Free( packets );
+
+    return (byte *) out;
+}
+
+/*
+ * Write <n> images ( of the same size ) in a GIF file, one after the
+ * other.  They are encoded at the same time, one by thread.  Images
+ * with a cmap different to the first one take it as local cmap.
+ */
+void
+write_gif_frames( handle, images, n )
+FILE *handle;
+bitmap_hdr *images;
+int n;
+{
+    byte **rasters;
+    int *lengths;
+    byte buffer[10];
+    int i;
+
+    for ( i = 0; i < n; i++ ) {
+        if ( images[i].magic != LUGUSED )
+            error( 19 );
+        if ( images[i].depth > 8 )
+            error( 15 );
+        if ( images[i].xsize != images[0].xsize ||
+             images[i].ysize != images[0].ysize )
+            error( 12 );
+    }
+
+    rasters = (byte **) Malloc( n * sizeof(byte *) );
+    lengths = (int *) Malloc( n * sizeof(int) );
+#pragma omp parallel for schedule(dynamic)
+    for ( i = 0; i < n; i++ )
+        rasters[i] = encode_gif( &images[i], &lengths[i] );
+
+    write_gif_hdr( handle );
+    write_gif_screen_hdr( handle, &images[0] );
+    write_gif_cmap( handle, &images[0] );
+    for ( i = 0; i < n; i++ ) {
+        if ( images[i].colors == images[0].colors &&
+             !memcmp( images[i].cmap, images[0].cmap, 3 * images[0].colors ) )
+            write_gif_image_hdr( handle, &images[i] );
+        else {
+            /* Like write_gif_image_hdr(), but with a local cmap */
+            bzero( buffer, 10 );
+            buffer[0] = ',';
+            buffer[5] = LSB(images[i].xsize);
+            buffer[6] = MSB(images[i].xsize);
+            buffer[7] = LSB(images[i].ysize);
+            buffer[8] = MSB(images[i].ysize);
+            buffer[9] = (1 << 7) | no_bits( images[i].colors );
+            Fwrite( buffer, 10, 1, handle );
+            write_gif_cmap( handle, &images[i] );
+        }
+        Fwrite( rasters[i], lengths[i], 1, handle );
+        Free( rasters[i] );
+    }
+    fputc( ';', handle );       /* end of the GIF file */
+
+    Free( rasters );
+    Free( lengths );
+}
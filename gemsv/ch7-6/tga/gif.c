@@ -453,8 +453,8 @@ void write_gif(handle, image)
 FILE *handle;
 bitmap_hdr *image;
 {
-  int codesize;
-  int read_pixel();
+  byte *raster;
+  int length;
 
   if ( image->magic != LUGUSED )
     error( 19 );
@@ -473,28 +473,13 @@ bitmap_hdr *image;
   write_gif_image_hdr( handle, image );
 
   /*
-   * Now store the original code size.
-   */
-  codesize = image->depth;
-  fputc( codesize, handle );
-
-  /*
-   * Image size.
-   */
-  image_size = image->xsize * image->ysize;
-  /* el primer codigo libre sera de +1 bits */
-  codesize++;
-  /*
-   * Compress the image.
+   * Compress the image ( the code size, the packets and
+   * a block with a size of 0 bytes ).
    */
   VPRINTF(stdout, "Compressing raster information\n");
-  ptr_image = image->r;
-  compress( codesize, handle, read_pixel);
-
-  /*
-   * Block with a size of 0 bytes.
-   */
-  fputc( 0, handle );
+  raster = encode_gif( image, &length );
+  Fwrite( raster, length, 1, handle );
+  Free( raster );
 
   /*
    * End of gif file.
@@ -0,0 +1,208 @@
+/*
+ * gifbench.c - check and time encode_gif() against compress().
+ *
+ * Makes mapped pictures of sky, gradients and noise with 256, 16
+ * and 2 colors, and compresses each one with compress() ( what
+ * write_gif() used ) and with encode_gif(), checking that the bytes
+ * are the same. Then writes an animation of frames with a loop of
+ * write_gif() and with write_gif_frames(). Speeds are in megabytes
+ * of pixels a second.
+ *
+ * usage: gifbench [xsize ysize [repetitions [frames]]]
+ */
+
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "lug.h"
+#include "lugfnts.h"
+
+extern byte *ptr_image;
+extern int image_size;
+extern int read_pixel();
+
+static double seconds()
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static void report(what, mb, t, same)
+char *what;
+double mb, t;
+int same;
+{
+  printf( "%-28s %10.1f MB/s", what, mb / t );
+  if ( same >= 0 )
+    printf( "  %s", same ? "same" : "DIFFERENT" );
+  printf( "\n" );
+}
+
+/*
+ * The bytes written in <handle> against <length> bytes at <buffer>.
+ */
+static int same_bytes(handle, buffer, length)
+FILE *handle;
+byte *buffer;
+long length;
+{
+  long i;
+
+  if ( ftell( handle ) != length )
+    return 0;
+  rewind( handle );
+  for ( i = 0; i < length; i++ )
+    if ( getc( handle ) != buffer[i] )
+      return 0;
+  return 1;
+}
+
+static void make_picture(image, xsize, ysize, depth, shift)
+bitmap_hdr *image;
+int xsize, ysize, depth, shift;
+{
+  int colors = 1 << depth;
+  int x, y, i;
+  long k;
+
+  image->magic = LUGUSED;
+  image->xsize = xsize;
+  image->ysize = ysize;
+  image->depth = depth;
+  image->colors = colors;
+  image->r = (byte *) Malloc( (long) xsize * ysize );
+  image->g = image->b = NULL;
+  image->cmap = (byte *) Malloc( 3 * colors );
+  for ( i = 0; i < 3 * colors; i++ )
+    image->cmap[i] = ( i * 37 ) & 255;
+  for ( y = 0; y < ysize; y++ )
+    for ( x = 0; x < xsize; x++ ) {
+      k = (long) y * xsize + x;
+      if ( y < ysize / 3 )              /* sky */
+        image->r[k] = colors / 2;
+      else if ( x < xsize / 2 )         /* gradient */
+        image->r[k] = ( ( x + shift ) / 16 + y / 32 ) & ( colors - 1 );
+      else                              /* noise */
+        image->r[k] = rand() & ( colors - 1 );
+    }
+}
+
+int main(argc, argv)
+int argc;
+char **argv;
+{
+  int xsize = argc > 2 ? atoi( argv[1] ) : 1024;
+  int ysize = argc > 2 ? atoi( argv[2] ) : 768;
+  int reps = argc > 3 ? atoi( argv[3] ) : 5;
+  int nframes = argc > 4 ? atoi( argv[4] ) : 16;
+  static int depths[] = { 8, 4, 1 };
+  long npix = (long) xsize * ysize;
+  double mb = npix / 1e6;
+  bitmap_hdr image, *frames;
+  FILE *fa = tmpfile(), *fb = tmpfile();
+  byte *raster;
+  char what[40];
+  int length, same;
+  long len;
+  double t;
+  int d, i;
+
+  if ( fa == NULL || fb == NULL ) {
+    fprintf( stderr, "gifbench: cannot make temporary files\n" );
+    exit( 1 );
+  }
+  srand( 1 );
+  printf( "%d x %d pictures, %.1f MB of pixels, %d repetitions\n",
+          xsize, ysize, mb, reps );
+
+  for ( d = 0; d < 3; d++ ) {
+    make_picture( &image, xsize, ysize, depths[d], 0 );
+
+    t = seconds();
+    for ( i = 0; i < reps; i++ ) {
+      rewind( fa );
+      fputc( image.depth, fa );
+      /*
+       * read_pixel() only starts again with a new pointer, so
+       * give it an empty one first.
+       */
+      ptr_image = NULL;
+      image_size = 0;
+      read_pixel();
+      ptr_image = image.r;
+      image_size = xsize * ysize;
+      compress( image.depth + 1, fa, read_pixel );
+      fputc( 0, fa );
+      fflush( fa );
+    }
+    t = seconds() - t;
+    sprintf( what, "compress(), %d bits", depths[d] );
+    report( what, mb * reps, t, -1 );
+    len = ftell( fa );
+
+    t = seconds();
+    for ( i = 0; i < reps; i++ ) {
+      rewind( fb );
+      raster = encode_gif( &image, &length );
+      Fwrite( raster, length, 1, fb );
+      fflush( fb );
+      Free( raster );
+    }
+    t = seconds() - t;
+    raster = encode_gif( &image, &length );
+    same = length == len && same_bytes( fa, raster, (long) length );
+    Free( raster );
+    sprintf( what, "encode_gif(), %d bits", depths[d] );
+    report( what, mb * reps, t, same );
+    printf( "%28s %10.1f%%\n", "compressed to", 100. * len / npix );
+
+    Free( image.r );
+    Free( image.cmap );
+  }
+
+  /*
+   * An animation.
+   */
+  if ( nframes < 1 )
+    return 0;
+  frames = (bitmap_hdr *) Malloc( nframes * sizeof(bitmap_hdr) );
+  for ( i = 0; i < nframes; i++ )
+    make_picture( &frames[i], xsize, ysize, 8, 4 * i );
+
+  /* One frame is a GIF file like write_gif() writes */
+  rewind( fa );
+  write_gif( fa, &frames[0] );
+  rewind( fb );
+  write_gif_frames( fb, frames, 1 );
+  len = ftell( fb );
+  raster = (byte *) Malloc( len );
+  rewind( fb );
+  Fread( raster, len, 1, fb );
+  same = same_bytes( fa, raster, len );
+  Free( raster );
+
+  t = seconds();
+  for ( i = 0; i < nframes; i++ ) {
+    raster = encode_gif( &frames[i], &length );
+    Free( raster );
+  }
+  t = seconds() - t;
+  sprintf( what, "%d frames, one by one", nframes );
+  report( what, mb * nframes, t, -1 );
+  t = seconds();
+  rewind( fb );
+  write_gif_frames( fb, frames, nframes );
+  fflush( fb );
+  t = seconds() - t;
+  sprintf( what, "%d frames, write_gif_frames", nframes );
+  report( what, mb * nframes, t, same );
+#ifdef _OPENMP
+  printf( "%28s %10d\n", "threads", omp_get_max_threads() );
+#endif
+
+  return 0;
+}
@@ -103,6 +103,35 @@ get_real_index_function(
 );
 
 
+/* encodgif.c */
+
+extern void
+compress(
+#ifdef USE_PROTOTYPES
+        int,
+        FILE *,
+        ifunptr
+#endif
+);
+
+extern byte *
+encode_gif(
+#ifdef USE_PROTOTYPES
+        bitmap_hdr *,
+        int *
+#endif
+);
+
+extern void
+write_gif_frames(
+#ifdef USE_PROTOTYPES
+        FILE *,
+        bitmap_hdr *,
+        int
+#endif
+);
+
+
 /* gif.c */
 
 extern void
@@ -831,6 +860,14 @@ read_tga_header(
 #endif
 );
 
+extern void
+get_tga_header(
+#ifdef USE_PROTOTYPES
+        byte *,
+        tga_hdr *
+#endif
+);
+
 extern void
 read_tga_data(
 #ifdef USE_PROTOTYPES
@@ -897,6 +934,75 @@ write_tga_rle_line24(
 );
 
 
+/* tgamap.c */
+
+extern int
+open_tga_map(
+#ifdef USE_PROTOTYPES
+        char *,
+        tga_map *
+#endif
+);
+
+extern void
+close_tga_map(
+#ifdef USE_PROTOTYPES
+        tga_map *
+#endif
+);
+
+extern int
+tga_tile(
+#ifdef USE_PROTOTYPES
+        tga_map *,
+        int,
+        int,
+        int,
+        int,
+        tga_view *
+#endif
+);
+
+extern void
+tga_view_planes(
+#ifdef USE_PROTOTYPES
+        tga_view *,
+        byte *,
+        byte *,
+        byte *
+#endif
+);
+
+extern int
+open_tga_stream(
+#ifdef USE_PROTOTYPES
+        char *,
+        tga_stream *,
+        int,
+        int,
+        int
+#endif
+);
+
+extern int
+write_tga_stream(
+#ifdef USE_PROTOTYPES
+        tga_stream *,
+        byte *,
+        byte *,
+        byte *,
+        int
+#endif
+);
+
+extern int
+close_tga_stream(
+#ifdef USE_PROTOTYPES
+        tga_stream *
+#endif
+);
+
+
 /* tiff.c */
 
 extern int
@@ -53,4 +53,50 @@ typedef struct {
         byte   image_descriptor;
 } tga_hdr;
 
+/*
+ * A Targa file mapped in memory ( see tgamap.c ). Uncompressed
+ * images are used from the mapped file, RLE images are decoded
+ * in blocks of scanlines when somebody needs them.
+ */
+typedef struct {
+        tga_hdr hdr;
+        byte   *base;           /* the whole file */
+        long    length;
+        int     mapped;         /* base comes from mmap() */
+        byte   *cmap;           /* RGB cmap of mapped images */
+        byte   *pixels;         /* raster data into the file */
+        int     bpp;            /* bytes by pixel */
+        long    rowbytes;
+        int     flip;           /* first scanline is the bottom one */
+        byte   *raster;         /* decoded RLE scanlines */
+        int     blocklines;     /* scanlines by RLE block */
+        int     nblocks;
+        int     known;          /* blocks with known start */
+        byte   *decoded;        /* block decoded ? */
+        long   *blockpos;       /* packet with the first pixel of a block */
+        int    *blockused;      /* ... and its pixels in the block before */
+} tga_map;
+
+/*
+ * A rectangle of a mapped Targa, still in the file pixel
+ * format ( BGR, BGRA, 5-5-5 or cmap indexes ).
+ */
+typedef struct {
+        byte   *data;           /* upper left pixel */
+        long    stride;         /* bytes to next line ( < 0 if flipped ) */
+        int     xsize, ysize;
+        int     bpp;
+} tga_view;
+
+/*
+ * A Targa being written a few scanlines each time.
+ */
+typedef struct {
+        FILE   *handle;
+        int     xsize, ysize;
+        int     rle;
+        int     lines;          /* written up to now */
+        byte   *buffer;         /* an encoded scanline */
+} tga_stream;
+
 #endif       /* MY_TGA */
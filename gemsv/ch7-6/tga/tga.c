@@ -296,22 +296,7 @@ tga_hdr *tga;
   byte buffer[18];
 
   Fread( buffer, 18, 1, handle );
-
-  /*
-   * Bytes are in reverse order so ...
-   */
-  tga->num_id = buffer[0];
-  tga->cmap_type = buffer[1];
-  tga->image_type = buffer[2];
-  tga->cmap_orign = ( buffer[4] << 8 ) | buffer[3];
-  tga->cmap_length = ( buffer[6] << 8 ) | buffer[5];
-  tga->cmap_entry_size = buffer[7] / 8;
-  tga->xorig = ( buffer[9] << 8 ) | buffer[8];
-  tga->yorig = ( buffer[11] << 8 ) | buffer[10];
-  tga->xsize = ( buffer[13] << 8 ) | buffer[12];
-  tga->ysize = ( buffer[15] << 8 ) | buffer[14];
-  tga->pixel_size = buffer[16] / 8;     /* we'll use it directly */
-  tga->image_descriptor = buffer[17];
+  get_tga_header( buffer, tga );
 
 /*  VPRINTF(stderr, "Image type %d\n", tga->image_type);
   VPRINTF(stderr, "%s color map\n", (tga->cmap_type ? "With" : "Without"));
@@ -359,6 +344,27 @@ tga_hdr *tga;
   }
 }
 
+void get_tga_header(buffer, tga)
+byte *buffer;
+tga_hdr *tga;
+{
+  /*
+   * Bytes are in reverse order so ...
+   */
+  tga->num_id = buffer[0];
+  tga->cmap_type = buffer[1];
+  tga->image_type = buffer[2];
+  tga->cmap_orign = ( buffer[4] << 8 ) | buffer[3];
+  tga->cmap_length = ( buffer[6] << 8 ) | buffer[5];
+  tga->cmap_entry_size = buffer[7] / 8;
+  tga->xorig = ( buffer[9] << 8 ) | buffer[8];
+  tga->yorig = ( buffer[11] << 8 ) | buffer[10];
+  tga->xsize = ( buffer[13] << 8 ) | buffer[12];
+  tga->ysize = ( buffer[15] << 8 ) | buffer[14];
+  tga->pixel_size = buffer[16] / 8;     /* we'll use it directly */
+  tga->image_descriptor = buffer[17];
+}
+
 void read_tga_data( buffer, no_bytes, handle )
 byte *buffer;
 int no_bytes;
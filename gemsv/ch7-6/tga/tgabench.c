@@ -0,0 +1,318 @@
+/*
+ * tgabench.c - check and time tgamap.c against tga.c.
+ *
+ * Makes a picture of sky, gradients and noise and writes it, plain
+ * and RLE, with write_tga_file() and with a tga_stream, checking
+ * that the plain files are the same, and RLE with packets running
+ * on across the scanlines ( so that tga_map blocks start inside a
+ * packet ), as other writers make them. Then reads each one with
+ * read_tga_file() and with a tga_map, timing the first pixel ( a
+ * 64x64 tile at the corner ), a 256x256 tile at the middle and the
+ * whole image, and checking the pixels against the picture.
+ * Speeds are in megabytes of planes a second.
+ *
+ * usage: tgabench [xsize ysize [repetitions]]
+ */
+
+#include <time.h>
+#include "lug.h"
+#include "lugfnts.h"
+
+static char *plain_name = "tgabench.tga";
+static char *stream_name = "tgabench2.tga";
+static char *rle_name = "tgabench3.tga";
+static char *long_name = "tgabench4.tga";
+
+static double seconds()
+{
+  return (double) clock() / CLOCKS_PER_SEC;
+}
+
+static void report(what, ms, mb, t, same)
+char *what;
+double ms, mb, t;
+int same;
+{
+  if ( ms > 0. )
+    printf( "%-28s %10.3f ms", what, ms );
+  else printf( "%-28s %13s", what, "" );
+  if ( mb > 0. )
+    printf( " %10.1f MB/s", mb / t );
+  else printf( " %15s", "" );
+  if ( same >= 0 )
+    printf( "  %s", same ? "same" : "DIFFERENT" );
+  printf( "\n" );
+}
+
+static int same_files(a, b)
+char *a, *b;
+{
+  FILE *fa = fopen( a, "rb" );
+  FILE *fb = fopen( b, "rb" );
+  int ca, cb;
+
+  if ( fa == NULL || fb == NULL )
+    return 0;
+  do {
+    ca = getc( fa );
+    cb = getc( fb );
+  } while ( ca == cb && ca != EOF );
+  fclose( fa );
+  fclose( fb );
+  return ca == cb;
+}
+
+#define SAME_PIXEL(i, j)  ( r[i] == r[j] && g[i] == g[j] && b[i] == b[j] )
+
+/*
+ * An RLE Targa of <image> whose packets don't stop at the end of
+ * the scanlines: runs of two or more pixels make run packets, the
+ * rest raw packets, of up to 128 pixels.
+ */
+static void write_long_packets(name, image)
+char *name;
+bitmap_hdr *image;
+{
+  FILE *handle = Fopen( name, "wb" );
+  long npix = (long) image->xsize * image->ysize;
+  byte *r = image->r, *g = image->g, *b = image->b;
+  long i = 0, j, n;
+
+  write_tga_header( handle, image, 1 );
+  while ( i < npix ) {
+    for ( n = 1; i + n < npix && n < 128 && SAME_PIXEL(i, i + n); n++ )
+      ;
+    if ( n > 1 ) {
+      putc( 127 + n, handle );
+      putc( b[i], handle );
+      putc( g[i], handle );
+      putc( r[i], handle );
+    }else {
+      for ( n = 1; i + n < npix && n < 128 &&
+                   !( i + n + 1 < npix && SAME_PIXEL(i + n, i + n + 1) ); n++ )
+        ;
+      putc( n - 1, handle );
+      for ( j = i; j < i + n; j++ ) {
+        putc( b[j], handle );
+        putc( g[j], handle );
+        putc( r[j], handle );
+      }
+    }
+    i += n;
+  }
+  Fclose( handle );
+}
+
+/*
+ * The tile ( x, y, xsize, ysize ) of <map> against the same
+ * rectangle of the planes.
+ */
+static int same_tile(map, x, y, xsize, ysize, image, r, g, b)
+tga_map *map;
+int x, y, xsize, ysize;
+bitmap_hdr *image;
+byte *r, *g, *b;
+{
+  tga_view view;
+  long offset;
+  int j, same = 1;
+
+  tga_tile( map, x, y, xsize, ysize, &view );
+  tga_view_planes( &view, r, g, b );
+  for ( j = 0; j < ysize; j++ ) {
+    offset = (long) (y + j) * image->xsize + x;
+    same &= !memcmp( r + j * xsize, image->r + offset, xsize ) &&
+            !memcmp( g + j * xsize, image->g + offset, xsize ) &&
+            !memcmp( b + j * xsize, image->b + offset, xsize );
+  }
+  return same;
+}
+
+static void time_reads(name, image, reps)
+char *name;
+bitmap_hdr *image;
+int reps;
+{
+  long npix = (long) image->xsize * image->ysize;
+  double mb = 3. * npix / 1e6;
+  int mx = image->xsize / 2 - 128, my = image->ysize / 2 - 128;
+  byte *r = (byte *) Malloc( npix );
+  byte *g = (byte *) Malloc( npix );
+  byte *b = (byte *) Malloc( npix );
+  bitmap_hdr in;
+  tga_map map;
+  tga_view view;
+  double t;
+  int i, same = 0;
+
+  t = seconds();
+  for ( i = 0; i < reps; i++ ) {
+    read_tga_file( name, &in );
+    same = !memcmp( in.r, image->r, npix ) &&
+           !memcmp( in.g, image->g, npix ) &&
+           !memcmp( in.b, image->b, npix );
+    free( in.r );
+    free( in.g );
+    free( in.b );
+  }
+  t = seconds() - t;
+  report( "read_tga_file()", 1e3 * t / reps, mb * reps, t, same );
+
+  t = seconds();
+  for ( i = 0; i < reps; i++ ) {
+    open_tga_map( name, &map );
+    tga_tile( &map, 0, 0, 64, 64, &view );
+    tga_view_planes( &view, r, g, b );
+    close_tga_map( &map );
+  }
+  t = seconds() - t;
+  open_tga_map( name, &map );
+  same = same_tile( &map, 0, 0, 64, 64, image, r, g, b );
+  close_tga_map( &map );
+  report( "map, first 64x64 tile", 1e3 * t / reps, 0., t, same );
+
+  t = seconds();
+  for ( i = 0; i < reps; i++ ) {
+    open_tga_map( name, &map );
+    tga_tile( &map, mx, my, 256, 256, &view );
+    tga_view_planes( &view, r, g, b );
+    close_tga_map( &map );
+  }
+  t = seconds() - t;
+  open_tga_map( name, &map );
+  same = same_tile( &map, mx, my, 256, 256, image, r, g, b );
+  close_tga_map( &map );
+  report( "map, middle 256x256 tile", 1e3 * t / reps, 0., t, same );
+
+  t = seconds();
+  for ( i = 0; i < reps; i++ ) {
+    open_tga_map( name, &map );
+    tga_tile( &map, 0, 0, image->xsize, image->ysize, &view );
+    tga_view_planes( &view, r, g, b );
+    close_tga_map( &map );
+  }
+  t = seconds() - t;
+  open_tga_map( name, &map );
+  same = same_tile( &map, 0, 0, image->xsize, image->ysize, image, r, g, b );
+  close_tga_map( &map );
+  report( "map, whole image", 1e3 * t / reps, mb * reps, t, same );
+
+  Free( r );
+  Free( g );
+  Free( b );
+}
+
+int main(argc, argv)
+int argc;
+char **argv;
+{
+  int xsize = argc > 2 ? atoi( argv[1] ) : 2048;
+  int ysize = argc > 2 ? atoi( argv[2] ) : 2048;
+  int reps = argc > 3 ? atoi( argv[3] ) : 3;
+  long npix = (long) xsize * ysize, k;
+  double mb = 3. * npix / 1e6;
+  bitmap_hdr image, in;
+  tga_stream stream;
+  double t;
+  int x, y, i, same;
+
+  if ( xsize < 256 || ysize < 256 ) {
+    fprintf( stderr, "tgabench: the image needs at least 256x256 pixels\n" );
+    exit( 1 );
+  }
+
+  image.magic = LUGUSED;
+  image.xsize = xsize;
+  image.ysize = ysize;
+  image.depth = 24;
+  image.colors = 1 << 24;
+  image.r = (byte *) Malloc( npix );
+  image.g = (byte *) Malloc( npix );
+  image.b = (byte *) Malloc( npix );
+  image.cmap = NULL;
+  srand( 1 );
+  for ( y = 0; y < ysize; y++ )
+    for ( x = 0; x < xsize; x++ ) {
+      k = (long) y * xsize + x;
+      if ( y < ysize / 3 ) {            /* sky */
+        image.r[k] = 100;
+        image.g[k] = 150;
+        image.b[k] = 250;
+      }else if ( x < xsize / 2 ) {      /* gradient */
+        image.r[k] = x / 8;
+        image.g[k] = y / 8;
+        image.b[k] = ( x + y ) / 16;
+      }else {                           /* noise */
+        image.r[k] = rand();
+        image.g[k] = rand();
+        image.b[k] = rand();
+      }
+    }
+  printf( "%d x %d picture, %.1f MB of planes, %d repetitions\n",
+          xsize, ysize, mb, reps );
+
+  /*
+   * Writing.
+   */
+  if ( xsize <= 2560 ) {
+    /* ( write_tga_line24 only takes 2560 pixels ) */
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+      write_tga_file( plain_name, &image );
+    t = seconds() - t;
+    report( "write_tga_file()", 0., mb * reps, t, -1 );
+    t = seconds();
+    for ( i = 0; i < reps; i++ )
+      write_rle_tga_file( rle_name, &image );
+    t = seconds() - t;
+    report( "write_rle_tga_file()", 0., mb * reps, t, -1 );
+  }
+  t = seconds();
+  for ( i = 0; i < reps; i++ ) {
+    open_tga_stream( stream_name, &stream, xsize, ysize, 0 );
+    for ( y = 0; y < ysize; y += 64 ) {
+      k = (long) y * xsize;
+      write_tga_stream( &stream, image.r + k, image.g + k, image.b + k,
+                        LUGMIN(64, ysize - y) );
+    }
+    close_tga_stream( &stream );
+  }
+  t = seconds() - t;
+  report( "tga_stream", 0., mb * reps, t,
+          xsize <= 2560 ? same_files( plain_name, stream_name ) : -1 );
+  t = seconds();
+  for ( i = 0; i < reps; i++ ) {
+    open_tga_stream( rle_name, &stream, xsize, ysize, 1 );
+    for ( y = 0; y < ysize; y += 64 ) {
+      k = (long) y * xsize;
+      write_tga_stream( &stream, image.r + k, image.g + k, image.b + k,
+                        LUGMIN(64, ysize - y) );
+    }
+    close_tga_stream( &stream );
+  }
+  t = seconds() - t;
+  read_tga_file( rle_name, &in );
+  same = !memcmp( in.r, image.r, npix ) && !memcmp( in.g, image.g, npix ) &&
+         !memcmp( in.b, image.b, npix );
+  free( in.r );
+  free( in.g );
+  free( in.b );
+  report( "tga_stream, RLE", 0., mb * reps, t, same );
+  write_long_packets( long_name, &image );
+
+  /*
+   * Reading.
+   */
+  printf( "plain Targa\n" );
+  time_reads( stream_name, &image, reps );
+  printf( "RLE Targa\n" );
+  time_reads( rle_name, &image, reps );
+  printf( "RLE Targa, packets across scanlines\n" );
+  time_reads( long_name, &image, reps );
+
+  remove( plain_name );
+  remove( stream_name );
+  remove( rle_name );
+  remove( long_name );
+  return 0;
+}
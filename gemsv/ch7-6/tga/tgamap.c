@@ -0,0 +1,474 @@
+/*
+ * This software is copyrighted as noted below.  It may be freely copied,
+ * modified, and redistributed, provided that the copyright notice is
+ * preserved on all copies.
+ *
+ * There is no warranty or other guarantee of fitness for this software,
+ * it is provided solely "as is".  Bug reports or fixes may be sent
+ * to the author, who may or may not act on them as he desires.
+ *
+ * You may not include this software in a program or other software product
+ * without supplying the source, or without informing the end-user that the
+ * source is available for no extra charge.
+ *
+ * If you modify this software, you should include a notice giving the
+ * name of the person performing the modification, the date of modification,
+ * and the reason for such modification.
+ */
+/*
+ * tgamap.c - Targa images without reading them.
+ *
+ * read_tga() allocates three planes and fills them before we can
+ * look at the first pixel. Here the file is mapped in memory and
+ * tga_tile() gives a rectangle of it in the file pixel format,
+ * pointing into the map. RLE images are decoded, the first time
+ * somebody asks for them, in blocks of about 64Kb of scanlines;
+ * to find where a block starts we only need to jump over the
+ * packets before it.
+ *
+ * open_tga_stream() and friends write a Targa some scanlines each
+ * time, so the whole image never needs to be in memory.
+ */
+
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "lug.h"
+#include "lugfnts.h"
+
+void rm_compress();
+
+#define TGA_BLOCK_BYTES         65536
+
+int open_tga_map(name, map)
+char *name;
+tga_map *map;
+{
+  FILE *handle;
+  byte *ptr, *end;
+  int bytes;
+  int i, aux;
+
+  bzero( map, sizeof(tga_map) );
+
+  /* Open the file descriptor */
+  if ( name != NULL )
+    handle = Fopen( name, "rb" );
+  else handle = stdin;
+
+#ifndef WIN32
+  /*
+   * Map it, if it's a regular file ( a compressed one has
+   * been uncompressed by Fopen ).
+   */
+  map->length = filelen( handle );
+  if ( map->length > 0 ) {
+    ptr = (byte *) mmap( NULL, (size_t) map->length, PROT_READ, MAP_PRIVATE,
+                         fileno(handle), 0 );
+    if ( ptr != (byte *) MAP_FAILED ) {
+      map->base = ptr;
+      map->mapped = 1;
+    }
+  }
+#endif
+  if ( !map->mapped ) {
+    /* A pipe or a system without mmap, so read it */
+    map->base = (byte *) read_file( handle, &bytes );
+    map->length = bytes;
+  }
+
+  /* The map keeps the file, so close it */
+  Fclose( handle );
+  rm_compress();
+
+  /*
+   * Read the Targa header.
+   */
+  if ( map->length < 18 )
+    error( 3 );
+  get_tga_header( map->base, &map->hdr );
+  end = map->base + map->length;
+
+  if ( TGA_INTERLACED(map->hdr.image_descriptor) )
+    error( 17 );
+  switch ( map->hdr.image_type ) {
+    case TGA_RGB:
+    case TGA_RLE_RGB:
+                if ( map->hdr.pixel_size < 2 || map->hdr.pixel_size > 4 )
+                  error( 14 );
+                break;
+    case TGA_MAPPED:
+    case TGA_RLE_MAPPED:
+                if ( map->hdr.cmap_type != 1 )
+                  error( 13 );
+                if ( map->hdr.pixel_size != 1 )
+                  error( 14 );
+                break;
+    default:
+                error( 9 );
+                break;
+  }
+  map->bpp = map->hdr.pixel_size;
+  map->rowbytes = (long) map->bpp * map->hdr.xsize;
+  map->flip = TGA_FLIP( map->hdr.image_descriptor );
+
+  /*
+   * Skip the identification and keep the cmap ( only if
+   * we need it ).
+   */
+  ptr = map->base + 18 + map->hdr.num_id;
+  if ( map->hdr.cmap_type ) {
+    if ( ptr + (long) map->hdr.cmap_length * map->hdr.cmap_entry_size > end )
+      error( 18 );
+    if ( map->bpp == 1 ) {
+      map->cmap = (byte *) Malloc( 3 * map->hdr.cmap_length );
+      for ( i = 0; i < map->hdr.cmap_length; i++ ) {
+        if ( map->hdr.cmap_entry_size < 3 ) {
+          aux = ( ptr[1] << 8 ) | ptr[0];
+          map->cmap[3*i]   = (aux & 0x7c00) >> 7;
+          map->cmap[3*i+1] = (aux & 0x03e0) >> 2;
+          map->cmap[3*i+2] = (aux & 0x001F) << 3;
+        }else {
+          map->cmap[3*i]   = ptr[2];
+          map->cmap[3*i+1] = ptr[1];
+          map->cmap[3*i+2] = ptr[0];
+        }
+        ptr += map->hdr.cmap_entry_size;
+      }
+    }else ptr += (long) map->hdr.cmap_length * map->hdr.cmap_entry_size;
+  }
+  map->pixels = ptr;
+
+  if ( map->hdr.image_type < 9 ) {
+    /* No RLE, so the raster is just there */
+    if ( ptr + map->rowbytes * map->hdr.ysize > end )
+      error( 18 );
+  }else {
+    /*
+     * RLE, we know where the first block starts and
+     * nothing else.
+     */
+    map->blocklines = LUGMAX( 1, TGA_BLOCK_BYTES / LUGMAX(1, map->rowbytes) );
+    map->nblocks = ( map->hdr.ysize + map->blocklines - 1 ) / map->blocklines;
+    map->decoded = (byte *) Malloc( map->nblocks + 1 );
+    map->blockpos = (long *) Malloc( (map->nblocks + 1) * sizeof(long) );
+    map->blockused = (int *) Malloc( (map->nblocks + 1) * sizeof(int) );
+    map->blockpos[0] = ptr - map->base;
+    map->known = 1;
+    /*
+     * The decoded scanlines go here; we don't use Malloc
+     * because it'd touch all the pages.
+     */
+    if ( map->rowbytes * map->hdr.ysize > 0 &&
+         (map->raster = (byte *) malloc( map->rowbytes * map->hdr.ysize ))
+              == NULL )
+      error( 2 );
+  }
+
+  return 0;
+}
+
+void close_tga_map(map)
+tga_map *map;
+{
+#ifndef WIN32
+  if ( map->mapped )
+    munmap( (void *) map->base, (size_t) map->length );
+  else
+#endif
+    Free( map->base );
+  Free( map->cmap );
+  Free( map->raster );
+  Free( map->decoded );
+  Free( map->blockpos );
+  Free( map->blockused );
+  bzero( map, sizeof(tga_map) );
+}
+
+/*
+ * Walk the packets of RLE block <k>, whose start we know, and
+ * save where the next one starts. The pixels go to <out>, or
+ * nowhere if <out> is NULL.
+ */
+static void walk_tga_block(map, k, out)
+tga_map *map;
+int k;
+byte *out;
+{
+  byte *ptr = map->base + map->blockpos[k];
+  byte *end = map->base + map->length;
+  int bpp = map->bpp;
+  int used = map->blockused[k];
+  int lines = LUGMIN( map->blocklines, map->hdr.ysize - k * map->blocklines );
+  long count = (long) lines * map->hdr.xsize;
+  int code, take;
+  byte *pixel;
+
+  while ( count > 0 ) {
+    if ( ptr >= end )
+      error( 18 );
+    code = (*ptr & 127) + 1;
+    take = (int) LUGMIN( (long) (code - used), count );
+    if ( *ptr & 128 ) {
+      if ( ptr + 1 + bpp > end )
+        error( 18 );
+      if ( out != NULL ) {
+        if ( bpp == 1 ) {
+          memset( out, ptr[1], take );
+          out += take;
+        }else {
+          for ( pixel = out + take * bpp; out < pixel; out += bpp )
+            memcpy( out, ptr + 1, bpp );
+        }
+      }
+    }else {
+      if ( ptr + 1 + code * bpp > end )
+        error( 18 );
+      if ( out != NULL ) {
+        memcpy( out, ptr + 1 + used * bpp, take * bpp );
+        out += take * bpp;
+      }
+    }
+    count -= take;
+    if ( used + take < code ) {
+      /* The next block starts into this packet */
+      used += take;
+      break;
+    }
+    ptr += 1 + ( (*ptr & 128) ? bpp : code * bpp );
+    used = 0;
+  }
+
+  if ( k + 1 == map->known && k + 1 < map->nblocks ) {
+    map->blockpos[k+1] = ptr - map->base;
+    map->blockused[k+1] = used;
+    map->known++;
+  }
+}
+
+static void decode_tga_block(map, k)
+tga_map *map;
+int k;
+{
+  /* Jump over the packets until block k */
+  while ( map->known <= k )
+    walk_tga_block( map, map->known - 1, (byte *) NULL );
+
+  walk_tga_block( map, k, map->raster + k * map->blocklines * map->rowbytes );
+  map->decoded[k] = 1;
+}
+
+/*
+ * A <xsize> x <ysize> rectangle of the image, with ( x, y ) the
+ * upper left corner. A full-width rectangle is a scanline range.
+ * Nothing is copied for uncompressed images, and the view keeps
+ * valid until close_tga_map().
+ */
+int tga_tile(map, x, y, xsize, ysize, view)
+tga_map *map;
+int x, y;
+int xsize, ysize;
+tga_view *view;
+{
+  byte *raster;
+  int first, last;
+  int k;
+
+  if ( x < 0 || y < 0 || xsize < 1 || ysize < 1 ||
+       x + xsize > map->hdr.xsize || y + ysize > map->hdr.ysize )
+    error( 12 );
+
+  /* Scanlines into the file */
+  if ( map->flip ) {
+    first = map->hdr.ysize - y - ysize;
+    last = map->hdr.ysize - 1 - y;
+  }else {
+    first = y;
+    last = y + ysize - 1;
+  }
+
+  if ( map->hdr.image_type < 9 )
+    raster = map->pixels;
+  else {
+    raster = map->raster;
+    for ( k = first / map->blocklines; k <= last / map->blocklines; k++ )
+      if ( !map->decoded[k] )
+        decode_tga_block( map, k );
+  }
+
+  view->xsize = xsize;
+  view->ysize = ysize;
+  view->bpp = map->bpp;
+  if ( map->flip ) {
+    view->data = raster + last * map->rowbytes + x * map->bpp;
+    view->stride = -map->rowbytes;
+  }else {
+    view->data = raster + first * map->rowbytes + x * map->bpp;
+    view->stride = map->rowbytes;
+  }
+
+  return 0;
+}
+
+/*
+ * Copy a view to our planes format ( like read_tga does ). Mapped
+ * images only fill <r>.
+ */
+void tga_view_planes(view, r, g, b)
+tga_view *view;
+byte *r, *g, *b;
+{
+  register int i;
+  int j;
+  int aux;
+  byte *ptr;
+
+  for ( j = 0; j < view->ysize; j++ ) {
+    ptr = view->data + j * view->stride;
+    switch ( view->bpp ) {
+      case 1:
+              bcopy( ptr, r, view->xsize );
+              r += view->xsize;
+              break;
+      case 2:
+              for ( i = 0; i < view->xsize; i++ ) {
+                aux = ( ptr[1] << 8 ) | ptr[0];
+                *r++ = (aux & 0x7c00) >> 7;
+                *g++ = (aux & 0x03e0) >> 2;
+                *b++ = (aux & 0x001F) << 3;
+                ptr += 2;
+              }
+              break;
+      default:
+              for ( i = 0; i < view->xsize; i++ ) {
+                *b++ = ptr[0];
+                *g++ = ptr[1];
+                *r++ = ptr[2];
+                ptr += view->bpp;
+              }
+              break;
+    }
+  }
+}
+
+/*
+ * Encode a RLE scanline; returns its bytes. Runs of two pixels
+ * are packed too ( like write_tga_rle_line24 ).
+ */
+static int tga_rle_line24(r, g, b, xsize, buffer)
+byte *r, *g, *b;
+int xsize;
+byte *buffer;
+{
+  byte *ptr = buffer;
+  int i = 0, j;
+
+#define SAMEPIXEL(i, j) ( r[i] == r[j] && g[i] == g[j] && b[i] == b[j] )
+
+  while ( i < xsize ) {
+    /* Repeated pixels ? */
+    for ( j = i + 1; j < xsize && j - i < 128 && SAMEPIXEL(i, j); j++ );
+    if ( j - i > 1 ) {
+      *ptr++ = 128 | (j - i - 1);
+      *ptr++ = b[i];
+      *ptr++ = g[i];
+      *ptr++ = r[i];
+      i = j;
+      continue;
+    }
+    /* No, so take them until the next run */
+    for ( j = i + 1; j < xsize && j - i < 128 &&
+                     !(j + 1 < xsize && SAMEPIXEL(j, j + 1)); j++ );
+    *ptr++ = j - i - 1;
+    for ( ; i < j; i++ ) {
+      *ptr++ = b[i];
+      *ptr++ = g[i];
+      *ptr++ = r[i];
+    }
+  }
+
+#undef SAMEPIXEL
+
+  return (int) (ptr - buffer);
+}
+
+int open_tga_stream(name, stream, xsize, ysize, rle)
+char *name;
+tga_stream *stream;
+int xsize, ysize;
+int rle;
+{
+  bitmap_hdr image;
+
+  /* Open the file descriptor */
+  if ( name != NULL )
+    stream->handle = Fopen( name, "wb" );
+  else stream->handle = stdout;
+
+  stream->xsize = xsize;
+  stream->ysize = ysize;
+  stream->rle = rle;
+  stream->lines = 0;
+  /* ( the worst RLE is a raw packet by each 128 pixels ) */
+  stream->buffer = (byte *) Malloc( 3 * xsize + xsize / 128 + 1 );
+
+  /* Only the sizes and depth are used for the header */
+  image.xsize = xsize;
+  image.ysize = ysize;
+  image.depth = 24;
+  write_tga_header( stream->handle, &image, rle );
+
+  return 0;
+}
+
+/*
+ * Write the next <lines> scanlines, stored in planes.
+ */
+int write_tga_stream(stream, r, g, b, lines)
+tga_stream *stream;
+byte *r, *g, *b;
+int lines;
+{
+  register int i;
+  int j, bytes;
+  byte *ptr;
+
+  if ( stream->lines + lines > stream->ysize )
+    error( 12 );
+
+  for ( j = 0; j < lines; j++ ) {
+    if ( stream->rle )
+      bytes = tga_rle_line24( r, g, b, stream->xsize, stream->buffer );
+    else {
+      ptr = stream->buffer;
+      for ( i = 0; i < stream->xsize; i++ ) {
+        *ptr++ = b[i];
+        *ptr++ = g[i];
+        *ptr++ = r[i];
+      }
+      bytes = 3 * stream->xsize;
+    }
+    Fwrite( stream->buffer, bytes, 1, stream->handle );
+    r += stream->xsize;
+    g += stream->xsize;
+    b += stream->xsize;
+  }
+  stream->lines += lines;
+
+  return 0;
+}
+
+int close_tga_stream(stream)
+tga_stream *stream;
+{
+  if ( stream->lines != stream->ysize )
+    error( 18 );
+
+  Free( stream->buffer );
+  stream->buffer = NULL;
+  if ( Fclose( stream->handle ) )
+    error( 4 );
+
+  return 0;
+}
@@ -8,6 +8,20 @@
 #include "gmVec3.h"
 #include "gmVec4.h"
 
+// With SSE (and AVX, if the compiler is told to use it) the products,
+// inverse and batch transforms below go four floats at a time; define
+// GM_NO_SIMD for the plain scalar code.  Products and transforms add in
+// the order of the scalar code and give the same results to the bit.
+
+#if defined(__SSE__) && !defined(GM_NO_SIMD)
+#define GM_SSE
+#include <xmmintrin.h>
+#endif
+#if defined(__AVX__) && !defined(GM_NO_SIMD)
+#define GM_AVX
+#include <immintrin.h>
+#endif
+
 // private function: RCD
 // - dot product of row i of matrix A and row j of matrix B
 
@@ -28,6 +42,90 @@ inline float MINOR(const gmMatrix4& M,
 	 M[r0][c2] * (M[r1][c0] * M[r2][c1] - M[r2][c0] * M[r1][c1]);
 }
 
+#ifdef GM_SSE
+
+#define SHUFFLE(v, a, b, c, d) _mm_shuffle_ps(v, v, _MM_SHUFFLE(d, c, b, a))
+
+// private function: MULTIPLY
+// - R = A * B; row i of R is the rows of B weighted by row i of A
+// - R may be A or B
+
+inline void MULTIPLY(const float A[4][4], const float B[4][4], float R[4][4])
+{
+  __m128 b0 = _mm_loadu_ps(B[0]), b1 = _mm_loadu_ps(B[1]);
+  __m128 b2 = _mm_loadu_ps(B[2]), b3 = _mm_loadu_ps(B[3]);
+  __m128 a0 = _mm_loadu_ps(A[0]), a1 = _mm_loadu_ps(A[1]);
+  __m128 a2 = _mm_loadu_ps(A[2]), a3 = _mm_loadu_ps(A[3]);
+
+#define ROW(a) _mm_add_ps(_mm_add_ps(_mm_add_ps( \
+    _mm_mul_ps(SHUFFLE(a, 0,0,0,0), b0), _mm_mul_ps(SHUFFLE(a, 1,1,1,1), b1)), \
+    _mm_mul_ps(SHUFFLE(a, 2,2,2,2), b2)), _mm_mul_ps(SHUFFLE(a, 3,3,3,3), b3))
+  _mm_storeu_ps(R[0], ROW(a0));
+  _mm_storeu_ps(R[1], ROW(a1));
+  _mm_storeu_ps(R[2], ROW(a2));
+  _mm_storeu_ps(R[3], ROW(a3));
+#undef ROW
+}
+
+// private function: INVERT
+// - R = inverse of M, from the 2x2 determinants s of rows 0,1 and c of
+//   rows 2,3 (Laplace expansion); each row of the adjoint is a sum of
+//   three columns of M weighted by them
+
+inline void INVERT(const float M[4][4], float R[4][4])
+{
+  __m128 m0 = _mm_loadu_ps(M[0]), m1 = _mm_loadu_ps(M[1]);
+  __m128 m2 = _mm_loadu_ps(M[2]), m3 = _mm_loadu_ps(M[3]);
+
+  // s0..s3 and c0..c3: columns 01 02 03 12; then s4 s5 c4 c5: 13 23
+  __m128 s = _mm_sub_ps(_mm_mul_ps(SHUFFLE(m0, 0,0,0,1), SHUFFLE(m1, 1,2,3,2)),
+                        _mm_mul_ps(SHUFFLE(m1, 0,0,0,1), SHUFFLE(m0, 1,2,3,2)));
+  __m128 c = _mm_sub_ps(_mm_mul_ps(SHUFFLE(m2, 0,0,0,1), SHUFFLE(m3, 1,2,3,2)),
+                        _mm_mul_ps(SHUFFLE(m3, 0,0,0,1), SHUFFLE(m2, 1,2,3,2)));
+  __m128 t = _mm_sub_ps(
+    _mm_mul_ps(_mm_shuffle_ps(m0, m2, _MM_SHUFFLE(2,1,2,1)),
+               _mm_shuffle_ps(m1, m3, _MM_SHUFFLE(3,3,3,3))),
+    _mm_mul_ps(_mm_shuffle_ps(m1, m3, _MM_SHUFFLE(2,1,2,1)),
+               _mm_shuffle_ps(m0, m2, _MM_SHUFFLE(3,3,3,3))));
+
+  // S[k] = (ck, ck, sk, sk)
+  __m128 S[6];
+  S[0] = _mm_shuffle_ps(c, s, _MM_SHUFFLE(0,0,0,0));
+  S[1] = _mm_shuffle_ps(c, s, _MM_SHUFFLE(1,1,1,1));
+  S[2] = _mm_shuffle_ps(c, s, _MM_SHUFFLE(2,2,2,2));
+  S[3] = _mm_shuffle_ps(c, s, _MM_SHUFFLE(3,3,3,3));
+  S[4] = SHUFFLE(t, 2,2,0,0);
+  S[5] = SHUFFLE(t, 3,3,1,1);
+
+  // X[j] = (M[1][j], M[0][j], M[3][j], M[2][j])
+  __m128 X0 = m1, X1 = m0, X2 = m3, X3 = m2;
+  _MM_TRANSPOSE4_PS(X0, X1, X2, X3);
+
+  __m128 odd = _mm_set_ps(-1.f, 1.f, -1.f, 1.f), even = _mm_set_ps(1.f, -1.f, 1.f, -1.f);
+  __m128 r0 = _mm_mul_ps(odd, _mm_add_ps(_mm_sub_ps(
+    _mm_mul_ps(X1, S[5]), _mm_mul_ps(X2, S[4])), _mm_mul_ps(X3, S[3])));
+  __m128 r1 = _mm_mul_ps(even, _mm_add_ps(_mm_sub_ps(
+    _mm_mul_ps(X0, S[5]), _mm_mul_ps(X2, S[2])), _mm_mul_ps(X3, S[1])));
+  __m128 r2 = _mm_mul_ps(odd, _mm_add_ps(_mm_sub_ps(
+    _mm_mul_ps(X0, S[4]), _mm_mul_ps(X1, S[2])), _mm_mul_ps(X3, S[0])));
+  __m128 r3 = _mm_mul_ps(even, _mm_add_ps(_mm_sub_ps(
+    _mm_mul_ps(X0, S[3]), _mm_mul_ps(X1, S[1])), _mm_mul_ps(X2, S[0])));
+
+  // determinant: row 0 of M times column 0 of the adjoint
+  __m128 col = _mm_movelh_ps(_mm_unpacklo_ps(r0, r1), _mm_unpacklo_ps(r2, r3));
+  __m128 d = _mm_mul_ps(m0, col);
+  d = _mm_add_ps(d, _mm_movehl_ps(d, d));
+  d = _mm_add_ss(d, SHUFFLE(d, 1,1,1,1));
+  __m128 di = _mm_set1_ps(gmInv(_mm_cvtss_f32(d)));
+
+  _mm_storeu_ps(R[0], _mm_mul_ps(r0, di));
+  _mm_storeu_ps(R[1], _mm_mul_ps(r1, di));
+  _mm_storeu_ps(R[2], _mm_mul_ps(r2, di));
+  _mm_storeu_ps(R[3], _mm_mul_ps(r3, di));
+}
+
+#endif
+
 // CONSTRUCTORS
 
 gmMatrix4::gmMatrix4()
@@ -114,6 +212,10 @@ gmMatrix4& gmMatrix4::operator -=(const gmMatrix4& M)
 
 gmMatrix4& gmMatrix4::operator *=(const gmMatrix4& M)
 {
+#ifdef GM_SSE
+  MULTIPLY(m_, M.m_, m_);
+  return *this;
+#else
   assign(RCD(*this, M, 0, 0), RCD(*this, M, 0, 1), 
 	 RCD(*this, M, 0, 2), RCD(*this, M, 0, 3),
 	 RCD(*this, M, 1, 0), RCD(*this, M, 1, 1),
@@ -123,6 +225,7 @@ gmMatrix4& gmMatrix4::operator *=(const gmMatrix4& M)
 	 RCD(*this, M, 3, 0), RCD(*this, M, 3, 1),
 	 RCD(*this, M, 3, 2), RCD(*this, M, 3, 3));
   return *this;
+#endif
 }
 
 gmMatrix4& gmMatrix4::operator *=(float d)
@@ -178,6 +281,11 @@ gmMatrix4 gmMatrix4::operator -() const
 
 gmMatrix4 gmMatrix4::operator *(const gmMatrix4& M) const
 {
+#ifdef GM_SSE
+  gmMatrix4 A;
+  MULTIPLY(m_, M.m_, A.m_);
+  return A;
+#else
   return gmMatrix4(RCD(*this, M, 0, 0), RCD(*this, M, 0, 1), 
 		   RCD(*this, M, 0, 2), RCD(*this, M, 0, 3),
 		   RCD(*this, M, 1, 0), RCD(*this, M, 1, 1),
@@ -186,6 +294,7 @@ gmMatrix4 gmMatrix4::operator *(const gmMatrix4& M) const
 		   RCD(*this, M, 2, 2), RCD(*this, M, 2, 3),
 		   RCD(*this, M, 3, 0), RCD(*this, M, 3, 1),
 		   RCD(*this, M, 3, 2), RCD(*this, M, 3, 3));
+#endif
 }
 
 gmMatrix4 gmMatrix4::operator *(float d) const
@@ -265,7 +374,13 @@ gmMatrix4 gmMatrix4::transpose() const
 gmMatrix4 gmMatrix4::inverse() const
 {
   assert(!isSingular());
+#ifdef GM_SSE
+  gmMatrix4 A;
+  INVERT(m_, A.m_);
+  return A;
+#else
   return adjoint() * gmInv(determinant());
+#endif
 }
 
 gmMatrix4 gmMatrix4::adjoint() const
@@ -519,3 +634,92 @@ gmMatrix4 gmMatrix4::betaSplineBasis(float bias, float tension)
 }
 
 
+
+////////////////////////////////////////////////////////////////////////////
+// BATCH TRANSFORMS
+
+static_assert(sizeof(gmVector3) == 3 * sizeof(float) &&
+	      sizeof(gmVector4) == 4 * sizeof(float),
+	      "gmVector3 and gmVector4 arrays must be packed floats");
+
+void gmTransform(const gmMatrix4& M, const float in[][3], float out[][3],
+		 int n)
+{
+#ifdef GM_SSE
+  __m128 m0 = _mm_loadu_ps(M[0]), m1 = _mm_loadu_ps(M[1]);
+  __m128 m2 = _mm_loadu_ps(M[2]), m3 = _mm_loadu_ps(M[3]);
+
+  for (int i = 0; i < n; i++) {
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                 _mm_mul_ps(_mm_set1_ps(in[i][0]), m0),
+                 _mm_mul_ps(_mm_set1_ps(in[i][1]), m1)),
+                 _mm_mul_ps(_mm_set1_ps(in[i][2]), m2)), m3);
+    _mm_storel_pi((__m64 *) out[i], r);
+    _mm_store_ss(&out[i][2], _mm_movehl_ps(r, r));
+  }
+#else
+  for (int i = 0; i < n; i++) {
+    float x = in[i][0], y = in[i][1], z = in[i][2];
+    out[i][0] = x * M[0][0] + y * M[1][0] + z * M[2][0] + M[3][0];
+    out[i][1] = x * M[0][1] + y * M[1][1] + z * M[2][1] + M[3][1];
+    out[i][2] = x * M[0][2] + y * M[1][2] + z * M[2][2] + M[3][2];
+  }
+#endif
+}
+
+void gmTransform(const gmMatrix4& M, const gmVector3 in[], gmVector3 out[],
+		 int n)
+{
+  if (n > 0)
+    gmTransform(M, (const float (*)[3]) &in[0][0], (float (*)[3]) &out[0][0], n);
+}
+
+void gmMultiply(const gmMatrix4& M, const float in[][4], float out[][4],
+		int n)
+{
+  int i = 0;
+#ifdef GM_SSE
+  // columns of M
+  __m128 c0 = _mm_loadu_ps(M[0]), c1 = _mm_loadu_ps(M[1]);
+  __m128 c2 = _mm_loadu_ps(M[2]), c3 = _mm_loadu_ps(M[3]);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+#ifdef GM_AVX
+  // two vectors at a time
+  __m256 C0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c0, 1);
+  __m256 C1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c1), c1, 1);
+  __m256 C2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), c2, 1);
+  __m256 C3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c3), c3, 1);
+
+  for (; i + 2 <= n; i += 2) {
+    __m256 v = _mm256_loadu_ps(in[i]);
+    __m256 r = _mm256_mul_ps(C0, _mm256_permute_ps(v, 0x00));
+    r = _mm256_add_ps(r, _mm256_mul_ps(C1, _mm256_permute_ps(v, 0x55)));
+    r = _mm256_add_ps(r, _mm256_mul_ps(C2, _mm256_permute_ps(v, 0xaa)));
+    r = _mm256_add_ps(r, _mm256_mul_ps(C3, _mm256_permute_ps(v, 0xff)));
+    _mm256_storeu_ps(out[i], r);
+  }
+#endif
+  for (; i < n; i++) {
+    __m128 v = _mm_loadu_ps(in[i]);
+    __m128 r = _mm_mul_ps(c0, SHUFFLE(v, 0,0,0,0));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, SHUFFLE(v, 1,1,1,1)));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, SHUFFLE(v, 2,2,2,2)));
+    r = _mm_add_ps(r, _mm_mul_ps(c3, SHUFFLE(v, 3,3,3,3)));
+    _mm_storeu_ps(out[i], r);
+  }
+#else
+  for (; i < n; i++) {
+    float x = in[i][0], y = in[i][1], z = in[i][2], w = in[i][3];
+    for (int j = 0; j < 4; j++)
+      out[i][j] = M[j][0] * x + M[j][1] * y + M[j][2] * z + M[j][3] * w;
+  }
+#endif
+}
+
+void gmMultiply(const gmMatrix4& M, const gmVector4 in[], gmVector4 out[],
+		int n)
+{
+  if (n > 0)
+    gmMultiply(M, (const float (*)[4]) &in[0][0], (float (*)[4]) &out[0][0], n);
+}
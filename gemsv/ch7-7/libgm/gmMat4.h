@@ -125,6 +125,16 @@ inline void gmMatrix4::copyTo(float f[4][4]) const
   f[3][2] = m_[3][2]; f[3][3] = m_[3][3];
 }
 
+// BATCH TRANSFORMS
+// - gmTransform: out[i] = M.transform(in[i]) for n points
+// - gmMultiply: out[i] = M * in[i] for n vectors
+// - the float forms take packed x y z and x y z w; out may be in
+
+void gmTransform(const gmMatrix4&, const gmVector3 in[], gmVector3 out[], int n);
+void gmTransform(const gmMatrix4&, const float in[][3], float out[][3], int n);
+void gmMultiply(const gmMatrix4&, const gmVector4 in[], gmVector4 out[], int n);
+void gmMultiply(const gmMatrix4&, const float in[][4], float out[][4], int n);
+
 #endif // GMMATRIX4_H
 
 
@@ -0,0 +1,120 @@
+// gmbench.cc - throughput of gmMatrix4 products, inverses and transforms
+//
+// Built twice: gmbench with the SSE/AVX code of gmMat4.cc, and
+// gmbench_scalar with GM_NO_SIMD.  Each prints millions of operations a
+// second and a checksum; products and transforms give the same checksums
+// in both.  The times mean little unless it is compiled with optimization
+// (cmake -DCMAKE_BUILD_TYPE=Release).
+//
+// Usage: gmbench [items [repetitions]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gmVec3.h"
+#include "gmVec4.h"
+#include "gmMat4.h"
+
+static int n, reps;
+
+static double seconds()
+{
+  return (double) clock() / CLOCKS_PER_SEC;
+}
+
+static float uniform()
+{
+  return 2.f * rand() / RAND_MAX - 1.f;
+}
+
+static void report(const char *name, double t, double sum)
+{
+  printf("%-28s %10.2f %20.9g\n", name, 1e-6 * n * reps / t, sum);
+}
+
+static double checksum(const float *f, int k)
+{
+  double s = 0;
+  for (int i = 0; i < k; i++)
+    s += f[i];
+  return s;
+}
+
+int main(int argc, char *argv[])
+{
+  n = argc > 1 ? atoi(argv[1]) : 4096;
+  reps = argc > 2 ? atoi(argv[2]) : 200;
+
+  gmMatrix4 *A = new gmMatrix4[n], *R = new gmMatrix4[n];
+  gmVector3 *p = new gmVector3[n], *q = new gmVector3[n];
+  gmVector4 *v = new gmVector4[n], *w = new gmVector4[n];
+  gmMatrix4 M = gmMatrix4::rotate(30, gmVector3(1, 2, 3)) *
+		gmMatrix4::translate(1, -2, 3);
+  int i, k;
+  double t, e;
+
+  srand(1);
+  for (i = 0; i < n; i++) {
+    A[i] = gmMatrix4::rotate(360 * uniform(),
+			     gmVector3(uniform(), uniform(), uniform() + 2)) *
+	   gmMatrix4::scale(2 + uniform(), 2 + uniform(), 2 + uniform());
+    A[i][0][3] = uniform();
+    A[i][3][0] = uniform();
+    p[i].assign(uniform(), uniform(), uniform());
+    v[i].assign(uniform(), uniform(), uniform(), 1);
+  }
+
+#ifdef GM_NO_SIMD
+  printf("libgm, scalar\n");
+#else
+  printf("libgm, SIMD\n");
+#endif
+  printf("%d items, %d repetitions\n", n, reps);
+  printf("%-28s %10s %20s\n", "operation", "Mop/s", "checksum");
+
+  t = seconds();
+  for (k = 0; k < reps; k++)
+    for (i = 0; i < n; i++)
+      R[i] = A[i] * M;
+  report("A * M", seconds() - t, checksum(R[0][0], 16 * n));
+
+  t = seconds();
+  for (k = 0; k < reps; k++)
+    for (i = 0; i < n; i++)
+      R[i] = A[i].inverse();
+  t = seconds() - t;
+  for (e = 0, i = 0; i < n; i++) {
+    gmMatrix4 I = A[i] * R[i];
+    for (k = 0; k < 16; k++) {
+      float d = gmAbs(I[k / 4][k % 4] - (k / 4 == k % 4));
+      if (d > e) e = d;
+    }
+  }
+  report("A.inverse() (error)", t, e);
+
+  t = seconds();
+  for (k = 0; k < reps; k++)
+    for (i = 0; i < n; i++)
+      q[i] = M.transform(p[i]);
+  report("M.transform(p)", seconds() - t, checksum(&q[0][0], 3 * n));
+
+  t = seconds();
+  for (k = 0; k < reps; k++)
+    gmTransform(M, p, q, n);
+  report("gmTransform(M, p, q, n)", seconds() - t, checksum(&q[0][0], 3 * n));
+
+  t = seconds();
+  for (k = 0; k < reps; k++)
+    for (i = 0; i < n; i++)
+      w[i] = M * v[i];
+  report("M * v", seconds() - t, checksum(&w[0][0], 4 * n));
+
+  t = seconds();
+  for (k = 0; k < reps; k++)
+    gmMultiply(M, v, w, n);
+  report("gmMultiply(M, v, w, n)", seconds() - t, checksum(&w[0][0], 4 * n));
+
+  delete [] A; delete [] R;
+  delete [] p; delete [] q; delete [] v; delete [] w;
+  return 0;
+}